@@ -0,0 +1,279 @@
+/**
+ * @file telemetry_archive.h
+ * @brief Archivo masivo de telemetría en tarjeta SD (SPI) con respaldo en LittleFS
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * La partición LittleFS de la flash interna se queda pequeña para archivos de
+ * varios días. Este módulo archiva los paquetes procesados en segmentos de
+ * una tarjeta SD conectada por SPI:
+ *
+ * - Los segmentos se preasignan completos al crearlos, de modo que los
+ *   añadidos sobrescriben clusters ya reservados y no modifican la FAT.
+ * - Los registros se acumulan en un bloque de TELEM_ARCHIVE_BLOCK_SIZE bytes
+ *   alineado en el fichero y se escriben de una vez al completarlo (escritura
+ *   multibloque por DMA en el driver SDSPI).
+ * - Si la tarjeta no está disponible (p. ej. en WOKWI) se usa un fichero
+ *   normal en LittleFS con el mismo formato, sin preasignar: los registros
+ *   solo se añaden al final y nunca se reescriben.
+ *
+ * Formato de segmento: registros telem_archive_record_t consecutivos; la zona
+ * preasignada sin usar (o, en LittleFS, lo que falta hasta el final del
+ * fichero) se lee a cero y no supera la comprobación de CRC, lo que permite
+ * recuperar el punto de escritura tras un reinicio. El último bloque
+ * de cada segmento se reserva para su mapa de zona (telem_zone_map_t), que se
+ * escribe al sellarlo y permite a las consultas descartar el segmento entero
+ * leyendo solo unas decenas de bytes.
+ *
+ * @note Las funciones de escritura deben llamarse desde una única tarea
+ * (la tarea procesadora).
+ */
+
+#ifndef TELEMETRY_ARCHIVE_H
+#define TELEMETRY_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_types.h"
+
+/** @brief Pin CS de la tarjeta SD (bus VSPI por defecto: SCK 18, MISO 19, MOSI 23) */
+#ifndef TELEM_SD_CS_PIN
+#define TELEM_SD_CS_PIN 5
+#endif
+
+/** @brief Frecuencia del bus SPI de la tarjeta SD (Hz) */
+#ifndef TELEM_SD_SPI_HZ
+#define TELEM_SD_SPI_HZ 20000000
+#endif
+
+/** @brief Tamaño preasignado de cada segmento en la tarjeta SD (bytes) */
+#ifndef TELEM_ARCHIVE_SEGMENT_SIZE
+#define TELEM_ARCHIVE_SEGMENT_SIZE (1024UL * 1024UL)
+#endif
+
+/** @brief Tamaño de cada segmento en el respaldo LittleFS (bytes) */
+#ifndef TELEM_ARCHIVE_FALLBACK_SEGMENT_SIZE
+#define TELEM_ARCHIVE_FALLBACK_SEGMENT_SIZE (64UL * 1024UL)
+#endif
+
+/** @brief Registros sin escribir que fuerzan la escritura del bloque parcial */
+#ifndef TELEM_ARCHIVE_SYNC_RECORDS
+#define TELEM_ARCHIVE_SYNC_RECORDS 16
+#endif
+
+/** @brief Antigüedad máxima de un registro sin escribir en el soporte (ms) */
+#ifndef TELEM_ARCHIVE_SYNC_MS
+#define TELEM_ARCHIVE_SYNC_MS 60000
+#endif
+
+/** @brief Tamaño del bloque de escritura (múltiplo del sector de 512 bytes) */
+#define TELEM_ARCHIVE_BLOCK_SIZE 4096
+
+/** @brief Directorio de los segmentos */
+#define TELEM_ARCHIVE_DIR "/telem"
+
+/** @brief Registro de archivo: paquete protegido por CRC */
+typedef struct {
+  uint32_t crc;                 /**< CRC32 del paquete */
+  telemetry_packet_t packet;    /**< Paquete archivado */
+} telem_archive_record_t;
+
+/** @brief Campos con rango mínimo/máximo en el mapa de zona */
+typedef enum {
+  TELEM_FIELD_NONE = 0,           /**< Sin filtro por valor */
+  TELEM_FIELD_BATTERY_VOLTAGE,    /**< power.battery_voltage (V) */
+  TELEM_FIELD_OBC_TEMPERATURE,    /**< temperature.obc_temperature (°C) */
+  TELEM_FIELD_COUNT
+} telem_archive_field_t;
+
+/**
+ * @brief Marca de un mapa de zona válido ("ZON2")
+ *
+ * @details Cambió al contar en type_counts los tipos presentes en los
+ * registros de housekeeping: los mapas antiguos dejan de ser válidos y sus
+ * segmentos se recorren enteros en lugar de descartarse por error.
+ */
+#define TELEM_ZONE_MAGIC 0x5A4F4E32u
+
+/** @brief Bloques leídos por cada toma del mutex durante una consulta */
+#ifndef TELEM_ARCHIVE_QUERY_CHUNK_BLOCKS
+#define TELEM_ARCHIVE_QUERY_CHUNK_BLOCKS 4
+#endif
+
+/**
+ * @brief Mapa de zona: resumen de un segmento sellado
+ *
+ * @note Los rangos de campo y los contadores por tipo incluyen lo contenido
+ * en registros combinados de housekeeping: uno con potencia y temperatura
+ * cuenta en TELEM_HOUSEKEEPING, TELEM_POWER_DATA y TELEM_TEMPERATURE_DATA.
+ * Un campo sin valores queda con min > max.
+ */
+typedef struct {
+  uint32_t magic;                              /**< TELEM_ZONE_MAGIC */
+  uint32_t records;                            /**< Registros del segmento */
+  uint32_t min_timestamp;                      /**< Timestamp mínimo */
+  uint32_t max_timestamp;                      /**< Timestamp máximo */
+  uint16_t type_counts[TELEM_TYPE_COUNT];      /**< Registros que contienen cada tipo */
+  float min_value[TELEM_FIELD_COUNT];          /**< Mínimo por campo */
+  float max_value[TELEM_FIELD_COUNT];          /**< Máximo por campo */
+  uint32_t crc;                                /**< CRC32 de los campos anteriores */
+} telem_zone_map_t;
+
+/**
+ * @brief Consulta sobre el archivo
+ *
+ * @details Un registro coincide si su timestamp está en
+ * [from_timestamp, to_timestamp], su tipo está en type_mask (0 = cualquiera)
+ * y, si field no es TELEM_FIELD_NONE, el valor del campo está en
+ * [min_value, max_value]. Ej.: "¿cuándo superó el OBC los 60 °C?" es
+ * field = TELEM_FIELD_OBC_TEMPERATURE, min_value = 60.5.
+ */
+typedef struct {
+  uint32_t from_timestamp;        /**< Inicio de la ventana temporal */
+  uint32_t to_timestamp;          /**< Fin de la ventana temporal */
+  uint32_t type_mask;             /**< Bit (1 << tipo) por tipo aceptado; 0 = todos. Un registro
+                                       de housekeeping coincide también por sus bits de presencia */
+  telem_archive_field_t field;    /**< Campo filtrado por valor */
+  float min_value;                /**< Valor mínimo aceptado del campo */
+  float max_value;                /**< Valor máximo aceptado del campo */
+} telemetry_archive_query_t;
+
+/** @brief Resultado de una consulta */
+typedef struct {
+  uint32_t segments;              /**< Segmentos considerados */
+  uint32_t segments_skipped;      /**< Segmentos descartados por su mapa de zona */
+  uint32_t segments_mapped;       /**< Segmentos leídos en la partición mapeada */
+  uint32_t records_scanned;       /**< Registros leídos */
+  uint32_t matches;               /**< Registros coincidentes */
+  uint32_t bytes_read;            /**< Bytes leídos del soporte */
+} telemetry_archive_query_stats_t;
+
+/**
+ * @brief Función llamada con cada registro coincidente
+ *
+ * @return true para continuar la consulta, false para terminarla
+ */
+typedef bool (*telemetry_archive_visitor_t)(const telemetry_packet_t* packet, void* context);
+
+/** @brief Soporte donde se archiva */
+typedef enum {
+  TELEM_ARCHIVE_NONE = 0,       /**< Archivo no disponible */
+  TELEM_ARCHIVE_SD,             /**< Tarjeta SD por SPI */
+  TELEM_ARCHIVE_LITTLEFS        /**< Respaldo en la flash interna */
+} telem_archive_backend_t;
+
+/** @brief Estadísticas del archivo */
+typedef struct {
+  telem_archive_backend_t backend;  /**< Soporte activo */
+  uint32_t segment;                 /**< Segmento actual */
+  uint32_t records;                 /**< Registros archivados desde el arranque */
+  uint32_t bytes_written;           /**< Bytes escritos en el soporte */
+  uint32_t flushes;                 /**< Escrituras de bloque realizadas */
+  uint32_t errors;                  /**< Errores de escritura */
+  uint32_t worst_flush_us;          /**< Peor latencia de escritura de bloque (µs) */
+} telemetry_archive_stats_t;
+
+/** @brief Resultado de telemetry_archive_benchmark() */
+typedef struct {
+  uint32_t bytes;                   /**< Bytes escritos */
+  uint32_t total_us;                /**< Duración de la escritura (µs) */
+  uint32_t kbps;                    /**< Velocidad sostenida (KB/s) */
+  uint32_t worst_block_us;          /**< Peor latencia por bloque (µs) */
+  uint32_t prealloc_us;             /**< Duración de la preasignación (µs) */
+} telemetry_archive_benchmark_t;
+
+/**
+ * @brief Monta el soporte y recupera el punto de escritura del último segmento
+ *
+ * @return true Si hay algún soporte disponible (SD o LittleFS)
+ *
+ * @note Con `TELEM_ARCHIVE_BENCHMARK` definido ejecuta además
+ * telemetry_archive_benchmark() al iniciar.
+ */
+bool telemetry_archive_init(void);
+
+/**
+ * @brief Añade un paquete al archivo
+ *
+ * @param packet Paquete a archivar
+ * @return true Si se añadió al bloque en curso
+ */
+bool telemetry_archive_append(const telemetry_packet_t* packet);
+
+/**
+ * @brief Vaciado periódico: escribe el bloque en curso incompleto solo si toca
+ *
+ * @details Escribe cuando hay TELEM_ARCHIVE_SYNC_RECORDS registros sin llevar
+ * al soporte o el más antiguo de ellos tiene TELEM_ARCHIVE_SYNC_MS; en otro
+ * caso no hace nada, de modo que llamarlo en cada reposo de la tarea
+ * procesadora no gasta ciclos de escritura. El bloque sigue abierto: en la
+ * tarjeta SD la siguiente escritura lo reescribe completo en su posición
+ * alineada y en LittleFS solo añade los registros nuevos.
+ */
+void telemetry_archive_flush(void);
+
+/**
+ * @brief Escribe ya los registros pendientes del bloque en curso
+ *
+ * @details Para antes de un deep sleep o un apagado, cuando los registros
+ * que solo están en RAM se perderían.
+ */
+void telemetry_archive_sync(void);
+
+/**
+ * @brief Obtiene estadísticas del archivo
+ *
+ * @param[out] stats Estructura donde se copian las estadísticas
+ */
+void telemetry_archive_get_stats(telemetry_archive_stats_t* stats);
+
+/**
+ * @brief Ejecuta una consulta sobre todos los segmentos, del más antiguo al actual
+ *
+ * @param query Criterios de la consulta
+ * @param visitor Función llamada con cada registro coincidente (puede ser NULL)
+ * @param context Contexto pasado a visitor
+ * @param[out] stats Estadísticas de la consulta (puede ser NULL)
+ * @return uint32_t Número de registros coincidentes
+ *
+ * @details Los segmentos sellados cuyo mapa de zona no puede contener
+ * coincidencias se descartan sin leer sus datos. El segmento actual se
+ * filtra con el mapa de zona que se mantiene en memoria.
+ *
+ * En el respaldo LittleFS el histórico publicado en la partición mapeada
+ * (ver telemetry_mapped.h) se recorre primero y en su sitio, incluidos los
+ * segmentos que ya rotaron fuera de los ficheros; los ficheros sellados que
+ * ya estaban publicados no se vuelven a leer.
+ *
+ * Los datos se leen por tramos de TELEM_ARCHIVE_QUERY_CHUNK_BLOCKS bloques
+ * y el mutex del archivo se suelta entre tramos, así que una consulta larga
+ * solo retrasa telemetry_archive_append() lo que tarda un tramo. El visitante
+ * se llama con el mutex tomado y no debe bloquearse.
+ */
+uint32_t telemetry_archive_query(const telemetry_archive_query_t* query,
+                                 telemetry_archive_visitor_t visitor, void* context,
+                                 telemetry_archive_query_stats_t* stats);
+
+/**
+ * @brief Mide la velocidad sostenida de escritura y la peor latencia
+ *
+ * @param bytes Bytes a escribir en un segmento de prueba (se borra al terminar)
+ * @param[out] result Cifras medidas (puede ser NULL)
+ * @return true Si se completó la escritura de prueba
+ *
+ * @details Escribe bloques completos por el mismo camino que el archivo y
+ * registra MB/s sostenidos y la peor latencia por bloque en el log.
+ */
+bool telemetry_archive_benchmark(uint32_t bytes, telemetry_archive_benchmark_t* result);
+
+/**
+ * @brief Compara la reproducción del archivo desde la partición mapeada y
+ * desde la API de ficheros
+ *
+ * @details Recorre todos los registros sellados por ambos caminos haciendo el
+ * mismo trabajo por paquete y registra registros, tiempo y KB/s de cada uno.
+ */
+void telemetry_archive_replay_benchmark(void);
+
+#endif // TELEMETRY_ARCHIVE_H
@@ -0,0 +1,54 @@
+/**
+ * @file telemetry_arena.h
+ * @brief Arena de memoria para los buffers temporales de una pasada
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Construcción de tramas, memoria de trabajo de compresión y estado de
+ * retransmisión solo viven durante una ventana de contacto. En lugar de usar
+ * el heap (y fragmentarlo con cada pasada), el transmisor toma todos esos
+ * buffers de una arena estática: reservar es incrementar un puntero y al
+ * perder la señal (LOS) la arena se libera entera con telemetry_arena_reset().
+ *
+ * @note La arena pertenece a la tarea transmisora y no está protegida para
+ * uso concurrente.
+ */
+
+#ifndef TELEMETRY_ARENA_H
+#define TELEMETRY_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Tamaño de la arena de pasada en bytes */
+#ifndef TELEM_ARENA_SIZE
+#define TELEM_ARENA_SIZE 16384
+#endif
+
+/** @brief Alineamiento de todas las reservas (bytes) */
+#define TELEM_ARENA_ALIGN 4
+
+/**
+ * @brief Reserva un bloque de la arena
+ *
+ * @param size Tamaño solicitado en bytes
+ * @return void* Puntero alineado a TELEM_ARENA_ALIGN o NULL si no hay espacio
+ */
+void* telemetry_arena_alloc(size_t size);
+
+/**
+ * @brief Libera de golpe todos los bloques reservados (fin de pasada)
+ */
+void telemetry_arena_reset(void);
+
+/**
+ * @brief Obtiene estadísticas de uso de la arena
+ *
+ * @param[out] used Bytes reservados en la pasada actual
+ * @param[out] high_water Máximo de bytes reservados en una pasada
+ * @param[out] failures Reservas rechazadas por falta de espacio
+ */
+void telemetry_arena_get_stats(uint32_t* used, uint32_t* high_water, uint32_t* failures);
+
+#endif // TELEMETRY_ARENA_H
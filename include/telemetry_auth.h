@@ -0,0 +1,141 @@
+/**
+ * @file telemetry_auth.h
+ * @brief Cifrado y autenticación AES-GCM de tramas de bajada
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Con `TELEM_DOWNLINK_AUTH` definido cada trama terminada se sella entera con
+ * AES-128-GCM (mbedtls, que en el ESP32 usa el acelerador AES del chip):
+ * una sola llamada por trama en lugar de una por paquete.
+ *
+ * - El encabezado de trama va en claro y se autentica como datos adicionales.
+ * - El nonce nunca se repite con la misma clave: lo forman un contador de
+ *   arranques, guardado en memoria RTC y reservado por bloques en NVS antes
+ *   de usarse, y un contador de tramas selladas en ese arranque.
+ * - Si no se puede sellar, la trama no sale: no hay vuelta atrás a tramas en
+ *   claro mientras la autenticación está activa.
+ *
+ * Formato de la carga sellada (flag TELEM_FRAME_FLAG_AUTH):
+ * | telem_auth_prefix_t | carga cifrada ... | etiqueta (16 bytes) |
+ *
+ * El sellado se aplica después de la compresión (telemetry_entropy.h): los
+ * datos cifrados ya no se pueden comprimir.
+ */
+
+#ifndef TELEMETRY_AUTH_H
+#define TELEMETRY_AUTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_downlink.h"
+
+/** @brief Bit de flags: carga útil cifrada y autenticada con AES-GCM */
+#define TELEM_FRAME_FLAG_AUTH 0x04
+
+/**
+ * @brief Clave AES-128 de la bajada
+ *
+ * @details La clave de vuelo se inyecta en la compilación definiendo
+ * TELEM_AUTH_KEY. La clave pública de pruebas ("TEIDESAT-TESTKEY") solo se
+ * usa con TELEM_AUTH_TEST_KEY, que define el entorno native. Sin ninguna de
+ * las dos, telemetry_auth_init() falla y `TELEM_DOWNLINK_AUTH` no compila.
+ */
+#if !defined(TELEM_AUTH_KEY) && defined(TELEM_AUTH_TEST_KEY)
+#define TELEM_AUTH_KEY { 0x54, 0x45, 0x49, 0x44, 0x45, 0x53, 0x41, 0x54, \
+                         0x2D, 0x54, 0x45, 0x53, 0x54, 0x4B, 0x45, 0x59 }
+#endif
+
+#if defined(TELEM_DOWNLINK_AUTH) && !defined(TELEM_AUTH_KEY)
+#error "TELEM_DOWNLINK_AUTH needs the flight key: define TELEM_AUTH_KEY"
+#endif
+
+/** @brief Identificador del satélite incluido en el nonce ("TEID") */
+#ifndef TELEM_AUTH_NONCE_SALT
+#define TELEM_AUTH_NONCE_SALT 0x54454944
+#endif
+
+/**
+ * @brief Arranques que se reservan en NVS con cada escritura
+ *
+ * @details Los despertares de deep sleep continúan el contador desde la
+ * memoria RTC; NVS solo se escribe cuando se agota la reserva, y un arranque
+ * en frío empieza en el límite reservado, por encima de cualquier arranque
+ * ya usado.
+ */
+#ifndef TELEM_AUTH_BOOT_RESERVE
+#define TELEM_AUTH_BOOT_RESERVE 64
+#endif
+
+/** @brief Bytes de la etiqueta de autenticación GCM */
+#define TELEM_AUTH_TAG_SIZE 16
+
+/** @brief Prefijo en claro de la carga sellada: lo que el receptor necesita para rehacer el nonce */
+typedef struct __attribute__((packed)) {
+  uint32_t boot;      /**< Contador de arranques */
+  uint32_t counter;   /**< Trama sellada dentro del arranque */
+} telem_auth_prefix_t;
+
+/** @brief Bytes que el sellado añade a la carga útil */
+#define TELEM_AUTH_OVERHEAD (sizeof(telem_auth_prefix_t) + TELEM_AUTH_TAG_SIZE)
+
+/** @brief Estadísticas del sellado */
+typedef struct {
+  uint32_t boot;       /**< Arranque en curso (0 si no se pudo reservar) */
+  uint32_t sealed;     /**< Nonces consumidos en este arranque (también los de sellados fallidos) */
+  uint32_t failures;   /**< Tramas que no se pudieron sellar y no se enviaron */
+} telemetry_auth_stats_t;
+
+/**
+ * @brief Carga la clave y reserva el número de este arranque
+ *
+ * @return true Si la clave se cargó en mbedtls y el arranque quedó reservado
+ * en NVS; si no, telemetry_frame_seal() rechaza todas las tramas
+ */
+bool telemetry_auth_init(void);
+
+/**
+ * @brief Indica si hay clave y nonces disponibles para sellar
+ */
+bool telemetry_auth_ready(void);
+
+/**
+ * @brief Obtiene las estadísticas del sellado
+ */
+void telemetry_auth_get_stats(telemetry_auth_stats_t* stats);
+
+/**
+ * @brief Cifra y autentica en su sitio la carga útil de una trama terminada
+ *
+ * @param frame Trama completa (comprimida o no)
+ * @return true Si la trama queda sellada
+ * @return false Si no hay clave, se agotaron los nonces o falló el cifrado;
+ * el fallo se contabiliza y la trama no debe enviarse
+ *
+ * @details Usa los TELEM_AUTH_OVERHEAD bytes que telemetry_frame_begin()
+ * reserva al final del buffer con `TELEM_DOWNLINK_AUTH` definido. Cada
+ * llamada consume un nonce, también si el cifrado falla.
+ */
+bool telemetry_frame_seal(telemetry_frame_t* frame);
+
+/**
+ * @brief Verifica y descifra en su sitio una trama sellada
+ *
+ * @param data Trama completa (encabezado incluido)
+ * @param length Bytes de la trama
+ * @return size_t Bytes de la carga útil descifrada, que queda tras el
+ * encabezado, o 0 si la trama no es auténtica
+ */
+size_t telemetry_frame_open(uint8_t* data, size_t length);
+
+/**
+ * @brief Mide ciclos por byte del sellado por trama frente al sellado por paquete
+ *
+ * @details Se ejecuta desde setup() con `TELEM_AUTH_BENCHMARK` definido.
+ * Indica si mbedtls usa el AES hardware (CONFIG_MBEDTLS_HARDWARE_AES) o la
+ * implementación software.
+ */
+void telemetry_auth_benchmark(void);
+
+#endif // TELEMETRY_AUTH_H
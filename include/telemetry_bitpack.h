@@ -0,0 +1,81 @@
+/**
+ * @file telemetry_bitpack.h
+ * @brief Empaquetado de paquetes de telemetría al ancho exacto de cada campo
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Muchos campos usan muchos menos bits que su tipo (system_mode 0-3,
+ * priority 0-2, battery_level 0-100, los bytes de estado...). Cada estructura
+ * de telemetry_types.h declara junto a ella el rango válido de sus campos en
+ * una tabla X-macro (p. ej. TELEM_POWER_FIELDS). A partir de esas tablas se
+ * generan en tiempo de compilación el empaquetador, el desempaquetador y el
+ * tamaño de cada tipo:
+ *
+ * - Un campo con rango [min, max] ocupa ceil(log2(max - min + 1)) bits y se
+ *   guarda como valor - min.
+ * - Los floats se transmiten con sus 32 bits.
+ * - Los bits se acumulan en una palabra de 64 bits y se escriben 32 bits de
+ *   una vez (little-endian), sin bucles bit a bit.
+ *
+ * Formato: encabezado empaquetado seguido de la carga útil del tipo. Un
+ * registro de housekeeping lleva tras el encabezado un bit de presencia por
+ * tipo simple y después las cargas presentes en orden de tipo. El resultado
+ * es autodelimitado: el tipo (y la presencia) determinan su longitud. Los
+ * tipos propios (TELEM_TYPE_COUNT..TELEM_TYPE_MAX) no tienen tabla de rangos:
+ * tras el encabezado empaquetado llevan su carga útil en bruto, todos los
+ * bytes de telemetry_packet_t que siguen a telem_header_t.
+ *
+ * @note Los valores fuera de rango se saturan al extremo más cercano y se
+ * cuentan en telemetry_bitpack_clamped().
+ */
+
+#ifndef TELEMETRY_BITPACK_H
+#define TELEMETRY_BITPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_types.h"
+
+/**
+ * @brief Tamaño empaquetado de un paquete
+ *
+ * @param packet Paquete de telemetría
+ * @return size_t Bytes que ocupará empaquetado, o 0 si el tipo no es válido
+ */
+size_t telemetry_bitpack_size(const telemetry_packet_t* packet);
+
+/**
+ * @brief Empaqueta un paquete al ancho exacto de sus campos
+ *
+ * @param packet Paquete a empaquetar
+ * @param[out] out Buffer de salida
+ * @param capacity Capacidad del buffer
+ * @return size_t Bytes escritos, o 0 si el tipo no es válido o no cabe
+ */
+size_t telemetry_bitpack_encode(const telemetry_packet_t* packet, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Desempaqueta un paquete
+ *
+ * @param in Datos empaquetados
+ * @param length Bytes disponibles en in
+ * @param[out] packet Paquete reconstruido
+ * @return size_t Bytes consumidos, o 0 si los datos no son válidos
+ */
+size_t telemetry_bitpack_decode(const uint8_t* in, size_t length, telemetry_packet_t* packet);
+
+/**
+ * @brief Número de valores saturados por estar fuera de su rango declarado
+ */
+uint32_t telemetry_bitpack_clamped(void);
+
+/**
+ * @brief Mide el coste de empaquetar y desempaquetar cada tipo y lo registra en el log
+ *
+ * @details Se ejecuta desde setup() con `TELEM_BITPACK_BENCHMARK` definido.
+ */
+void telemetry_bitpack_benchmark(void);
+
+#endif // TELEMETRY_BITPACK_H
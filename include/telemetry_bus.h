@@ -0,0 +1,196 @@
+/**
+ * @file telemetry_bus.h
+ * @brief Gestor asíncrono de los buses I2C/SPI de sensores
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Los sensores reales de potencia y temperatura compartirán buses I2C y SPI.
+ * Si cada generador hiciera lecturas bloqueantes, todo el ciclo esperaría en
+ * serie al dispositivo más lento. En su lugar cada bus tiene una tarea
+ * propietaria que recibe descriptores de transacción por una cola:
+ *
+ * - El solicitante encola todas las transacciones del ciclo y sigue
+ *   trabajando; los buses avanzan en paralelo entre sí.
+ * - La tarea del bus vacía su cola de una vez y ejecuta las transacciones
+ *   seguidas. Mientras el controlador transfiere (DMA o interrupción) la
+ *   tarea duerme hasta que telemetry_bus_complete() la despierta.
+ * - Cada transacción termina con su callback y/o una notificación a la tarea
+ *   que la pidió (telemetry_bus_wait()).
+ * - Cada transferencia lleva un identificador que el controlador devuelve al
+ *   terminar: una finalización tardía de una transacción ya dada por perdida
+ *   se descarta en lugar de completar la siguiente.
+ *
+ * El barrido de sensores (telemetry_sensors.h) lee por aquí las entradas que
+ * cuelgan de un bus mientras convierte las del ADC.
+ *
+ * Mientras no haya hardware en el árbol, cada bus usa un controlador simulado
+ * con la latencia de cada dispositivo declarada en TELEM_BUS_MOCK_DEVICES; la
+ * finalización la da un esp_timer, igual que la daría la interrupción real.
+ */
+
+#ifndef TELEMETRY_BUS_H
+#define TELEMETRY_BUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/** @brief Transacciones en cola por bus */
+#ifndef TELEM_BUS_QUEUE_LENGTH
+#define TELEM_BUS_QUEUE_LENGTH 16
+#endif
+
+/** @brief Tiempo máximo de una transacción antes de darla por perdida (ms) */
+#ifndef TELEM_BUS_TIMEOUT_MS
+#define TELEM_BUS_TIMEOUT_MS 20
+#endif
+
+/** @brief Prioridad de las tareas de bus (por encima del recolector: casi siempre están bloqueadas) */
+#ifndef TELEM_BUS_TASK_PRIORITY
+#define TELEM_BUS_TASK_PRIORITY 3
+#endif
+
+/** @brief Buses gestionados */
+typedef enum {
+  TELEM_BUS_I2C0 = 0,       /**< I2C de monitores de potencia y sensores de temperatura */
+  TELEM_BUS_SPI2,           /**< SPI (HSPI) del ADC de termistores */
+  TELEM_BUS_COUNT
+} telem_bus_id_t;
+
+/**
+ * @brief Dispositivos simulados: DEVICE(bus, dirección, latencia en µs, registro)
+ *
+ * @details Latencias típicas de una lectura completa de cada dispositivo. Las
+ * lecturas devuelven el valor de registro de 16 bits (big-endian, como los
+ * monitores I2C) repetido; el del monitor de batería equivale a 0.1 A.
+ */
+#ifndef TELEM_BUS_MOCK_DEVICES
+#define TELEM_BUS_MOCK_DEVICES(DEVICE) \
+  DEVICE(TELEM_BUS_I2C0, 0x40, 600, 1000)    /* Monitor de potencia de la batería */ \
+  DEVICE(TELEM_BUS_I2C0, 0x41, 600, 1000)    /* Monitor de potencia de los paneles */ \
+  DEVICE(TELEM_BUS_I2C0, 0x48, 400, 0x2300)  /* Temperatura del OBC */ \
+  DEVICE(TELEM_BUS_I2C0, 0x49, 400, 0x1C00)  /* Temperatura de comunicaciones */ \
+  DEVICE(TELEM_BUS_SPI2, 0, 900, 0x0800)     /* ADC de termistores (payload, batería, exterior) */ \
+  DEVICE(TELEM_BUS_SPI2, 1, 300, 0x0800)     /* ADC de tensiones de paneles */
+#endif
+
+/** @brief Estado de una transacción */
+typedef enum {
+  TELEM_BUS_PENDING = 0,    /**< En cola o en curso */
+  TELEM_BUS_OK,             /**< Completada */
+  TELEM_BUS_ERROR,          /**< El controlador informó de un error */
+  TELEM_BUS_TIMEOUT         /**< Sin finalización en TELEM_BUS_TIMEOUT_MS */
+} telem_bus_status_t;
+
+typedef struct telemetry_bus_txn telemetry_bus_txn_t;
+
+/** @brief Callback de finalización (se ejecuta en la tarea del bus) */
+typedef void (*telemetry_bus_callback_t)(telemetry_bus_txn_t* txn);
+
+/** @brief Descriptor de transacción; debe seguir vivo hasta su finalización */
+struct telemetry_bus_txn {
+  uint8_t bus;                        /**< telem_bus_id_t */
+  uint8_t device;                     /**< Dirección I2C o línea CS de SPI */
+  uint8_t reg;                        /**< Registro inicial */
+  bool write;                         /**< true = escritura, false = lectura */
+  uint8_t* data;                      /**< Datos a escribir o buffer de lectura */
+  uint16_t length;                    /**< Bytes de data */
+  telemetry_bus_callback_t callback;  /**< Callback opcional */
+  void* arg;                          /**< Argumento libre para el callback */
+  TaskHandle_t notify;                /**< Tarea a notificar al terminar (NULL = ninguna) */
+  uint32_t id;                        /**< Identificador de la transferencia (lo asigna la tarea del bus) */
+  volatile telem_bus_status_t status; /**< Estado (lo escribe la tarea del bus) */
+  int64_t queued_us;                  /**< Instante de encolado */
+  int64_t completed_us;               /**< Instante de finalización */
+};
+
+/**
+ * @brief Inicia una transferencia en el controlador del bus
+ *
+ * @return true Si la transferencia arrancó; su fin se señala con
+ * telemetry_bus_complete() pasando txn->id
+ */
+typedef bool (*telemetry_bus_driver_t)(telemetry_bus_txn_t* txn);
+
+/** @brief Estadísticas de un bus */
+typedef struct {
+  uint32_t transactions;      /**< Transacciones completadas */
+  uint32_t batches;           /**< Veces que la tarea vació su cola */
+  uint32_t max_batch;         /**< Mayor número de transacciones seguidas */
+  uint32_t errors;            /**< Errores y timeouts */
+  uint32_t queue_full;        /**< Envíos rechazados por cola llena */
+  uint32_t stale;             /**< Finalizaciones tardías descartadas */
+  uint64_t busy_us;           /**< Tiempo total ocupado en transferencias */
+} telemetry_bus_stats_t;
+
+/** @brief Resultado de telemetry_bus_benchmark() */
+typedef struct {
+  uint32_t devices;           /**< Dispositivos leídos por ciclo */
+  uint32_t device_sum_us;     /**< Suma de las latencias de los dispositivos */
+  uint32_t blocking_us;       /**< Ciclo con lecturas bloqueantes una a una */
+  uint32_t queued_us;         /**< Ciclo con todas las lecturas en cola a la vez */
+} telemetry_bus_benchmark_t;
+
+/**
+ * @brief Crea la cola y la tarea de cada bus con el controlador simulado
+ *
+ * @return true Si todos los buses quedaron operativos
+ *
+ * @details Se llama desde setup() antes de crear las tareas de telemetría.
+ */
+bool telemetry_bus_init(void);
+
+/**
+ * @brief Sustituye el controlador de un bus (p. ej. por el de I2C/SPI real)
+ */
+void telemetry_bus_set_driver(telem_bus_id_t bus, telemetry_bus_driver_t driver);
+
+/**
+ * @brief Encola una transacción sin bloquear
+ *
+ * @param txn Descriptor (bus, dispositivo, datos y forma de aviso rellenos)
+ * @return true Si quedó en cola
+ */
+bool telemetry_bus_submit(telemetry_bus_txn_t* txn);
+
+/**
+ * @brief Espera las notificaciones de finalización de la tarea actual
+ *
+ * @param count Transacciones pedidas con notify = tarea actual
+ * @param timeout_ms Espera máxima total
+ * @return uint32_t Finalizaciones recibidas
+ */
+uint32_t telemetry_bus_wait(uint32_t count, uint32_t timeout_ms);
+
+/**
+ * @brief Señala el fin de la transferencia en curso de un bus
+ *
+ * @param bus Bus cuya transferencia terminó
+ * @param id Identificador de la transacción que recibió el controlador
+ * @param ok Resultado del controlador
+ *
+ * @details Se puede llamar desde una ISR o desde una tarea. Si la
+ * transacción ya no está en curso (se dio por perdida) la finalización se
+ * descarta y se cuenta en stale.
+ */
+void telemetry_bus_complete(telem_bus_id_t bus, uint32_t id, bool ok);
+
+/**
+ * @brief Obtiene las estadísticas de un bus
+ */
+void telemetry_bus_get_stats(telem_bus_id_t bus, telemetry_bus_stats_t* stats);
+
+/**
+ * @brief Compara el tiempo de adquisición de un ciclo con lecturas bloqueantes y en cola
+ *
+ * @param result Cifras medidas (puede ser NULL)
+ * @return true Si todas las lecturas terminaron bien
+ *
+ * @details Se ejecuta desde setup() con `TELEM_BUS_BENCHMARK` definido y lee
+ * una vez cada dispositivo de TELEM_BUS_MOCK_DEVICES por ciclo.
+ */
+bool telemetry_bus_benchmark(telemetry_bus_benchmark_t* result);
+
+#endif // TELEMETRY_BUS_H
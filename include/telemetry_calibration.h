@@ -0,0 +1,190 @@
+/**
+ * @file telemetry_calibration.h
+ * @brief Calibración en punto fijo de las cuentas ADC de los sensores
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Cada canal calibrado tiene una tabla de coeficientes que convierte cuentas
+ * ADC brutas en unidades de ingeniería (°C, V, A) sin coma flotante:
+ *
+ * - Polinomio (TELEM_CAL_KIND_POLYNOMIAL): hasta TELEM_CAL_MAX_COEFFS
+ *   coeficientes Q16.16 sobre u = cuenta / 2^TELEM_CAL_ADC_BITS (0 <= u < 1),
+ *   evaluado por Horner con acumulador de 64 bits. Normalizar la entrada
+ *   mantiene todos los coeficientes en el mismo rango, sea cual sea el grado.
+ * - Tabla (TELEM_CAL_KIND_LUT): TELEM_CAL_LUT_POINTS valores Q16.16 en
+ *   cuentas equiespaciadas con paso potencia de dos e interpolación lineal.
+ *   El segmento sale de un desplazamiento, sin búsqueda ni divisiones.
+ *
+ * La entrada de cada canal es un valor de 12 bits: cuentas ADC brutas para
+ * el NTC (la tabla ya absorbe la no linealidad del ADC) y milivoltios del
+ * pin para la batería, que analogReadMilliVolts() corrige con la
+ * calibración de fábrica del eFuse. La tabla de la batería solo tiene que
+ * deshacer el divisor y su tolerancia.
+ *
+ * Las tablas se pueden sustituir desde tierra con
+ * telemetry_calibration_update(): se validan, se activan sin detener la
+ * adquisición y se guardan en LittleFS para el siguiente arranque. Las
+ * subidas llegan como fichero (TELEM_CAL_UPLOAD_FILE) y las aplica
+ * telemetry_calibration_poll_upload(). Las conversiones se hacen por bloques
+ * (telemetry_calibrate_block()), que resuelven la tabla y su tipo una vez
+ * por bloque y no por muestra.
+ */
+
+#ifndef TELEMETRY_CALIBRATION_H
+#define TELEMETRY_CALIBRATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Resolución del ADC en bits */
+#define TELEM_CAL_ADC_BITS 12
+
+/**
+ * @brief log2 del número de segmentos de las tablas
+ *
+ * @details Con 64 segmentos la tabla del NTC se desvía menos de 1 °C de la
+ * ecuación beta entre -40 y 125 °C; con 32 llega a casi 8 °C en los extremos.
+ */
+#ifndef TELEM_CAL_LUT_SEGMENT_BITS
+#define TELEM_CAL_LUT_SEGMENT_BITS 6
+#endif
+
+/** @brief Puntos de una tabla (segmentos + 1) */
+#define TELEM_CAL_LUT_POINTS ((1 << TELEM_CAL_LUT_SEGMENT_BITS) + 1)
+
+/** @brief Coeficientes máximos de un polinomio (grado 4) */
+#define TELEM_CAL_MAX_COEFFS 5
+
+/** @brief Fichero con las tablas recibidas desde tierra */
+#ifndef TELEM_CAL_FILE
+#define TELEM_CAL_FILE "/calibration.bin"
+#endif
+
+/** @brief Fichero de subida desde tierra (un telemetry_calibration_upload_t) */
+#ifndef TELEM_CAL_UPLOAD_FILE
+#define TELEM_CAL_UPLOAD_FILE "/calibration_upload.bin"
+#endif
+
+/** @brief Espera máxima de una actualización a que un lector suelte el búfer inactivo */
+#ifndef TELEM_CAL_UPDATE_TIMEOUT_MS
+#define TELEM_CAL_UPDATE_TIMEOUT_MS 100
+#endif
+
+/** @brief Uno en Q16.16 */
+#define TELEM_Q16_ONE 65536
+
+/** @brief Convierte un valor Q16.16 a float (solo para el marco de muestras y los informes) */
+#define TELEM_Q16_TO_FLOAT(q) ((float)(q) * (1.0f / TELEM_Q16_ONE))
+
+/** @brief Canales calibrados: CHANNEL(nombre) */
+#define TELEM_CAL_CHANNELS(CHANNEL) \
+  CHANNEL(NTC_TEMPERATURE)  /* °C del NTC de 10 kΩ, desde cuentas ADC */ \
+  CHANNEL(BATTERY_VOLTAGE)  /* V de batería, desde los mV del pin tras el divisor */
+
+#define TELEM_CAL_ENUM_CHANNEL(name) TELEM_CAL_##name,
+
+/** @brief Canales calibrados */
+typedef enum {
+  TELEM_CAL_CHANNELS(TELEM_CAL_ENUM_CHANNEL)
+  TELEM_CAL_CHANNEL_COUNT
+} telem_cal_channel_t;
+
+/** @brief Tipo de conversión de una tabla */
+typedef enum {
+  TELEM_CAL_KIND_POLYNOMIAL = 0,  /**< value[0..count-1] = c0..c(n-1) */
+  TELEM_CAL_KIND_LUT              /**< value[i] = salida en cuenta i << (ADC_BITS - SEGMENT_BITS) */
+} telem_cal_kind_t;
+
+/** @brief Tabla de calibración de un canal (también el formato de subida) */
+typedef struct {
+  uint8_t kind;                               /**< telem_cal_kind_t */
+  uint8_t count;                              /**< Coeficientes o puntos usados */
+  uint16_t version;                           /**< Versión asignada en tierra (0 = por defecto) */
+  int32_t value[TELEM_CAL_LUT_POINTS];        /**< Coeficientes o puntos Q16.16 */
+} telemetry_calibration_t;
+
+/** @brief Subida de una tabla desde tierra, tal como llega en TELEM_CAL_UPLOAD_FILE */
+typedef struct {
+  uint32_t magic;                             /**< TELEM_RETENTION_MAGIC */
+  uint32_t channel;                           /**< telem_cal_channel_t */
+  telemetry_calibration_t table;
+  uint32_t crc;                               /**< CRC32 de los campos anteriores */
+} telemetry_calibration_upload_t;
+
+/**
+ * @brief Carga las tablas guardadas o, si no hay ninguna válida, las de por defecto
+ *
+ * @details Requiere LittleFS montado (telemetry_logger_init()) y debe
+ * llamarse antes de crear las tareas.
+ *
+ * @return true Si se recuperaron tablas subidas desde tierra
+ */
+bool telemetry_calibration_init(void);
+
+/**
+ * @brief Convierte un bloque de cuentas de un mismo canal
+ *
+ * @param channel Canal calibrado
+ * @param raw Cuentas ADC (se saturan a 2^TELEM_CAL_ADC_BITS - 1)
+ * @param out Valores Q16.16
+ * @param count Número de muestras
+ */
+void telemetry_calibrate_block(telem_cal_channel_t channel, const uint16_t* raw, int32_t* out, size_t count);
+
+/**
+ * @brief Convierte una sola cuenta
+ *
+ * @return int32_t Valor Q16.16
+ */
+int32_t telemetry_calibrate(telem_cal_channel_t channel, uint16_t raw);
+
+/**
+ * @brief Sustituye la tabla de un canal (subida desde tierra)
+ *
+ * @param channel Canal calibrado
+ * @param table Tabla nueva
+ * @return true Si la tabla es válida, está activa y quedó guardada
+ *
+ * @details La tabla nueva se escribe en el búfer inactivo del canal y se
+ * activa con un único cambio de índice, así que una conversión en curso
+ * termina con la tabla anterior. Cada búfer lleva la cuenta de sus lectores:
+ * antes de reescribir el inactivo se espera (hasta
+ * TELEM_CAL_UPDATE_TIMEOUT_MS) a que lo suelte quien aún convierta con él,
+ * de modo que dos actualizaciones seguidas no pisan una tabla en uso. Las
+ * actualizaciones se serializan entre sí.
+ *
+ * Se rechazan polinomios cuya suma de coeficientes en valor absoluto no
+ * quepa en 32 bits (la evaluación no puede desbordar) y tablas con un número
+ * de puntos distinto de TELEM_CAL_LUT_POINTS.
+ */
+bool telemetry_calibration_update(telem_cal_channel_t channel, const telemetry_calibration_t* table);
+
+/**
+ * @brief Aplica la subida pendiente en TELEM_CAL_UPLOAD_FILE, si la hay
+ *
+ * @return true Si había una subida válida y se aplicó
+ *
+ * @details Lo llama periódicamente el trabajador de mantenimiento. El fichero
+ * se borra siempre tras leerlo, también si está incompleto, tiene el CRC mal
+ * o la tabla se rechaza, para no reintentarlo en cada pasada.
+ */
+bool telemetry_calibration_poll_upload(void);
+
+/**
+ * @brief Copia la tabla activa de un canal
+ */
+void telemetry_calibration_get(telem_cal_channel_t channel, telemetry_calibration_t* table);
+
+/**
+ * @brief Compara la calibración en punto fijo con la misma tabla en doble precisión
+ *
+ * @details Se ejecuta desde setup() con `TELEM_CALIBRATION_BENCHMARK`
+ * definido. Para cada canal recorre las 2^TELEM_CAL_ADC_BITS cuentas por
+ * bloques e informa del error máximo y de los ciclos por muestra, y los
+ * compara con la ecuación beta en coma flotante que sustituye la tabla del NTC.
+ */
+void telemetry_calibration_benchmark(void);
+
+#endif // TELEMETRY_CALIBRATION_H
@@ -0,0 +1,153 @@
+/**
+ * @file telemetry_coroutine.h
+ * @brief Corrutinas sin pila (estilo protothread) para las tareas de telemetría
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Una corrutina es una función que se reanuda en el punto de su última
+ * espera: TELEM_CO_BEGIN abre un switch sobre la línea guardada y cada espera
+ * guarda su __LINE__ y retorna. No tiene pila propia, así que varias
+ * corrutinas pueden compartir una única tarea de FreeRTOS.
+ *
+ * Reglas dentro del cuerpo:
+ * - Las variables que deban sobrevivir a una espera son `static` (cada
+ *   corrutina tiene una sola instancia) y las que no, se declaran en un
+ *   bloque que termine antes de la espera.
+ * - No se puede usar `switch` alrededor de una espera ni poner dos esperas
+ *   en la misma línea.
+ * - Nada de bloqueos largos: mientras el cuerpo se ejecuta, el resto de
+ *   corrutinas de la tarea no avanza.
+ *
+ * Las esperas son por tiempo (TELEM_CO_SLEEP) o por señal con plazo opcional
+ * (TELEM_CO_AWAIT_SIGNAL). telemetry_co_signal() se puede llamar desde
+ * cualquier tarea, por ejemplo desde un callback del servicio de
+ * temporizadores, y despierta a la tarea que ejecuta la corrutina; desde una
+ * ISR se usa telemetry_co_signal_from_isr().
+ */
+
+#ifndef TELEMETRY_COROUTINE_H
+#define TELEMETRY_COROUTINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/** @brief Plazo infinito en TELEM_CO_AWAIT_SIGNAL */
+#define TELEM_CO_FOREVER UINT32_MAX
+
+/** @brief Motivo por el que una corrutina está detenida */
+typedef enum {
+  TELEM_CO_READY = 0,         /**< Lista para reanudarse */
+  TELEM_CO_WAIT_TIME,         /**< Hasta el plazo */
+  TELEM_CO_WAIT_SIGNAL        /**< Hasta una señal o el plazo */
+} telem_co_wait_t;
+
+typedef struct telemetry_co telemetry_co_t;
+
+/** @brief Cuerpo de una corrutina */
+typedef void (*telemetry_co_body_t)(telemetry_co_t* co);
+
+/** @brief Estado de una corrutina; lo reserva quien la usa */
+struct telemetry_co {
+  telemetry_co_body_t body;
+  const char* name;
+  TaskHandle_t task;          /**< Tarea que la ejecuta: destino de las notificaciones */
+  uint16_t resume_line;       /**< Punto de reanudación (0 = inicio) */
+  uint8_t wait;               /**< telem_co_wait_t */
+  bool forever;               /**< La espera no tiene plazo */
+  bool signaled;              /**< La última espera terminó por una señal */
+  TickType_t deadline;
+  volatile uint32_t signals;  /**< Señales pendientes */
+  uint32_t resumes;           /**< Reanudaciones */
+  uint32_t max_run_us;        /**< Reanudación más larga */
+};
+
+/** @brief Inicializador estático: lista para empezar desde el principio */
+#define TELEM_CO_INITIALIZER(name, body) \
+  { (body), (name), NULL, 0, TELEM_CO_READY, false, false, 0, 0, 0, 0 }
+
+/** @brief Abre el cuerpo de la corrutina */
+#define TELEM_CO_BEGIN(co) switch((co)->resume_line) { case 0:
+
+/** @brief Cierra el cuerpo; si se llega aquí, la corrutina vuelve a empezar */
+#define TELEM_CO_END(co) } (co)->resume_line = 0
+
+/** @brief Guarda el punto de reanudación y devuelve el control */
+#define TELEM_CO_SUSPEND(co) (co)->resume_line = __LINE__; return; case __LINE__:
+
+/** @brief Cede el turno a las demás corrutinas de la tarea */
+#define TELEM_CO_YIELD(co) \
+  do { telemetry_co_wait((co), TELEM_CO_READY, 0); TELEM_CO_SUSPEND(co); } while(0)
+
+/** @brief Duerme ms milisegundos (las señales quedan pendientes) */
+#define TELEM_CO_SLEEP(co, ms) \
+  do { telemetry_co_wait((co), TELEM_CO_WAIT_TIME, (ms)); TELEM_CO_SUSPEND(co); } while(0)
+
+/** @brief Espera una señal como mucho timeout_ms; (co)->signaled dice cuál de las dos llegó */
+#define TELEM_CO_AWAIT_SIGNAL(co, timeout_ms) \
+  do { telemetry_co_wait((co), TELEM_CO_WAIT_SIGNAL, (timeout_ms)); TELEM_CO_SUSPEND(co); } while(0)
+
+/** @brief Resultado de telemetry_co_benchmark() */
+typedef struct {
+  uint32_t task_switch_ns;      /**< Cambio de contexto entre dos tareas (ns) */
+  uint32_t co_switch_ns;        /**< Cambio entre dos corrutinas de una tarea (ns) */
+  uint32_t task_heap_bytes;     /**< Heap de una tarea con la pila de las de telemetría (pila y TCB) */
+  uint32_t co_state_bytes;      /**< Estado de una corrutina (sizeof(telemetry_co_t)) */
+} telemetry_co_benchmark_t;
+
+/**
+ * @brief Prepara una corrutina para empezar desde el principio
+ */
+void telemetry_co_init(telemetry_co_t* co, const char* name, telemetry_co_body_t body);
+
+/**
+ * @brief Anota la espera con la que se va a suspender (lo usan las macros)
+ */
+void telemetry_co_wait(telemetry_co_t* co, telem_co_wait_t wait, uint32_t timeout_ms);
+
+/**
+ * @brief Envía una señal a una corrutina (desde cualquier tarea, no desde ISR)
+ */
+void telemetry_co_signal(telemetry_co_t* co);
+
+/**
+ * @brief Envía una señal a una corrutina desde una ISR
+ *
+ * @param woken Se pone a pdTRUE si hay que ceder la CPU al salir de la ISR
+ */
+void telemetry_co_signal_from_isr(telemetry_co_t* co, BaseType_t* woken);
+
+/**
+ * @brief Comprueba si una corrutina puede reanudarse
+ *
+ * @return TickType_t 0 si está lista; si no, ticks hasta su plazo
+ * (portMAX_DELAY si solo espera una señal)
+ *
+ * @details Una corrutina que pasa a estar lista sigue lista hasta que se
+ * reanuda; las señales pendientes se consumen en ese momento.
+ */
+TickType_t telemetry_co_poll(telemetry_co_t* co);
+
+/**
+ * @brief Ejecuta el cuerpo hasta su siguiente espera
+ */
+void telemetry_co_resume(telemetry_co_t* co);
+
+/**
+ * @brief Mide el cambio de contexto entre tareas frente al de corrutinas
+ *
+ * @param result Cifras medidas (puede ser NULL)
+ * @return true Si se pudo crear la tarea auxiliar
+ *
+ * @details Se ejecuta desde setup() con `TELEM_COROUTINE_BENCHMARK` definido.
+ * Hace ping-pong con notificaciones entre dos tareas y con señales entre dos
+ * corrutinas de una misma tarea, y mide lo que cuesta en heap una tarea con
+ * la pila de las de telemetría: el modo cooperativo ahorra dos de ellas.
+ * Los cambios se miden en ciclos de CPU y se entregan en nanosegundos
+ * (ciclos * 1000 / MHz de la CPU).
+ */
+bool telemetry_co_benchmark(telemetry_co_benchmark_t* result);
+
+#endif // TELEMETRY_COROUTINE_H
@@ -0,0 +1,105 @@
+/**
+ * @file telemetry_downlink.h
+ * @brief Tramas de bajada que agrupan varios paquetes de telemetría
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Durante una ventana de contacto el transmisor agrupa los paquetes en tramas
+ * con un encabezado común. Cada paquete se copia con su tamaño real (según su
+ * tipo) en lugar de los 64 bytes de la unión telemetry_packet_t.
+ *
+ * Formato de trama:
+ * | telem_frame_header_t | paquete 0 | paquete 1 | ... |
+ *
+ * Con `TELEM_DOWNLINK_BITPACK` definido los paquetes se empaquetan al ancho
+ * exacto de sus campos y la trama lleva TELEM_FRAME_FLAG_BITPACK.
+ *
+ * Con `TELEM_DOWNLINK_AUTH` definido telemetry_frame_begin() reserva al final
+ * del buffer el espacio que añade el sellado AES-GCM (telemetry_auth.h).
+ */
+
+#ifndef TELEMETRY_DOWNLINK_H
+#define TELEMETRY_DOWNLINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_types.h"
+
+/** @brief Palabra de sincronización de trama (ASM corto CCSDS) */
+#define TELEM_FRAME_SYNC 0x1ACF
+
+/** @brief Carga útil máxima por trama en bytes */
+#ifndef TELEM_FRAME_MAX_PAYLOAD
+#define TELEM_FRAME_MAX_PAYLOAD 1024
+#endif
+
+/** @brief Tramas retenidas para retransmisión durante una misma pasada */
+#ifndef TELEM_FRAMES_PER_PASS
+#define TELEM_FRAMES_PER_PASS 8
+#endif
+
+/** @brief Bit de flags: los paquetes de la trama van empaquetados al ancho de sus campos (telemetry_bitpack.h) */
+#define TELEM_FRAME_FLAG_BITPACK 0x01
+
+/** @brief Encabezado de trama de bajada */
+typedef struct __attribute__((packed)) {
+  uint16_t sync;            /**< TELEM_FRAME_SYNC */
+  uint16_t frame_sequence;  /**< Número de secuencia de la trama */
+  uint8_t packet_count;     /**< Paquetes contenidos */
+  uint8_t flags;            /**< Reservado para codificaciones de la trama */
+  uint16_t payload_length;  /**< Bytes de carga útil tras el encabezado */
+} telem_frame_header_t;
+
+/** @brief Trama en construcción sobre un buffer externo */
+typedef struct {
+  uint8_t* data;            /**< Buffer de la trama (encabezado + carga útil) */
+  size_t capacity;          /**< Capacidad total del buffer */
+  size_t length;            /**< Bytes ocupados (incluye el encabezado) */
+} telemetry_frame_t;
+
+/**
+ * @brief Tamaño real de un paquete según su tipo
+ *
+ * @param packet Paquete de telemetría
+ * @return size_t Bytes significativos del paquete (encabezado incluido)
+ */
+size_t telemetry_packet_wire_size(const telemetry_packet_t* packet);
+
+/**
+ * @brief Inicia una trama vacía
+ *
+ * @param frame Trama a inicializar
+ * @param buffer Memoria para la trama (p. ej. de la arena de pasada)
+ * @param capacity Tamaño de buffer, al menos sizeof(telem_frame_header_t)
+ *                 (más TELEM_AUTH_OVERHEAD con `TELEM_DOWNLINK_AUTH`)
+ * @param frame_sequence Número de secuencia de la trama
+ */
+void telemetry_frame_begin(telemetry_frame_t* frame, uint8_t* buffer, size_t capacity,
+                           uint16_t frame_sequence);
+
+/**
+ * @brief Añade un paquete a la trama
+ *
+ * @param frame Trama en construcción
+ * @param packet Paquete a añadir
+ * @return true Si el paquete cabía en la trama
+ * @return false Si la trama está llena
+ */
+bool telemetry_frame_add_packet(telemetry_frame_t* frame, const telemetry_packet_t* packet);
+
+/**
+ * @brief Indica si la trama admite otro paquete de tamaño máximo
+ *
+ * @param frame Trama en construcción
+ * @return true Si queda espacio para cualquier tipo de paquete
+ */
+bool telemetry_frame_has_room(const telemetry_frame_t* frame);
+
+/**
+ * @brief Devuelve el encabezado de la trama
+ */
+telem_frame_header_t* telemetry_frame_header(const telemetry_frame_t* frame);
+
+#endif // TELEMETRY_DOWNLINK_H
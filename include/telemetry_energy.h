@@ -0,0 +1,184 @@
+/**
+ * @file telemetry_energy.h
+ * @brief Contabilidad de energía por etapa del sistema de telemetría
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Estima qué parte del presupuesto de potencia consume la propia telemetría.
+ * Cada etapa (recolector, procesador, transmisor y sistema) acumula tiempo de
+ * CPU, bytes escritos en flash y bytes enviados por UART; junto con el tiempo
+ * en deep sleep, un modelo de costes configurable convierte esos contadores
+ * en energía por etapa y por paquete.
+ *
+ * El tiempo de CPU sale de las estadísticas de ejecución de FreeRTOS
+ * (uxTaskGetSystemState(), contador en µs de esp_timer), no de restar
+ * instantes de reloj: no se imputa a una etapa el tiempo en que otra tarea
+ * la ha expulsado. Al pedir el informe se toma la diferencia del contador de
+ * cada tarea desde el informe anterior; las tareas IDLE no cuentan y las no
+ * registradas van a TELEM_STAGE_SYSTEM. Si varias etapas comparten una tarea
+ * (modo cooperativo), su CPU se reparte en proporción al tiempo activo que
+ * cada etapa declara con telemetry_energy_add_active().
+ *
+ * Sin `configGENERATE_RUN_TIME_STATS` y `configUSE_TRACE_FACILITY` se vuelve
+ * al tiempo activo declarado, que incluye las expulsiones.
+ *
+ * La misma función de estimación sirve para comparar opciones de codificación
+ * antes de elegirlas (p. ej. gastar CPU en comprimir frente a enviar más bytes).
+ */
+
+#ifndef TELEMETRY_ENERGY_H
+#define TELEMETRY_ENERGY_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * @brief Tareas que se siguen entre informes
+ *
+ * @note Los contadores de FreeRTOS son de 32 bits en µs y dan la vuelta cada
+ * ~71 minutos: hay que pedir el informe con más frecuencia (el estado general
+ * lo hace cada 30 s).
+ */
+#ifndef TELEM_ENERGY_MAX_TASKS
+#define TELEM_ENERGY_MAX_TASKS 24
+#endif
+
+/** @brief Etapas del pipeline a las que se imputa el consumo */
+typedef enum {
+  TELEM_STAGE_COLLECTOR = 0,   /**< Tarea recolectora y generadores */
+  TELEM_STAGE_PROCESSOR,       /**< Tarea procesadora */
+  TELEM_STAGE_TRANSMITTER,     /**< Tarea transmisora */
+  TELEM_STAGE_SYSTEM,          /**< setup(), loop() y tareas no registradas */
+  TELEM_STAGE_COUNT
+} telem_energy_stage_t;
+
+/**
+ * @brief Modelo de costes energéticos
+ *
+ * @note 1 mW de potencia activa equivale a 1 nJ por µs de CPU.
+ */
+typedef struct {
+  uint32_t cpu_nj_per_us;        /**< Energía por µs de CPU activa (nJ) */
+  uint32_t flash_nj_per_byte;    /**< Energía por byte escrito en flash (nJ) */
+  uint32_t uart_nj_per_byte;     /**< Energía por byte enviado por UART (nJ) */
+  uint32_t sleep_uw;             /**< Potencia en deep sleep (µW) */
+} telemetry_energy_model_t;
+
+/** @brief Contadores y energía estimada de una etapa */
+typedef struct {
+  uint64_t cpu_us;               /**< Tiempo de CPU (µs), de las estadísticas de ejecución */
+  uint32_t flash_bytes;          /**< Bytes escritos en flash */
+  uint32_t uart_bytes;           /**< Bytes enviados por UART */
+  uint64_t energy_uj;            /**< Energía estimada (µJ) */
+} telemetry_energy_stage_t;
+
+/**
+ * @brief Informe completo de consumo
+ *
+ * @note Las energías son de 64 bits: en 32 bits los µJ darían la vuelta a
+ * los ~4295 J, unas horas de misión. Se reducen (saturando) solo al
+ * escribirlas en un paquete.
+ */
+typedef struct {
+  telemetry_energy_stage_t stages[TELEM_STAGE_COUNT]; /**< Desglose por etapa */
+  uint64_t sleep_energy_uj;      /**< Energía estimada en deep sleep (µJ) */
+  uint64_t total_energy_uj;      /**< Energía total estimada (µJ) */
+  uint32_t packets;              /**< Paquetes generados */
+  uint64_t energy_per_packet_uj; /**< Energía total por paquete (µJ) */
+} telemetry_energy_report_t;
+
+/**
+ * @brief Sustituye el modelo de costes
+ *
+ * @param model Nuevo modelo (p. ej. calibrado con medidas del EPS)
+ */
+void telemetry_energy_set_model(const telemetry_energy_model_t* model);
+
+/**
+ * @brief Asocia una tarea a una etapa para imputarle su consumo
+ *
+ * @param stage Etapa a la que pertenece la tarea
+ * @param task Handle de la tarea (NULL para deshacer la asociación)
+ *
+ * @details Varias etapas pueden compartir tarea; entonces la etapa en curso
+ * la indica telemetry_energy_set_running_stage().
+ */
+void telemetry_energy_register_task(telem_energy_stage_t stage, TaskHandle_t task);
+
+/**
+ * @brief Indica qué etapa se ejecuta ahora en la tarea compartida
+ *
+ * @param stage Etapa en curso o TELEM_STAGE_SYSTEM entre etapas
+ *
+ * @details Solo la usa la tarea cooperativa, que es la única compartida.
+ */
+void telemetry_energy_set_running_stage(telem_energy_stage_t stage);
+
+/**
+ * @brief Devuelve la etapa asociada a la tarea que llama
+ *
+ * @return telem_energy_stage_t Etapa registrada, la etapa en curso si la
+ * tarea es compartida, o TELEM_STAGE_SYSTEM
+ */
+telem_energy_stage_t telemetry_energy_current_stage(void);
+
+/**
+ * @brief Suma tiempo activo (de reloj) a una etapa
+ *
+ * @param stage Etapa
+ * @param us Microsegundos entre el principio y el final de su trabajo
+ *
+ * @details Reparte la CPU de una tarea compartida entre sus etapas, y es el
+ * tiempo de CPU cuando no hay estadísticas de ejecución.
+ */
+void telemetry_energy_add_active(telem_energy_stage_t stage, uint32_t us);
+
+/**
+ * @brief Suma bytes escritos en flash a la etapa de la tarea actual
+ *
+ * @param bytes Número de bytes
+ */
+void telemetry_energy_add_flash(uint32_t bytes);
+
+/**
+ * @brief Suma bytes enviados por UART a la etapa de la tarea actual
+ *
+ * @param bytes Número de bytes
+ */
+void telemetry_energy_add_uart(uint32_t bytes);
+
+/**
+ * @brief Suma paquetes generados
+ *
+ * @param count Número de paquetes
+ */
+void telemetry_energy_add_packets(uint32_t count);
+
+/**
+ * @brief Estima la energía de una operación hipotética con el modelo actual
+ *
+ * @param cpu_us Tiempo de CPU (µs)
+ * @param flash_bytes Bytes a escribir en flash
+ * @param uart_bytes Bytes a enviar por UART
+ * @return uint32_t Energía estimada (µJ), saturada en UINT32_MAX
+ *
+ * @details Útil para decidir entre opciones de codificación comparando su
+ * coste total, p. ej. comprimir (más CPU) frente a enviar el paquete en claro
+ * (más bytes de UART).
+ */
+uint32_t telemetry_energy_estimate_uj(uint32_t cpu_us, uint32_t flash_bytes, uint32_t uart_bytes);
+
+/**
+ * @brief Calcula el informe de consumo a partir de los contadores actuales
+ *
+ * @param[out] report Estructura donde se escribe el informe
+ *
+ * @details Antes incorpora la CPU de cada tarea desde el informe anterior.
+ * Si otra tarea está haciendo esa cuenta en ese momento, el informe sale con
+ * la CPU ya incorporada.
+ */
+void telemetry_energy_get_report(telemetry_energy_report_t* report);
+
+#endif // TELEMETRY_ENERGY_H
@@ -0,0 +1,127 @@
+/**
+ * @file telemetry_entropy.h
+ * @brief Codificación entrópica rANS con tablas estáticas para tramas de bajada
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Los paquetes consecutivos de un mismo tipo apenas cambian entre sí, así que
+ * la carga útil de una trama se transforma primero en diferencias byte a byte
+ * con el paquete anterior del mismo tipo dentro de la trama. Los residuos
+ * resultantes tienen una distribución muy sesgada (casi todo ceros), que se
+ * codifica con rANS usando una tabla de frecuencias fija entrenada fuera de
+ * línea y compilada como constante:
+ *
+ * - Sin estado adaptativo: codificar solo consulta la tabla.
+ * - Cada trama se decodifica por sí sola (las referencias de la diferencia
+ *   nunca salen de la trama).
+ *
+ * Formato de la carga comprimida (flag TELEM_FRAME_FLAG_ENTROPY):
+ * | longitud original (uint16) | estado rANS (uint32) | bytes rANS ... |
+ *
+ * La compresión solo se aplica a tramas sin TELEM_FRAME_FLAG_BITPACK: los
+ * datos empaquetados a nivel de bit ya no están alineados a byte.
+ */
+
+#ifndef TELEMETRY_ENTROPY_H
+#define TELEMETRY_ENTROPY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_downlink.h"
+
+/** @brief Bit de flags: carga útil con diferencias + rANS (ver telemetry_entropy.h) */
+#define TELEM_FRAME_FLAG_ENTROPY 0x02
+
+/** @brief Bits de precisión de la tabla de frecuencias (suma 1 << TELEM_ENTROPY_PROB_BITS) */
+#define TELEM_ENTROPY_PROB_BITS 12
+
+/**
+ * @brief Codifica un bloque de bytes con rANS y la tabla estática
+ *
+ * @param in Datos a codificar
+ * @param length Bytes de entrada
+ * @param[out] out Buffer de salida
+ * @param capacity Capacidad de out
+ * @return size_t Bytes escritos (estado incluido), o 0 si no caben
+ */
+size_t telemetry_entropy_encode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Decodifica un bloque codificado con telemetry_entropy_encode()
+ *
+ * @param in Datos codificados
+ * @param length Bytes codificados
+ * @param[out] out Buffer de salida
+ * @param out_length Bytes originales a reconstruir
+ * @return true Si el flujo era válido
+ */
+bool telemetry_entropy_decode(const uint8_t* in, size_t length, uint8_t* out, size_t out_length);
+
+/**
+ * @brief Comprime en su sitio la carga útil de una trama terminada
+ *
+ * @param frame Trama completa (sin TELEM_FRAME_FLAG_BITPACK)
+ * @param scratch Buffer temporal de al menos la carga útil de la trama
+ * @param scratch_capacity Tamaño de scratch
+ * @return true Si la trama queda comprimida (menor que la original)
+ *
+ * @details Si la versión comprimida no es menor, la trama queda intacta.
+ */
+bool telemetry_frame_compress(telemetry_frame_t* frame, uint8_t* scratch, size_t scratch_capacity);
+
+/**
+ * @brief Reconstruye la carga útil original de una trama comprimida
+ *
+ * @param payload Carga útil comprimida (tras telem_frame_header_t)
+ * @param length Bytes de la carga comprimida
+ * @param[out] out Buffer para la carga original
+ * @param capacity Capacidad de out
+ * @param scratch Buffer temporal de al menos capacity bytes
+ * @return size_t Bytes de la carga original, o 0 si los datos no son válidos
+ */
+size_t telemetry_frame_decompress(const uint8_t* payload, size_t length, uint8_t* out,
+                                  size_t capacity, uint8_t* scratch);
+
+/**
+ * @brief Calcula los residuos que codifica rANS (diferencias con el paquete anterior del mismo tipo)
+ *
+ * @param payload Carga útil sin comprimir
+ * @param[out] residuals Residuos (mismo tamaño; no puede solaparse con payload)
+ * @param length Bytes de la carga
+ * @return true Si la carga se pudo delimitar en paquetes completos
+ *
+ * @details Es la misma transformación que aplica telemetry_frame_compress();
+ * el arnés de entrenamiento (test/test_entropy) hace el histograma de la
+ * tabla sobre su salida.
+ */
+bool telemetry_entropy_residuals(const uint8_t* payload, uint8_t* residuals, size_t length);
+
+/**
+ * @brief Tabla de frecuencias compilada (256 entradas, suma 1 << TELEM_ENTROPY_PROB_BITS)
+ */
+const uint16_t* telemetry_entropy_frequencies(void);
+
+/**
+ * @brief Llena una carga útil con ciclos simulados del recolector
+ *
+ * @param first Índice del primer paquete (4 paquetes por ciclo)
+ * @param[out] out Buffer de la carga
+ * @param capacity Capacidad de out
+ * @param[out] bitpacked Tamaño de los mismos paquetes empaquetados a nivel de bit (puede ser NULL)
+ * @return size_t Bytes escritos (solo paquetes completos)
+ *
+ * @details Es la muestra de entrenamiento de la tabla y la que usa
+ * telemetry_entropy_benchmark().
+ */
+size_t telemetry_entropy_sample_payload(uint32_t first, uint8_t* out, size_t capacity, size_t* bitpacked);
+
+/**
+ * @brief Mide ratio y velocidad frente a la trama sin comprimir y empaquetada a nivel de bit
+ *
+ * @details Se ejecuta desde setup() con `TELEM_ENTROPY_BENCHMARK` definido.
+ */
+void telemetry_entropy_benchmark(void);
+
+#endif // TELEMETRY_ENTROPY_H
@@ -12,6 +12,110 @@
 #ifndef TELEMETRY_GENERATORS_H
 #define TELEMETRY_GENERATORS_H
 
+#include <stdbool.h>
+#include "telemetry_types.h"
+
+/**
+ * @brief Destino de los paquetes producidos por los generadores
+ *
+ * @param packet Paquete generado
+ * @return true Si el paquete se aceptó
+ */
+typedef bool (*telemetry_packet_sink_t)(const telemetry_packet_t* packet);
+
+/** @brief Periodo por defecto de los generadores propios (ms) */
+#ifndef TELEM_GENERATOR_PERIOD_MS
+#define TELEM_GENERATOR_PERIOD_MS 5000
+#endif
+
+/** @brief Generadores registrables como máximo */
+#ifndef TELEM_MAX_GENERATORS
+#define TELEM_MAX_GENERATORS 8
+#endif
+
+/**
+ * @brief Rellena la carga útil de un paquete
+ *
+ * @param packet Paquete a cero con el encabezado ya relleno
+ */
+typedef void (*telemetry_fill_t)(telemetry_packet_t* packet);
+
+/**
+ * @brief Descripción de un generador de telemetría
+ *
+ * @details Los tipos propios de carga útil o experimentos usan identificadores
+ * de TELEM_TYPE_COUNT a TELEM_TYPE_MAX; el resto del sistema los trata como
+ * paquetes completos de tamaño fijo.
+ */
+typedef struct {
+  uint8_t type;             /**< telem_data_type_t o identificador propio */
+  uint8_t priority;         /**< Prioridad del encabezado (0=low,1=normal,2=high) */
+  uint32_t period_ms;       /**< Periodo de generación */
+  telemetry_fill_t fill;    /**< Relleno de la carga útil */
+} telemetry_generator_t;
+
+/**
+ * @brief Inicializa los contadores de los generadores
+ *
+ * @details Tras un reinicio en caliente recupera el número de secuencia y el
+ * tiempo de actividad desde memoria RTC, validados con número mágico y CRC,
+ * para que la numeración de paquetes continúe sin saltos. En un arranque en
+ * frío los contadores se ponen a cero. También registra los generadores
+ * propios (ver telemetry_generator_register()).
+ *
+ * @return true Si los contadores se recuperaron del arranque anterior
+ * @return false Si se inicializaron desde cero
+ */
+bool telemetry_generators_init(void);
+
+/**
+ * @brief Redirige la salida de los generadores
+ *
+ * @param sink Función que recibirá los paquetes, o NULL para volver a
+ * telemetry_store_packet()
+ *
+ * @details Permite, por ejemplo, acumular las muestras en memoria RTC durante
+ * los despertares de bajo consumo, cuando el buffer principal no existe.
+ */
+void telemetry_generators_set_sink(telemetry_packet_sink_t sink);
+
+/**
+ * @brief Sella el encabezado de un paquete producido fuera de los generadores
+ *
+ * @param header Encabezado con el tipo y la prioridad ya puestos
+ * @param age_ms Antigüedad del dato: la marca de tiempo se retrasa lo mismo
+ *
+ * @details Consume el siguiente número de secuencia, así que solo debe
+ * llamarse desde el recolector (lo usa telemetry_isr_drain()).
+ */
+void telemetry_generators_stamp(telem_header_t* header, uint32_t age_ms);
+
+/**
+ * @brief Registra un generador en la tabla estática del recolector
+ *
+ * @param generator Descripción, que debe vivir mientras el sistema funcione
+ * (normalmente `static const`)
+ * @return true Si quedó registrado (o ya lo estaba)
+ * @return false Si la descripción no es válida (sin relleno, periodo 0 o tipo
+ * mayor que TELEM_TYPE_MAX) o la tabla está llena
+ *
+ * @details Se puede llamar desde cualquier tarea: la tabla está protegida por
+ * un cerrojo. El generador vence por primera vez en la siguiente pasada.
+ */
+bool telemetry_generator_register(const telemetry_generator_t* generator);
+
+/**
+ * @brief Ejecuta los generadores vencidos
+ *
+ * @param now_ms Tiempo actual en ms (ticks de FreeRTOS)
+ * @return uint32_t Milisegundos hasta el próximo vencimiento
+ *
+ * @details Los vencimientos se guardan en un montículo mínimo, así que cada
+ * pasada solo visita los generadores vencidos. Si hay alguno, antes se hace
+ * un único barrido de sensores (telemetry_sensors.h).
+ */
+uint32_t telemetry_generators_run_due(uint32_t now_ms);
+
 /**
  * @brief Genera datos de telemetría del estado del sistema
  * 
@@ -78,4 +182,24 @@ void generate_temperature_telemetry(void);
  */
 void generate_subsystem_telemetry(void);
 
+/**
+ * @brief Genera un registro combinado de housekeeping
+ *
+ * @details Rellena las cargas útiles de sistema, potencia, temperaturas y
+ * subsistemas y las agrupa en un único housekeeping_telem_t con un solo
+ * encabezado y número de secuencia (ver telemetry_housekeeping.h).
+ */
+void generate_housekeeping_telemetry(void);
+
+/**
+ * @brief Genera la telemetría de un ciclo completo del recolector
+ *
+ * @details Ejecuta todos los generadores registrados, vencidos o no, tras un
+ * único barrido de sensores (telemetry_sensors.h). Lo usan los despertares de
+ * bajo consumo, en los que cada despertar es un ciclo. Con
+ * `TELEM_MERGED_HOUSEKEEPING` definido los generadores propios son un único
+ * registro combinado; en caso contrario, los cuatro paquetes por separado.
+ */
+void generate_cycle_telemetry(void);
+
 #endif /* TELEMETRY_GENERATORS_H */
\ No newline at end of file
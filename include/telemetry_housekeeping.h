@@ -0,0 +1,62 @@
+/**
+ * @file telemetry_housekeeping.h
+ * @brief Construcción y expansión de registros combinados de housekeeping
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Cada ciclo del recolector produce cuatro paquetes con marcas de tiempo casi
+ * idénticas y secuencias consecutivas. Con `TELEM_MERGED_HOUSEKEEPING`
+ * definido, el ciclo se guarda y se transmite como un único
+ * housekeeping_telem_t: un encabezado, un mapa de presencia y las cuatro
+ * cargas útiles seguidas. Se reducen a la cuarta parte los encabezados y las
+ * operaciones de almacenamiento y recuperación por ciclo.
+ */
+
+#ifndef TELEMETRY_HOUSEKEEPING_H
+#define TELEMETRY_HOUSEKEEPING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "telemetry_types.h"
+
+/**
+ * @brief Tamaño de la carga útil de un tipo de telemetría (sin encabezado)
+ *
+ * @param type Tipo de telemetría simple (no TELEM_HOUSEKEEPING)
+ * @return size_t Bytes de carga útil, o 0 si el tipo no es válido
+ */
+size_t telemetry_payload_size(telem_data_type_t type);
+
+/**
+ * @brief Inicia un registro de housekeeping vacío
+ *
+ * @param record Registro a inicializar (su encabezado lo rellena el llamante)
+ */
+void telemetry_hk_begin(housekeeping_telem_t* record);
+
+/**
+ * @brief Añade la carga útil de un paquete al registro
+ *
+ * @param record Registro en construcción
+ * @param packet Paquete simple cuyo tipo aún no está presente en el registro
+ * @return true Si se añadió
+ * @return false Si el tipo no es válido, ya estaba presente o no hay espacio
+ *
+ * @note Los tipos deben añadirse en orden creciente.
+ */
+bool telemetry_hk_add(housekeeping_telem_t* record, const telemetry_packet_t* packet);
+
+/**
+ * @brief Reconstruye un paquete simple a partir de un registro
+ *
+ * @param record Registro de housekeeping
+ * @param type Tipo de paquete a extraer
+ * @param[out] packet Paquete reconstruido con el encabezado compartido
+ * @return true Si el tipo estaba presente
+ * @return false En caso contrario
+ */
+bool telemetry_hk_extract(const housekeeping_telem_t* record, telem_data_type_t type,
+                          telemetry_packet_t* packet);
+
+#endif // TELEMETRY_HOUSEKEEPING_H
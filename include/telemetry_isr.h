@@ -0,0 +1,139 @@
+/**
+ * @file telemetry_isr.h
+ * @brief Almacenamiento de paquetes desde interrupciones
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * telemetry_store_packet() toma el mutex del buffer, así que no se puede
+ * llamar desde una ISR. Los sensores que avisan por interrupción dejan sus
+ * paquetes con telemetry_store_packet_from_isr() en un anillo propio de cada
+ * fuente (un productor, la ISR, y un consumidor, el recolector), sin
+ * cerrojos ni secciones críticas: cabeza y cola son contadores libres que
+ * solo escribe su dueño, publicados con semántica acquire/release.
+ *
+ * - El instante del evento se captura en la propia ISR (esp_timer, en µs);
+ *   al fusionar el paquete el encabezado se sella con ese instante y con el
+ *   siguiente número de secuencia (telemetry_generators_stamp()).
+ * - Si el anillo está lleno el paquete se descarta y se cuenta en el
+ *   contador de desbordes de la fuente, que solo escribe la ISR.
+ * - El recolector vacía los anillos al principio de cada pasada
+ *   (telemetry_isr_drain()) y anota la latencia de traspaso, desde la
+ *   captura hasta la fusión en el buffer principal.
+ *
+ * La fuente que se registra al arrancar es la línea ALERT del monitor de
+ * potencia (telemetry_sensors_alert_init()).
+ */
+
+#ifndef TELEMETRY_ISR_H
+#define TELEMETRY_ISR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "telemetry_types.h"
+#include "telemetry_generators.h"
+
+/** @brief Fuentes de interrupción como máximo */
+#ifndef TELEM_ISR_MAX_SOURCES
+#define TELEM_ISR_MAX_SOURCES 2
+#endif
+
+/** @brief Paquetes en vuelo por fuente (potencia de dos) */
+#ifndef TELEM_ISR_RING_SIZE
+#define TELEM_ISR_RING_SIZE 8
+#endif
+
+/** @brief Identificador de una fuente (posición en el registro) */
+typedef uint8_t telem_isr_source_t;
+
+/** @brief Fuente no registrada */
+#define TELEM_ISR_INVALID_SOURCE UINT8_MAX
+
+/**
+ * @brief Aviso al consumidor tras dejar un paquete (se ejecuta en la ISR)
+ *
+ * @param woken Se pone a pdTRUE si hay que cambiar de tarea al salir de la ISR
+ */
+typedef void (*telemetry_isr_notify_t)(BaseType_t* woken);
+
+/** @brief Estadísticas de una fuente */
+typedef struct {
+  const char* name;
+  uint32_t stored;            /**< Paquetes aceptados por la ISR */
+  uint32_t overflows;         /**< Paquetes descartados con el anillo lleno */
+  uint32_t merged;            /**< Paquetes fusionados en el buffer principal */
+  uint32_t rejected;          /**< Fusionados que el buffer no aceptó */
+  uint32_t max_pending;       /**< Mayor ocupación del anillo vista al vaciarlo */
+  uint32_t max_latency_us;    /**< Mayor latencia de traspaso */
+  uint32_t avg_latency_us;    /**< Latencia media de traspaso */
+} telemetry_isr_stats_t;
+
+/**
+ * @brief Registra una fuente de interrupción
+ *
+ * @param name Nombre para los informes (debe vivir mientras el sistema funcione)
+ * @return telem_isr_source_t Identificador para telemetry_store_packet_from_isr(),
+ * o TELEM_ISR_INVALID_SOURCE si no quedan fuentes
+ *
+ * @details Se llama desde una tarea antes de habilitar la interrupción.
+ */
+telem_isr_source_t telemetry_isr_register(const char* name);
+
+/**
+ * @brief Instala el aviso al consumidor (NULL para ninguno)
+ *
+ * @details Lo instala el recolector cuando el buffer ya existe; hasta
+ * entonces los paquetes esperan en los anillos.
+ */
+void telemetry_isr_set_notify(telemetry_isr_notify_t notify);
+
+/**
+ * @brief Deja un paquete en el anillo de una fuente (seguro desde ISR)
+ *
+ * @param source Fuente registrada
+ * @param packet Paquete con la carga útil y el tipo y prioridad del
+ * encabezado; la marca de tiempo y la secuencia se ponen al fusionarlo
+ * @param woken Se pone a pdTRUE si hay que ceder la CPU al salir de la ISR
+ * (puede ser NULL)
+ * @return true Si el paquete quedó en el anillo
+ * @return false Si la fuente no existe o el anillo está lleno
+ */
+bool telemetry_store_packet_from_isr(telem_isr_source_t source, const telemetry_packet_t* packet,
+                                     BaseType_t* woken);
+
+/**
+ * @brief Fusiona los paquetes de todas las fuentes
+ *
+ * @param sink Destino de los paquetes (normalmente telemetry_store_packet())
+ * @return uint32_t Paquetes fusionados
+ *
+ * @details Solo puede haber un consumidor: lo llama el recolector.
+ */
+uint32_t telemetry_isr_drain(telemetry_packet_sink_t sink);
+
+/**
+ * @brief Copia las estadísticas de una fuente
+ *
+ * @return false Si la fuente no existe
+ */
+bool telemetry_isr_get_stats(telem_isr_source_t source, telemetry_isr_stats_t* stats);
+
+/**
+ * @brief Escribe en el log una línea por fuente registrada
+ */
+void telemetry_isr_log_summary(void);
+
+/**
+ * @brief Mide el coste del productor, el desborde y la fusión
+ *
+ * @details Se ejecuta desde setup() con `TELEM_ISR_BENCHMARK` definido, antes
+ * de crear las tareas. Usa un anillo propio fuera del registro y un destino
+ * que solo cuenta los paquetes: no ocupa ninguna de las
+ * TELEM_ISR_MAX_SOURCES fuentes, no aparece en telemetry_isr_log_summary(),
+ * no toca el buffer principal ni sella los paquetes, así que tampoco consume
+ * números de secuencia.
+ */
+void telemetry_isr_benchmark(void);
+
+#endif // TELEMETRY_ISR_H
@@ -0,0 +1,159 @@
+/**
+ * @file telemetry_lock.h
+ * @brief Mutex instrumentado con perfil de contención y de retención
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Sustituto directo de xSemaphoreTake()/xSemaphoreGive() sobre un mutex de
+ * FreeRTOS. Con `TELEM_LOCK_PROFILING` activo cada cerrojo registra:
+ *
+ * - Adquisiciones y cuántas encontraron el cerrojo ocupado (contención).
+ * - Histogramas del tiempo de espera y del tiempo de retención, en
+ *   TELEM_LOCK_HIST_BINS intervalos de base 4 (< 4 µs, < 16 µs, ... ≥ 16 ms).
+ * - Tiempos de espera agotados y la tarea que tenía el cerrojo en el último:
+ *   un take agotado en el buffer es un paquete que se pierde sin más aviso.
+ *
+ * Las estadísticas de adquisición y retención las actualiza quien tiene el
+ * cerrojo, así que no necesitan sección crítica; solo los tiempos agotados
+ * (sin el cerrojo) la usan.
+ *
+ * El resumen sale en la línea de estado y por el enlace de bajada como
+ * paquete propio (TELEM_LOCK_PROFILE_TYPE, un cerrojo por paquete en turno
+ * rotatorio). Con `TELEM_LOCK_PROFILING` a 0 el envoltorio se reduce a las
+ * llamadas de FreeRTOS en línea y el resumen desaparece.
+ */
+
+#ifndef TELEMETRY_LOCK_H
+#define TELEMETRY_LOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "telemetry_types.h"
+
+/** @brief Perfilado de cerrojos (0 = envoltorio sin coste) */
+#ifndef TELEM_LOCK_PROFILING
+#define TELEM_LOCK_PROFILING 1
+#endif
+
+/** @brief Cerrojos perfilados como máximo */
+#ifndef TELEM_LOCK_MAX
+#define TELEM_LOCK_MAX 4
+#endif
+
+/** @brief Intervalos de los histogramas */
+#define TELEM_LOCK_HIST_BINS 8
+
+/** @brief Caracteres del nombre de tarea conservados */
+#define TELEM_LOCK_NAME_LEN 12
+
+/** @brief Identificador propio del paquete de resumen (ver telemetry_generator_t) */
+#define TELEM_LOCK_PROFILE_TYPE TELEM_TYPE_COUNT
+
+/** @brief Periodo del paquete de resumen */
+#ifndef TELEM_LOCK_PROFILE_PERIOD_MS
+#define TELEM_LOCK_PROFILE_PERIOD_MS 60000
+#endif
+
+/** @brief Mutex con su perfil; lo reserva quien lo usa */
+typedef struct {
+  SemaphoreHandle_t handle;
+  const char* name;
+#if TELEM_LOCK_PROFILING
+  uint8_t id;                                   /**< Posición en el registro de cerrojos */
+  int64_t taken_us;                             /**< Instante de la adquisición en curso */
+  uint32_t acquires;                            /**< Adquisiciones */
+  uint32_t contended;                           /**< Adquisiciones que encontraron el cerrojo ocupado */
+  uint32_t timeouts;                            /**< Esperas agotadas */
+  uint32_t max_wait_us;                         /**< Mayor espera con éxito */
+  uint32_t max_hold_us;                         /**< Mayor retención */
+  uint32_t wait_hist[TELEM_LOCK_HIST_BINS];     /**< Esperas con éxito por intervalo */
+  uint32_t hold_hist[TELEM_LOCK_HIST_BINS];     /**< Retenciones por intervalo */
+  char timeout_owner[TELEM_LOCK_NAME_LEN];      /**< Tarea con el cerrojo en el último tiempo agotado */
+#endif
+} telemetry_lock_t;
+
+/**
+ * @brief Resumen de un cerrojo para el enlace de bajada
+ *
+ * @details Los histogramas van normalizados en medios puntos porcentuales
+ * (0..200) para que quepan en un byte sea cual sea el tiempo en órbita, y el
+ * resumen completo en un paquete de 64 bytes. El nombre de la tarea va
+ * relleno con ceros, sin terminador si ocupa todo el campo.
+ */
+typedef struct {
+  telem_header_t header;                        /**< Encabezado común (type = TELEM_LOCK_PROFILE_TYPE) */
+  uint8_t lock_id;                              /**< Posición en el registro de cerrojos */
+  char timeout_owner[TELEM_LOCK_NAME_LEN - 1];  /**< Tarea con el cerrojo en el último tiempo agotado */
+  uint32_t acquires;
+  uint32_t contended;
+  uint32_t timeouts;
+  uint32_t max_wait_us;
+  uint32_t max_hold_us;
+  uint8_t wait_hist[TELEM_LOCK_HIST_BINS];      /**< Esperas por intervalo (medios puntos %) */
+  uint8_t hold_hist[TELEM_LOCK_HIST_BINS];      /**< Retenciones por intervalo (medios puntos %) */
+} lock_profile_telem_t;
+
+#if TELEM_LOCK_PROFILING
+
+/**
+ * @brief Crea el mutex y registra el cerrojo para los resúmenes
+ *
+ * @param lock Cerrojo
+ * @param name Nombre para los informes
+ * @return true Si el mutex se creó
+ */
+bool telemetry_lock_create(telemetry_lock_t* lock, const char* name);
+
+/**
+ * @brief Toma el cerrojo (equivale a xSemaphoreTake() == pdTRUE)
+ *
+ * @param lock Cerrojo
+ * @param timeout Espera máxima en ticks
+ * @return true Si se obtuvo el cerrojo
+ */
+bool telemetry_lock_take(telemetry_lock_t* lock, TickType_t timeout);
+
+/**
+ * @brief Libera el cerrojo y anota el tiempo de retención
+ */
+void telemetry_lock_give(telemetry_lock_t* lock);
+
+/**
+ * @brief Registra el generador del paquete de resumen (ver telemetry_generator_register())
+ */
+bool telemetry_lock_register_generator(void);
+
+/**
+ * @brief Escribe en el log una línea por cerrojo registrado
+ */
+void telemetry_lock_log_summary(void);
+
+#else
+
+static inline bool telemetry_lock_create(telemetry_lock_t* lock, const char* name) {
+  lock->name = name;
+  lock->handle = xSemaphoreCreateMutex();
+  return lock->handle != NULL;
+}
+
+static inline bool telemetry_lock_take(telemetry_lock_t* lock, TickType_t timeout) {
+  return xSemaphoreTake(lock->handle, timeout) == pdTRUE;
+}
+
+static inline void telemetry_lock_give(telemetry_lock_t* lock) {
+  xSemaphoreGive(lock->handle);
+}
+
+static inline bool telemetry_lock_register_generator(void) {
+  return false;
+}
+
+static inline void telemetry_lock_log_summary(void) {
+}
+
+#endif // TELEM_LOCK_PROFILING
+
+#endif // TELEMETRY_LOCK_H
@@ -14,9 +14,17 @@
 #define TELEMETRY_LOGGER_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #define TELEMETRY_LOG_FILE "/telemetry_log.txt"
 
+/** @brief Bytes del buffer de líneas diferidas (ver telemetry_logger_defer_task()) */
+#ifndef TELEM_LOG_DEFER_BYTES
+#define TELEM_LOG_DEFER_BYTES 2048
+#endif
+
 /**
  * @brief Inicializa el sistema de logging de telemetría
  *  
@@ -39,6 +47,32 @@ bool telemetry_logger_init(void);
  */
 void telemetry_logf(const char *fmt, ...);
 
+/**
+ * @brief Difiere las líneas de una tarea hasta telemetry_log_flush()
+ *
+ * @param task Tarea cuyas líneas no deben esperar a la UART ni a LittleFS,
+ * o NULL para que todas se escriban al momento
+ *
+ * @details Las líneas de esa tarea se copian a un buffer en RAM de
+ * TELEM_LOG_DEFER_BYTES y las escribe (Serial y fichero) quien llame a
+ * telemetry_log_flush(). Si no caben, la línea entera se descarta y se
+ * cuenta en telemetry_log_dropped(). Lo usa la tarea del modo cooperativo.
+ */
+void telemetry_logger_defer_task(TaskHandle_t task);
+
+/**
+ * @brief Escribe las líneas diferidas en el Serial y en el archivo
+ *
+ * @details Abre el archivo una sola vez por llamada. Se llama desde una
+ * tarea que sí puede bloquear (el trabajador de mantenimiento).
+ */
+void telemetry_log_flush(void);
+
+/**
+ * @brief Líneas diferidas descartadas por falta de sitio
+ */
+uint32_t telemetry_log_dropped(void);
+
 /**
  * @brief Vuelca el contenido completo del archivo de log por Serial.
  * 
@@ -0,0 +1,172 @@
+/**
+ * @file telemetry_mapped.h
+ * @brief Segmentos de archivo de solo lectura en una partición mapeada en memoria
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Leer el archivo a través de LittleFS copia cada byte por la capa VFS y la
+ * caché de LittleFS. Los segmentos sellados se publican además en una
+ * partición dedicada (`telem_arc`, ver partitions.csv) que se mapea completa
+ * en el espacio de datos con esp_partition_mmap(): los decodificadores y el
+ * transmisor leen los paquetes directamente de la flash mapeada, sin copias.
+ *
+ * La partición se divide en ranuras de TELEM_MAPPED_SLOT_SIZE bytes con el
+ * mismo formato que un segmento de archivo (bloques de registros y bloque
+ * final con el mapa de zona), seguido de los metadatos de la ranura. Las
+ * ranuras se reutilizan en orden, sobrescribiendo la más antigua.
+ *
+ * Hay más ranuras que segmentos en el respaldo LittleFS, así que la partición
+ * guarda el histórico sellado que ya rotó fuera de los ficheros:
+ * telemetry_archive_query() lo recorre desde aquí con un cursor, leyendo los
+ * registros en su sitio.
+ *
+ * @note La escritura (begin/write/seal) debe hacerse desde una única tarea;
+ * la lectura con cursores puede hacerse desde cualquiera. El archivo publica
+ * con su mutex tomado y lo toma también para leer con cursores.
+ */
+
+#ifndef TELEMETRY_MAPPED_H
+#define TELEMETRY_MAPPED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_types.h"
+#include "telemetry_archive.h"
+
+/** @brief Etiqueta de la partición de archivo mapeada */
+#define TELEM_MAPPED_PARTITION "telem_arc"
+
+/** @brief Tamaño de cada ranura (múltiplo del sector de borrado de 4 KB) */
+#ifndef TELEM_MAPPED_SLOT_SIZE
+#define TELEM_MAPPED_SLOT_SIZE TELEM_ARCHIVE_FALLBACK_SEGMENT_SIZE
+#endif
+
+/** @brief Número máximo de ranuras gestionadas */
+#ifndef TELEM_MAPPED_MAX_SLOTS
+#define TELEM_MAPPED_MAX_SLOTS 32
+#endif
+
+/** @brief Marca de una ranura sellada ("MAPD") */
+#define TELEM_MAPPED_MAGIC 0x4D415044u
+
+/** @brief Pie de una ranura: mapa de zona del segmento y metadatos */
+typedef struct {
+  telem_zone_map_t zone;          /**< Mapa de zona (misma posición que en el segmento) */
+  uint32_t magic;                 /**< TELEM_MAPPED_MAGIC */
+  uint32_t generation;            /**< Orden de publicación (creciente) */
+  uint32_t source_segment;        /**< Segmento de archivo de origen */
+  uint32_t crc;                   /**< CRC32 de los campos anteriores */
+} telem_mapped_footer_t;
+
+/**
+ * @brief Cursor de lectura sobre las ranuras, de la más antigua a la más reciente
+ *
+ * @details El cursor recuerda la generación de la ranura, no su posición: si
+ * la ranura se reutiliza entre dos llamadas, el cursor sigue por la siguiente
+ * generación publicada en lugar de leer la ranura nueva.
+ */
+typedef struct {
+  uint32_t generation;            /**< Generación de la ranura en curso */
+  uint32_t record;                /**< Registro dentro de la ranura */
+} telemetry_mapped_cursor_t;
+
+/**
+ * @brief Localiza y mapea la partición y lee los pies de sus ranuras
+ *
+ * @return true Si la partición existe y se ha mapeado
+ */
+bool telemetry_mapped_init(void);
+
+/**
+ * @brief Indica si la partición mapeada está disponible
+ */
+bool telemetry_mapped_available(void);
+
+/**
+ * @brief Empieza a publicar un segmento en la ranura más antigua (la borra)
+ *
+ * @param source_segment Segmento de archivo de origen
+ * @return true Si la ranura está lista para escribir
+ */
+bool telemetry_mapped_begin(uint32_t source_segment);
+
+/**
+ * @brief Escribe un bloque de registros en la ranura en curso
+ *
+ * @param block Índice del bloque dentro de la ranura
+ * @param data TELEM_ARCHIVE_BLOCK_SIZE bytes con el formato de segmento
+ * @return true Si se escribió correctamente
+ */
+bool telemetry_mapped_write_block(uint32_t block, const void* data);
+
+/**
+ * @brief Sella la ranura en curso escribiendo su pie
+ *
+ * @param zone Mapa de zona del segmento publicado
+ * @return true Si la ranura quedó publicada
+ */
+bool telemetry_mapped_seal(const telem_zone_map_t* zone);
+
+/**
+ * @brief Número de ranuras publicadas
+ */
+uint32_t telemetry_mapped_slots(void);
+
+/**
+ * @brief Pie de una ranura publicada (puntero a la flash mapeada)
+ *
+ * @param position Posición en el orden de publicación (0 = la más antigua)
+ * @return const telem_mapped_footer_t* Pie de la ranura o NULL
+ */
+const telem_mapped_footer_t* telemetry_mapped_footer(uint32_t position);
+
+/**
+ * @brief Sitúa un cursor al principio de la ranura más antigua
+ */
+void telemetry_mapped_cursor_begin(telemetry_mapped_cursor_t* cursor);
+
+/**
+ * @brief Pie de la ranura en la que está el cursor
+ *
+ * @param cursor Cursor de lectura (se lleva a la siguiente ranura publicada
+ * si la suya ya no existe)
+ * @return const telem_mapped_footer_t* Pie de la ranura o NULL al terminar
+ */
+const telem_mapped_footer_t* telemetry_mapped_cursor_footer(telemetry_mapped_cursor_t* cursor);
+
+/**
+ * @brief Lleva el cursor al principio de la siguiente ranura
+ */
+void telemetry_mapped_cursor_skip(telemetry_mapped_cursor_t* cursor);
+
+/**
+ * @brief Generación de la ranura que publica un segmento sellado
+ *
+ * @param zone Mapa de zona del segmento
+ * @return uint32_t Generación de la ranura con el mismo mapa de zona, o 0 si
+ * el segmento no está publicado
+ */
+uint32_t telemetry_mapped_generation_of(const telem_zone_map_t* zone);
+
+/**
+ * @brief Como telemetry_mapped_next(), pero sin pasar de la ranura en curso
+ *
+ * @param cursor Cursor de lectura
+ * @return const telemetry_packet_t* Paquete (sin copiar) o NULL al acabar la
+ * ranura; el cursor queda entonces al principio de la siguiente
+ */
+const telemetry_packet_t* telemetry_mapped_next_in_slot(telemetry_mapped_cursor_t* cursor);
+
+/**
+ * @brief Devuelve el siguiente paquete válido directamente de la flash mapeada
+ *
+ * @param cursor Cursor de lectura
+ * @return const telemetry_packet_t* Paquete (sin copiar) o NULL al terminar
+ *
+ * @warning El puntero deja de ser válido cuando la ranura se reutiliza; no
+ * debe conservarse más allá de la pasada de lectura.
+ */
+const telemetry_packet_t* telemetry_mapped_next(telemetry_mapped_cursor_t* cursor);
+
+#endif // TELEMETRY_MAPPED_H
@@ -0,0 +1,84 @@
+/**
+ * @file telemetry_pool.h
+ * @brief Pool de bloques fijos para compartir paquetes entre etapas sin copias
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * En lugar de copiar los 64 bytes de cada paquete entre etapas, las etapas
+ * pueden intercambiar un handle a un bloque del pool. Cada bloque lleva un
+ * contador de referencias, de modo que varios consumidores comparten el mismo
+ * paquete y el bloque vuelve al pool cuando el último lo libera.
+ *
+ * Características principales:
+ * - Reserva y liberación sin bloqueo (pila de Treiber con etiqueta anti-ABA)
+ * - Tiempo constante y determinista, sin uso del heap
+ * - Estadísticas de uso, máximo histórico y agotamiento
+ */
+
+#ifndef TELEMETRY_POOL_H
+#define TELEMETRY_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_types.h"
+
+/** @brief Número de bloques del pool */
+#ifndef TELEM_POOL_SIZE
+#define TELEM_POOL_SIZE 64
+#endif
+
+/** @brief Handle a un bloque del pool */
+typedef uint16_t telem_pool_handle_t;
+
+/** @brief Handle inválido (pool agotado) */
+#define TELEM_POOL_INVALID 0xFFFF
+
+/**
+ * @brief Inicializa el pool con todos los bloques libres
+ *
+ * @note Debe llamarse una vez antes de que ninguna tarea use el pool.
+ */
+void telemetry_pool_init(void);
+
+/**
+ * @brief Reserva un bloque con una referencia
+ *
+ * @return telem_pool_handle_t Handle del bloque o TELEM_POOL_INVALID si el pool está agotado
+ *
+ * @note Segura desde cualquier tarea o ISR.
+ */
+telem_pool_handle_t telemetry_pool_alloc(void);
+
+/**
+ * @brief Añade una referencia a un bloque ya reservado
+ *
+ * @param handle Handle válido
+ */
+void telemetry_pool_retain(telem_pool_handle_t handle);
+
+/**
+ * @brief Elimina una referencia; el bloque vuelve al pool al llegar a cero
+ *
+ * @param handle Handle válido
+ */
+void telemetry_pool_release(telem_pool_handle_t handle);
+
+/**
+ * @brief Acceso al paquete almacenado en un bloque
+ *
+ * @param handle Handle válido
+ * @return telemetry_packet_t* Puntero al paquete dentro del pool
+ */
+telemetry_packet_t* telemetry_pool_get(telem_pool_handle_t handle);
+
+/**
+ * @brief Obtiene estadísticas del pool
+ *
+ * @param[out] in_use Bloques reservados actualmente
+ * @param[out] high_water Máximo de bloques reservados a la vez
+ * @param[out] exhausted Reservas fallidas por pool agotado
+ */
+void telemetry_pool_get_stats(uint32_t* in_use, uint32_t* high_water, uint32_t* exhausted);
+
+#endif // TELEMETRY_POOL_H
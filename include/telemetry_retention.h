@@ -0,0 +1,58 @@
+/**
+ * @file telemetry_retention.h
+ * @brief Soporte para conservar el estado de telemetría tras reinicios en caliente
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Un reinicio software, un watchdog o la recuperación de un brownout no borran
+ * la RAM del ESP32. Este módulo ofrece las utilidades comunes para que otros
+ * módulos coloquen su estado en secciones no inicializadas (`__NOINIT_ATTR` o
+ * `RTC_NOINIT_ATTR`) y lo validen al arrancar mediante un número mágico y un
+ * CRC32, de modo que la recuperación no necesite tocar la flash.
+ *
+ * @see https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-guides/memory-types.html
+ */
+
+#ifndef TELEMETRY_RETENTION_H
+#define TELEMETRY_RETENTION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_attr.h"
+
+/** @brief Número mágico que marca un bloque retenido como válido ("TSAT") */
+#define TELEM_RETENTION_MAGIC 0x54534154u
+
+/**
+ * @brief Indica si el arranque actual es un reinicio en caliente
+ *
+ * @return true Si la causa del reinicio conserva la RAM (software, pánico,
+ * watchdog o brownout)
+ * @return false Si es un arranque en frío (encendido, reset externo, deep sleep)
+ *
+ * @note Que el arranque sea en caliente no garantiza que los datos sean
+ * válidos: cada módulo debe comprobar además su número mágico y su CRC.
+ */
+bool telemetry_retention_warm_boot(void);
+
+/**
+ * @brief Indica si la memoria RTC slow conserva el contenido del arranque anterior
+ *
+ * @return true En los mismos casos que telemetry_retention_warm_boot() y además
+ * al despertar de deep sleep, que apaga la DRAM pero mantiene la memoria RTC
+ * @return false En un arranque en frío
+ */
+bool telemetry_retention_rtc_preserved(void);
+
+/**
+ * @brief Calcula el CRC32 de un bloque de memoria
+ *
+ * @param data Puntero a los datos
+ * @param len Longitud en bytes
+ * @return uint32_t CRC32 (polinomio IEEE 802.3) calculado con la tabla de la ROM
+ */
+uint32_t telemetry_retention_crc(const void* data, size_t len);
+
+#endif // TELEMETRY_RETENTION_H
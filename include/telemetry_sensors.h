@@ -0,0 +1,158 @@
+/**
+ * @file telemetry_sensors.h
+ * @brief Adquisición multicanal de sensores en un único barrido por ciclo
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Cada ciclo del recolector hace un solo barrido: cada entrada física se
+ * convierte una vez y los canales que dependen de ella se calculan a partir
+ * de esa misma muestra. El resultado es un marco de muestras por ciclo que
+ * leen todos los generadores, de modo que:
+ *
+ * - No hay conversiones repetidas de la misma entrada (antes cinco lecturas
+ *   del sensor de temperatura para un solo paquete).
+ * - Todos los campos de un ciclo corresponden al mismo instante, también
+ *   entre paquetes distintos (p. ej. la temperatura de batería de potencia y
+ *   de temperaturas).
+ *
+ * Las entradas y canales se declaran en tablas X-macro. Las entradas
+ * externas solo están cableadas con `WOKWI` definido (NTC y potenciómetro del
+ * diagrama); sin ellas los canales toman su valor nominal simulado. La
+ * corriente de batería se lee del monitor de potencia por el bus I2C
+ * (telemetry_bus.h).
+ *
+ * La línea ALERT del monitor de potencia (sobrecorriente o subtensión) es
+ * una fuente de interrupción (telemetry_isr.h): en el flanco de bajada la
+ * ISR deja un paquete de potencia con power_state = TELEM_POWER_STATE_ALERT
+ * y las medidas de batería del último barrido, sin esperar al siguiente
+ * ciclo del recolector.
+ */
+
+#ifndef TELEMETRY_SENSORS_H
+#define TELEMETRY_SENSORS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Pin ADC del sensor de temperatura NTC */
+#ifndef TELEM_SENSOR_NTC_PIN
+#define TELEM_SENSOR_NTC_PIN 34
+#endif
+
+/** @brief Pin ADC del divisor de tensión de la batería */
+#ifndef TELEM_SENSOR_VBAT_PIN
+#define TELEM_SENSOR_VBAT_PIN 35
+#endif
+
+/** @brief Factor del divisor de tensión de la batería (tabla de calibración por defecto) */
+#ifndef TELEM_SENSOR_VBAT_DIVIDER
+#define TELEM_SENSOR_VBAT_DIVIDER 2.0f
+#endif
+
+/** @brief Resistencia del shunt del monitor de potencia de la batería (ohmios) */
+#ifndef TELEM_SENSOR_SHUNT_OHMS
+#define TELEM_SENSOR_SHUNT_OHMS 0.1f
+#endif
+
+/** @brief Pin GPIO de la línea ALERT del monitor de potencia (activa a nivel bajo) */
+#ifndef TELEM_SENSOR_ALERT_PIN
+#define TELEM_SENSOR_ALERT_PIN 27
+#endif
+
+/** @brief power_state de los paquetes que genera la línea ALERT */
+#define TELEM_POWER_STATE_ALERT 1
+
+/**
+ * @brief Entradas físicas: INPUT(nombre)
+ *
+ * @details Cada una supone una conversión por barrido.
+ */
+#define TELEM_SENSOR_INPUTS(INPUT) \
+  INPUT(NTC_TEMPERATURE) \
+  INPUT(BATTERY_DIVIDER) \
+  INPUT(BATTERY_SHUNT) \
+  INPUT(CPU_TEMPERATURE)
+
+/**
+ * @brief Canales del marco de muestras: CHANNEL(nombre, entrada, desfase, nominal)
+ *
+ * @details valor = entrada + desfase si la entrada está cableada, o nominal
+ * si no lo está. El desfase simula el gradiente térmico entre módulos que
+ * comparten un único sensor.
+ */
+#define TELEM_SENSOR_CHANNELS(CHANNEL) \
+  CHANNEL(OBC_TEMPERATURE, NTC_TEMPERATURE, 0.0f, 35.0f) \
+  CHANNEL(COMMS_TEMPERATURE, NTC_TEMPERATURE, -5.0f, 28.0f) \
+  CHANNEL(PAYLOAD_TEMPERATURE, NTC_TEMPERATURE, 3.0f, 25.0f) \
+  CHANNEL(BATTERY_TEMPERATURE, NTC_TEMPERATURE, 0.0f, 22.0f) \
+  CHANNEL(EXTERNAL_TEMPERATURE, NTC_TEMPERATURE, -10.0f, -15.0f) \
+  CHANNEL(BATTERY_VOLTAGE, BATTERY_DIVIDER, 0.0f, 3.95f) \
+  CHANNEL(BATTERY_CURRENT, BATTERY_SHUNT, 0.0f, 0.1f) \
+  CHANNEL(CPU_TEMPERATURE, CPU_TEMPERATURE, 0.0f, 0.0f)
+
+#define TELEM_SENSOR_ENUM_INPUT(name) TELEM_INPUT_##name,
+#define TELEM_SENSOR_ENUM_CHANNEL(name, input, offset, nominal) TELEM_CH_##name,
+
+/** @brief Entradas físicas */
+typedef enum {
+  TELEM_SENSOR_INPUTS(TELEM_SENSOR_ENUM_INPUT)
+  TELEM_SENSOR_INPUT_COUNT
+} telem_sensor_input_t;
+
+/** @brief Canales del marco de muestras */
+typedef enum {
+  TELEM_SENSOR_CHANNELS(TELEM_SENSOR_ENUM_CHANNEL)
+  TELEM_SENSOR_CHANNEL_COUNT
+} telem_sensor_channel_t;
+
+/** @brief Marco de muestras de un ciclo */
+typedef struct {
+  float value[TELEM_SENSOR_CHANNEL_COUNT];  /**< Valor de cada canal (°C o V) */
+  int64_t sample_time_us;                   /**< esp_timer_get_time() al iniciar el barrido */
+  uint32_t sweep_us;                        /**< Duración del barrido */
+  uint32_t sweep;                           /**< Número de barrido (0 = aún ninguno) */
+} telemetry_sample_frame_t;
+
+/** @brief Estadísticas de adquisición */
+typedef struct {
+  uint32_t sweeps;            /**< Barridos realizados */
+  uint32_t conversions;       /**< Conversiones de entradas cableadas */
+  uint32_t bus_failures;      /**< Lecturas por bus fallidas o sin bus (canal con su valor nominal) */
+  uint32_t last_sweep_us;     /**< Duración del último barrido */
+  uint32_t worst_sweep_us;    /**< Peor duración de barrido */
+} telemetry_sensor_stats_t;
+
+/**
+ * @brief Convierte una vez cada entrada y rellena el marco de muestras del ciclo
+ *
+ * @return const telemetry_sample_frame_t* Marco recién adquirido
+ */
+const telemetry_sample_frame_t* telemetry_sensors_sweep(void);
+
+/**
+ * @brief Marco de muestras del ciclo actual
+ *
+ * @return const telemetry_sample_frame_t* Último marco; si todavía no hay
+ * ninguno se hace un barrido
+ */
+const telemetry_sample_frame_t* telemetry_sensors_frame(void);
+
+/**
+ * @brief Registra la línea ALERT como fuente de interrupción y la habilita
+ *
+ * @return false Si no queda ninguna fuente de interrupción libre
+ *
+ * @details Se llama una vez desde setup(). El paquete de alerta lleva la
+ * tensión, la corriente y la temperatura de batería del último barrido
+ * (hace uno si todavía no hay ninguno); el nivel de carga y los paneles
+ * solares van a cero, porque la ISR no puede calcularlos.
+ */
+bool telemetry_sensors_alert_init(void);
+
+/**
+ * @brief Obtiene las estadísticas de adquisición
+ */
+void telemetry_sensors_get_stats(telemetry_sensor_stats_t* stats);
+
+#endif // TELEMETRY_SENSORS_H
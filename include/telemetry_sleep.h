@@ -0,0 +1,149 @@
+/**
+ * @file telemetry_sleep.h
+ * @brief Modo de bajo consumo con muestreo por ciclos de deep sleep
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * En órbita la energía es tan escasa como la CPU. Con `TELEM_LOW_POWER_MODE`
+ * definido, el ESP32 pasa el tiempo entre muestras en deep sleep:
+ *
+ * - Cada despertar por temporizador ejecuta solo los generadores y guarda los
+ *   paquetes en un lote en memoria RTC, sin montar LittleFS ni crear tareas.
+ * - Cuando el lote tiene TELEM_SLEEP_BATCH_CYCLES ciclos, el arranque sigue
+ *   el camino normal: las tareas vuelcan el lote al buffer, lo procesan y lo
+ *   transmiten, y después el sistema vuelve a dormir.
+ * - Lo que el transmisor no haya enviado al volver a dormir pasa también a
+ *   memoria RTC (hasta TELEM_SLEEP_CARRY_SIZE paquetes, los más recientes) y
+ *   vuelve al buffer en el siguiente despertar completo; el resto sigue en
+ *   el archivo masivo.
+ *
+ * Un modelo de consumo simple (potencia activa y en deep sleep) estima la
+ * energía gastada por muestra a partir de los tiempos medidos.
+ *
+ * @see https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/sleep_modes.html
+ */
+
+#ifndef TELEMETRY_SLEEP_H
+#define TELEMETRY_SLEEP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_types.h"
+#include "telemetry_generators.h"
+
+/** @brief Periodo de muestreo en modo de bajo consumo (ms) */
+#ifndef TELEM_SLEEP_PERIOD_MS
+#define TELEM_SLEEP_PERIOD_MS 5000
+#endif
+
+/** @brief Ciclos de muestreo acumulados en RTC antes de despertar por completo */
+#ifndef TELEM_SLEEP_BATCH_CYCLES
+#define TELEM_SLEEP_BATCH_CYCLES 6
+#endif
+
+/** @brief Paquetes generados en cada ciclo de muestreo */
+#ifdef TELEM_MERGED_HOUSEKEEPING
+#define TELEM_SLEEP_PACKETS_PER_CYCLE 1
+#else
+#define TELEM_SLEEP_PACKETS_PER_CYCLE 4
+#endif
+
+/** @brief Capacidad del lote en memoria RTC (paquetes) */
+#define TELEM_SLEEP_BATCH_SIZE (TELEM_SLEEP_BATCH_CYCLES * TELEM_SLEEP_PACKETS_PER_CYCLE)
+
+/** @brief Paquetes sin transmitir que se conservan en memoria RTC al volver a dormir */
+#ifndef TELEM_SLEEP_CARRY_SIZE
+#define TELEM_SLEEP_CARRY_SIZE 16
+#endif
+
+/** @brief Tiempo mínimo despierto tras un despertar completo antes de volver a dormir (ms) */
+#ifndef TELEM_SLEEP_MIN_AWAKE_MS
+#define TELEM_SLEEP_MIN_AWAKE_MS 10000
+#endif
+
+/** @brief Potencia estimada con las CPUs activas (mW) */
+#ifndef TELEM_SLEEP_ACTIVE_POWER_MW
+#define TELEM_SLEEP_ACTIVE_POWER_MW 165
+#endif
+
+/** @brief Potencia estimada en deep sleep (µW) */
+#ifndef TELEM_SLEEP_DEEP_POWER_UW
+#define TELEM_SLEEP_DEEP_POWER_UW 33
+#endif
+
+/**
+ * @brief Estadísticas acumuladas del modo de bajo consumo
+ */
+typedef struct {
+  uint32_t samples;            /**< Ciclos de muestreo realizados */
+  uint32_t full_wakes;         /**< Despertares completos (procesado del lote) */
+  uint32_t carried;            /**< Paquetes sin transmitir conservados en memoria RTC */
+  uint32_t carry_dropped;      /**< Paquetes sin transmitir que no cabían (solo quedan en el archivo) */
+  uint64_t awake_us;           /**< Tiempo total despierto (µs) */
+  uint64_t sleep_us;           /**< Tiempo total en deep sleep (µs) */
+  uint32_t energy_per_sample_uj; /**< Energía estimada por muestra (µJ) */
+} telemetry_sleep_stats_t;
+
+/**
+ * @brief Atiende un despertar de deep sleep al principio de setup()
+ *
+ * @details Si el ESP32 despierta por temporizador y el lote aún no está
+ * lleno, toma una muestra de todos los generadores, la guarda en memoria RTC
+ * y vuelve a dormir sin retornar. En cualquier otro caso retorna y el
+ * arranque continúa por el camino normal.
+ *
+ * @note Sin `TELEM_LOW_POWER_MODE` la función no hace nada.
+ */
+void telemetry_sleep_handle_wake(void);
+
+/**
+ * @brief Vuelca el lote acumulado en memoria RTC
+ *
+ * @details Primero devuelve al buffer principal los paquetes conservados al
+ * dormir, que ya pasaron por el bus de temas y el archivo, y después entrega
+ * el lote de muestras a sink.
+ *
+ * @param sink Destino de los paquetes (el del recolector: buffer y bus de temas)
+ * @return uint32_t Número de paquetes del lote aceptados
+ *
+ * @note Debe llamarse después de telemetry_storage_init().
+ */
+uint32_t telemetry_sleep_flush_batch(telemetry_packet_sink_t sink);
+
+/**
+ * @brief Vuelve a deep sleep cuando el trabajo del despertar completo ha terminado
+ *
+ * @details Pensada para llamarse periódicamente desde loop(). Duerme cuando
+ * se ha cumplido TELEM_SLEEP_MIN_AWAKE_MS y los suscriptores del bus de
+ * temas no tienen paquetes pendientes (telemetry_topic_pending()), sin
+ * esperar a la ventana de contacto. El buffer principal está en memoria
+ * `.noinit`, que sobrevive a un reinicio pero no al deep sleep: antes de
+ * dormir sus paquetes pasan a memoria RTC y el bloque parcial del archivo se
+ * escribe (telemetry_archive_sync()). Sin `TELEM_LOW_POWER_MODE` la función
+ * no hace nada.
+ */
+void telemetry_sleep_service(void);
+
+/**
+ * @brief Marca de tiempo (ms) que se mantiene continua a través del deep sleep
+ *
+ * @return uint32_t Milisegundos acumulados desde el arranque en frío
+ */
+uint32_t telemetry_sleep_timestamp(void);
+
+/**
+ * @brief Versión en microsegundos de telemetry_sleep_timestamp(), con la misma base
+ *
+ * @return uint64_t Microsegundos acumulados desde el arranque en frío
+ */
+uint64_t telemetry_sleep_timestamp_us(void);
+
+/**
+ * @brief Obtiene las estadísticas del modo de bajo consumo
+ *
+ * @param[out] stats Estructura donde se copian las estadísticas
+ */
+void telemetry_sleep_get_stats(telemetry_sleep_stats_t* stats);
+
+#endif // TELEMETRY_SLEEP_H
@@ -0,0 +1,111 @@
+/**
+ * @file telemetry_soc.h
+ * @brief Estimador del estado de carga (SoC) de la batería
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Filtro de Kalman extendido de un solo estado en punto fijo:
+ *
+ * - Predicción por conteo de culombios: SoC -= I·dt / capacidad, y la
+ *   varianza crece con el ruido de proceso del sensor de corriente.
+ * - Corrección por tensión: la tensión en circuito abierto se estima como
+ *   V + I·R_interna y se compara con la curva OCV(SoC). La pendiente de la
+ *   curva en el SoC actual es la H del filtro, así que en la meseta plana de
+ *   la curva la tensión apenas corrige y domina el conteo.
+ *
+ * Cada actualización hace una consulta a la tabla OCV (índice por
+ * desplazamiento) y cinco divisiones de 64 bits: tres por constantes del
+ * modelo (R interna, capacidad y deriva) y dos por la varianza de la
+ * innovación (ganancia y varianza corregida). Sin bucles, el coste por
+ * muestra es constante. El estado vive en memoria RTC con número mágico y CRC (ver
+ * telemetry_retention.h), de modo que el conteo continúa tras deep sleep y
+ * reinicios en caliente; en un arranque en frío parte de la tensión.
+ *
+ * Convenio de signo: corriente de batería positiva = descarga.
+ */
+
+#ifndef TELEMETRY_SOC_H
+#define TELEMETRY_SOC_H
+
+#include <stdint.h>
+#include "telemetry_sensors.h"
+
+/** @brief Capacidad nominal de la batería (mAh) */
+#ifndef TELEM_SOC_CAPACITY_MAH
+#define TELEM_SOC_CAPACITY_MAH 3000
+#endif
+
+/** @brief Resistencia interna de la batería (mΩ) */
+#ifndef TELEM_SOC_RESISTANCE_MOHM
+#define TELEM_SOC_RESISTANCE_MOHM 80
+#endif
+
+/** @brief Desviación típica de la tensión en circuito abierto estimada (mV) */
+#ifndef TELEM_SOC_VOLTAGE_NOISE_MV
+#define TELEM_SOC_VOLTAGE_NOISE_MV 20
+#endif
+
+/** @brief Deriva del conteo de culombios: varianza añadida por hora en (%)² */
+#ifndef TELEM_SOC_DRIFT_PCT2_PER_HOUR
+#define TELEM_SOC_DRIFT_PCT2_PER_HOUR 1
+#endif
+
+/** @brief Estado de un estimador */
+typedef struct {
+  int32_t soc;            /**< Estado de carga, fracción en Q30 (2^30 = 100 %) */
+  uint32_t variance;      /**< Varianza del SoC, fracción² en Q32 */
+  uint64_t last_us;       /**< Instante de la última actualización */
+  uint32_t updates;       /**< Actualizaciones desde el arranque en frío */
+} telemetry_soc_state_t;
+
+/**
+ * @brief Arranca un estimador a partir de la tensión en reposo
+ *
+ * @param state Estimador
+ * @param voltage_q16 Tensión de batería (V, Q16.16)
+ * @param current_q16 Corriente de batería (A, Q16.16)
+ * @param now_us Instante de la muestra
+ */
+void telemetry_soc_reset(telemetry_soc_state_t* state, int32_t voltage_q16, int32_t current_q16, uint64_t now_us);
+
+/**
+ * @brief Predicción y corrección con una muestra (coste constante)
+ *
+ * @param state Estimador
+ * @param voltage_q16 Tensión de batería (V, Q16.16)
+ * @param current_q16 Corriente de batería (A, Q16.16)
+ * @param now_us Instante de la muestra
+ */
+void telemetry_soc_step(telemetry_soc_state_t* state, int32_t voltage_q16, int32_t current_q16, uint64_t now_us);
+
+/**
+ * @brief Actualiza el estimador de a bordo con el marco de muestras del ciclo
+ *
+ * @details Lo llama el recolector tras cada barrido de sensores.
+ */
+void telemetry_soc_update(const telemetry_sample_frame_t* samples);
+
+/**
+ * @brief Nivel de batería del estimador de a bordo
+ *
+ * @return uint8_t Estado de carga redondeado, 0-100 %
+ */
+uint8_t telemetry_soc_level(void);
+
+/**
+ * @brief Copia el estado del estimador de a bordo
+ */
+void telemetry_soc_get_state(telemetry_soc_state_t* state);
+
+/**
+ * @brief Mide el coste por actualización y la convergencia con una descarga simulada
+ *
+ * @details Se ejecuta desde setup() con `TELEM_SOC_BENCHMARK` definido. La
+ * batería simulada descarga con pulsos de corriente y ruido de tensión; el
+ * estimador arranca con un error inicial de 30 puntos y usa su propio
+ * estado, sin tocar el de a bordo.
+ */
+void telemetry_soc_benchmark(void);
+
+#endif // TELEMETRY_SOC_H
@@ -14,7 +14,15 @@
  * - Protección multitarea mediante mutex de FreeRTOS
  * - Manejo eficiente de condiciones de buffer lleno
  * - Estadísticas de uso y pérdida de paquetes
+ * - Deduplicación por repetición: una carga útil idéntica a la anterior de su
+ *   mismo tipo se guarda solo como encabezado dentro de una ranura de repeticiones
+ * - Iterador de instantánea sin bloqueo para volcados y consultas que no
+ *   consume paquetes ni toma el mutex
+ * - Entrega opcional de paquetes como handles del pool compartido (sin copias
+ *   entre etapas)
  * - Timeout configurable para operaciones de mutex
+ * - Conservación del contenido tras reinicios en caliente (memoria no inicializada
+ *   validada con número mágico y CRC)
  * 
  * @see https://github.com/CDFER/Ring-Buffer-Demo-ESP32-Arduino
  * @see https://www.youtube.com/watch?v=09HHWATPcwY
@@ -28,6 +36,9 @@
   #include "freertos/semphr.h"
   #include "freertos/task.h"
   #include "telemetry_types.h"
+  #include "telemetry_retention.h"
+  #include "telemetry_pool.h"
+  #include "telemetry_lock.h"
 
 
 /** @brief Capacidad máxima del buffer circular en número de paquetes */
@@ -36,6 +47,48 @@
 /** @brief Tamaño en bytes de cada paquete de telemetría */
 #define TELEM_PACKET_SIZE sizeof(telemetry_packet_t)
 
+/** @brief Activa la deduplicación de cargas útiles repetidas */
+#ifndef TELEM_DEDUP_ENABLED
+#define TELEM_DEDUP_ENABLED 1
+#endif
+
+/** @brief Tipo interno de las ranuras de repeticiones (nunca se entrega a los consumidores) */
+#define TELEM_STORAGE_REPEAT_TYPE ((telem_data_type_t)0x7F)
+
+/**
+ * @brief Encabezado compacto de un paquete cuya carga útil se repite
+ */
+typedef struct {
+  uint32_t timestamp;     /**< Timestamp del paquete */
+  uint16_t sequence;      /**< Número de secuencia del paquete */
+  uint8_t type;           /**< Tipo de telemetría */
+  uint8_t priority;       /**< Prioridad */
+} telem_repeat_entry_t;
+
+/** @brief Repeticiones que caben en una ranura del buffer */
+#define TELEM_REPEAT_ENTRIES \
+  ((sizeof(telemetry_packet_t) - sizeof(telem_header_t) - 4) / sizeof(telem_repeat_entry_t))
+
+/**
+ * @brief Ranura de repeticiones
+ *
+ * @details Cada entrada representa un paquete cuya carga útil es idéntica a la
+ * del último paquete completo de su mismo tipo. Al recuperarlo se expande
+ * con esa carga útil y los campos de encabezado de la entrada.
+ */
+typedef struct {
+  telem_header_t header;                              /**< type = TELEM_STORAGE_REPEAT_TYPE */
+  uint8_t count;                                      /**< Entradas ocupadas */
+  uint8_t reserved[3];                                /**< Relleno */
+  telem_repeat_entry_t entries[TELEM_REPEAT_ENTRIES]; /**< Encabezados de los paquetes repetidos */
+} telem_repeat_run_t;
+
+/** @brief Contenido de una ranura del buffer: un paquete completo o un grupo de repeticiones */
+typedef union {
+  telemetry_packet_t packet;      /**< Paquete completo */
+  telem_repeat_run_t repeat;      /**< Grupo de repeticiones */
+} telemetry_slot_t;
+
 /**
  * @brief Estructura principal del buffer circular de telemetría
  *
@@ -44,23 +97,70 @@
  * estadísticos y el mutex para sincronización.
  */
 typedef struct {
-  telemetry_packet_t buffer[TELEM_BUFFER_SIZE];  /**< Array circular de paquetes */
+  telemetry_slot_t buffer[TELEM_BUFFER_SIZE];    /**< Array circular de paquetes */
   uint32_t write_index;                          /**< Índice de escritura actual */
   uint32_t read_index;                           /**< Índice de lectura actual */
+  uint32_t read_entry;                           /**< Siguiente entrada de la ranura de repeticiones en lectura */
+  uint32_t pending_packets;                      /**< Paquetes pendientes (las repeticiones cuentan por separado) */
+  uint32_t packets_deduplicated;                 /**< Paquetes guardados como repetición */
+  uint32_t head_generation;                      /**< Ranuras escritas desde el arranque en frío */
+  uint32_t tail_generation;                      /**< Ranuras consumidas desde el arranque en frío */
+  uint32_t slot_generation[TELEM_BUFFER_SIZE];   /**< 2*posición+2 si la ranura es estable, impar mientras se escribe */
   uint32_t packets_written;                      /**< Total de paquetes escritos */
 	uint32_t packets_read;                         /**< Total de paquetes leídos */
-  uint32_t packets_lost;                         /**< Paquetes perdidos por buffer lleno */
-  SemaphoreHandle_t mutex;                       /**< Mutex para sincronización */
+  uint32_t packets_lost;                         /**< Paquetes perdidos por buffer lleno o corruptos */
+  uint32_t magic;                                /**< TELEM_RETENTION_MAGIC si el estado es válido */
+  uint32_t control_crc;                          /**< CRC de índices y contadores */
+  uint32_t slot_crc[TELEM_BUFFER_SIZE];          /**< CRC de cada paquete almacenado */
+  uint32_t writer_valid_mask;                    /**< Tipos con último paquete escrito conocido */
+  uint32_t reader_valid_mask;                    /**< Tipos con último paquete leído conocido */
+  telemetry_packet_t writer_last[TELEM_TYPE_COUNT]; /**< Último paquete completo escrito por tipo */
+  telemetry_packet_t reader_last[TELEM_TYPE_COUNT]; /**< Último paquete completo leído por tipo */
+  uint32_t reader_last_crc[TELEM_TYPE_COUNT];    /**< CRC de reader_last */
+  telemetry_lock_t mutex;                        /**< Mutex para sincronización (instrumentado) */
 } telemetry_buffer_t;
 
+/**
+ * @brief Iterador sobre una instantánea del buffer
+ *
+ * @details Captura las generaciones de cabeza y cola al empezar y recorre las
+ * ranuras comprobando su contador de generación antes y después de copiarlas
+ * (patrón seqlock). Las ranuras consumidas y reescritas durante el recorrido
+ * se saltan y se contabilizan en `skipped`.
+ */
+typedef struct {
+  uint32_t position;                              /**< Posición absoluta de la siguiente ranura */
+  uint32_t end;                                   /**< Generación de cabeza al capturar la instantánea */
+  uint32_t entry;                                 /**< Siguiente entrada de la ranura de repeticiones actual */
+  bool has_slot;                                  /**< true si `slot` contiene una ranura de repeticiones en curso */
+  telemetry_slot_t slot;                          /**< Copia de la ranura de repeticiones en curso */
+  uint32_t valid_mask;                            /**< Tipos con carga útil de referencia en `last` */
+  telemetry_packet_t last[TELEM_TYPE_COUNT];      /**< Último paquete completo visto por tipo */
+  uint32_t skipped;                               /**< Ranuras sobrescritas o en escritura durante el recorrido */
+  uint32_t unresolved;                            /**< Repeticiones sin carga útil de referencia en la instantánea */
+} telemetry_snapshot_t;
+
 /**
  * @brief Inicializa el sistema de almacenamiento de telemetría
  * 
  * @details Inicializa el buffer circular y crea el mutex de sincronización.
  * Debe llamarse antes de usar cualquier otra función del módulo.
+ *
+ * Tras un reinicio en caliente, si el número mágico y el CRC de los índices
+ * son válidos, el contenido del buffer se conserva y la telemetría pendiente
+ * se sigue entregando sin tocar la flash. Cada paquete se valida además con
+ * su propio CRC al recuperarlo.
  */
 void telemetry_storage_init(void);
 
+/**
+ * @brief Indica si el último telemetry_storage_init() recuperó el buffer
+ *
+ * @return true Si el contenido previo al reinicio se conservó
+ * @return false Si el buffer se inicializó vacío
+ */
+bool telemetry_storage_was_restored(void);
+
 /**
  * @brief Almacena un nuevo paquete de telemetría en el buffer
  * 
@@ -83,20 +183,69 @@ bool telemetry_store_packet(const telemetry_packet_t* packet);
  */
 bool telemetry_retrieve_packet(telemetry_packet_t* packet);
 
+/**
+ * @brief Recupera el siguiente paquete en un bloque del pool compartido
+ *
+ * @param[out] handle Handle del bloque con el paquete (una referencia)
+ * @return true Si se recuperó un paquete correctamente
+ * @return false Si el buffer está vacío, el pool está agotado o hay error de sincronización
+ *
+ * @details El paquete se copia una única vez, del buffer al pool; a partir de
+ * ahí las etapas se pasan el handle y cada consumidor adicional toma su propia
+ * referencia con telemetry_pool_retain(). Quien termine con el paquete debe
+ * llamar a telemetry_pool_release().
+ */
+bool telemetry_retrieve_handle(telem_pool_handle_t* handle);
+
+/**
+ * @brief Inicia un recorrido del contenido actual del buffer sin consumirlo
+ *
+ * @param[out] snapshot Iterador a inicializar
+ *
+ * @note No toma el mutex: los productores y consumidores no se bloquean.
+ * Si la ranura más antigua es de repeticiones parcialmente consumida, sus
+ * entradas ya leídas también se recorren.
+ */
+void telemetry_snapshot_begin(telemetry_snapshot_t* snapshot);
+
+/**
+ * @brief Obtiene el siguiente paquete de la instantánea
+ *
+ * @param snapshot Iterador iniciado con telemetry_snapshot_begin()
+ * @param[out] packet Copia del paquete (las repeticiones se expanden)
+ * @return true Si se obtuvo un paquete
+ * @return false Si se llegó al final de la instantánea
+ *
+ * @note Las repeticiones se expanden con el último paquete completo de su tipo
+ * visto en el recorrido o, para las primeras, con el último leído por el
+ * consumidor al capturar la instantánea. Si ninguno está disponible se saltan
+ * y se cuentan en `unresolved`.
+ */
+bool telemetry_snapshot_next(telemetry_snapshot_t* snapshot, telemetry_packet_t* packet);
+
 /**
  * @brief Obtiene el número de paquetes disponibles para lectura
  * 
- * @return uint32_t Número de paquetes almacenados en el buffer
+ * @return uint32_t Número de paquetes almacenados en el buffer (cada repetición
+ * deduplicada cuenta como un paquete)
  */
 uint32_t telemetry_available_packets(void);
 
 /**
  * @brief Obtiene el espacio libre en el buffer
  * 
- * @return uint32_t Número de paquetes adicionales que pueden almacenarse
+ * @return uint32_t Número de ranuras libres; cada una admite un paquete
+ * completo o hasta TELEM_REPEAT_ENTRIES repeticiones
  */
 uint32_t telemetry_free_space(void);
 
+/**
+ * @brief Obtiene el número de paquetes guardados como repetición
+ *
+ * @return uint32_t Paquetes cuya carga útil no se almacenó por ser idéntica a la anterior
+ */
+uint32_t telemetry_deduplicated_packets(void);
+
 /**
  * @brief Obtiene estadísticas de uso del buffer
  * 
@@ -109,4 +258,13 @@ uint32_t telemetry_free_space(void);
  */
 void telemetry_get_stats(uint32_t* written, uint32_t* read, uint32_t* lost);
 
+/**
+ * @brief Obtiene estadísticas del pool de paquetes compartidos
+ *
+ * @param[out] in_use Bloques del pool en uso actualmente
+ * @param[out] high_water Máximo de bloques en uso a la vez
+ * @param[out] exhausted Veces que el pool estaba agotado al recuperar un paquete
+ */
+void telemetry_get_pool_stats(uint32_t* in_use, uint32_t* high_water, uint32_t* exhausted);
+
 #endif // TELEMETRY_STORAGE_H
\ No newline at end of file
@@ -14,6 +14,10 @@
  * - Procesador: Procesa y visualiza los datos almacenados
  * - Transmisor: Simula el envío de datos a estación terrestre
  * 
+ * Cada etapa es una corrutina sin pila (telemetry_coroutine.h). Por defecto
+ * cada una tiene su propia tarea; con `TELEM_COOP_TASKS` las tres comparten
+ * una única tarea (vTelemetryCoopTask()) y se ahorran dos pilas y dos TCB.
+ * 
  * @note Las tareas están optimizadas para entorno WOKWI con intervalos
  * reducidos para facilitar la visualización durante pruebas.
  */
@@ -24,6 +28,33 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+/** @brief Periodo de las ventanas de contacto simuladas (ms) */
+#ifndef TELEM_CONTACT_PERIOD_MS
+#define TELEM_CONTACT_PERIOD_MS 30000
+#endif
+
+/** @brief Pila de la tarea del modo cooperativo: basta con la del camino más profundo */
+#ifndef TELEM_COOP_STACK_SIZE
+#define TELEM_COOP_STACK_SIZE 4096
+#endif
+
+/** @brief Periodo del trabajo de E/S del modo cooperativo (telemetry_coop_io_service()) */
+#ifndef TELEM_COOP_IO_PERIOD_MS
+#define TELEM_COOP_IO_PERIOD_MS 250
+#endif
+
+/**
+ * @brief Mayor reanudación admitida de una corrutina en el modo cooperativo
+ *
+ * @details Es el retraso máximo que una etapa puede imponer a las otras dos.
+ * Lo fija el peor caso del barrido de sensores: las lecturas por bus esperan
+ * como mucho 2 * TELEM_BUS_TIMEOUT_MS. telemetry_tasks_log_summary() marca
+ * las corrutinas que lo superan.
+ */
+#ifndef TELEM_COOP_STALL_BUDGET_US
+#define TELEM_COOP_STALL_BUDGET_US 50000
+#endif
+
 /**
  * @brief Tarea recolectora de datos de telemetría
  * @param pvParameters Parámetros de la tarea (no utilizados en esta implementación)
@@ -36,9 +67,14 @@
  * - Temperaturas de todos los subsistemas
  * - Estado operativo de subsistemas
  * 
- * La tarea utiliza la función vTaskDelayUntil() para mantener una periodicidad
- * precisa de 5 segundos, independiente del tiempo de ejecución de las funciones
- * generadoras.
+ * Los generadores están registrados en una tabla con su propio periodo (ver
+ * telemetry_generator_register()). En cada despertar la tarea ejecuta solo
+ * los vencidos y duerme hasta el siguiente vencimiento; los vencimientos son
+ * absolutos, así que la periodicidad no depende del tiempo de ejecución de
+ * los generadores. La espera es un temporizador de una sola vez del servicio
+ * de temporizadores (telemetry_timers.h) que señaliza a la corrutina.
+ * Cada paquete va al buffer, que es la cola de la bajada, y se publica en el
+ * bus de temas (telemetry_topics.h) para los consumidores a bordo.
  * 
  * @note En entorno de producción, los intervalos deberían ajustarse según
  * los requisitos específicos del proyecto y las limitaciones de energía.
@@ -51,18 +87,19 @@ void vTelemetryCollectorTask(void *pvParameters);
  * @param pvParameters Parámetros de la tarea (no utilizados en esta implementación)
  * 
  * @details
- * Esta tarea se encarga de recuperar los paquetes de telemetría del buffer
- * circular y procesarlos para su visualización y análisis. Las principales
- * funciones incluyen:
+ * Esta tarea se suscribe a todos los temas del bus (telemetry_topics.h) y
+ * procesa los paquetes para su visualización y análisis. No consume el
+ * buffer circular, que queda para el transmisor. Las principales funciones
+ * incluyen:
  * 
- * - Recuperación de paquetes del buffer de almacenamiento
+ * - Recepción de paquetes del bus como handles del pool, sin copias
  * - Procesamiento y formateo de datos para visualización
  * - Presentación estructurada en terminal
- * - Monitoreo del estado del buffer (paquetes disponibles)
+ * - Monitoreo del estado del buffer (paquetes pendientes de bajada)
  * 
- * La tarea implementa un patrón de consumo activo, donde verifica
- * constantemente la disponibilidad de nuevos paquetes. Cuando no hay datos
- * disponibles, entra en modo de espera para reducir el consumo de CPU.
+ * La tarea procesa un paquete por turno mientras haya datos. Cuando no hay
+ * datos disponibles espera el aviso del bus (o un segundo como mucho) para
+ * reducir el consumo de CPU.
  * En un sistema real, esta tarea podría incluir operaciones más
  * complejas como compresión, cifrado o detección de anomalías.
  * 
@@ -80,17 +117,61 @@ void vTelemetryProcessorTask(void *pvParameters);
  * cuando el satélite está sobre una estación terrestre.
  * 
  * Características principales:
- * - Simula ventanas de comunicación cada ~30 segundos
- * - Transmite paquetes en lotes cuando hay conectividad
+ * - Simula ventanas de comunicación cada TELEM_CONTACT_PERIOD_MS con un
+ *   temporizador periódico que despierta la tarea; fuera de ellas no se ejecuta
+ * - Transmite paquetes en lotes cuando hay conectividad, agrupados en tramas
+ *   (ver telemetry_downlink.h) construidas en la arena de pasada
+ * - Libera todos los buffers temporales de la pasada al cerrarse la ventana
  * - Implementa un mecanismo de transmisión con confirmación visual
  * - Incluye pausas entre paquetes para simular latencia de transmisión
  * 
  * @note En un sistema real, esta tarea incluiría protocolos de comunicación
  * específicos (AX.25, CSP, etc.) y manejo de errores de transmisión.
- * @note La simulación de ventanas de comunicación utiliza una condición
- * temporal simple. En un satélite real, esto se basaría en efemérides y
- * posición orbital.
+ * @note La simulación de ventanas de comunicación utiliza un periodo fijo.
+ * En un satélite real, esto se basaría en efemérides y posición orbital.
  */
 void vTelemetryTransmitterTask(void *pvParameters);
 
+/**
+ * @brief Tarea única del modo cooperativo (`TELEM_COOP_TASKS`)
+ * @param pvParameters Parámetros de la tarea (no utilizados en esta implementación)
+ * 
+ * @details
+ * Ejecuta las corrutinas del recolector, el procesador y el transmisor en
+ * ese orden de reanudación; entre paquetes de una pasada el transmisor
+ * duerme como corrutina y las otras dos siguen trabajando.
+ *
+ * Mientras una corrutina se ejecuta las otras no avanzan, así que la E/S
+ * que bloquea sale de esta tarea: sus líneas de log se difieren
+ * (telemetry_logger_defer_task()) y el archivo en SD/LittleFS lo escribe
+ * telemetry_coop_io_service() en el trabajador de mantenimiento. Lo que
+ * queda dentro tiene cota (ver TELEM_COOP_STALL_BUDGET_US):
+ * - Barrido de sensores: lecturas por bus de como mucho 2 * TELEM_BUS_TIMEOUT_MS.
+ * - Mutex del buffer (hasta 100 ms de espera): el resto de usuarios solo lo
+ *   retiene para copiar un paquete o leer contadores, y la herencia de
+ *   prioridad del mutex evita que una tarea de menor prioridad lo alargue.
+ * - Sellado de la trama y pasada del transmisor: un paquete por reanudación.
+ */
+void vTelemetryCoopTask(void *pvParameters);
+
+/**
+ * @brief Trabajo de E/S del modo cooperativo
+ * @param arg No utilizado (callback de telemetry_timers.h)
+ *
+ * @details Se programa cada TELEM_COOP_IO_PERIOD_MS en el trabajador de
+ * mantenimiento. Escribe las líneas de log diferidas de la tarea
+ * cooperativa y archiva los paquetes que recibe del bus de temas con su
+ * propia suscripción, abriendo el archivo la primera vez. La flash y la UART
+ * de este trabajo se imputan al sistema, no a las etapas.
+ */
+void telemetry_coop_io_service(void *arg);
+
+/**
+ * @brief Escribe en el log una línea por corrutina: reanudaciones y la más larga
+ *
+ * @details Las que superan TELEM_COOP_STALL_BUDGET_US se marcan con un aviso,
+ * junto con las líneas de log diferidas que se perdieron.
+ */
+void telemetry_tasks_log_summary(void);
+
 #endif /* TELEMETRY_TASKS_H */
\ No newline at end of file
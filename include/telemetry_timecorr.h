@@ -0,0 +1,82 @@
+/**
+ * @file telemetry_timecorr.h
+ * @brief Tramas de correlación de tiempo a bordo / tierra
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Las marcas de tiempo de telem_header_t son milisegundos locales desde el
+ * arranque en frío (telemetry_sleep_timestamp()) y no dicen nada de UTC. Para
+ * que tierra pueda convertirlas, el transmisor anota el reloj local de alta
+ * resolución en el instante en que sale el marcador de sincronización de una
+ * trama y lo envía después en una trama de correlación
+ * (TELEM_FRAME_FLAG_TIMECORR):
+ *
+ * - Tierra conoce el instante UTC de recepción de ese marcador (menos los
+ *   retardos de propagación y de estación), así que cada trama de correlación
+ *   aporta un par (reloj local, UTC).
+ * - Con varios pares, telemetry_correlator.h (lib/telemetry_ground, solo
+ *   en tierra) ajusta deriva y desfase y convierte en lote las marcas de
+ *   tiempo de los paquetes.
+ *
+ * Los pares solo son comparables dentro de una misma época: el reloj local
+ * vuelve a cero en cada arranque en frío y la época cambia con él.
+ */
+
+#ifndef TELEMETRY_TIMECORR_H
+#define TELEMETRY_TIMECORR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_downlink.h"
+
+/** @brief Bit de flags: la carga útil es un telem_time_correlation_t en lugar de paquetes */
+#define TELEM_FRAME_FLAG_TIMECORR 0x08
+
+/** @brief Cada cuántas tramas de una pasada se envía una correlación (la primera siempre) */
+#ifndef TELEM_TIMECORR_PERIOD
+#define TELEM_TIMECORR_PERIOD 4
+#endif
+
+/** @brief Correlación entre el reloj local y la emisión del marcador de una trama */
+typedef struct __attribute__((packed)) {
+  uint32_t epoch;             /**< Identificador del dominio de reloj (cambia en cada arranque en frío) */
+  uint16_t marker_sequence;   /**< Trama cuyo marcador de sincronización se anotó */
+  uint64_t marker_local_us;   /**< Reloj local (µs, base de telemetry_sleep_timestamp_us()) al emitir el marcador */
+} telem_time_correlation_t;
+
+/**
+ * @brief Elige la época del dominio de reloj si aún no existe
+ */
+void telemetry_timecorr_init(void);
+
+/**
+ * @brief Anota el instante de emisión del marcador de una trama
+ *
+ * @param frame_sequence Trama que se acaba de entregar al transmisor
+ *
+ * @details Debe llamarse justo al entregar la trama, sin trabajo en medio.
+ */
+void telemetry_timecorr_mark(uint16_t frame_sequence);
+
+/**
+ * @brief Indica si tras la trama n-ésima de la pasada toca enviar una correlación
+ *
+ * @param frame_in_pass Posición de la trama en la pasada (0 = primera)
+ */
+bool telemetry_timecorr_due(uint32_t frame_in_pass);
+
+/**
+ * @brief Construye una trama de correlación con el último marcador anotado
+ *
+ * @param frame Trama a construir
+ * @param buffer Memoria para la trama
+ * @param capacity Tamaño de buffer (más TELEM_AUTH_OVERHEAD con `TELEM_DOWNLINK_AUTH`)
+ * @param frame_sequence Número de secuencia de la trama de correlación
+ * @return true Si había un marcador anotado y la trama cabe
+ */
+bool telemetry_timecorr_frame(telemetry_frame_t* frame, uint8_t* buffer, size_t capacity,
+                              uint16_t frame_sequence);
+
+#endif // TELEMETRY_TIMECORR_H
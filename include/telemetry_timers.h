@@ -0,0 +1,144 @@
+/**
+ * @file telemetry_timers.h
+ * @brief Servicio de temporizadores con rueda jerárquica
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Todo el trabajo periódico y diferido del sistema (ticks del recolector,
+ * ventanas de contacto, volcados del log, línea de estado, vigilancia del
+ * bajo consumo) se programa aquí en lugar de repartirse en retardos y
+ * comparaciones con millis() dentro de cada tarea.
+ *
+ * La rueda tiene TELEM_TIMER_LEVELS niveles de 64 ranuras en ticks de
+ * FreeRTOS: el nivel 0 cubre 64 ticks con resolución de un tick y cada nivel
+ * siguiente 64 veces más (unas 4,6 h con cuatro niveles a 1 kHz).
+ *
+ * - Insertar y cancelar son O(1): el nivel sale de la distancia al
+ *   vencimiento y la ranura de sus bits; cada temporizador es un nodo de una
+ *   lista doblemente enlazada que reserva quien lo usa.
+ * - Los temporizadores de niveles altos bajan de nivel al pasar por los
+ *   límites de bloque, como mucho una vez por nivel.
+ * - Un mapa de bits de ranuras ocupadas por nivel permite saltar los ticks
+ *   vacíos y calcular el próximo vencimiento exacto: la tarea de servicio
+ *   solo despierta cuando vence algo o cuando se programa un vencimiento
+ *   anterior al que esperaba.
+ *
+ * Los callbacks no se ejecutan en la tarea de servicio salvo que lo pidan
+ * (TELEM_TIMER_WORKER_SERVICE, para avisos breves). El resto se encola al
+ * trabajador designado y lo ejecuta la tarea que lo atiende con
+ * telemetry_timers_dispatch().
+ */
+
+#ifndef TELEMETRY_TIMERS_H
+#define TELEMETRY_TIMERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Niveles de la rueda (64 ranuras cada uno) */
+#define TELEM_TIMER_LEVELS 4
+
+/** @brief Trabajos en cola por trabajador */
+#ifndef TELEM_TIMER_QUEUE_LENGTH
+#define TELEM_TIMER_QUEUE_LENGTH 8
+#endif
+
+/** @brief Prioridad de la tarea de servicio (por encima de las de telemetría y de bus) */
+#ifndef TELEM_TIMER_TASK_PRIORITY
+#define TELEM_TIMER_TASK_PRIORITY 4
+#endif
+
+/** @brief Espera indefinida en telemetry_timers_dispatch() */
+#define TELEM_TIMER_FOREVER UINT32_MAX
+
+/** @brief Tareas que ejecutan los callbacks */
+typedef enum {
+  TELEM_TIMER_WORKER_SERVICE = 0,   /**< La propia tarea de servicio: avisos breves que no bloquean */
+  TELEM_TIMER_WORKER_MAINTENANCE,   /**< Tarea de Arduino (loop()): volcados, estado y bajo consumo */
+  TELEM_TIMER_WORKER_COUNT
+} telem_timer_worker_t;
+
+/** @brief Callback de un temporizador */
+typedef void (*telemetry_timer_callback_t)(void* arg);
+
+/** @brief Temporizador; lo reserva quien lo usa y debe vivir mientras esté activo */
+typedef struct telemetry_timer {
+  struct telemetry_timer* next;         /**< Lista de la ranura */
+  struct telemetry_timer* prev;
+  uint32_t expires;                     /**< Tick de vencimiento */
+  uint32_t period;                      /**< Periodo en ticks (0 = una sola vez) */
+  uint32_t due;                         /**< Vencimiento del último disparo */
+  telemetry_timer_callback_t callback;
+  void* arg;
+  const char* name;
+  uint8_t worker;                       /**< telem_timer_worker_t */
+  uint8_t flags;                        /**< Uso interno */
+  uint8_t level;                        /**< Uso interno: nivel de la rueda */
+  uint8_t slot;                         /**< Uso interno: ranura del nivel */
+  uint32_t runs;                        /**< Callbacks ejecutados */
+  uint32_t overruns;                    /**< Disparos perdidos porque el anterior seguía en cola */
+} telemetry_timer_t;
+
+/** @brief Estadísticas del servicio */
+typedef struct {
+  uint32_t wakeups;           /**< Despertares de la tarea de servicio */
+  uint32_t expirations;       /**< Vencimientos procesados */
+  uint32_t cascades;          /**< Temporizadores bajados de nivel */
+  uint32_t overruns;          /**< Disparos perdidos (cola llena o trabajo anterior pendiente) */
+  uint32_t max_latency_ms;    /**< Mayor retraso entre vencimiento y inicio del callback */
+  uint32_t active;            /**< Temporizadores en la rueda */
+} telemetry_timer_stats_t;
+
+/**
+ * @brief Crea la tarea de servicio y las colas de los trabajadores
+ *
+ * @return true Si el servicio quedó operativo
+ */
+bool telemetry_timers_init(void);
+
+/**
+ * @brief Prepara un temporizador sin activarlo
+ *
+ * @param timer Temporizador
+ * @param name Nombre para los informes
+ * @param callback Función a ejecutar
+ * @param arg Argumento del callback
+ * @param worker Tarea que ejecuta el callback
+ */
+void telemetry_timer_setup(telemetry_timer_t* timer, const char* name, telemetry_timer_callback_t callback,
+                           void* arg, telem_timer_worker_t worker);
+
+/**
+ * @brief Arma (o rearma) un temporizador
+ *
+ * @param timer Temporizador preparado con telemetry_timer_setup()
+ * @param delay_ms Retardo hasta el primer vencimiento
+ * @param period_ms Periodo de los siguientes (0 = una sola vez)
+ *
+ * @details Los periódicos avanzan desde su vencimiento anterior, así que no
+ * acumulan deriva; si el servicio se retrasa más de un periodo no se
+ * recuperan los disparos perdidos en ráfaga.
+ */
+void telemetry_timer_start(telemetry_timer_t* timer, uint32_t delay_ms, uint32_t period_ms);
+
+/**
+ * @brief Desarma un temporizador; un disparo ya encolado se descarta
+ */
+void telemetry_timer_stop(telemetry_timer_t* timer);
+
+/**
+ * @brief Ejecuta un trabajo pendiente de un trabajador
+ *
+ * @param worker Trabajador que atiende la tarea actual
+ * @param timeout_ms Espera máxima (TELEM_TIMER_FOREVER = sin límite)
+ * @return true Si se recibió un trabajo
+ */
+bool telemetry_timers_dispatch(telem_timer_worker_t worker, uint32_t timeout_ms);
+
+/**
+ * @brief Obtiene las estadísticas del servicio
+ */
+void telemetry_timers_get_stats(telemetry_timer_stats_t* stats);
+
+#endif // TELEMETRY_TIMERS_H
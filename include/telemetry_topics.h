@@ -0,0 +1,146 @@
+/**
+ * @file telemetry_topics.h
+ * @brief Bus de publicación/suscripción por tipo de telemetría
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * El buffer principal es una única cola FIFO: cada paquete lo recibe un solo
+ * consumidor. Es la cola de la bajada, que vacía el transmisor en cada
+ * ventana de contacto. Los consumidores a bordo (procesador, comprobación de
+ * límites, baliza, archivo...) se suscriben en su lugar a este bus y cada uno
+ * recibe su propia referencia a los paquetes que le interesan.
+ *
+ * - Los temas son los tipos de telemetría (telem_data_type_t y los propios a
+ *   partir de TELEM_TYPE_COUNT): cada suscriptor da una máscara de tipos.
+ * - El paquete se copia una vez al pool compartido (telemetry_pool.h); a
+ *   cada suscriptor se le entrega el handle con una referencia más. Publicar
+ *   cuesta O(suscriptores) y no reserva memoria: las colas de handles se
+ *   crean al suscribirse.
+ * - Si la cola de un suscriptor está llena el paquete se descarta solo para
+ *   él. Si el pool está agotado no llega a ninguno y se anota en todos los
+ *   suscriptores de su tipo. Cada suscriptor lleva sus propias estadísticas
+ *   de contrapresión: entregados, descartados, recibidos y máximo de la cola.
+ */
+
+#ifndef TELEMETRY_TOPICS_H
+#define TELEMETRY_TOPICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "telemetry_types.h"
+#include "telemetry_pool.h"
+
+/** @brief Suscriptores como máximo */
+#ifndef TELEM_TOPIC_MAX_SUBSCRIBERS
+#define TELEM_TOPIC_MAX_SUBSCRIBERS 4
+#endif
+
+/**
+ * @brief Handles en cola por suscriptor
+ *
+ * @note Entre todas las colas pueden retener hasta
+ * TELEM_TOPIC_MAX_SUBSCRIBERS * TELEM_TOPIC_QUEUE_LENGTH bloques del pool.
+ */
+#ifndef TELEM_TOPIC_QUEUE_LENGTH
+#define TELEM_TOPIC_QUEUE_LENGTH 8
+#endif
+
+/** @brief Bit de un tipo en la máscara de suscripción */
+#define TELEM_TOPIC_MASK(type) (1UL << (type))
+
+/** @brief Todos los tipos, incluidos los propios fuera de la máscara */
+#define TELEM_TOPIC_ALL UINT32_MAX
+
+/** @brief Identificador de un suscriptor (posición en el registro) */
+typedef uint8_t telem_topic_sub_t;
+
+/** @brief Suscriptor no registrado */
+#define TELEM_TOPIC_INVALID UINT8_MAX
+
+/**
+ * @brief Aviso al suscriptor de que tiene paquetes en cola
+ *
+ * @details Se ejecuta en la tarea que publica: solo debe despertar al
+ * suscriptor (p. ej. con telemetry_co_signal()).
+ */
+typedef void (*telemetry_topic_notify_t)(void* arg);
+
+/** @brief Estadísticas de un suscriptor */
+typedef struct {
+  const char* name;
+  uint32_t mask;              /**< Tipos suscritos */
+  uint32_t delivered;         /**< Paquetes puestos en su cola */
+  uint32_t dropped;           /**< Paquetes descartados con la cola llena */
+  uint32_t pool_dropped;      /**< Paquetes perdidos con el pool agotado */
+  uint32_t received;          /**< Paquetes retirados de la cola */
+  uint32_t queued;            /**< En cola ahora */
+  uint32_t high_water;        /**< Máximo en cola */
+} telemetry_topic_stats_t;
+
+/**
+ * @brief Registra un suscriptor
+ *
+ * @param name Nombre para los informes (debe vivir mientras el sistema funcione)
+ * @param mask Tipos que recibe (TELEM_TOPIC_MASK() combinados o TELEM_TOPIC_ALL)
+ * @param notify Aviso tras cada entrega (puede ser NULL si el suscriptor sondea)
+ * @param arg Argumento del aviso
+ * @return telem_topic_sub_t Identificador o TELEM_TOPIC_INVALID si no queda
+ * sitio o no se pudo crear la cola
+ *
+ * @details Se puede llamar desde cualquier tarea, también mientras otra
+ * publica. Solo recibe lo que se publique a partir de este momento.
+ */
+telem_topic_sub_t telemetry_topic_subscribe(const char* name, uint32_t mask,
+                                            telemetry_topic_notify_t notify, void* arg);
+
+/**
+ * @brief Entrega un paquete del pool a los suscriptores de su tipo
+ *
+ * @param handle Handle válido; quien publica conserva su referencia
+ * @return uint32_t Suscriptores a los que se entregó
+ */
+uint32_t telemetry_topic_publish(telem_pool_handle_t handle);
+
+/**
+ * @brief Copia un paquete al pool y lo publica
+ *
+ * @param packet Paquete completo
+ * @return true Si se pudo publicar (aunque ningún suscriptor lo quisiera)
+ * @return false Si el pool está agotado (se cuenta en pool_dropped de los
+ * suscriptores del tipo)
+ */
+bool telemetry_topic_publish_packet(const telemetry_packet_t* packet);
+
+/**
+ * @brief Retira el siguiente paquete de la cola de un suscriptor
+ *
+ * @param subscriber Suscriptor
+ * @param[out] handle Handle con una referencia que debe liberar quien lo recibe
+ * (telemetry_pool_release())
+ * @param timeout Espera máxima en ticks (0 para sondear)
+ * @return true Si había un paquete
+ */
+bool telemetry_topic_receive(telem_topic_sub_t subscriber, telem_pool_handle_t* handle,
+                             TickType_t timeout);
+
+/**
+ * @brief Paquetes en cola entre todos los suscriptores
+ */
+uint32_t telemetry_topic_pending(void);
+
+/**
+ * @brief Copia las estadísticas de un suscriptor
+ *
+ * @return false Si el suscriptor no existe
+ */
+bool telemetry_topic_get_stats(telem_topic_sub_t subscriber, telemetry_topic_stats_t* stats);
+
+/**
+ * @brief Escribe en el log una línea por suscriptor
+ */
+void telemetry_topic_log_summary(void);
+
+#endif // TELEMETRY_TOPICS_H
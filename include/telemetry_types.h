@@ -24,9 +24,22 @@ typedef enum {
     TELEM_SYSTEM_STATUS = 0,      /**< Estado general del sistema */
     TELEM_POWER_DATA,             /**< Datos del sistema de potencia */
     TELEM_TEMPERATURE_DATA,       /**< Mediciones de temperatura */
-    TELEM_COMMUNICATION_STATUS    /**< Estado de comunicaciones */
+    TELEM_COMMUNICATION_STATUS,   /**< Estado de comunicaciones */
+    TELEM_HOUSEKEEPING            /**< Registro combinado de un ciclo completo del recolector */
 } telem_data_type_t;
 
+/** @brief Número de tipos de telemetría definidos */
+#define TELEM_TYPE_COUNT (TELEM_HOUSEKEEPING + 1)
+
+/**
+ * @brief Mayor identificador de tipo que cabe en el encabezado empaquetado
+ *
+ * @details Los identificadores entre TELEM_TYPE_COUNT y este valor quedan
+ * para paquetes propios (ver telemetry_generator_t); el campo de tipo del
+ * encabezado empaquetado ocupa 3 bits.
+ */
+#define TELEM_TYPE_MAX 7
+
 /**
  * @brief Encabezado común para todos los paquetes de telemetría
  *
@@ -41,11 +54,25 @@ typedef struct {
     uint8_t priority;         /**< Prioridad (0=low,1=normal,2=high) */
 } telem_header_t;
 
+/**
+ * @brief Rangos válidos de los campos del encabezado
+ *
+ * @details Tabla X-macro usada por el empaquetador de bits
+ * (telemetry_bitpack.h): FIELD(campo, mínimo, máximo) para campos enteros y
+ * RAW_FLOAT(campo) para floats, que se transmiten con sus 32 bits.
+ */
+#define TELEM_HEADER_FIELDS(FIELD, RAW_FLOAT) \
+    FIELD(type, 0, TELEM_TYPE_MAX) \
+    FIELD(timestamp, 0, UINT32_MAX) \
+    FIELD(sequence, 0, UINT16_MAX) \
+    FIELD(priority, 0, 2)
+
 /**
  * @brief Datos de estado general del sistema
  *
  * @details Contiene métricas del OBC como uptime, uso CPU, marcas de pila y memoria
- * libre, así como conteos de tareas y errores.
+ * libre, así como conteos de tareas y errores, y el consumo estimado de la
+ * propia telemetría (ver telemetry_energy.h).
  */
 typedef struct {
     telem_header_t header;        /**< Encabezado común */
@@ -56,8 +83,22 @@ typedef struct {
     uint32_t heap_free;           /**< Memoria heap libre en bytes */
     uint8_t task_count;           /**< Número de tareas activas */
     float cpu_temperature;       /**< Temperatura CPU del ESP32 en celsius */
+    uint32_t energy_total_mj;     /**< Energía estimada consumida por la telemetría (mJ) */
+    uint16_t energy_per_packet_uj; /**< Energía estimada por paquete generado (µJ) */
 } system_status_telem_t;
 
+/** @brief Rangos válidos de system_status_telem_t (ver TELEM_HEADER_FIELDS) */
+#define TELEM_SYSTEM_STATUS_FIELDS(FIELD, RAW_FLOAT) \
+    FIELD(uptime_seconds, 0, UINT32_MAX) \
+    FIELD(system_mode, 0, 3) \
+    FIELD(cpu_usage, 0, 100) \
+    FIELD(stack_high_water, 0, UINT16_MAX) \
+    FIELD(heap_free, 0, 524287) \
+    FIELD(task_count, 0, 63) \
+    RAW_FLOAT(cpu_temperature) \
+    FIELD(energy_total_mj, 0, UINT32_MAX) \
+    FIELD(energy_per_packet_uj, 0, UINT16_MAX)
+
 /**
  * @brief Datos del sistema de potencia
  *
@@ -75,6 +116,16 @@ typedef struct {
     uint8_t power_state;          /**< Estado de potencia (codificado) */
 } power_telem_t;
 
+/** @brief Rangos válidos de power_telem_t (ver TELEM_HEADER_FIELDS) */
+#define TELEM_POWER_FIELDS(FIELD, RAW_FLOAT) \
+    RAW_FLOAT(battery_voltage) \
+    RAW_FLOAT(battery_current) \
+    RAW_FLOAT(solar_panel_voltage) \
+    RAW_FLOAT(solar_panel_current) \
+    FIELD(battery_level, 0, 100) \
+    FIELD(battery_temperature, -40, 85) \
+    FIELD(power_state, 0, 15)
+
 /**
  * @brief Datos de temperatura del bus espacial
  *
@@ -89,6 +140,14 @@ typedef struct {
     int16_t external_temperature;   /**< Temperatura externa/ambiente */
 } temperature_telem_t;
 
+/** @brief Rangos válidos de temperature_telem_t en °C (ver TELEM_HEADER_FIELDS) */
+#define TELEM_TEMPERATURE_FIELDS(FIELD, RAW_FLOAT) \
+    FIELD(obc_temperature, -60, 150) \
+    FIELD(comms_temperature, -60, 150) \
+    FIELD(payload_temperature, -60, 150) \
+    FIELD(battery_temperature, -60, 150) \
+    FIELD(external_temperature, -150, 150)
+
 /**
  * @brief Estado de subsistemas / máquinas a bordo
  *
@@ -107,6 +166,49 @@ typedef struct {
     uint8_t command_success_rate;   /**< Tasa de éxito de comandos (%) */
 } subsystem_status_telem_t;
 
+/** @brief Rangos válidos de subsystem_status_telem_t (ver TELEM_HEADER_FIELDS) */
+#define TELEM_SUBSYSTEM_FIELDS(FIELD, RAW_FLOAT) \
+    FIELD(comms_status, 0, 15) \
+    FIELD(adcs_status, 0, 15) \
+    FIELD(payload_status, 0, 15) \
+    FIELD(power_status, 0, 15) \
+    FIELD(comms_uptime, 0, UINT32_MAX) \
+    FIELD(payload_uptime, 0, UINT32_MAX) \
+    FIELD(last_command_id, 0, UINT8_MAX) \
+    FIELD(command_success_rate, 0, 100)
+
+/**
+ * @brief Tamaño de un paquete en bytes
+ *
+ * @details El registro combinado de housekeeping necesita 96 bytes; sin
+ * `TELEM_MERGED_HOUSEKEEPING` los paquetes siguen en 64 y no se paga ese
+ * tercio de más en cada ranura del buffer y del pool.
+ */
+#ifdef TELEM_MERGED_HOUSEKEEPING
+#define TELEM_PACKET_RAW_SIZE 96
+#else
+#define TELEM_PACKET_RAW_SIZE 64
+#endif
+
+/** @brief Capacidad para las cargas útiles concatenadas de un registro de housekeeping */
+#define TELEM_HK_PAYLOAD_SIZE (TELEM_PACKET_RAW_SIZE - 16)
+
+/**
+ * @brief Registro combinado de housekeeping de un ciclo del recolector
+ *
+ * @details Sustituye a los cuatro paquetes de un ciclo (sistema, potencia,
+ * temperaturas y subsistemas) por un único registro con un solo encabezado.
+ * `presence` indica qué cargas útiles contiene (bit n = tipo n) y estas se
+ * guardan seguidas, sin su encabezado y en orden creciente de tipo.
+ * Ver telemetry_housekeeping.h para construirlo y expandirlo.
+ */
+typedef struct {
+    telem_header_t header;          /**< Encabezado común compartido por todo el ciclo */
+    uint8_t presence;               /**< Mapa de bits de cargas útiles presentes */
+    uint8_t payload_length;         /**< Bytes ocupados en payloads */
+    uint8_t payloads[TELEM_HK_PAYLOAD_SIZE]; /**< Cargas útiles concatenadas */
+} housekeeping_telem_t;
+
 /**
  * @brief Unión que representa un paquete de telemetría genérico
  *
@@ -119,7 +221,8 @@ typedef union {
     power_telem_t power;                   /**< Datos de potencia */
     temperature_telem_t temperature;       /**< Datos de temperatura */
     subsystem_status_telem_t subsystems;   /**< Estados de subsistemas */
-    uint8_t raw_data[64];                  /**< Buffer crudo para datos genéricos */
+    housekeeping_telem_t housekeeping;     /**< Registro combinado de housekeeping */
+    uint8_t raw_data[TELEM_PACKET_RAW_SIZE]; /**< Buffer crudo para datos genéricos */
 } telemetry_packet_t;
 
 #endif // TELEMETRY_TYPES_H
\ No newline at end of file
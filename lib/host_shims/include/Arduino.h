@@ -0,0 +1,72 @@
+/**
+ * @file Arduino.h
+ * @brief Subconjunto de la API de Arduino-ESP32 para el entorno native
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+/** @brief Puerto serie: la salida va a stdout */
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  size_t print(const char* text);
+  size_t println(const char* text);
+  size_t println(void);
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  size_t write(uint8_t byte);
+  size_t write(const uint8_t* data, size_t length);
+  void flush(void);
+};
+extern HardwareSerial Serial;
+
+/** @brief Contador de ciclos: en el PC, nanosegundos del reloj monotónico */
+class EspClass {
+public:
+  uint32_t getCycleCount(void);
+  uint32_t getCpuFreqMHz(void);
+  uint32_t getFreeHeap(void);
+};
+extern EspClass ESP;
+
+#define INPUT 1
+#define OUTPUT 3
+#define INPUT_PULLUP 5
+#define HIGH 1
+#define LOW 0
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+int analogRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+uint8_t digitalPinToInterrupt(uint8_t pin);
+
+/** @brief Temperatura interna del ESP32 (fija en el PC) */
+float temperatureRead(void);
+
+#endif // HOST_ARDUINO_H
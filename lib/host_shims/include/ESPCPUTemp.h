@@ -0,0 +1,11 @@
+/**
+ * @file ESPCPUTemp.h
+ * @brief Sustituto vacío de la biblioteca ESPCPUTemp (temperatureRead() está en Arduino.h)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_ESPCPUTEMP_H
+#define HOST_ESPCPUTEMP_H
+
+#endif // HOST_ESPCPUTEMP_H
@@ -0,0 +1,67 @@
+/**
+ * @file FS.h
+ * @brief Ficheros de Arduino-ESP32 sobre ficheros del PC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+public:
+  File() : handle(nullptr) {}
+  explicit File(void* handle) : handle(handle) {}
+  operator bool() const;
+  size_t size() const;
+  size_t position() const;
+  int available(void);
+  int read(void);
+  size_t read(uint8_t* buffer, size_t length);
+  size_t write(const uint8_t* buffer, size_t length);
+  size_t write(uint8_t byte);
+  size_t println(const char* text);
+  bool seek(uint32_t position, SeekMode mode = SeekSet);
+  void flush(void);
+  void close(void);
+
+private:
+  void* handle;
+};
+
+/** @brief Sistema de ficheros montado en un subdirectorio de host_shims_root() */
+class FS {
+public:
+  explicit FS(const char* mount) : mount(mount) {}
+  File open(const char* path, const char* mode = FILE_READ, bool create = false);
+  bool exists(const char* path);
+  bool remove(const char* path);
+  bool mkdir(const char* path);
+
+protected:
+  std::string path_of(const char* path) const;
+  const char* mount;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif // HOST_FS_H
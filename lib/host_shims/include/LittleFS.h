@@ -0,0 +1,22 @@
+/**
+ * @file LittleFS.h
+ * @brief LittleFS de Arduino-ESP32 sobre un directorio del PC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+public:
+  LittleFSFS() : fs::FS("littlefs") {}
+  bool begin(bool format_on_fail = false);
+  size_t totalBytes(void);
+  size_t usedBytes(void);
+};
+extern LittleFSFS LittleFS;
+
+#endif // HOST_LITTLEFS_H
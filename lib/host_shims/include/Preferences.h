@@ -0,0 +1,34 @@
+/**
+ * @file Preferences.h
+ * @brief Preferences (NVS) de Arduino-ESP32 sobre ficheros del PC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Cada clave es un fichero `nvs/<espacio>.<clave>` bajo
+ * host_shims_root(), así que sobrevive a un proceso hijo que simula un
+ * arranque en frío. host_shims_fail_nvs() hace fallar las escrituras.
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class Preferences {
+public:
+  bool begin(const char* name, bool read_only = false);
+  void end(void);
+  bool isKey(const char* key);
+  uint32_t getUInt(const char* key, uint32_t default_value = 0);
+  size_t putUInt(const char* key, uint32_t value);
+
+private:
+  std::string path_of(const char* key) const;
+  std::string space;
+  bool opened = false;
+  bool read_only = false;
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,27 @@
+/**
+ * @file SD.h
+ * @brief Tarjeta SD de Arduino-ESP32 sobre un directorio del PC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Por defecto no hay tarjeta: begin() falla hasta que la prueba la
+ * monta con host_shims_set_sd_present().
+ */
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include "FS.h"
+#include "SPI.h"
+
+class SDFS : public fs::FS {
+public:
+  SDFS() : fs::FS("sd") {}
+  bool begin(uint8_t ss_pin = 5, SPIClass& spi = SPI, uint32_t frequency = 4000000,
+             const char* mountpoint = "/sd", uint8_t max_files = 5, bool format_if_empty = false);
+  uint64_t cardSize(void);
+  void end(void);
+};
+extern SDFS SD;
+
+#endif // HOST_SD_H
@@ -0,0 +1,26 @@
+/**
+ * @file SPI.h
+ * @brief Bus SPI de Arduino-ESP32 (sin efecto en el PC)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <stdint.h>
+
+#define VSPI 3
+#define HSPI 2
+
+class SPIClass {
+public:
+  explicit SPIClass(uint8_t bus = VSPI) : bus(bus) {}
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+
+private:
+  uint8_t bus;
+};
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
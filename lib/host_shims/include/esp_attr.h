@@ -0,0 +1,22 @@
+/**
+ * @file esp_attr.h
+ * @brief Atributos de colocación de ESP-IDF (sin efecto en el PC)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details La memoria "no inicializada" del PC se pone a cero al arrancar el
+ * proceso, así que cada ejecución de prueba es un arranque en frío.
+ */
+
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_FAST_ATTR
+#define RTC_SLOW_ATTR
+#define __NOINIT_ATTR
+
+#endif // HOST_ESP_ATTR_H
@@ -0,0 +1,11 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Cabecera vacía de ESP-IDF para el entorno native
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#endif // HOST_ESP_HEAP_CAPS_H
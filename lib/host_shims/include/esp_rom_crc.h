@@ -0,0 +1,15 @@
+/**
+ * @file esp_rom_crc.h
+ * @brief CRC32 de la ROM del ESP32, en software
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_ESP_ROM_CRC_H
+#define HOST_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const* buf, uint32_t len);
+
+#endif // HOST_ESP_ROM_CRC_H
@@ -0,0 +1,13 @@
+/**
+ * @file timers.h
+ * @brief Cabecera de temporizadores de FreeRTOS (el firmware usa esp_timer)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#ifndef HOST_FREERTOS_TIMERS_H
+#define HOST_FREERTOS_TIMERS_H
+
+#include "FreeRTOS.h"
+
+#endif // HOST_FREERTOS_TIMERS_H
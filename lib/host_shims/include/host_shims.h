@@ -0,0 +1,101 @@
+/**
+ * @file host_shims.h
+ * @brief Control de los sustitutos del entorno native desde las pruebas
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * La biblioteca host_shims implementa en el PC lo que los módulos de
+ * telemetría usan de Arduino, FreeRTOS y ESP-IDF, para compilarlos sin
+ * cambios en el entorno `native` de PlatformIO (`pio test -e native`):
+ *
+ * - Tareas de FreeRTOS sobre hilos POSIX, con notificaciones, colas, mutex
+ *   con propietario y tiempo de CPU por tarea (ulTaskGetRunTimeCounter).
+ * - esp_get_free_heap_size() parte de 200 KB y descuenta la pila de las
+ *   tareas vivas, como en el ESP32; el TCB no se simula.
+ * - Las secciones críticas y el contexto de ISR se emulan con un único
+ *   cerrojo global; una "ISR" es cualquier hilo que llame a las funciones
+ *   FromISR.
+ * - LittleFS y la tarjeta SD son directorios, cada clave de Preferences
+ *   (NVS) es un fichero y la partición del archivo
+ *   mapeado es un fichero mapeado con mmap (escrituras en AND, como la flash
+ *   NOR).
+ * - El cifrado GCM es un sustituto sin seguridad: conserva la interfaz, el
+ *   tamaño de la etiqueta y la detección de manipulaciones, y permite
+ *   inyectar fallos.
+ *
+ * Todos los ficheros viven bajo host_shims_root(), que por defecto es un
+ * directorio temporal propio del proceso.
+ */
+
+#ifndef HOST_SHIMS_H
+#define HOST_SHIMS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Directorio raíz de los ficheros simulados
+ *
+ * @details Se toma de la variable de entorno `TELEM_HOST_ROOT` o, si no
+ * existe, de un directorio temporal creado al primer uso.
+ */
+const char* host_shims_root(void);
+
+/**
+ * @brief Borra todos los ficheros simulados (LittleFS, SD, NVS y partición)
+ */
+void host_shims_reset_storage(void);
+
+/**
+ * @brief Fija la lectura de una entrada analógica
+ *
+ * @param pin Pin del ADC
+ * @param raw Cuentas que devolverá analogRead()
+ * @param millivolts Tensión que devolverá analogReadMilliVolts()
+ */
+void host_shims_set_analog(uint8_t pin, int raw, uint32_t millivolts);
+
+/**
+ * @brief Lanza la interrupción que attachInterrupt() instaló en un pin
+ *
+ * @details El manejador se ejecuta en el hilo que llama, que mientras tanto
+ * se ve a sí mismo en contexto de ISR (xPortInIsrContext()).
+ *
+ * @return false Si el pin no tiene manejador
+ */
+bool host_shims_trigger_interrupt(uint8_t pin);
+
+/**
+ * @brief Monta o desmonta la tarjeta SD simulada
+ */
+void host_shims_set_sd_present(bool present);
+
+/**
+ * @brief Hace fallar las siguientes operaciones de cifrado GCM
+ *
+ * @param count Operaciones que fallarán (0 = ninguna)
+ */
+void host_shims_fail_gcm(uint32_t count);
+
+/**
+ * @brief Hace fallar las siguientes escrituras de Preferences (NVS)
+ *
+ * @param count Escrituras que fallarán (0 = ninguna)
+ */
+void host_shims_fail_nvs(uint32_t count);
+
+/**
+ * @brief Causa del último reinicio que devolverá esp_reset_reason()
+ */
+void host_shims_set_reset_reason(int reason);
+
+/**
+ * @brief Veces que se ha llamado a esp_deep_sleep_start()
+ *
+ * @details En el PC dormir no reinicia: el hilo que duerme se queda parado
+ * para siempre y la prueba comprueba lo que quedó hecho antes.
+ */
+uint32_t host_shims_deep_sleeps(void);
+
+#endif // HOST_SHIMS_H
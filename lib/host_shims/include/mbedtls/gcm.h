@@ -0,0 +1,55 @@
+/**
+ * @file gcm.h
+ * @brief API de AES-GCM de mbedTLS para el entorno native
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details La implementación del PC NO es AES: es un cifrado de flujo con
+ * etiqueta de 128 bits, suficiente para probar el sellado, la detección de
+ * manipulaciones y los fallos (host_shims_fail_gcm()). No sirve para
+ * comprobar vectores de prueba de AES-GCM.
+ */
+
+#ifndef HOST_MBEDTLS_GCM_H
+#define HOST_MBEDTLS_GCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_GCM_ENCRYPT 1
+#define MBEDTLS_GCM_DECRYPT 0
+#define MBEDTLS_ERR_GCM_AUTH_FAILED -0x0012
+#define MBEDTLS_ERR_GCM_BAD_INPUT -0x0014
+
+typedef enum {
+  MBEDTLS_CIPHER_ID_NONE = 0,
+  MBEDTLS_CIPHER_ID_NULL,
+  MBEDTLS_CIPHER_ID_AES
+} mbedtls_cipher_id_t;
+
+typedef struct {
+  uint8_t key[32];
+  unsigned int key_bits;
+} mbedtls_gcm_context;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void mbedtls_gcm_init(mbedtls_gcm_context* ctx);
+int mbedtls_gcm_setkey(mbedtls_gcm_context* ctx, mbedtls_cipher_id_t cipher, const unsigned char* key,
+                       unsigned int key_bits);
+int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context* ctx, int mode, size_t length, const unsigned char* iv,
+                              size_t iv_len, const unsigned char* add, size_t add_len,
+                              const unsigned char* input, unsigned char* output, size_t tag_len,
+                              unsigned char* tag);
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context* ctx, size_t length, const unsigned char* iv, size_t iv_len,
+                             const unsigned char* add, size_t add_len, const unsigned char* tag,
+                             size_t tag_len, const unsigned char* input, unsigned char* output);
+void mbedtls_gcm_free(mbedtls_gcm_context* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_MBEDTLS_GCM_H
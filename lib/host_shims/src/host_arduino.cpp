@@ -0,0 +1,216 @@
+/**
+ * @file host_arduino.cpp
+ * @brief Arduino-ESP32 y funciones de sistema de ESP-IDF en el PC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_rom_crc.h"
+#include "esp_sleep.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_shims.h"
+
+/** @brief Pines del ADC simulados */
+#define HOST_ANALOG_PINS 40
+
+HardwareSerial Serial;
+EspClass ESP;
+
+/** @brief Pines GPIO simulados */
+#define HOST_GPIO_PINS 40
+
+static int analog_raw[HOST_ANALOG_PINS];
+static uint32_t analog_millivolts[HOST_ANALOG_PINS];
+static esp_reset_reason_t reset_reason = ESP_RST_POWERON;
+static uint32_t deep_sleeps = 0;
+static uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+static void (*interrupt_handlers[HOST_GPIO_PINS])(void);
+
+/** @brief Ejecuta una función en contexto de ISR (host_rtos.cpp) */
+void host_rtos_run_as_isr(void (*handler)(void));
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+size_t HardwareSerial::print(const char* text) {
+  return fputs(text, stdout) >= 0 ? strlen(text) : 0;
+}
+
+size_t HardwareSerial::println(const char* text) {
+  return print(text) + println();
+}
+
+size_t HardwareSerial::println(void) {
+  return fputc('\n', stdout) != EOF ? 1 : 0;
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int written = vprintf(format, args);
+  va_end(args);
+  return written > 0 ? (size_t)written : 0;
+}
+
+size_t HardwareSerial::write(uint8_t byte) {
+  return fputc(byte, stdout) != EOF ? 1 : 0;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {
+  return fwrite(data, 1, length, stdout);
+}
+
+void HardwareSerial::flush(void) {
+  fflush(stdout);
+}
+
+uint32_t EspClass::getCycleCount(void) {
+  // Un "ciclo" es un nanosegundo: las cuentas de ciclos/µs dan 1000 MHz
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
+
+uint32_t EspClass::getCpuFreqMHz(void) {
+  return 1000;
+}
+
+uint32_t EspClass::getFreeHeap(void) {
+  return esp_get_free_heap_size();
+}
+
+unsigned long millis(void) {
+  return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros(void) {
+  return (unsigned long)esp_timer_get_time();
+}
+
+void delay(unsigned long ms) {
+  usleep((useconds_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  usleep(us);
+}
+
+int analogRead(uint8_t pin) {
+  return pin < HOST_ANALOG_PINS ? __atomic_load_n(&analog_raw[pin], __ATOMIC_RELAXED) : 0;
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin) {
+  return pin < HOST_ANALOG_PINS ? __atomic_load_n(&analog_millivolts[pin], __ATOMIC_RELAXED) : 0;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+int digitalRead(uint8_t pin) {
+  (void)pin;
+  return LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  (void)pin;
+  (void)value;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+  (void)mode;
+  if(pin < HOST_GPIO_PINS) {
+    __atomic_store_n(&interrupt_handlers[pin], handler, __ATOMIC_RELEASE);
+  }
+}
+
+bool host_shims_trigger_interrupt(uint8_t pin) {
+  void (*handler)(void) = pin < HOST_GPIO_PINS ?
+                          __atomic_load_n(&interrupt_handlers[pin], __ATOMIC_ACQUIRE) : NULL;
+  if(handler == NULL) {
+    return false;
+  }
+  host_rtos_run_as_isr(handler);
+  return true;
+}
+
+uint8_t digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+float temperatureRead(void) {
+  return 45.0f;
+}
+
+uint32_t esp_random(void) {
+  // xorshift64*: reproducible entre ejecuciones, que es lo que quiere una prueba
+  uint64_t state = __atomic_load_n(&random_state, __ATOMIC_RELAXED);
+  uint64_t next;
+  do {
+    next = state;
+    next ^= next >> 12;
+    next ^= next << 25;
+    next ^= next >> 27;
+  } while(!__atomic_compare_exchange_n(&random_state, &state, next, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  return (uint32_t)((next * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+esp_reset_reason_t esp_reset_reason(void) {
+  return reset_reason;
+}
+
+void esp_restart(void) {
+  fflush(stdout);
+  _exit(0);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const* buf, uint32_t len) {
+  // Misma convención que la ROM: CRC-32 reflejado con inversión a la entrada y a la salida
+  crc = ~crc;
+  for(uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for(int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+    }
+  }
+  return ~crc;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+  return reset_reason == ESP_RST_DEEPSLEEP ? ESP_SLEEP_WAKEUP_TIMER : ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_us) {
+  (void)time_us;
+  return ESP_OK;
+}
+
+void esp_deep_sleep_start(void) {
+  __atomic_add_fetch(&deep_sleeps, 1, __ATOMIC_RELEASE);
+  for(;;) {
+    vTaskDelay(portMAX_DELAY / 2);
+  }
+}
+
+void host_shims_set_analog(uint8_t pin, int raw, uint32_t millivolts) {
+  if(pin < HOST_ANALOG_PINS) {
+    __atomic_store_n(&analog_raw[pin], raw, __ATOMIC_RELAXED);
+    __atomic_store_n(&analog_millivolts[pin], millivolts, __ATOMIC_RELAXED);
+  }
+}
+
+void host_shims_set_reset_reason(int reason) {
+  reset_reason = (esp_reset_reason_t)reason;
+}
+
+uint32_t host_shims_deep_sleeps(void) {
+  return __atomic_load_n(&deep_sleeps, __ATOMIC_ACQUIRE);
+}
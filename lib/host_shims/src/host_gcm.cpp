@@ -0,0 +1,140 @@
+/**
+ * @file host_gcm.cpp
+ * @brief Sustituto de AES-GCM para el entorno native (sin seguridad)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details El flujo de clave sale de un generador sembrado con la clave y el
+ * nonce, y la etiqueta es un resumen de 128 bits de clave, nonce, datos
+ * asociados y texto cifrado. Reproduce lo que importa a las pruebas: el
+ * mismo (clave, nonce) da el mismo flujo, y cualquier bit cambiado invalida
+ * la etiqueta.
+ */
+
+#include <string.h>
+#include "mbedtls/gcm.h"
+#include "host_shims.h"
+
+static uint32_t pending_failures = 0;
+
+/**
+ * @brief Paso de splitmix64
+ */
+static uint64_t mix(uint64_t* state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static uint64_t absorb(uint64_t state, const unsigned char* data, size_t length) {
+  for(size_t i = 0; i < length; i++) {
+    state = (state ^ data[i]) * 0x100000001B3ULL;
+  }
+  return state;
+}
+
+static uint64_t seed_of(const mbedtls_gcm_context* ctx, const unsigned char* iv, size_t iv_len) {
+  uint64_t state = absorb(0xCBF29CE484222325ULL, ctx->key, ctx->key_bits / 8);
+  return absorb(state, iv, iv_len);
+}
+
+static void keystream_xor(uint64_t seed, const unsigned char* input, unsigned char* output, size_t length) {
+  uint64_t state = seed;
+  uint64_t word = 0;
+  for(size_t i = 0; i < length; i++) {
+    if(i % 8 == 0) {
+      word = mix(&state);
+    }
+    output[i] = input[i] ^ (unsigned char)(word >> (8 * (i % 8)));
+  }
+}
+
+static void compute_tag(uint64_t seed, const unsigned char* add, size_t add_len, const unsigned char* cipher,
+                        size_t length, unsigned char tag[16]) {
+  uint64_t state = absorb(seed ^ 0x5A5A5A5A5A5A5A5AULL, add, add_len);
+  state = absorb(state ^ add_len, cipher, length);
+  state ^= length;
+  uint64_t words[2] = { mix(&state), mix(&state) };
+  memcpy(tag, words, 16);
+}
+
+static bool consume_failure(void) {
+  uint32_t pending = __atomic_load_n(&pending_failures, __ATOMIC_ACQUIRE);
+  while(pending > 0) {
+    if(__atomic_compare_exchange_n(&pending_failures, &pending, pending - 1, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void host_shims_fail_gcm(uint32_t count) {
+  __atomic_store_n(&pending_failures, count, __ATOMIC_RELEASE);
+}
+
+extern "C" {
+
+void mbedtls_gcm_init(mbedtls_gcm_context* ctx) {
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_gcm_setkey(mbedtls_gcm_context* ctx, mbedtls_cipher_id_t cipher, const unsigned char* key,
+                       unsigned int key_bits) {
+  if(cipher != MBEDTLS_CIPHER_ID_AES || (key_bits != 128 && key_bits != 192 && key_bits != 256)) {
+    return MBEDTLS_ERR_GCM_BAD_INPUT;
+  }
+  memcpy(ctx->key, key, key_bits / 8);
+  ctx->key_bits = key_bits;
+  return 0;
+}
+
+int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context* ctx, int mode, size_t length, const unsigned char* iv,
+                              size_t iv_len, const unsigned char* add, size_t add_len,
+                              const unsigned char* input, unsigned char* output, size_t tag_len,
+                              unsigned char* tag) {
+  if(ctx->key_bits == 0 || tag_len > 16 || consume_failure()) {
+    return MBEDTLS_ERR_GCM_BAD_INPUT;
+  }
+
+  uint64_t seed = seed_of(ctx, iv, iv_len);
+  unsigned char full_tag[16];
+  if(mode == MBEDTLS_GCM_ENCRYPT) {
+    keystream_xor(seed, input, output, length);
+    compute_tag(seed, add, add_len, output, length, full_tag);
+  } else {
+    compute_tag(seed, add, add_len, input, length, full_tag);
+    keystream_xor(seed, input, output, length);
+  }
+  memcpy(tag, full_tag, tag_len);
+  return 0;
+}
+
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context* ctx, size_t length, const unsigned char* iv, size_t iv_len,
+                             const unsigned char* add, size_t add_len, const unsigned char* tag,
+                             size_t tag_len, const unsigned char* input, unsigned char* output) {
+  if(ctx->key_bits == 0 || tag_len > 16) {
+    return MBEDTLS_ERR_GCM_BAD_INPUT;
+  }
+
+  uint64_t seed = seed_of(ctx, iv, iv_len);
+  unsigned char expected[16];
+  compute_tag(seed, add, add_len, input, length, expected);
+  unsigned char diff = 0;
+  for(size_t i = 0; i < tag_len; i++) {
+    diff |= (unsigned char)(expected[i] ^ tag[i]);
+  }
+  if(diff != 0) {
+    memset(output, 0, length);
+    return MBEDTLS_ERR_GCM_AUTH_FAILED;
+  }
+  keystream_xor(seed, input, output, length);
+  return 0;
+}
+
+void mbedtls_gcm_free(mbedtls_gcm_context* ctx) {
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+} // extern "C"
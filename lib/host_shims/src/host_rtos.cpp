@@ -0,0 +1,580 @@
+/**
+ * @file host_rtos.cpp
+ * @brief FreeRTOS y esp_timer sobre hilos POSIX
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <deque>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+
+/** @brief Heap libre simulado con ninguna tarea creada */
+#define HOST_HEAP_BYTES (200 * 1024)
+
+/** @brief Tarea simulada: un hilo con su contador de notificaciones */
+typedef struct host_task {
+  char name[16];
+  UBaseType_t priority;
+  UBaseType_t number;
+  TaskFunction_t function;
+  void* arg;
+  pthread_t thread;
+  uint32_t stack_bytes;       /**< Pila descontada del heap simulado */
+  bool deleted;
+  uint32_t notify;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} host_task_t;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<host_task_t*> registry;
+static uint32_t task_stack_bytes = 0;
+static thread_local host_task_t* current_task = NULL;
+static thread_local bool in_isr = false;
+
+static pthread_mutex_t critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/**
+ * @brief Instante absoluto (CLOCK_MONOTONIC) tras un número de ticks
+ */
+static void deadline_after(timespec* deadline, TickType_t ticks) {
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+  uint64_t nsec = (uint64_t)deadline->tv_nsec + (uint64_t)ticks * 1000000ULL;
+  deadline->tv_sec += (time_t)(nsec / 1000000000ULL);
+  deadline->tv_nsec = (long)(nsec % 1000000000ULL);
+}
+
+/**
+ * @brief Condición que espera con CLOCK_MONOTONIC
+ */
+static void monotonic_cond_init(pthread_cond_t* cond) {
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+/**
+ * @brief Espera en una condición hasta el plazo (portMAX_DELAY = sin plazo)
+ *
+ * @return false Si venció el plazo
+ */
+static bool cond_wait_until(pthread_cond_t* cond, pthread_mutex_t* lock, TickType_t ticks,
+                            const timespec* deadline) {
+  if(ticks == portMAX_DELAY) {
+    pthread_cond_wait(cond, lock);
+    return true;
+  }
+  return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+static host_task_t* task_new(const char* name, UBaseType_t priority) {
+  host_task_t* task = new host_task_t;
+  memset(task->name, 0, sizeof(task->name));
+  strncpy(task->name, name != NULL ? name : "", sizeof(task->name) - 1);
+  task->priority = priority;
+  task->function = NULL;
+  task->arg = NULL;
+  task->stack_bytes = 0;
+  task->deleted = false;
+  task->notify = 0;
+  pthread_mutex_init(&task->lock, NULL);
+  monotonic_cond_init(&task->cond);
+
+  pthread_mutex_lock(&registry_lock);
+  task->number = (UBaseType_t)registry.size() + 1;
+  registry.push_back(task);
+  pthread_mutex_unlock(&registry_lock);
+  return task;
+}
+
+/**
+ * @brief Tarea del hilo actual; los hilos ajenos (el de la prueba) se adoptan
+ */
+static host_task_t* task_self(void) {
+  if(current_task == NULL) {
+    pthread_mutex_lock(&registry_lock);
+    bool first = registry.empty();
+    pthread_mutex_unlock(&registry_lock);
+    current_task = task_new(first ? "main" : "host", 1);
+    current_task->thread = pthread_self();
+  }
+  return current_task;
+}
+
+static void* task_trampoline(void* arg) {
+  current_task = (host_task_t*)arg;
+  current_task->function(current_task->arg);
+  // Una tarea de FreeRTOS no puede volver: en el PC se da por borrada
+  vTaskDelete(NULL);
+  return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* handle) {
+  host_task_t* task = task_new(name, priority);
+  task->function = function;
+  task->arg = arg;
+  if(handle != NULL) {
+    *handle = task;
+  }
+  // En el ESP32 la pila sale del heap (stack_depth en bytes); el TCB no se simula
+  task->stack_bytes = stack_depth;
+  __atomic_add_fetch(&task_stack_bytes, stack_depth, __ATOMIC_RELAXED);
+  if(pthread_create(&task->thread, NULL, task_trampoline, task) != 0) {
+    vTaskDelete(task);
+    return pdFAIL;
+  }
+  pthread_detach(task->thread);
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+  (void)core;
+  return xTaskCreate(function, name, stack_depth, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  host_task_t* target = task != NULL ? (host_task_t*)task : task_self();
+  if(!__atomic_exchange_n(&target->deleted, true, __ATOMIC_ACQ_REL)) {
+    __atomic_sub_fetch(&task_stack_bytes, target->stack_bytes, __ATOMIC_RELAXED);
+  }
+  if(target == current_task) {
+    pthread_exit(NULL);
+  }
+}
+
+uint32_t esp_get_free_heap_size(void) {
+  return HOST_HEAP_BYTES - __atomic_load_n(&task_stack_bytes, __ATOMIC_RELAXED);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  usleep((useconds_t)ticks * 1000);
+}
+
+void taskYIELD(void) {
+  sched_yield();
+}
+
+int64_t esp_timer_get_time(void) {
+  static timespec boot = { 0, 0 };
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once(&once, [] { clock_gettime(CLOCK_MONOTONIC, &boot); });
+
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)(now.tv_sec - boot.tv_sec) * 1000000 + (now.tv_nsec - boot.tv_nsec) / 1000;
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+  return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  return task_self();
+}
+
+char* pcTaskGetName(TaskHandle_t task) {
+  return (task != NULL ? (host_task_t*)task : task_self())->name;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+  return (task != NULL ? (host_task_t*)task : task_self())->priority;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  (void)task;
+  return 4096; // Sin pila propia que medir
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+  UBaseType_t count = 0;
+  pthread_mutex_lock(&registry_lock);
+  for(host_task_t* task : registry) {
+    count += __atomic_load_n(&task->deleted, __ATOMIC_ACQUIRE) ? 0 : 1;
+  }
+  pthread_mutex_unlock(&registry_lock);
+  return count;
+}
+
+uint32_t ulTaskGetRunTimeCounter(TaskHandle_t task) {
+  host_task_t* target = task != NULL ? (host_task_t*)task : task_self();
+  clockid_t clock;
+  timespec cpu;
+
+  if(__atomic_load_n(&target->deleted, __ATOMIC_ACQUIRE) ||
+     pthread_getcpuclockid(target->thread, &clock) != 0 || clock_gettime(clock, &cpu) != 0) {
+    return 0;
+  }
+  return (uint32_t)((uint64_t)cpu.tv_sec * 1000000ULL + (uint64_t)cpu.tv_nsec / 1000ULL);
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t count, uint32_t* total_run_time) {
+  std::vector<host_task_t*> alive;
+  pthread_mutex_lock(&registry_lock);
+  for(host_task_t* task : registry) {
+    if(!__atomic_load_n(&task->deleted, __ATOMIC_ACQUIRE)) {
+      alive.push_back(task);
+    }
+  }
+  pthread_mutex_unlock(&registry_lock);
+  if(alive.size() > count) {
+    return 0;
+  }
+
+  for(size_t i = 0; i < alive.size(); i++) {
+    memset(&status[i], 0, sizeof(status[i]));
+    status[i].xHandle = alive[i];
+    status[i].pcTaskName = alive[i]->name;
+    status[i].xTaskNumber = alive[i]->number;
+    status[i].eCurrentState = alive[i] == current_task ? eRunning : eReady;
+    status[i].uxCurrentPriority = alive[i]->priority;
+    status[i].uxBasePriority = alive[i]->priority;
+    status[i].ulRunTimeCounter = ulTaskGetRunTimeCounter(alive[i]);
+    status[i].usStackHighWaterMark = 4096;
+  }
+  if(total_run_time != NULL) {
+    // Como en el ESP32: tiempo total desde el arranque, en µs
+    *total_run_time = (uint32_t)esp_timer_get_time();
+  }
+  return (UBaseType_t)alive.size();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  host_task_t* task = task_self();
+  timespec deadline;
+  deadline_after(&deadline, ticks);
+
+  pthread_mutex_lock(&task->lock);
+  while(task->notify == 0 && ticks > 0) {
+    if(!cond_wait_until(&task->cond, &task->lock, ticks, &deadline)) {
+      break;
+    }
+  }
+  uint32_t value = task->notify;
+  if(value > 0) {
+    task->notify = clear_on_exit ? 0 : value - 1;
+  }
+  pthread_mutex_unlock(&task->lock);
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+  host_task_t* task = (host_task_t*)handle;
+  pthread_mutex_lock(&task->lock);
+  task->notify++;
+  pthread_cond_signal(&task->cond);
+  pthread_mutex_unlock(&task->lock);
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+  xTaskNotifyGive(task);
+  if(woken != NULL) {
+    *woken = pdTRUE;
+  }
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+  (void)mux;
+  pthread_mutex_lock(&critical_lock);
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+  (void)mux;
+  pthread_mutex_unlock(&critical_lock);
+}
+
+BaseType_t xPortInIsrContext(void) {
+  return in_isr ? pdTRUE : pdFALSE;
+}
+
+/** @brief Cola de copias de tamaño fijo */
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  std::deque<std::vector<uint8_t> > items;
+  size_t length;
+  size_t item_size;
+} host_queue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  host_queue_t* queue = new host_queue_t;
+  pthread_mutex_init(&queue->lock, NULL);
+  monotonic_cond_init(&queue->changed);
+  queue->length = length;
+  queue->item_size = item_size;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t handle) {
+  host_queue_t* queue = (host_queue_t*)handle;
+  pthread_mutex_destroy(&queue->lock);
+  pthread_cond_destroy(&queue->changed);
+  delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t ticks) {
+  host_queue_t* queue = (host_queue_t*)handle;
+  timespec deadline;
+  deadline_after(&deadline, ticks);
+
+  pthread_mutex_lock(&queue->lock);
+  while(queue->items.size() >= queue->length && ticks > 0) {
+    if(!cond_wait_until(&queue->changed, &queue->lock, ticks, &deadline)) {
+      break;
+    }
+  }
+  if(queue->items.size() >= queue->length) {
+    pthread_mutex_unlock(&queue->lock);
+    return pdFALSE;
+  }
+  const uint8_t* bytes = (const uint8_t*)item;
+  queue->items.push_back(std::vector<uint8_t>(bytes, bytes + queue->item_size));
+  pthread_cond_broadcast(&queue->changed);
+  pthread_mutex_unlock(&queue->lock);
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+  BaseType_t sent = xQueueSend(queue, item, 0);
+  if(sent == pdTRUE && woken != NULL) {
+    *woken = pdTRUE;
+  }
+  return sent;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t ticks) {
+  host_queue_t* queue = (host_queue_t*)handle;
+  timespec deadline;
+  deadline_after(&deadline, ticks);
+
+  pthread_mutex_lock(&queue->lock);
+  while(queue->items.empty() && ticks > 0) {
+    if(!cond_wait_until(&queue->changed, &queue->lock, ticks, &deadline)) {
+      break;
+    }
+  }
+  if(queue->items.empty()) {
+    pthread_mutex_unlock(&queue->lock);
+    return pdFALSE;
+  }
+  memcpy(item, queue->items.front().data(), queue->item_size);
+  queue->items.pop_front();
+  pthread_cond_broadcast(&queue->changed);
+  pthread_mutex_unlock(&queue->lock);
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle) {
+  host_queue_t* queue = (host_queue_t*)handle;
+  pthread_mutex_lock(&queue->lock);
+  UBaseType_t count = (UBaseType_t)queue->items.size();
+  pthread_mutex_unlock(&queue->lock);
+  return count;
+}
+
+/** @brief Mutex con propietario, como los de FreeRTOS */
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t released;
+  host_task_t* holder;
+} host_mutex_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  host_mutex_t* mutex = new host_mutex_t;
+  pthread_mutex_init(&mutex->lock, NULL);
+  monotonic_cond_init(&mutex->released);
+  mutex->holder = NULL;
+  return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks) {
+  host_mutex_t* mutex = (host_mutex_t*)handle;
+  host_task_t* self = task_self();
+  timespec deadline;
+  deadline_after(&deadline, ticks);
+
+  pthread_mutex_lock(&mutex->lock);
+  while(mutex->holder != NULL && ticks > 0) {
+    if(!cond_wait_until(&mutex->released, &mutex->lock, ticks, &deadline)) {
+      break;
+    }
+  }
+  bool taken = mutex->holder == NULL;
+  if(taken) {
+    mutex->holder = self;
+  }
+  pthread_mutex_unlock(&mutex->lock);
+  return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle) {
+  host_mutex_t* mutex = (host_mutex_t*)handle;
+  pthread_mutex_lock(&mutex->lock);
+  bool owner = mutex->holder == task_self();
+  if(owner) {
+    mutex->holder = NULL;
+    pthread_cond_signal(&mutex->released);
+  }
+  pthread_mutex_unlock(&mutex->lock);
+  return owner ? pdTRUE : pdFALSE;
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t handle) {
+  host_mutex_t* mutex = (host_mutex_t*)handle;
+  pthread_mutex_lock(&mutex->lock);
+  host_task_t* holder = mutex->holder;
+  pthread_mutex_unlock(&mutex->lock);
+  return holder;
+}
+
+/**
+ * @brief Temporizador de esp_timer
+ *
+ * @details Todos los vencimientos los despacha un único hilo ("esp_timer"),
+ * como la tarea de esp_timer de ESP-IDF; con ESP_TIMER_ISR el callback se ve
+ * a sí mismo en contexto de ISR.
+ */
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void* arg;
+  bool isr_dispatch;
+  bool armed;
+  int64_t expiry_us;
+  uint64_t period_us;
+};
+
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_changed;
+static std::vector<esp_timer*> timers;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+
+static void* timer_dispatcher(void* arg) {
+  (void)arg;
+  current_task = task_new("esp_timer", 22);
+  current_task->thread = pthread_self();
+
+  pthread_mutex_lock(&timer_lock);
+  for(;;) {
+    esp_timer* next = NULL;
+    for(esp_timer* timer : timers) {
+      if(timer->armed && (next == NULL || timer->expiry_us < next->expiry_us)) {
+        next = timer;
+      }
+    }
+    if(next == NULL) {
+      pthread_cond_wait(&timer_changed, &timer_lock);
+      continue;
+    }
+
+    int64_t wait_us = next->expiry_us - esp_timer_get_time();
+    if(wait_us > 0) {
+      timespec deadline;
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      uint64_t nsec = (uint64_t)deadline.tv_nsec + (uint64_t)wait_us * 1000ULL;
+      deadline.tv_sec += (time_t)(nsec / 1000000000ULL);
+      deadline.tv_nsec = (long)(nsec % 1000000000ULL);
+      pthread_cond_timedwait(&timer_changed, &timer_lock, &deadline);
+      continue;
+    }
+
+    if(next->period_us > 0) {
+      next->expiry_us += (int64_t)next->period_us;
+    } else {
+      next->armed = false;
+    }
+    pthread_mutex_unlock(&timer_lock);
+    in_isr = next->isr_dispatch;
+    next->callback(next->arg);
+    in_isr = false;
+    pthread_mutex_lock(&timer_lock);
+  }
+  return NULL;
+}
+
+void host_rtos_run_as_isr(void (*handler)(void)) {
+  bool was_in_isr = in_isr;
+  in_isr = true;
+  handler();
+  in_isr = was_in_isr;
+}
+
+static void timer_start_dispatcher(void) {
+  monotonic_cond_init(&timer_changed);
+  pthread_t thread;
+  pthread_create(&thread, NULL, timer_dispatcher, NULL);
+  pthread_detach(thread);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  if(args == NULL || args->callback == NULL || out == NULL) {
+    return ESP_FAIL;
+  }
+  pthread_once(&timer_once, timer_start_dispatcher);
+
+  esp_timer* timer = new esp_timer;
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  timer->isr_dispatch = args->dispatch_method == ESP_TIMER_ISR;
+  timer->armed = false;
+  timer->expiry_us = 0;
+  timer->period_us = 0;
+
+  pthread_mutex_lock(&timer_lock);
+  timers.push_back(timer);
+  pthread_mutex_unlock(&timer_lock);
+  *out = timer;
+  return ESP_OK;
+}
+
+/**
+ * @brief Arma un temporizador; falla si ya estaba armado, como en ESP-IDF
+ */
+static esp_err_t timer_arm(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+  pthread_mutex_lock(&timer_lock);
+  if(timer->armed) {
+    pthread_mutex_unlock(&timer_lock);
+    return ESP_FAIL;
+  }
+  timer->armed = true;
+  timer->expiry_us = esp_timer_get_time() + (int64_t)timeout_us;
+  timer->period_us = period_us;
+  pthread_cond_signal(&timer_changed);
+  pthread_mutex_unlock(&timer_lock);
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  return timer_arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+  return timer_arm(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  pthread_mutex_lock(&timer_lock);
+  bool armed = timer->armed;
+  timer->armed = false;
+  pthread_cond_signal(&timer_changed);
+  pthread_mutex_unlock(&timer_lock);
+  return armed ? ESP_OK : ESP_FAIL;
+}
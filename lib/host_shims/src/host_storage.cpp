@@ -0,0 +1,385 @@
+/**
+ * @file host_storage.cpp
+ * @brief LittleFS, tarjeta SD, NVS y partición mapeada sobre ficheros del PC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <FS.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <SD.h>
+#include <SPI.h>
+#include "esp_partition.h"
+#include "host_shims.h"
+
+/** @brief Tamaño de la partición del archivo mapeado (768 KB) */
+#define HOST_PARTITION_SIZE 0xC0000
+
+LittleFSFS LittleFS;
+SDFS SD;
+SPIClass SPI;
+
+static std::string root_dir;
+static pthread_once_t root_once = PTHREAD_ONCE_INIT;
+static bool sd_present = false;
+static uint32_t nvs_failures = 0;
+
+static esp_partition_t arc_partition = {
+  ESP_PARTITION_TYPE_DATA, 0x40, 0x330000, HOST_PARTITION_SIZE, "telem_arc", false
+};
+static pthread_mutex_t partition_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t* partition_memory = NULL;
+
+static void root_init(void) {
+  const char* env = getenv("TELEM_HOST_ROOT");
+  if(env != NULL && env[0] != '\0') {
+    root_dir = env;
+    mkdir(root_dir.c_str(), 0755);
+    return;
+  }
+  char pattern[] = "/tmp/telem_host_XXXXXX";
+  root_dir = mkdtemp(pattern) != NULL ? pattern : "/tmp";
+}
+
+const char* host_shims_root(void) {
+  pthread_once(&root_once, root_init);
+  return root_dir.c_str();
+}
+
+static int remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+  (void)st;
+  (void)flag;
+  (void)ftw;
+  return ::remove(path);
+}
+
+void host_shims_reset_storage(void) {
+  std::string root = host_shims_root();
+  nftw((root + "/littlefs").c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+  nftw((root + "/sd").c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+  nftw((root + "/nvs").c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+  pthread_mutex_lock(&partition_lock);
+  if(partition_memory != NULL) {
+    memset(partition_memory, 0xFF, HOST_PARTITION_SIZE);
+  } else {
+    ::remove((root + "/telem_arc.bin").c_str());
+  }
+  pthread_mutex_unlock(&partition_lock);
+}
+
+void host_shims_set_sd_present(bool present) {
+  sd_present = present;
+}
+
+void host_shims_fail_nvs(uint32_t count) {
+  __atomic_store_n(&nvs_failures, count, __ATOMIC_RELEASE);
+}
+
+static bool nvs_consume_failure(void) {
+  uint32_t pending = __atomic_load_n(&nvs_failures, __ATOMIC_ACQUIRE);
+  while(pending > 0) {
+    if(__atomic_compare_exchange_n(&nvs_failures, &pending, pending - 1, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+namespace fs {
+
+static FILE* stream_of(void* handle) {
+  return (FILE*)handle;
+}
+
+File::operator bool() const {
+  return handle != nullptr;
+}
+
+size_t File::size() const {
+  struct stat st;
+  if(handle == nullptr) {
+    return 0;
+  }
+  fflush(stream_of(handle));
+  return fstat(fileno(stream_of(handle)), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+size_t File::position() const {
+  long position = handle != nullptr ? ftell(stream_of(handle)) : -1;
+  return position >= 0 ? (size_t)position : 0;
+}
+
+int File::available(void) {
+  return handle != nullptr ? (int)(size() - position()) : 0;
+}
+
+int File::read(void) {
+  return handle != nullptr ? fgetc(stream_of(handle)) : -1;
+}
+
+size_t File::read(uint8_t* buffer, size_t length) {
+  return handle != nullptr ? fread(buffer, 1, length, stream_of(handle)) : 0;
+}
+
+size_t File::write(const uint8_t* buffer, size_t length) {
+  return handle != nullptr ? fwrite(buffer, 1, length, stream_of(handle)) : 0;
+}
+
+size_t File::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t File::println(const char* text) {
+  if(handle == nullptr) {
+    return 0;
+  }
+  // Como Print::println() de Arduino: CR LF
+  int written = fprintf(stream_of(handle), "%s\r\n", text);
+  return written > 0 ? (size_t)written : 0;
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+  static const int whence[] = { SEEK_SET, SEEK_CUR, SEEK_END };
+  return handle != nullptr && fseek(stream_of(handle), (long)position, whence[mode]) == 0;
+}
+
+void File::flush(void) {
+  if(handle != nullptr) {
+    fflush(stream_of(handle));
+  }
+}
+
+void File::close(void) {
+  if(handle != nullptr) {
+    fclose(stream_of(handle));
+    handle = nullptr;
+  }
+}
+
+std::string FS::path_of(const char* path) const {
+  return std::string(host_shims_root()) + "/" + mount + path;
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+  (void)create;
+  return File(fopen(path_of(path).c_str(), mode));
+}
+
+bool FS::exists(const char* path) {
+  return access(path_of(path).c_str(), F_OK) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return ::remove(path_of(path).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  struct stat st;
+  std::string full = path_of(path);
+  if(stat(full.c_str(), &st) == 0) {
+    return S_ISDIR(st.st_mode);
+  }
+  return ::mkdir(full.c_str(), 0755) == 0;
+}
+
+} // namespace fs
+
+bool LittleFSFS::begin(bool format_on_fail) {
+  (void)format_on_fail;
+  std::string dir = std::string(host_shims_root()) + "/" + mount;
+  return ::mkdir(dir.c_str(), 0755) == 0 || access(dir.c_str(), F_OK) == 0;
+}
+
+size_t LittleFSFS::totalBytes(void) {
+  return 1408 * 1024;
+}
+
+size_t LittleFSFS::usedBytes(void) {
+  return 0;
+}
+
+bool SDFS::begin(uint8_t ss_pin, SPIClass& spi, uint32_t frequency, const char* mountpoint,
+                 uint8_t max_files, bool format_if_empty) {
+  (void)ss_pin;
+  (void)spi;
+  (void)frequency;
+  (void)mountpoint;
+  (void)max_files;
+  (void)format_if_empty;
+  if(!sd_present) {
+    return false;
+  }
+  std::string dir = std::string(host_shims_root()) + "/" + mount;
+  return ::mkdir(dir.c_str(), 0755) == 0 || access(dir.c_str(), F_OK) == 0;
+}
+
+uint64_t SDFS::cardSize(void) {
+  return sd_present ? 4ULL * 1024 * 1024 * 1024 : 0;
+}
+
+void SDFS::end(void) {
+}
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {
+  (void)sck;
+  (void)miso;
+  (void)mosi;
+  (void)ss;
+}
+
+bool Preferences::begin(const char* name, bool read_only_mode) {
+  std::string dir = std::string(host_shims_root()) + "/nvs";
+  if(::mkdir(dir.c_str(), 0755) != 0 && access(dir.c_str(), F_OK) != 0) {
+    return false;
+  }
+  space = name;
+  read_only = read_only_mode;
+  opened = true;
+  return true;
+}
+
+void Preferences::end(void) {
+  opened = false;
+}
+
+std::string Preferences::path_of(const char* key) const {
+  return std::string(host_shims_root()) + "/nvs/" + space + "." + key;
+}
+
+bool Preferences::isKey(const char* key) {
+  return opened && access(path_of(key).c_str(), F_OK) == 0;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t default_value) {
+  uint32_t value = default_value;
+  FILE* f = opened ? fopen(path_of(key).c_str(), "rb") : NULL;
+  if(f != NULL) {
+    if(fread(&value, sizeof(value), 1, f) != 1) {
+      value = default_value;
+    }
+    fclose(f);
+  }
+  return value;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+  if(!opened || read_only || nvs_consume_failure()) {
+    return 0;
+  }
+  // Como NVS: la entrada nueva sustituye a la anterior de una vez
+  std::string path = path_of(key);
+  std::string staging = path + ".new";
+  FILE* f = fopen(staging.c_str(), "wb");
+  if(f == NULL) {
+    return 0;
+  }
+  bool written = fwrite(&value, sizeof(value), 1, f) == 1;
+  written = fclose(f) == 0 && written;
+  if(!written || ::rename(staging.c_str(), path.c_str()) != 0) {
+    return 0;
+  }
+  return sizeof(value);
+}
+
+/**
+ * @brief Mapea el fichero de la partición, creándolo borrado (0xFF) si no existe
+ */
+static bool partition_map(void) {
+  pthread_mutex_lock(&partition_lock);
+  if(partition_memory == NULL) {
+    std::string path = std::string(host_shims_root()) + "/telem_arc.bin";
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if(fd >= 0 && fstat(fd, &st) == 0) {
+      bool fresh = st.st_size != HOST_PARTITION_SIZE;
+      if(!fresh || ftruncate(fd, HOST_PARTITION_SIZE) == 0) {
+        void* memory = mmap(NULL, HOST_PARTITION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(memory != MAP_FAILED) {
+          partition_memory = (uint8_t*)memory;
+          if(fresh) {
+            memset(partition_memory, 0xFF, HOST_PARTITION_SIZE);
+          }
+        }
+      }
+    }
+    if(fd >= 0) {
+      ::close(fd);
+    }
+  }
+  bool mapped = partition_memory != NULL;
+  pthread_mutex_unlock(&partition_lock);
+  return mapped;
+}
+
+static bool partition_range_ok(const esp_partition_t* partition, size_t offset, size_t size) {
+  return partition == &arc_partition && offset <= HOST_PARTITION_SIZE &&
+         size <= HOST_PARTITION_SIZE - offset && partition_map();
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+  (void)subtype;
+  if(type != ESP_PARTITION_TYPE_DATA || (label != NULL && strcmp(label, arc_partition.label) != 0)) {
+    return NULL;
+  }
+  return &arc_partition;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void** out_ptr,
+                             spi_flash_mmap_handle_t* out_handle) {
+  (void)memory;
+  if(!partition_range_ok(partition, offset, size)) {
+    return ESP_FAIL;
+  }
+  *out_ptr = partition_memory + offset;
+  if(out_handle != NULL) {
+    *out_handle = 1;
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  if(!partition_range_ok(partition, offset, size) || offset % 4096 != 0 || size % 4096 != 0) {
+    return ESP_FAIL;
+  }
+  memset(partition_memory + offset, 0xFF, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* src, size_t size) {
+  if(!partition_range_ok(partition, offset, size)) {
+    return ESP_FAIL;
+  }
+  // Flash NOR: escribir solo baja bits; subirlos exige borrar el sector
+  const uint8_t* bytes = (const uint8_t*)src;
+  for(size_t i = 0; i < size; i++) {
+    partition_memory[offset + i] &= bytes[i];
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+  if(!partition_range_ok(partition, offset, size)) {
+    return ESP_FAIL;
+  }
+  memcpy(dst, partition_memory + offset, size);
+  return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+  (void)handle;
+}
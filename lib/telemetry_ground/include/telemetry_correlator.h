@@ -0,0 +1,73 @@
+/**
+ * @file telemetry_correlator.h
+ * @brief Ajuste de deriva y desfase del reloj local y conversión de marcas de tiempo a UTC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Parte de tierra de telemetry_timecorr.h. Vive en lib/telemetry_ground,
+ * que solo se compila en el entorno native: el firmware no lo necesita y la
+ * ingesta de la estación lo usa en el PC. Solo depende de la biblioteca
+ * estándar.
+ *
+ * - telemetry_correlator_fit() ajusta por mínimos cuadrados
+ *   utc = utc_ref + rate * (local - local_ref) con los pares de una época.
+ *   Los datos se centran en su media para no perder precisión en double.
+ * - telemetry_correlator_convert() convierte un lote de marcas de tiempo
+ *   (ms locales de telem_header_t) a UTC. El bucle es aritmética pura sin
+ *   saltos sobre arrays contiguos, de modo que el compilador lo vectoriza.
+ *
+ * Los instantes UTC de los pares son los de recepción del marcador en tierra
+ * menos los retardos de propagación y de estación; calcularlos es cosa del
+ * llamador.
+ */
+
+#ifndef TELEMETRY_CORRELATOR_H
+#define TELEMETRY_CORRELATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Modelo lineal reloj local -> UTC de una época */
+typedef struct {
+  double local_ref_us;      /**< Media del reloj local de los pares (µs) */
+  double utc_ref_s;         /**< UTC en local_ref_us (s) */
+  double rate;              /**< Segundos UTC por microsegundo local (nominal 1e-6) */
+  double drift_ppm;         /**< Deriva del reloj local respecto a UTC (ppm, positivo = adelanta) */
+  double residual_rms_us;   /**< Residuo cuadrático medio del ajuste (µs) */
+  uint32_t points;          /**< Pares usados en el ajuste */
+} telemetry_time_fit_t;
+
+/**
+ * @brief Ajusta deriva y desfase con los pares de una época
+ *
+ * @param local_us Reloj local de cada marcador (telem_time_correlation_t.marker_local_us)
+ * @param utc_s UTC de emisión de cada marcador (s)
+ * @param count Número de pares
+ * @param[out] fit Modelo ajustado
+ * @return true Si hay al menos un par (con uno solo se asume ritmo nominal)
+ */
+bool telemetry_correlator_fit(const uint64_t* local_us, const double* utc_s, size_t count,
+                              telemetry_time_fit_t* fit);
+
+/**
+ * @brief Convierte un instante del reloj local de alta resolución a UTC
+ */
+double telemetry_correlator_utc(const telemetry_time_fit_t* fit, uint64_t local_us);
+
+/**
+ * @brief Convierte en lote marcas de tiempo de paquetes a UTC
+ *
+ * @param fit Modelo de la época de los paquetes
+ * @param timestamps_ms Marcas de tiempo de telem_header_t (ms locales)
+ * @param count Número de marcas
+ * @param[out] utc_s UTC de cada marca (s)
+ *
+ * @details Las marcas de 32 bits dan la vuelta cada ~49 días; se
+ * interpretan como la vuelta más cercana a local_ref_us (±24 días).
+ */
+void telemetry_correlator_convert(const telemetry_time_fit_t* fit, const uint32_t* timestamps_ms,
+                                  size_t count, double* utc_s);
+
+#endif // TELEMETRY_CORRELATOR_H
@@ -0,0 +1,76 @@
+/**
+ * @file telemetry_correlator.cpp
+ * @brief Implementación del ajuste reloj local -> UTC
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Las restas se hacen primero en enteros respecto al primer par y solo
+ * después se pasan a double: el reloj local (µs) y UTC (s desde 1970) son
+ * magnitudes grandes y restarlas ya en double perdería los microsegundos.
+ */
+
+#include <math.h>
+#include "telemetry_correlator.h"
+
+/** @brief Ritmo nominal: un microsegundo local es un microsegundo UTC */
+#define CORRELATOR_NOMINAL_RATE 1e-6
+
+bool telemetry_correlator_fit(const uint64_t* local_us, const double* utc_s, size_t count,
+                              telemetry_time_fit_t* fit) {
+  if(count == 0) {
+    return false;
+  }
+
+  // Medias relativas al primer par
+  double mean_x = 0.0;
+  double mean_y = 0.0;
+  for(size_t i = 0; i < count; i++) {
+    mean_x += (double)(int64_t)(local_us[i] - local_us[0]);
+    mean_y += utc_s[i] - utc_s[0];
+  }
+  mean_x /= (double)count;
+  mean_y /= (double)count;
+
+  double sxx = 0.0;
+  double sxy = 0.0;
+  for(size_t i = 0; i < count; i++) {
+    double dx = (double)(int64_t)(local_us[i] - local_us[0]) - mean_x;
+    double dy = (utc_s[i] - utc_s[0]) - mean_y;
+    sxx += dx * dx;
+    sxy += dx * dy;
+  }
+
+  fit->rate = sxx > 0.0 ? sxy / sxx : CORRELATOR_NOMINAL_RATE;
+  fit->local_ref_us = (double)local_us[0] + mean_x;
+  fit->utc_ref_s = utc_s[0] + mean_y;
+  fit->drift_ppm = (CORRELATOR_NOMINAL_RATE / fit->rate - 1.0) * 1e6;
+  fit->points = (uint32_t)count;
+
+  double residual = 0.0;
+  for(size_t i = 0; i < count; i++) {
+    double dx = (double)(int64_t)(local_us[i] - local_us[0]) - mean_x;
+    double error = (utc_s[i] - utc_s[0]) - mean_y - fit->rate * dx;
+    residual += error * error;
+  }
+  fit->residual_rms_us = sqrt(residual / (double)count) * 1e6;
+  return true;
+}
+
+double telemetry_correlator_utc(const telemetry_time_fit_t* fit, uint64_t local_us) {
+  return fit->utc_ref_s + fit->rate * ((double)local_us - fit->local_ref_us);
+}
+
+void telemetry_correlator_convert(const telemetry_time_fit_t* fit, const uint32_t* timestamps_ms,
+                                  size_t count, double* utc_s) {
+  // Referencia en ms enteros cerca del centro del ajuste
+  uint64_t ref_ms = (uint64_t)fit->local_ref_us / 1000;
+  const uint32_t ref_ms32 = (uint32_t)ref_ms;
+  const double base = telemetry_correlator_utc(fit, ref_ms * 1000);
+  const double step = fit->rate * 1000.0;
+
+  // La resta en uint32 y el paso a int32 eligen la vuelta más cercana sin saltos
+  for(size_t i = 0; i < count; i++) {
+    utc_s[i] = base + (double)(int32_t)(timestamps_ms[i] - ref_ms32) * step;
+  }
+}
@@ -23,11 +23,150 @@
 #include "esp_system.h"
 #include "../include/telemetry_storage.h"
 #include "../include/telemetry_logger.h"
+#include "../include/telemetry_sleep.h"
+#include "../include/telemetry_energy.h"
+#include "../include/telemetry_archive.h"
+#include "../include/telemetry_sensors.h"
+#include "../include/telemetry_bitpack.h"
+#include "../include/telemetry_entropy.h"
+#include "../include/telemetry_auth.h"
+#include "../include/telemetry_bus.h"
+#include "../include/telemetry_calibration.h"
+#include "../include/telemetry_soc.h"
+#include "../include/telemetry_timers.h"
+#include "../include/telemetry_lock.h"
+#include "../include/telemetry_coroutine.h"
+#include "../include/telemetry_isr.h"
+#include "../include/telemetry_topics.h"
+#include "../include/telemetry_tasks.h"
 
-// Declaración de las tareas de telemetría
-void vTelemetryCollectorTask(void *pvParameters);
-void vTelemetryProcessorTask(void *pvParameters);
-void vTelemetryTransmitterTask(void *pvParameters);
+/** @brief Tareas de telemetría creadas en setup(), para vigilar sus pilas */
+static TaskHandle_t telemetry_task_handles[3];
+
+/**
+ * @brief Vuelca un resumen del contenido del buffer sin consumirlo
+ *
+ * @details Recorre una instantánea del buffer (sin tomar el mutex, por lo que
+ * no retrasa a los productores) y muestra cuántos paquetes hay de cada tipo y
+ * el rango de secuencias pendientes.
+ */
+static void dump_buffer_snapshot(void) {
+  static telemetry_snapshot_t snapshot;
+  telemetry_packet_t packet;
+  uint32_t per_type[TELEM_TYPE_COUNT] = {0};
+  uint32_t total = 0;
+  uint16_t first_sequence = 0;
+  uint16_t last_sequence = 0;
+
+  telemetry_snapshot_begin(&snapshot);
+  while(telemetry_snapshot_next(&snapshot, &packet)) {
+    if(total == 0) {
+      first_sequence = packet.header.sequence;
+    }
+    last_sequence = packet.header.sequence;
+    if((uint32_t)packet.header.type < TELEM_TYPE_COUNT) {
+      per_type[packet.header.type]++;
+    }
+    total++;
+  }
+
+  telemetry_logf("🔎 BUFFER SNAPSHOT: %lu packets (Seq %u..%u) | SYS=%lu PWR=%lu TEMP=%lu COMMS=%lu HK=%lu | Skipped=%lu Unresolved=%lu",
+                 total, first_sequence, last_sequence,
+                 per_type[TELEM_SYSTEM_STATUS], per_type[TELEM_POWER_DATA],
+                 per_type[TELEM_TEMPERATURE_DATA], per_type[TELEM_COMMUNICATION_STATUS],
+                 per_type[TELEM_HOUSEKEEPING], snapshot.skipped, snapshot.unresolved);
+}
+
+/**
+ * @brief Volcado periódico del fichero de log y del contenido del buffer
+ */
+static void periodic_log_dump(void* arg) {
+  Serial.println("\n[Logger] Dump periódico del fichero /telemetry_log.txt:");
+  telemetry_dump_log();
+  dump_buffer_snapshot();
+}
+
+/**
+ * @brief Línea de estado general periódica
+ */
+static void periodic_status(void* arg) {
+  telemetry_logf("\n📈 SYSTEM STATUS: Uptime: %lus | Heap: %lu | Tasks: %d",
+                 millis() / 1000,
+                 esp_get_free_heap_size(),
+                 uxTaskGetNumberOfTasks());
+
+  uint32_t written, read, lost, pool_in_use, pool_high_water, pool_exhausted;
+  telemetry_get_stats(&written, &read, &lost);
+  telemetry_get_pool_stats(&pool_in_use, &pool_high_water, &pool_exhausted);
+  telemetry_logf("💾 STORAGE: Written=%lu | Read=%lu | Lost=%lu | Dedup=%lu | Pool=%lu/%d (max %lu, exhausted %lu)",
+                 written, read, lost, telemetry_deduplicated_packets(),
+                 pool_in_use, TELEM_POOL_SIZE, pool_high_water, pool_exhausted);
+
+  telemetry_archive_stats_t archive;
+  telemetry_archive_get_stats(&archive);
+  telemetry_logf("🗄️ ARCHIVE: Records=%lu | Segment=%lu | %lu KB in %lu writes | Worst=%luus | Errors=%lu",
+                 archive.records, archive.segment, archive.bytes_written / 1024,
+                 archive.flushes, archive.worst_flush_us, archive.errors);
+
+  telemetry_sensor_stats_t sensors;
+  telemetry_sensors_get_stats(&sensors);
+  telemetry_logf("🌡️ SENSORS: Sweeps=%lu | %lu conversions/sweep | Bus failures=%lu | Last=%luus | Worst=%luus",
+                 sensors.sweeps, sensors.sweeps > 0 ? sensors.conversions / sensors.sweeps : 0UL,
+                 sensors.bus_failures, sensors.last_sweep_us, sensors.worst_sweep_us);
+
+  telemetry_energy_report_t energy;
+  telemetry_energy_get_report(&energy);
+  telemetry_logf("⚡ ENERGY: Total=%llumJ | Collect=%llumJ | Process=%llumJ | Xmit=%llumJ | Sleep=%llumJ | %lluuJ/packet",
+                 (unsigned long long)(energy.total_energy_uj / 1000),
+                 (unsigned long long)(energy.stages[TELEM_STAGE_COLLECTOR].energy_uj / 1000),
+                 (unsigned long long)(energy.stages[TELEM_STAGE_PROCESSOR].energy_uj / 1000),
+                 (unsigned long long)(energy.stages[TELEM_STAGE_TRANSMITTER].energy_uj / 1000),
+                 (unsigned long long)(energy.sleep_energy_uj / 1000),
+                 (unsigned long long)energy.energy_per_packet_uj);
+
+  telemetry_timer_stats_t timers;
+  telemetry_timers_get_stats(&timers);
+  telemetry_logf("⏱️ TIMERS: Active=%lu | Fired=%lu | Wakeups=%lu | Cascades=%lu | Overruns=%lu | Max latency=%lums",
+                 timers.active, timers.expirations, timers.wakeups, timers.cascades,
+                 timers.overruns, timers.max_latency_ms);
+
+#ifdef TELEM_DOWNLINK_AUTH
+  telemetry_auth_stats_t auth;
+  telemetry_auth_get_stats(&auth);
+  telemetry_logf("🔐 AUTH: Boot=%lu | Nonces=%lu | Dropped=%lu",
+                 auth.boot, auth.sealed, auth.failures);
+#endif
+
+  telemetry_lock_log_summary();
+  telemetry_isr_log_summary();
+  telemetry_topic_log_summary();
+#ifdef TELEM_COOP_TASKS
+  telemetry_tasks_log_summary();
+#endif
+
+  // Margen mínimo de pila de cada tarea de telemetría (una sola en modo cooperativo)
+  for(size_t i = 0; i < sizeof(telemetry_task_handles) / sizeof(telemetry_task_handles[0]); i++) {
+    if(telemetry_task_handles[i] != NULL) {
+      telemetry_logf("🧵 STACK %s: %u bytes never used",
+                     pcTaskGetName(telemetry_task_handles[i]),
+                     (unsigned)uxTaskGetStackHighWaterMark(telemetry_task_handles[i]));
+    }
+  }
+}
+
+/**
+ * @brief Aplica las tablas de calibración subidas desde tierra
+ */
+static void periodic_calibration_upload(void* arg) {
+  telemetry_calibration_poll_upload();
+}
+
+/**
+ * @brief Vuelve a deep sleep cuando el lote se haya procesado (modo bajo consumo)
+ */
+static void periodic_sleep_service(void* arg) {
+  telemetry_sleep_service();
+}
 
 /**
  * @brief Función de inicialización del sistema
@@ -41,8 +180,14 @@ void vTelemetryTransmitterTask(void *pvParameters);
  * - Recolector: Prioridad 2 (alta)
  * - Procesador: Prioridad 1 (normal)
  * - Transmisor: Prioridad 1 (normal)
+ * 
+ * Con `TELEM_COOP_TASKS` se crea en su lugar una única tarea con las tres
+ * etapas como corrutinas (ver telemetry_tasks.h).
  */
 void setup() {
+  // En modo de bajo consumo, un despertar de muestreo termina aquí
+  telemetry_sleep_handle_wake();
+
   Serial.begin(115200);
 
   // Esperar un poco que Serial esté listo
@@ -61,16 +206,73 @@ void setup() {
 
   telemetry_logf("\n🛰️  TEIDESAT SATELLITE TELEMETRY SYSTEM - ESP32 WOKWI");
   telemetry_logf("======================================================");
+
+  // Tablas de calibración subidas desde tierra (LittleFS ya está montado)
+  telemetry_calibration_init();
+  // Tareas de los buses de sensores: el barrido lee por ellas los monitores I2C
+  if(!telemetry_bus_init()) {
+    telemetry_logf("⚠️ Sensor buses unavailable: bus channels use nominal values");
+  }
+  // Línea ALERT del monitor de potencia: sus paquetes llegan por interrupción
+  if(!telemetry_sensors_alert_init()) {
+    telemetry_logf("⚠️ Power alert line not attached: no free ISR source");
+  }
+#ifdef TELEM_BITPACK_BENCHMARK
+  telemetry_bitpack_benchmark();
+#endif
+#ifdef TELEM_ENTROPY_BENCHMARK
+  telemetry_entropy_benchmark();
+#endif
+#ifdef TELEM_AUTH_BENCHMARK
+  telemetry_auth_benchmark();
+#endif
+#ifdef TELEM_BUS_BENCHMARK
+  telemetry_bus_benchmark(NULL);
+#endif
+#ifdef TELEM_CALIBRATION_BENCHMARK
+  telemetry_calibration_benchmark();
+#endif
+#ifdef TELEM_SOC_BENCHMARK
+  telemetry_soc_benchmark();
+#endif
+#ifdef TELEM_COROUTINE_BENCHMARK
+  telemetry_co_benchmark(NULL);
+#endif
+#ifdef TELEM_ISR_BENCHMARK
+  telemetry_isr_benchmark();
+#endif
+
+  // Servicio de temporizadores: antes de las tareas, que arman los suyos al arrancar
+  if(!telemetry_timers_init()) {
+    telemetry_logf("❌ Timer service could not be started");
+  }
+
   telemetry_logf("Starting FreeRTOS tasks...");
 
   // Crear tareas de telemetría
+#ifdef TELEM_COOP_TASKS
+  // Modo cooperativo: las tres etapas como corrutinas de una única tarea;
+  // su CPU se reparte entre las etapas según el tiempo activo de cada una
+  xTaskCreate(
+    vTelemetryCoopTask,
+    "TelemCoop",
+    TELEM_COOP_STACK_SIZE,
+    NULL,
+    2,
+    &telemetry_task_handles[0]
+  );
+#else
+  TaskHandle_t collector_handle = NULL;
+  TaskHandle_t processor_handle = NULL;
+  TaskHandle_t transmitter_handle = NULL;
+
   xTaskCreate(
     vTelemetryCollectorTask,   // Función
     "TelemCollect",            // Nombre
     4096,                      // Stack size
     NULL,                      // Parámetros
     2,                         // Prioridad
-    NULL                       // Handle
+    &collector_handle          // Handle
   );
 
   xTaskCreate(
@@ -79,7 +281,7 @@ void setup() {
     4096,
     NULL,
     1,
-    NULL
+    &processor_handle
   );
 
   xTaskCreate(
@@ -88,9 +290,37 @@ void setup() {
     4096,
     NULL,
     1,
-    NULL
+    &transmitter_handle
   );
 
+  // Cada tarea imputa su consumo a su etapa al arrancar (run_coroutines())
+  telemetry_task_handles[0] = collector_handle;
+  telemetry_task_handles[1] = processor_handle;
+  telemetry_task_handles[2] = transmitter_handle;
+#endif
+
+  // Trabajo periódico de mantenimiento, ejecutado por loop()
+  static telemetry_timer_t dump_timer;
+  static telemetry_timer_t status_timer;
+  static telemetry_timer_t sleep_timer;
+  static telemetry_timer_t calibration_timer;
+  telemetry_timer_setup(&dump_timer, "log-dump", periodic_log_dump, NULL, TELEM_TIMER_WORKER_MAINTENANCE);
+  telemetry_timer_setup(&status_timer, "status", periodic_status, NULL, TELEM_TIMER_WORKER_MAINTENANCE);
+  telemetry_timer_setup(&sleep_timer, "sleep", periodic_sleep_service, NULL, TELEM_TIMER_WORKER_MAINTENANCE);
+  telemetry_timer_setup(&calibration_timer, "calibration", periodic_calibration_upload, NULL,
+                        TELEM_TIMER_WORKER_MAINTENANCE);
+  telemetry_timer_start(&dump_timer, 15000, 15000);
+  telemetry_timer_start(&status_timer, 30000, 30000);
+  telemetry_timer_start(&sleep_timer, 1000, 1000);
+  telemetry_timer_start(&calibration_timer, 5000, 5000);
+#ifdef TELEM_COOP_TASKS
+  // E/S que no puede bloquear a la tarea cooperativa: log diferido y archivo
+  static telemetry_timer_t coop_io_timer;
+  telemetry_timer_setup(&coop_io_timer, "coop-io", telemetry_coop_io_service, NULL,
+                        TELEM_TIMER_WORKER_MAINTENANCE);
+  telemetry_timer_start(&coop_io_timer, TELEM_COOP_IO_PERIOD_MS, TELEM_COOP_IO_PERIOD_MS);
+#endif
+
   telemetry_logf("✅ All telemetry tasks created successfully");
   telemetry_logf("📡 System operational - Telemetry data generation started");
   telemetry_logf("--------------------------------------------------------");
@@ -99,34 +329,18 @@ void setup() {
 /**
  * @brief Bucle principal del programa
  * 
- * @details En un sistema basado en FreeRTOS, el loop principal se utiliza
- * principalmente para tareas de mantenimiento y monitoreo. En este caso:
- * - Muestra estadísticas del sistema cada 30 segundos
- * - Monitorea el estado general del ESP32
- * - Reporta uso de memoria y número de tareas
+ * @details La tarea de Arduino es el trabajador de mantenimiento del
+ * servicio de temporizadores (telemetry_timers.h): duerme hasta que vence
+ * alguno de sus trabajos y lo ejecuta en cuanto vence, sin sondeo:
+ * - Volcado del log y del buffer cada 15 segundos
+ * - Estado general (memoria, tareas, almacenamiento, energía) cada 30 segundos
+ * - Vigilancia del modo de bajo consumo cada segundo
+ * - Tablas de calibración subidas desde tierra cada 5 segundos
+ * - Con `TELEM_COOP_TASKS`, log diferido y archivo cada TELEM_COOP_IO_PERIOD_MS
  * 
  * @note La mayoría del trabajo real se realiza en las tareas de FreeRTOS,
  * no en este loop.
  */
 void loop() {
-  // FreeRTOS maneja las tareas, este loop puede estar vacío
-  delay(1000);
-
-  // Dump periódico del fichero cada 15 segundos
-  static uint32_t last_dump = 0;
-  if (millis() - last_dump > 15000) {
-    Serial.println("\n[Logger] Dump periódico del fichero /telemetry_log.txt:");
-    telemetry_dump_log();
-    last_dump = millis();
-  }
-
-	// Mostrar estado general periódicamente
-  static uint32_t last_status = 0;
-  if(millis() - last_status > 30000) { // Cada 30 segundos
-    last_status = millis();
-    telemetry_logf("\n📈 SYSTEM STATUS: Uptime: %lus | Heap: %lu | Tasks: %d",
-                   millis() / 1000,
-                   esp_get_free_heap_size(),
-                   uxTaskGetNumberOfTasks());
-  }
-}
\ No newline at end of file
+  telemetry_timers_dispatch(TELEM_TIMER_WORKER_MAINTENANCE, TELEM_TIMER_FOREVER);
+}
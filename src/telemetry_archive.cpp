@@ -0,0 +1,1046 @@
+/**
+ * @file telemetry_archive.cpp
+ * @brief Implementación del archivo masivo de telemetría en tarjeta SD
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Cada segmento es una secuencia de bloques de TELEM_ARCHIVE_BLOCK_SIZE bytes
+ * con ARCHIVE_RECORDS_PER_BLOCK registros cada uno (el resto del bloque queda
+ * a cero). Un bloque se escribe al completarse; el bloque parcial solo llega
+ * al soporte cuando acumula TELEM_ARCHIVE_SYNC_RECORDS registros sin escribir,
+ * cuando el más antiguo de ellos cumple TELEM_ARCHIVE_SYNC_MS o cuando se
+ * pide con telemetry_archive_sync() (antes de dormir).
+ *
+ * En la tarjeta SD los bloques se escriben completos y alineados, con un
+ * único seek + write: el driver SDSPI lo convierte en una escritura
+ * multibloque (CMD25) por DMA y, al estar el fichero preasignado, FATFS no
+ * necesita reservar clusters ni actualizar la FAT. En LittleFS reescribir
+ * datos ya escritos obliga a copiar el bloque de flash entero, así que los
+ * segmentos no se preasignan y solo se añaden al final los registros nuevos
+ * (y el relleno a cero al completar el bloque).
+ *
+ * Los segmentos se reutilizan de forma circular (TELEM_ARCHIVE_MAX_SEGMENTS)
+ * y el índice del segmento actual se guarda en un pequeño fichero auxiliar.
+ *
+ * El mapa de zona del segmento actual se mantiene en memoria y se escribe en
+ * el último bloque del segmento al sellarlo. Un mutex serializa la escritura
+ * con las consultas, que lo toman por tramos de unos pocos bloques para no
+ * bloquear a la tarea procesadora durante toda la consulta; el contador de
+ * rotaciones les permite saber si el escritor recicló el segmento que estaban
+ * leyendo mientras lo soltaban.
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <SD.h>
+#include <SPI.h>
+#include <string.h>
+#include <float.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "../include/telemetry_archive.h"
+#include "../include/telemetry_retention.h"
+#include "../include/telemetry_energy.h"
+#include "../include/telemetry_logger.h"
+#include "../include/telemetry_housekeeping.h"
+#include "../include/telemetry_mapped.h"
+#include "../include/telemetry_lock.h"
+#include "../include/telemetry_downlink.h"
+
+/** @brief Segmentos en rotación en la tarjeta SD */
+#ifndef TELEM_ARCHIVE_MAX_SEGMENTS
+#define TELEM_ARCHIVE_MAX_SEGMENTS 4096
+#endif
+
+/** @brief Segmentos en rotación en el respaldo LittleFS (el histórico sellado se publica en la partición mapeada) */
+#ifndef TELEM_ARCHIVE_FALLBACK_MAX_SEGMENTS
+#define TELEM_ARCHIVE_FALLBACK_MAX_SEGMENTS 4
+#endif
+
+/** @brief Bytes escritos en la prueba de rendimiento al iniciar */
+#ifndef TELEM_ARCHIVE_BENCHMARK_BYTES
+#define TELEM_ARCHIVE_BENCHMARK_BYTES (512UL * 1024UL)
+#endif
+
+/** @brief Espera máxima por el mutex del archivo (ms) */
+#ifndef TELEM_ARCHIVE_LOCK_MS
+#define TELEM_ARCHIVE_LOCK_MS 1000
+#endif
+
+#define ARCHIVE_RECORDS_PER_BLOCK (TELEM_ARCHIVE_BLOCK_SIZE / sizeof(telem_archive_record_t))
+#define ARCHIVE_QUERY_CHUNK_RECORDS (TELEM_ARCHIVE_QUERY_CHUNK_BLOCKS * ARCHIVE_RECORDS_PER_BLOCK)
+#define ARCHIVE_INDEX_FILE TELEM_ARCHIVE_DIR "/current"
+#define ARCHIVE_BENCH_FILE TELEM_ARCHIVE_DIR "/bench.bin"
+
+static fs::FS* archive_fs = NULL;
+static File segment_file;
+
+static uint32_t segment_size = 0;         /**< Tamaño de segmento del soporte activo */
+static uint32_t max_segments = 0;         /**< Segmentos en rotación del soporte activo */
+static uint32_t block_index = 0;          /**< Bloque en curso dentro del segmento */
+static uint32_t block_records = 0;        /**< Registros en el bloque en curso */
+static uint32_t synced_records = 0;       /**< Registros del bloque en curso ya escritos en el soporte */
+static int64_t pending_since_us = 0;      /**< Llegada del registro más antiguo sin escribir */
+static telem_zone_map_t current_zone;     /**< Mapa de zona del segmento en curso */
+static uint32_t rotations = 0;            /**< Cambios de segmento desde el arranque */
+static telemetry_lock_t archive_mutex;
+
+/** @brief Bloque de escritura en curso (alineado para DMA) */
+static uint8_t block_buffer[TELEM_ARCHIVE_BLOCK_SIZE] __attribute__((aligned(4)));
+
+static telemetry_archive_stats_t archive_stats;
+
+/**
+ * @brief Construye la ruta de un segmento
+ */
+static void archive_segment_path(uint32_t segment, char* path, size_t size) {
+  snprintf(path, size, TELEM_ARCHIVE_DIR "/seg_%05lu.bin", (unsigned long)segment);
+}
+
+/**
+ * @brief Bloques de datos de un segmento (el último guarda el mapa de zona)
+ */
+static uint32_t archive_data_blocks(void) {
+  return segment_size / TELEM_ARCHIVE_BLOCK_SIZE - 1;
+}
+
+/**
+ * @brief Tipos contenidos en un paquete, como bits (1 << tipo)
+ *
+ * @details Un registro de housekeeping contiene su propio tipo y los de sus
+ * cargas útiles presentes.
+ */
+static uint32_t archive_record_types(const telemetry_packet_t* packet) {
+  uint32_t types = 1UL << packet->header.type;
+  if(packet->header.type == TELEM_HOUSEKEEPING) {
+    types |= packet->housekeeping.presence;
+  }
+  return types;
+}
+
+/**
+ * @brief Obtiene el valor de un campo de un paquete
+ *
+ * @return true Si el paquete contiene el campo (directamente o en un registro
+ * combinado de housekeeping)
+ */
+static bool archive_field_value(const telemetry_packet_t* packet, telem_archive_field_t field, float* value) {
+  telem_data_type_t type = field == TELEM_FIELD_BATTERY_VOLTAGE ? TELEM_POWER_DATA : TELEM_TEMPERATURE_DATA;
+  telemetry_packet_t part;
+
+  if(field == TELEM_FIELD_NONE || field >= TELEM_FIELD_COUNT) {
+    return false;
+  }
+  if(packet->header.type == TELEM_HOUSEKEEPING) {
+    if(!telemetry_hk_extract(&packet->housekeeping, type, &part)) {
+      return false;
+    }
+    packet = &part;
+  } else if(packet->header.type != type) {
+    return false;
+  }
+
+  *value = field == TELEM_FIELD_BATTERY_VOLTAGE ? packet->power.battery_voltage
+                                                : (float)packet->temperature.obc_temperature;
+  return true;
+}
+
+/**
+ * @brief Deja un mapa de zona vacío
+ */
+static void zone_reset(telem_zone_map_t* zone) {
+  memset(zone, 0, sizeof(*zone));
+  zone->magic = TELEM_ZONE_MAGIC;
+  zone->min_timestamp = UINT32_MAX;
+  for(int field = 0; field < TELEM_FIELD_COUNT; field++) {
+    zone->min_value[field] = FLT_MAX;
+    zone->max_value[field] = -FLT_MAX;
+  }
+}
+
+/**
+ * @brief Incorpora un paquete al mapa de zona
+ */
+static void zone_update(telem_zone_map_t* zone, const telemetry_packet_t* packet) {
+  float value;
+
+  zone->records++;
+  if(packet->header.timestamp < zone->min_timestamp) zone->min_timestamp = packet->header.timestamp;
+  if(packet->header.timestamp > zone->max_timestamp) zone->max_timestamp = packet->header.timestamp;
+  uint32_t types = archive_record_types(packet);
+  for(int type = 0; type < TELEM_TYPE_COUNT; type++) {
+    if(types & (1UL << type)) {
+      zone->type_counts[type]++;
+    }
+  }
+
+  for(int field = TELEM_FIELD_NONE + 1; field < TELEM_FIELD_COUNT; field++) {
+    if(archive_field_value(packet, (telem_archive_field_t)field, &value)) {
+      if(value < zone->min_value[field]) zone->min_value[field] = value;
+      if(value > zone->max_value[field]) zone->max_value[field] = value;
+    }
+  }
+}
+
+/**
+ * @brief Indica si un segmento con este mapa de zona puede contener coincidencias
+ */
+static bool zone_may_match(const telem_zone_map_t* zone, const telemetry_archive_query_t* query) {
+  if(zone->records == 0 ||
+     zone->max_timestamp < query->from_timestamp || zone->min_timestamp > query->to_timestamp) {
+    return false;
+  }
+
+  if(query->type_mask != 0) {
+    bool any_type = false;
+    for(int type = 0; type < TELEM_TYPE_COUNT; type++) {
+      if(zone->type_counts[type] > 0 && (query->type_mask & (1UL << type))) {
+        any_type = true;
+      }
+    }
+    if(!any_type) {
+      return false;
+    }
+  }
+
+  if(query->field != TELEM_FIELD_NONE && query->field < TELEM_FIELD_COUNT) {
+    return zone->max_value[query->field] >= query->min_value &&
+           zone->min_value[query->field] <= query->max_value;
+  }
+  return true;
+}
+
+/**
+ * @brief Indica si un registro coincide con la consulta
+ */
+static bool archive_record_matches(const telemetry_packet_t* packet, const telemetry_archive_query_t* query) {
+  float value;
+
+  if(packet->header.timestamp < query->from_timestamp || packet->header.timestamp > query->to_timestamp) {
+    return false;
+  }
+  if(query->type_mask != 0 && !(query->type_mask & archive_record_types(packet))) {
+    return false;
+  }
+  if(query->field != TELEM_FIELD_NONE) {
+    return archive_field_value(packet, query->field, &value) &&
+           value >= query->min_value && value <= query->max_value;
+  }
+  return true;
+}
+
+/**
+ * @brief Crea (o recicla) un fichero con todo su tamaño escrito a cero
+ *
+ * @details Escribir el fichero completo al crearlo reserva todos sus clusters
+ * de una vez; los añadidos posteriores solo sobrescriben datos. Con tamaño 0
+ * deja el fichero vacío.
+ */
+static bool archive_preallocate(const char* path, uint32_t size) {
+  File f = archive_fs->open(path, FILE_WRITE);
+  if(!f) {
+    return false;
+  }
+
+  memset(block_buffer, 0, sizeof(block_buffer));
+  for(uint32_t offset = 0; offset < size; offset += TELEM_ARCHIVE_BLOCK_SIZE) {
+    if(f.write(block_buffer, TELEM_ARCHIVE_BLOCK_SIZE) != TELEM_ARCHIVE_BLOCK_SIZE) {
+      f.close();
+      return false;
+    }
+  }
+  f.close();
+  return true;
+}
+
+/**
+ * @brief Comprueba si un registro del bloque en memoria es válido
+ */
+static bool archive_record_valid(const telem_archive_record_t* record) {
+  return record->crc != 0 &&
+         record->crc == telemetry_retention_crc(&record->packet, sizeof(record->packet));
+}
+
+/**
+ * @brief Lee un bloque del segmento abierto en block_buffer
+ *
+ * @details En LittleFS el último bloque puede estar a medias: lo que falta
+ * hasta el final del fichero se deja a cero, como en un bloque preasignado.
+ */
+static bool archive_read_block(uint32_t block) {
+  if(!segment_file.seek(block * TELEM_ARCHIVE_BLOCK_SIZE, SeekSet)) {
+    return false;
+  }
+  size_t length = segment_file.read(block_buffer, TELEM_ARCHIVE_BLOCK_SIZE);
+  if(length == 0 || length > TELEM_ARCHIVE_BLOCK_SIZE) {
+    return false;
+  }
+  memset(block_buffer + length, 0, TELEM_ARCHIVE_BLOCK_SIZE - length);
+  return true;
+}
+
+/** @brief Resultado de recorrer un tramo de bloques */
+typedef enum {
+  ARCHIVE_WALK_MORE = 0,    /**< El tramo terminó sin llegar al final de los datos */
+  ARCHIVE_WALK_END,         /**< Se llegó al primer bloque vacío (o a un error de lectura) */
+  ARCHIVE_WALK_STOPPED      /**< La función pidió detener el recorrido */
+} archive_walk_t;
+
+/**
+ * @brief Recorre los registros válidos de los bloques [first, last) de un segmento
+ *
+ * @param f Fichero del segmento
+ * @param first Primer bloque del tramo
+ * @param last Bloque siguiente al último del tramo
+ * @param fn Función llamada con cada paquete; si devuelve false se detiene
+ * @param context Contexto pasado a fn
+ * @param[in,out] bytes_read Acumulador de bytes leídos
+ *
+ * @details Cada bloque termina en su primer registro inválido y el recorrido
+ * termina en el primer bloque vacío.
+ */
+static archive_walk_t archive_for_each_record(File& f, uint32_t first, uint32_t last,
+                                              bool (*fn)(const telemetry_packet_t*, void*), void* context,
+                                              uint32_t* bytes_read) {
+  telem_archive_record_t record;
+
+  for(uint32_t block = first; block < last; block++) {
+    if(!f.seek(block * TELEM_ARCHIVE_BLOCK_SIZE, SeekSet)) {
+      return ARCHIVE_WALK_END;
+    }
+    for(uint32_t slot = 0; slot < ARCHIVE_RECORDS_PER_BLOCK; slot++) {
+      if(f.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+        return ARCHIVE_WALK_END;
+      }
+      *bytes_read += sizeof(record);
+      if(!archive_record_valid(&record)) {
+        if(slot == 0) {
+          return ARCHIVE_WALK_END;
+        }
+        break;
+      }
+      if(!fn(&record.packet, context)) {
+        return ARCHIVE_WALK_STOPPED;
+      }
+    }
+  }
+  return ARCHIVE_WALK_MORE;
+}
+
+/**
+ * @brief Lee y valida el mapa de zona de un segmento sellado
+ */
+static bool archive_read_zone(File& f, telem_zone_map_t* zone, uint32_t* bytes_read) {
+  if(!f.seek(archive_data_blocks() * TELEM_ARCHIVE_BLOCK_SIZE, SeekSet) ||
+     f.read((uint8_t*)zone, sizeof(*zone)) != sizeof(*zone)) {
+    return false;
+  }
+  *bytes_read += sizeof(*zone);
+  return zone->magic == TELEM_ZONE_MAGIC &&
+         zone->crc == telemetry_retention_crc(zone, offsetof(telem_zone_map_t, crc));
+}
+
+/**
+ * @brief Lleva al soporte los registros del bloque en curso que aún no están en él
+ *
+ * @details En la tarjeta SD se escribe el bloque completo en su posición
+ * alineada. En LittleFS solo se añaden al final del fichero los registros
+ * nuevos y, si el bloque está completo, el relleno a cero que lo cierra.
+ */
+static bool archive_write_block(void) {
+  uint32_t from = 0;
+  uint32_t to = TELEM_ARCHIVE_BLOCK_SIZE;
+  if(archive_stats.backend == TELEM_ARCHIVE_LITTLEFS) {
+    from = synced_records * sizeof(telem_archive_record_t);
+    if(block_records < ARCHIVE_RECORDS_PER_BLOCK) {
+      to = block_records * sizeof(telem_archive_record_t);
+    }
+  }
+
+  int64_t start = esp_timer_get_time();
+  bool ok = segment_file.seek(block_index * TELEM_ARCHIVE_BLOCK_SIZE + from, SeekSet) &&
+            segment_file.write(block_buffer + from, to - from) == to - from;
+  segment_file.flush();
+
+  uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+  if(!ok) {
+    archive_stats.errors++;
+    return false;
+  }
+
+  synced_records = block_records;
+  archive_stats.flushes++;
+  archive_stats.bytes_written += to - from;
+  if(elapsed > archive_stats.worst_flush_us) {
+    archive_stats.worst_flush_us = elapsed;
+  }
+  telemetry_energy_add_flash(to - from);
+  return true;
+}
+
+/**
+ * @brief Vuelve a cargar el bloque en curso tras usar block_buffer para otra cosa
+ */
+static void archive_restore_block(void) {
+  if(!segment_file || block_records == 0 || !archive_read_block(block_index)) {
+    memset(block_buffer, 0, sizeof(block_buffer));
+  }
+}
+
+/**
+ * @brief Sella el segmento actual escribiendo su mapa de zona en el último bloque
+ */
+static void archive_seal_segment(void) {
+  current_zone.crc = telemetry_retention_crc(&current_zone, offsetof(telem_zone_map_t, crc));
+
+  if(!segment_file.seek(archive_data_blocks() * TELEM_ARCHIVE_BLOCK_SIZE, SeekSet) ||
+     segment_file.write((const uint8_t*)&current_zone, sizeof(current_zone)) != sizeof(current_zone)) {
+    archive_stats.errors++;
+    return;
+  }
+  segment_file.flush();
+  archive_stats.bytes_written += sizeof(current_zone);
+  telemetry_energy_add_flash(sizeof(current_zone));
+}
+
+/**
+ * @brief Abre un segmento, creándolo si no existe o reciclándolo si se indica
+ */
+static bool archive_open_segment(uint32_t segment, bool recycle) {
+  char path[32];
+  archive_segment_path(segment, path, sizeof(path));
+
+  if(segment_file) {
+    segment_file.close();
+  }
+
+  if(recycle || !archive_fs->exists(path)) {
+    // LittleFS: el segmento empieza vacío y crece por el final
+    uint32_t size = archive_stats.backend == TELEM_ARCHIVE_SD ? segment_size : 0;
+    if(!archive_preallocate(path, size)) {
+      return false;
+    }
+  }
+
+  segment_file = archive_fs->open(path, "r+");
+  if(!segment_file) {
+    return false;
+  }
+
+  File index = archive_fs->open(ARCHIVE_INDEX_FILE, FILE_WRITE);
+  if(index) {
+    index.write((const uint8_t*)&segment, sizeof(segment));
+    index.close();
+  }
+
+  archive_stats.segment = segment;
+  block_index = 0;
+  block_records = 0;
+  synced_records = 0;
+  memset(block_buffer, 0, sizeof(block_buffer));
+  zone_reset(&current_zone);
+  return true;
+}
+
+/**
+ * @brief Adaptador de zone_update() para archive_for_each_record()
+ */
+static bool archive_zone_visit(const telemetry_packet_t* packet, void* context) {
+  zone_update((telem_zone_map_t*)context, packet);
+  return true;
+}
+
+/**
+ * @brief Recupera el punto de escritura y el mapa de zona del segmento abierto
+ *
+ * @details Los bloques se llenan en orden, así que basta una búsqueda
+ * binaria sobre el primer registro de cada bloque para encontrar el primer
+ * bloque sin usar; después se carga el último bloque usado, se cuentan sus
+ * registros válidos y se recorre el segmento para reconstruir el mapa de zona.
+ */
+static void archive_recover_position(void) {
+  uint32_t low = 0;
+  uint32_t high = archive_data_blocks();
+  uint32_t bytes_read = 0;
+
+  while(low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if(archive_read_block(mid) && archive_record_valid((const telem_archive_record_t*)block_buffer)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  block_index = 0;
+  block_records = 0;
+  synced_records = 0;
+  memset(block_buffer, 0, sizeof(block_buffer));
+  if(low == 0 || !archive_read_block(low - 1)) {
+    return;
+  }
+
+  const telem_archive_record_t* records = (const telem_archive_record_t*)block_buffer;
+  uint32_t valid = 0;
+  while(valid < ARCHIVE_RECORDS_PER_BLOCK && archive_record_valid(&records[valid])) {
+    valid++;
+  }
+
+  if(valid == ARCHIVE_RECORDS_PER_BLOCK) {
+    block_index = low;
+    memset(block_buffer, 0, sizeof(block_buffer));
+  } else {
+    block_index = low - 1;
+    block_records = valid;
+    synced_records = valid;
+    memset(block_buffer + valid * sizeof(telem_archive_record_t), 0,
+           sizeof(block_buffer) - valid * sizeof(telem_archive_record_t));
+  }
+
+  archive_for_each_record(segment_file, 0, block_index, archive_zone_visit, &current_zone, &bytes_read);
+  for(uint32_t slot = 0; slot < block_records; slot++) {
+    zone_update(&current_zone, &records[slot].packet);
+  }
+}
+
+/**
+ * @brief Monta la tarjeta SD o, si falla, el respaldo en LittleFS
+ */
+static bool archive_mount(void) {
+  if(SD.begin(TELEM_SD_CS_PIN, SPI, TELEM_SD_SPI_HZ)) {
+    archive_fs = &SD;
+    archive_stats.backend = TELEM_ARCHIVE_SD;
+    segment_size = TELEM_ARCHIVE_SEGMENT_SIZE;
+    max_segments = TELEM_ARCHIVE_MAX_SEGMENTS;
+    return true;
+  }
+
+  if(LittleFS.begin(true)) {
+    archive_fs = &LittleFS;
+    archive_stats.backend = TELEM_ARCHIVE_LITTLEFS;
+    segment_size = TELEM_ARCHIVE_FALLBACK_SEGMENT_SIZE;
+    max_segments = TELEM_ARCHIVE_FALLBACK_MAX_SEGMENTS;
+    return true;
+  }
+
+  archive_stats.backend = TELEM_ARCHIVE_NONE;
+  return false;
+}
+
+/**
+ * @brief Copia el segmento recién sellado a la partición mapeada
+ *
+ * @details Solo en el respaldo de flash interna, cuyos segmentos tienen el
+ * tamaño de una ranura; la tarjeta SD no se puede mapear en memoria.
+ */
+static void archive_publish_mapped(void) {
+  if(archive_stats.backend != TELEM_ARCHIVE_LITTLEFS || segment_size != TELEM_MAPPED_SLOT_SIZE ||
+     !telemetry_mapped_begin(archive_stats.segment)) {
+    return;
+  }
+
+  for(uint32_t block = 0; block < archive_data_blocks(); block++) {
+    if(!archive_read_block(block) || !telemetry_mapped_write_block(block, block_buffer)) {
+      archive_stats.errors++;
+      return;
+    }
+  }
+  telemetry_mapped_seal(&current_zone);
+}
+
+/**
+ * @brief Sella el segmento lleno y pasa al siguiente de la rotación
+ */
+static bool archive_next_segment(void) {
+  archive_seal_segment();
+  archive_publish_mapped();
+  rotations++;
+  return archive_open_segment((archive_stats.segment + 1) % max_segments, true);
+}
+
+bool telemetry_archive_init(void) {
+  memset(&archive_stats, 0, sizeof(archive_stats));
+  if(archive_mutex.handle == NULL) {
+    telemetry_lock_create(&archive_mutex, "archive");
+  }
+
+  if(!archive_mount()) {
+    telemetry_logf("⚠️ Archive: no storage available");
+    return false;
+  }
+  archive_fs->mkdir(TELEM_ARCHIVE_DIR);
+  telemetry_mapped_init();
+
+#ifdef TELEM_ARCHIVE_BENCHMARK
+  telemetry_archive_benchmark(TELEM_ARCHIVE_BENCHMARK_BYTES, NULL);
+#endif
+
+  uint32_t segment = 0;
+  File index = archive_fs->open(ARCHIVE_INDEX_FILE, FILE_READ);
+  if(index) {
+    if(index.read((uint8_t*)&segment, sizeof(segment)) != sizeof(segment) || segment >= max_segments) {
+      segment = 0;
+    }
+    index.close();
+  }
+
+  if(!archive_open_segment(segment, false)) {
+    telemetry_logf("⚠️ Archive: cannot open segment %lu", segment);
+    archive_stats.backend = TELEM_ARCHIVE_NONE;
+    return false;
+  }
+  archive_recover_position();
+
+  if(block_index >= archive_data_blocks()) {
+    archive_next_segment();
+  }
+
+  telemetry_logf("🗄️ Archive on %s: segment %lu, block %lu, %lu records in block | Mapped slots=%lu",
+                 archive_stats.backend == TELEM_ARCHIVE_SD ? "SD" : "LittleFS",
+                 archive_stats.segment, block_index, block_records, telemetry_mapped_slots());
+
+#ifdef TELEM_ARCHIVE_BENCHMARK
+  telemetry_archive_replay_benchmark();
+#endif
+  return true;
+}
+
+bool telemetry_archive_append(const telemetry_packet_t* packet) {
+  bool result = true;
+
+  if(archive_stats.backend == TELEM_ARCHIVE_NONE || archive_mutex.handle == NULL) {
+    return false;
+  }
+  if(!telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+    archive_stats.errors++;
+    return false;
+  }
+
+  if(!segment_file) {
+    telemetry_lock_give(&archive_mutex);
+    return false;
+  }
+
+  telem_archive_record_t* record = (telem_archive_record_t*)block_buffer + block_records;
+  record->packet = *packet;
+  record->crc = telemetry_retention_crc(&record->packet, sizeof(record->packet));
+  if(block_records == synced_records) {
+    pending_since_us = esp_timer_get_time();
+  }
+  block_records++;
+  archive_stats.records++;
+  zone_update(&current_zone, packet);
+
+  if(block_records == ARCHIVE_RECORDS_PER_BLOCK) {
+    // Bloque completo: se escribe y se pasa al siguiente (o al siguiente segmento)
+    archive_write_block();
+    block_index++;
+    block_records = 0;
+    synced_records = 0;
+    memset(block_buffer, 0, sizeof(block_buffer));
+
+    if(block_index >= archive_data_blocks()) {
+      result = archive_next_segment();
+    }
+  }
+
+  telemetry_lock_give(&archive_mutex);
+  return result;
+}
+
+/**
+ * @brief Escribe el bloque parcial si tiene registros pendientes y, salvo que se fuerce, si toca
+ */
+static void archive_sync_partial(bool force) {
+  if(archive_stats.backend == TELEM_ARCHIVE_NONE || archive_mutex.handle == NULL) {
+    return;
+  }
+  if(telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+    // Sin registros nuevos el bloque del soporte ya está al día
+    uint32_t pending = block_records - synced_records;
+    bool due = pending >= TELEM_ARCHIVE_SYNC_RECORDS ||
+               esp_timer_get_time() - pending_since_us >= (int64_t)TELEM_ARCHIVE_SYNC_MS * 1000;
+    if(segment_file && pending > 0 && (force || due)) {
+      archive_write_block();
+    }
+    telemetry_lock_give(&archive_mutex);
+  }
+}
+
+void telemetry_archive_flush(void) {
+  archive_sync_partial(false);
+}
+
+void telemetry_archive_sync(void) {
+  archive_sync_partial(true);
+}
+
+void telemetry_archive_get_stats(telemetry_archive_stats_t* stats) {
+  *stats = archive_stats;
+}
+
+/** @brief Estado de una consulta en curso */
+typedef struct {
+  const telemetry_archive_query_t* query;
+  telemetry_archive_visitor_t visitor;
+  void* context;
+  telemetry_archive_query_stats_t* stats;
+  uint32_t mapped_until;      /**< Las ranuras mapeadas de generación menor ya se recorrieron */
+} archive_query_state_t;
+
+/**
+ * @brief Evalúa un registro leído durante una consulta
+ */
+static bool archive_query_visit(const telemetry_packet_t* packet, void* context) {
+  archive_query_state_t* state = (archive_query_state_t*)context;
+
+  state->stats->records_scanned++;
+  if(!archive_record_matches(packet, state->query)) {
+    return true;
+  }
+  state->stats->matches++;
+  return state->visitor == NULL || state->visitor(packet, state->context);
+}
+
+/**
+ * @brief Indica si el escritor ha reciclado un segmento desde que empezó a leerse
+ *
+ * @param age Distancia del segmento al actual cuando empezó a leerse
+ * @param since Valor de rotations en ese momento
+ *
+ * @note Llamar con archive_mutex tomado.
+ */
+static bool archive_recycled(uint32_t age, uint32_t since) {
+  return rotations - since >= max_segments - age;
+}
+
+/**
+ * @brief Consulta un segmento leyendo sus bloques por tramos
+ *
+ * @param segment Segmento a consultar
+ * @param age Distancia al segmento actual al empezar la consulta (0 = el actual)
+ * @param since Valor de rotations al empezar la consulta
+ * @param state Consulta en curso
+ * @return false Si el visitante pidió terminar la consulta
+ *
+ * @details El mutex se toma para decidir si el segmento puede contener
+ * coincidencias y después una vez por tramo, de modo que la tarea procesadora
+ * puede archivar entre tramos. El segmento actual se lee con segment_file
+ * mientras siga siéndolo; si el escritor pasa al siguiente a mitad de la
+ * consulta, el resto se lee del fichero ya sellado.
+ */
+static bool archive_query_segment(uint32_t segment, uint32_t age, uint32_t since,
+                                  archive_query_state_t* state) {
+  telemetry_archive_query_stats_t* stats = state->stats;
+  File sealed;
+  uint32_t blocks = 0;
+  char path[32];
+
+  if(!telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+    return true;
+  }
+  if(archive_recycled(age, since)) {
+    telemetry_lock_give(&archive_mutex);
+    return true;
+  }
+  bool live = segment == archive_stats.segment;
+  bool skip = true;
+  archive_segment_path(segment, path, sizeof(path));
+  if(live) {
+    stats->segments++;
+    if(segment_file && zone_may_match(&current_zone, state->query)) {
+      // El bloque parcial se lleva al soporte para leerlo junto al resto
+      if(block_records > synced_records) {
+        archive_write_block();
+      }
+      blocks = block_index + (block_records > 0 ? 1 : 0);
+      skip = false;
+    }
+  } else {
+    sealed = archive_fs->open(path, FILE_READ);
+    if(sealed) {
+      telem_zone_map_t zone;
+      bool zoned = archive_read_zone(sealed, &zone, &stats->bytes_read);
+      uint32_t generation = zoned ? telemetry_mapped_generation_of(&zone) : 0;
+      if(generation != 0 && generation < state->mapped_until) {
+        // Ya recorrido en la partición mapeada
+        sealed.close();
+        telemetry_lock_give(&archive_mutex);
+        return true;
+      }
+      stats->segments++;
+      blocks = archive_data_blocks();
+      // Sin mapa de zona válido (p. ej. reinicio antes de sellar) no se puede descartar
+      skip = zoned && !zone_may_match(&zone, state->query);
+    }
+  }
+  if(skip && (live || sealed)) {
+    stats->segments_skipped++;
+  }
+  telemetry_lock_give(&archive_mutex);
+
+  archive_walk_t walk = ARCHIVE_WALK_MORE;
+  for(uint32_t first = 0; !skip && first < blocks && walk == ARCHIVE_WALK_MORE;
+      first += TELEM_ARCHIVE_QUERY_CHUNK_BLOCKS) {
+    if(!telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+      break;
+    }
+    if(archive_recycled(age, since)) {
+      telemetry_lock_give(&archive_mutex);
+      break;
+    }
+    if(live && !sealed && segment != archive_stats.segment) {
+      sealed = archive_fs->open(path, FILE_READ);
+    }
+
+    File& source = (live && !sealed) ? segment_file : sealed;
+    uint32_t last = first + TELEM_ARCHIVE_QUERY_CHUNK_BLOCKS < blocks ? first + TELEM_ARCHIVE_QUERY_CHUNK_BLOCKS : blocks;
+    walk = source ? archive_for_each_record(source, first, last, archive_query_visit, state, &stats->bytes_read)
+                  : ARCHIVE_WALK_END;
+    telemetry_lock_give(&archive_mutex);
+    // Cede el procesador a una tarea de igual prioridad que espere el mutex
+    taskYIELD();
+  }
+
+  if(sealed) {
+    sealed.close();
+  }
+  return walk != ARCHIVE_WALK_STOPPED;
+}
+
+/**
+ * @brief Consulta el histórico publicado en la partición mapeada
+ *
+ * @details Los registros se leen en su sitio, sin copiarlos por la VFS. Como
+ * con los ficheros, el mutex se toma por tramos: los segmentos se publican
+ * con él tomado y el cursor pasa a la siguiente generación si su ranura se
+ * reutilizó entretanto.
+ *
+ * @return false Si el visitante pidió terminar la consulta
+ */
+static bool archive_query_mapped(archive_query_state_t* state) {
+  telemetry_archive_query_stats_t* stats = state->stats;
+  telemetry_mapped_cursor_t cursor;
+  archive_walk_t walk = ARCHIVE_WALK_MORE;
+  uint32_t counted = 0;
+
+  telemetry_mapped_cursor_begin(&cursor);
+  while(walk == ARCHIVE_WALK_MORE &&
+        telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+    for(uint32_t step = 0; walk == ARCHIVE_WALK_MORE && step < ARCHIVE_QUERY_CHUNK_RECORDS; step++) {
+      const telem_mapped_footer_t* footer = telemetry_mapped_cursor_footer(&cursor);
+      if(footer == NULL) {
+        walk = ARCHIVE_WALK_END;
+        break;
+      }
+      if(footer->generation != counted) {
+        counted = footer->generation;
+        stats->segments++;
+        stats->segments_mapped++;
+        if(!zone_may_match(&footer->zone, state->query)) {
+          stats->segments_skipped++;
+          telemetry_mapped_cursor_skip(&cursor);
+          continue;
+        }
+      }
+      const telemetry_packet_t* packet = telemetry_mapped_next_in_slot(&cursor);
+      if(packet != NULL) {
+        stats->bytes_read += sizeof(telem_archive_record_t);
+        if(!archive_query_visit(packet, state)) {
+          walk = ARCHIVE_WALK_STOPPED;
+        }
+      }
+    }
+    telemetry_lock_give(&archive_mutex);
+    taskYIELD();
+  }
+
+  state->mapped_until = cursor.generation;
+  return walk != ARCHIVE_WALK_STOPPED;
+}
+
+uint32_t telemetry_archive_query(const telemetry_archive_query_t* query,
+                                 telemetry_archive_visitor_t visitor, void* context,
+                                 telemetry_archive_query_stats_t* stats) {
+  telemetry_archive_query_stats_t local;
+  archive_query_state_t state = { query, visitor, context, &local, 0 };
+  bool running = true;
+  char path[32];
+
+  memset(&local, 0, sizeof(local));
+  if(archive_stats.backend == TELEM_ARCHIVE_NONE || archive_mutex.handle == NULL) {
+    if(stats != NULL) *stats = local;
+    return 0;
+  }
+
+  // Segmento actual y rotaciones de referencia para detectar reciclados
+  if(!telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+    if(stats != NULL) *stats = local;
+    return 0;
+  }
+  uint32_t current = archive_stats.segment;
+  uint32_t since = rotations;
+  telemetry_lock_give(&archive_mutex);
+
+  // Segmentos sellados anteriores al actual, del más reciente hacia atrás hasta el primer hueco
+  uint32_t older = 0;
+  while(older < max_segments - 1) {
+    archive_segment_path((current + max_segments - older - 1) % max_segments, path, sizeof(path));
+    if(!archive_fs->exists(path)) {
+      break;
+    }
+    older++;
+  }
+
+  // Histórico publicado en la partición mapeada (del respaldo LittleFS)
+  if(archive_stats.backend == TELEM_ARCHIVE_LITTLEFS && telemetry_mapped_available()) {
+    running = archive_query_mapped(&state);
+  }
+
+  // Recorrido cronológico hasta el segmento actual incluido; el mutex se toma por tramos
+  for(uint32_t age = older + 1; age > 0 && running; age--) {
+    running = archive_query_segment((current + max_segments - (age - 1)) % max_segments, age - 1, since, &state);
+  }
+
+  if(stats != NULL) {
+    *stats = local;
+  }
+  return local.matches;
+}
+
+bool telemetry_archive_benchmark(uint32_t bytes, telemetry_archive_benchmark_t* result) {
+  if(archive_fs == NULL || archive_mutex.handle == NULL ||
+     !telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+    return false;
+  }
+
+  // La prueba usa el bloque de escritura: el bloque parcial se lleva antes al soporte
+  if(segment_file && block_records > synced_records) {
+    archive_write_block();
+  }
+
+  uint32_t blocks = (bytes + TELEM_ARCHIVE_BLOCK_SIZE - 1) / TELEM_ARCHIVE_BLOCK_SIZE;
+
+  int64_t start = esp_timer_get_time();
+  if(!archive_preallocate(ARCHIVE_BENCH_FILE, blocks * TELEM_ARCHIVE_BLOCK_SIZE)) {
+    telemetry_logf("⚠️ Archive benchmark: preallocation failed");
+    archive_restore_block();
+    telemetry_lock_give(&archive_mutex);
+    return false;
+  }
+  uint32_t prealloc_us = (uint32_t)(esp_timer_get_time() - start);
+
+  File f = archive_fs->open(ARCHIVE_BENCH_FILE, "r+");
+  if(!f) {
+    archive_restore_block();
+    telemetry_lock_give(&archive_mutex);
+    return false;
+  }
+
+  memset(block_buffer, 0xA5, sizeof(block_buffer));
+  uint32_t worst_us = 0;
+  uint32_t written = 0;
+  start = esp_timer_get_time();
+  for(uint32_t block = 0; block < blocks; block++) {
+    int64_t block_start = esp_timer_get_time();
+    if(!f.seek(block * TELEM_ARCHIVE_BLOCK_SIZE, SeekSet) ||
+       f.write(block_buffer, TELEM_ARCHIVE_BLOCK_SIZE) != TELEM_ARCHIVE_BLOCK_SIZE) {
+      break;
+    }
+    f.flush();
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - block_start);
+    if(elapsed > worst_us) {
+      worst_us = elapsed;
+    }
+    written += TELEM_ARCHIVE_BLOCK_SIZE;
+  }
+  uint32_t total_us = (uint32_t)(esp_timer_get_time() - start);
+  f.close();
+  archive_fs->remove(ARCHIVE_BENCH_FILE);
+  archive_restore_block();
+  telemetry_lock_give(&archive_mutex);
+
+  // KB/s = bytes * 1e6 / (us * 1024); se muestran MB/s con dos decimales
+  uint32_t kbps = total_us > 0 ? (uint32_t)((uint64_t)written * 1000000ULL / ((uint64_t)total_us * 1024)) : 0;
+  telemetry_logf("⏱️ Archive benchmark (%s): %lu KB in %lu ms = %lu.%02lu MB/s | worst block %lu us | prealloc %lu ms",
+                 archive_stats.backend == TELEM_ARCHIVE_SD ? "SD" : "LittleFS",
+                 written / 1024, total_us / 1000, kbps / 1024, (kbps % 1024) * 100 / 1024,
+                 worst_us, prealloc_us / 1000);
+
+  if(result != NULL) {
+    result->bytes = written;
+    result->total_us = total_us;
+    result->kbps = kbps;
+    result->worst_block_us = worst_us;
+    result->prealloc_us = prealloc_us;
+  }
+  return written == blocks * TELEM_ARCHIVE_BLOCK_SIZE;
+}
+
+/** @brief Totales de una reproducción de referencia */
+typedef struct {
+  uint32_t records;
+  uint32_t wire_bytes;
+} archive_replay_totals_t;
+
+/**
+ * @brief Trabajo de referencia por paquete en la reproducción: calcular su tamaño en trama
+ */
+static bool archive_replay_visit(const telemetry_packet_t* packet, void* context) {
+  archive_replay_totals_t* totals = (archive_replay_totals_t*)context;
+  totals->records++;
+  totals->wire_bytes += telemetry_packet_wire_size(packet);
+  return true;
+}
+
+void telemetry_archive_replay_benchmark(void) {
+  archive_replay_totals_t mapped = { 0, 0 };
+  archive_replay_totals_t file = { 0, 0 };
+  uint32_t file_bytes = 0;
+  telemetry_mapped_cursor_t cursor;
+  const telemetry_packet_t* packet;
+  char path[32];
+
+  if(archive_fs == NULL || archive_mutex.handle == NULL) {
+    return;
+  }
+
+  // Flash mapeada: los paquetes se leen en su sitio
+  int64_t start = esp_timer_get_time();
+  telemetry_mapped_cursor_begin(&cursor);
+  while((packet = telemetry_mapped_next(&cursor)) != NULL) {
+    archive_replay_visit(packet, &mapped);
+  }
+  uint32_t mapped_us = (uint32_t)(esp_timer_get_time() - start);
+
+  // API de ficheros: cada registro se copia a través de la VFS
+  start = esp_timer_get_time();
+  for(uint32_t segment = 0; segment < max_segments; segment++) {
+    if(segment == archive_stats.segment) {
+      continue;
+    }
+    archive_segment_path(segment, path, sizeof(path));
+    if(!telemetry_lock_take(&archive_mutex, pdMS_TO_TICKS(TELEM_ARCHIVE_LOCK_MS))) {
+      continue;
+    }
+    File f = archive_fs->open(path, FILE_READ);
+    if(f) {
+      archive_for_each_record(f, 0, archive_data_blocks(), archive_replay_visit, &file, &file_bytes);
+      f.close();
+    }
+    telemetry_lock_give(&archive_mutex);
+  }
+  uint32_t file_us = (uint32_t)(esp_timer_get_time() - start);
+
+  // KB/s de registros reproducidos
+  uint64_t mapped_bytes = (uint64_t)mapped.records * sizeof(telem_archive_record_t);
+  uint64_t replayed_bytes = (uint64_t)file.records * sizeof(telem_archive_record_t);
+  uint32_t mapped_kbps = mapped_us > 0 ? (uint32_t)(mapped_bytes * 1000000ULL / ((uint64_t)mapped_us * 1024)) : 0;
+  uint32_t file_kbps = file_us > 0 ? (uint32_t)(replayed_bytes * 1000000ULL / ((uint64_t)file_us * 1024)) : 0;
+  telemetry_logf("📼 Replay: mapped %lu records in %lu us (%lu KB/s) | file API %lu records in %lu us (%lu KB/s)",
+                 mapped.records, mapped_us, mapped_kbps, file.records, file_us, file_kbps);
+}
@@ -0,0 +1,41 @@
+/**
+ * @file telemetry_arena.cpp
+ * @brief Implementación de la arena de pasada (bump allocator)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include "../include/telemetry_arena.h"
+
+/** @brief Memoria de la arena, alineada para cualquier tipo básico */
+static uint8_t arena_memory[TELEM_ARENA_SIZE] __attribute__((aligned(8)));
+
+static size_t arena_offset = 0;         /**< Primer byte libre */
+static size_t arena_high_water = 0;     /**< Máximo uso registrado */
+static uint32_t arena_failures = 0;     /**< Reservas fallidas */
+
+void* telemetry_arena_alloc(size_t size) {
+  size_t aligned = (size + TELEM_ARENA_ALIGN - 1) & ~(size_t)(TELEM_ARENA_ALIGN - 1);
+
+  if(aligned > TELEM_ARENA_SIZE - arena_offset) {
+    arena_failures++;
+    return NULL;
+  }
+
+  void* block = &arena_memory[arena_offset];
+  arena_offset += aligned;
+  if(arena_offset > arena_high_water) {
+    arena_high_water = arena_offset;
+  }
+  return block;
+}
+
+void telemetry_arena_reset(void) {
+  arena_offset = 0;
+}
+
+void telemetry_arena_get_stats(uint32_t* used, uint32_t* high_water, uint32_t* failures) {
+  *used = (uint32_t)arena_offset;
+  *high_water = (uint32_t)arena_high_water;
+  *failures = arena_failures;
+}
@@ -0,0 +1,320 @@
+/**
+ * @file telemetry_auth.cpp
+ * @brief Implementación del sellado AES-GCM de tramas de bajada
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Nonce de 12 bytes: | arranque (4) | trama del arranque (4) | TELEM_AUTH_NONCE_SALT (4) |
+ *
+ * El número de arranque se guarda en memoria RTC, que sobrevive a deep sleep
+ * y a los reinicios en caliente, y su límite se reserva en NVS antes de
+ * usarlo: un arranque en frío, o una memoria RTC corrupta, continúa desde el
+ * límite, así que ningún (arranque, trama) se repite aunque se pierda la
+ * alimentación a mitad de una pasada. El contador de tramas no depende del
+ * número de secuencia del encabezado, que es de 16 bits y da la vuelta.
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "mbedtls/gcm.h"
+#include "../include/telemetry_auth.h"
+#include "../include/telemetry_logger.h"
+#include "../include/telemetry_retention.h"
+
+#define AUTH_NONCE_SIZE 12
+
+/** @brief Espacio y clave de NVS con el primer arranque no reservado */
+#define AUTH_NVS_NAMESPACE "telem_auth"
+#define AUTH_NVS_BOOT_LIMIT "boot_limit"
+
+/**
+ * @brief Último arranque usado, conservado en memoria RTC
+ */
+typedef struct {
+  uint32_t magic;   /**< TELEM_RETENTION_MAGIC si el bloque es válido */
+  uint32_t boot;    /**< Arranque en curso */
+  uint32_t crc;     /**< CRC de los campos anteriores */
+} auth_retained_t;
+
+static RTC_NOINIT_ATTR auth_retained_t retained;
+
+static mbedtls_gcm_context auth_gcm;
+static bool auth_ready = false;
+static uint32_t auth_boot = 0;
+static uint32_t auth_counter = 0;
+static uint32_t auth_failures = 0;
+static portMUX_TYPE auth_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Compone el nonce de una trama
+ */
+static void auth_nonce(uint32_t boot, uint32_t counter, uint8_t* nonce) {
+  uint32_t salt = TELEM_AUTH_NONCE_SALT;
+  memcpy(nonce, &boot, 4);
+  memcpy(nonce + 4, &counter, 4);
+  memcpy(nonce + 8, &salt, 4);
+}
+
+/**
+ * @brief Reserva el número de este arranque
+ *
+ * @return true Si el arranque está por debajo del límite guardado en NVS
+ */
+static bool auth_reserve_boot(uint32_t* boot) {
+  Preferences prefs;
+  if(!prefs.begin(AUTH_NVS_NAMESPACE, false)) {
+    return false;
+  }
+  uint32_t limit = prefs.getUInt(AUTH_NVS_BOOT_LIMIT, 0);
+
+  // Los arranques desde el último guardado en RTC hasta el límite no se han usado
+  bool rtc_valid = telemetry_retention_rtc_preserved() &&
+                   retained.magic == TELEM_RETENTION_MAGIC &&
+                   retained.crc == telemetry_retention_crc(&retained, offsetof(auth_retained_t, crc)) &&
+                   retained.boot != UINT32_MAX;
+  uint32_t next = rtc_valid ? retained.boot + 1 : limit;
+
+  bool reserved = next != UINT32_MAX;
+  if(reserved && next >= limit) {
+    uint32_t new_limit = next < UINT32_MAX - TELEM_AUTH_BOOT_RESERVE ? next + TELEM_AUTH_BOOT_RESERVE : UINT32_MAX;
+    reserved = prefs.putUInt(AUTH_NVS_BOOT_LIMIT, new_limit) == sizeof(uint32_t);
+  }
+  prefs.end();
+
+  if(reserved) {
+    retained.magic = TELEM_RETENTION_MAGIC;
+    retained.boot = next;
+    retained.crc = telemetry_retention_crc(&retained, offsetof(auth_retained_t, crc));
+    *boot = next;
+  }
+  return reserved;
+}
+
+/**
+ * @brief Consume el siguiente nonce del arranque
+ *
+ * @return false Si no hay clave o el contador del arranque se agotó
+ */
+static bool auth_next_nonce(uint32_t* counter) {
+  bool available;
+  portENTER_CRITICAL(&auth_mux);
+  available = auth_ready && auth_counter != UINT32_MAX;
+  if(available) {
+    *counter = auth_counter++;
+  }
+  portEXIT_CRITICAL(&auth_mux);
+  return available;
+}
+
+/**
+ * @brief Contabiliza una trama que no se pudo sellar
+ */
+static void auth_count_failure(void) {
+  portENTER_CRITICAL(&auth_mux);
+  auth_failures++;
+  portEXIT_CRITICAL(&auth_mux);
+}
+
+bool telemetry_auth_init(void) {
+  if(auth_ready) {
+    return true;
+  }
+
+#ifndef TELEM_AUTH_KEY
+  telemetry_logf("❌ Auth: no key configured (TELEM_AUTH_KEY)");
+  return false;
+#else
+  static const uint8_t key[16] = TELEM_AUTH_KEY;
+  uint32_t boot;
+  if(!auth_reserve_boot(&boot)) {
+    telemetry_logf("❌ Auth: boot counter could not be reserved in NVS");
+    return false;
+  }
+
+  mbedtls_gcm_init(&auth_gcm);
+  if(mbedtls_gcm_setkey(&auth_gcm, MBEDTLS_CIPHER_ID_AES, key, 128) != 0) {
+    mbedtls_gcm_free(&auth_gcm);
+    return false;
+  }
+
+  portENTER_CRITICAL(&auth_mux);
+  auth_boot = boot;
+  auth_counter = 0;
+  auth_ready = true;
+  portEXIT_CRITICAL(&auth_mux);
+  return true;
+#endif
+}
+
+bool telemetry_auth_ready(void) {
+  return auth_ready && auth_counter != UINT32_MAX;
+}
+
+void telemetry_auth_get_stats(telemetry_auth_stats_t* stats) {
+  portENTER_CRITICAL(&auth_mux);
+  stats->boot = auth_boot;
+  stats->sealed = auth_counter;
+  stats->failures = auth_failures;
+  portEXIT_CRITICAL(&auth_mux);
+}
+
+bool telemetry_frame_seal(telemetry_frame_t* frame) {
+  telem_frame_header_t* header = telemetry_frame_header(frame);
+  uint8_t nonce[AUTH_NONCE_SIZE];
+  telem_auth_prefix_t prefix;
+  uint32_t counter;
+
+#ifdef TELEM_DOWNLINK_AUTH
+  // Recuperar la reserva que hizo telemetry_frame_begin()
+  if(!(header->flags & TELEM_FRAME_FLAG_AUTH)) {
+    frame->capacity += TELEM_AUTH_OVERHEAD;
+  }
+#endif
+  if((header->flags & TELEM_FRAME_FLAG_AUTH) ||
+     frame->length + TELEM_AUTH_OVERHEAD > frame->capacity ||
+     !auth_next_nonce(&counter)) {
+    auth_count_failure();
+    return false;
+  }
+  prefix.boot = auth_boot;
+  prefix.counter = counter;
+
+  uint8_t* payload = frame->data + sizeof(telem_frame_header_t);
+  size_t length = frame->length - sizeof(telem_frame_header_t);
+  memmove(payload + sizeof(prefix), payload, length);
+  memcpy(payload, &prefix, sizeof(prefix));
+
+  // El encabezado final es el dato adicional autenticado
+  header->flags |= TELEM_FRAME_FLAG_AUTH;
+  header->payload_length = (uint16_t)(length + TELEM_AUTH_OVERHEAD);
+  frame->length += TELEM_AUTH_OVERHEAD;
+
+  uint8_t* cipher = payload + sizeof(prefix);
+  auth_nonce(prefix.boot, prefix.counter, nonce);
+  int ret = mbedtls_gcm_crypt_and_tag(&auth_gcm, MBEDTLS_GCM_ENCRYPT, length,
+                                      nonce, sizeof(nonce),
+                                      frame->data, sizeof(telem_frame_header_t),
+                                      cipher, cipher, TELEM_AUTH_TAG_SIZE, cipher + length);
+  if(ret != 0) {
+    // La carga puede estar a medio cifrar: la trama ya no sirve
+    auth_count_failure();
+    return false;
+  }
+  return true;
+}
+
+size_t telemetry_frame_open(uint8_t* data, size_t length) {
+  telem_frame_header_t* header = (telem_frame_header_t*)data;
+  uint8_t nonce[AUTH_NONCE_SIZE];
+  telem_auth_prefix_t prefix;
+
+  if(!auth_ready || length < sizeof(telem_frame_header_t) + TELEM_AUTH_OVERHEAD ||
+     !(header->flags & TELEM_FRAME_FLAG_AUTH) ||
+     header->payload_length != length - sizeof(telem_frame_header_t)) {
+    return 0;
+  }
+
+  uint8_t* payload = data + sizeof(telem_frame_header_t);
+  size_t cipher_length = header->payload_length - TELEM_AUTH_OVERHEAD;
+  memcpy(&prefix, payload, sizeof(prefix));
+
+  uint8_t* cipher = payload + sizeof(prefix);
+  auth_nonce(prefix.boot, prefix.counter, nonce);
+  if(mbedtls_gcm_auth_decrypt(&auth_gcm, cipher_length, nonce, sizeof(nonce),
+                              data, sizeof(telem_frame_header_t),
+                              cipher + cipher_length, TELEM_AUTH_TAG_SIZE,
+                              cipher, cipher) != 0) {
+    return 0;
+  }
+
+  memmove(payload, cipher, cipher_length);
+  header->flags &= ~TELEM_FRAME_FLAG_AUTH;
+  header->payload_length = (uint16_t)cipher_length;
+  return cipher_length;
+}
+
+/**
+ * @brief Sella un bloque en su sitio con el siguiente nonce del arranque
+ */
+static bool auth_seal_block(const uint8_t* aad, uint8_t* data, size_t length, uint8_t* tag) {
+  uint8_t nonce[AUTH_NONCE_SIZE];
+  uint32_t counter;
+  if(!auth_next_nonce(&counter)) {
+    return false;
+  }
+  auth_nonce(auth_boot, counter, nonce);
+  return mbedtls_gcm_crypt_and_tag(&auth_gcm, MBEDTLS_GCM_ENCRYPT, length, nonce, sizeof(nonce),
+                                   aad, sizeof(telem_frame_header_t), data, data,
+                                   TELEM_AUTH_TAG_SIZE, tag) == 0;
+}
+
+void telemetry_auth_benchmark(void) {
+  const int iterations = 20;
+  static uint8_t frame_data[sizeof(telem_frame_header_t) + TELEM_FRAME_MAX_PAYLOAD + TELEM_AUTH_OVERHEAD];
+  static uint8_t original[TELEM_FRAME_MAX_PAYLOAD];
+  uint8_t tag[TELEM_AUTH_TAG_SIZE];
+  const size_t packet_size = sizeof(telemetry_packet_t);
+  const size_t length = TELEM_FRAME_MAX_PAYLOAD - TELEM_FRAME_MAX_PAYLOAD % packet_size;
+
+  if(!telemetry_auth_init()) {
+    telemetry_logf("❌ Auth benchmark: mbedtls GCM key setup failed");
+    return;
+  }
+
+  uint8_t* payload = frame_data + sizeof(telem_frame_header_t);
+  for(size_t i = 0; i < length; i++) {
+    payload[i] = (uint8_t)(i * 31 + 7);
+  }
+  memcpy(original, payload, length);
+
+  // Una llamada GCM por trama
+  bool ok = true;
+  uint32_t start = ESP.getCycleCount();
+  for(int i = 0; i < iterations; i++) {
+    ok = auth_seal_block(frame_data, payload, length, tag) && ok;
+  }
+  uint32_t frame_cycles = ESP.getCycleCount() - start;
+
+  // Una llamada GCM por paquete (misma cantidad de datos)
+  start = ESP.getCycleCount();
+  for(int i = 0; i < iterations; i++) {
+    for(size_t offset = 0; offset < length; offset += packet_size) {
+      ok = auth_seal_block(frame_data, payload + offset, packet_size, tag) && ok;
+    }
+  }
+  uint32_t packet_cycles = ESP.getCycleCount() - start;
+
+  // Ida y vuelta completa con el formato de trama
+  telemetry_frame_t frame;
+  for(int tamper = 0; tamper < 2; tamper++) {
+    memcpy(payload, original, length);
+    telemetry_frame_begin(&frame, frame_data, sizeof(frame_data), (uint16_t)tamper);
+    frame.length = sizeof(telem_frame_header_t) + length;
+    telemetry_frame_header(&frame)->payload_length = (uint16_t)length;
+    ok = ok && telemetry_frame_seal(&frame);
+
+    // La segunda vez se altera un byte: la trama no debe pasar la verificación
+    frame.data[sizeof(telem_frame_header_t) + sizeof(telem_auth_prefix_t)] ^= (uint8_t)tamper;
+    size_t opened = telemetry_frame_open(frame.data, frame.length);
+    ok = ok && (tamper ? opened == 0 : opened == length && memcmp(payload, original, length) == 0);
+  }
+
+  size_t total = length * iterations;
+#if defined(CONFIG_MBEDTLS_HARDWARE_AES)
+  const char* engine = "HW AES";
+#else
+  const char* engine = "SW AES";
+#endif
+  telemetry_logf("🔐 Auth (%s, GCM-128): frame %lu.%02lu cyc/B | per-packet %lu.%02lu cyc/B | %u B/frame | %s",
+                 engine,
+                 (unsigned long)(frame_cycles / total), (unsigned long)((uint64_t)frame_cycles * 100 / total % 100),
+                 (unsigned long)(packet_cycles / total), (unsigned long)((uint64_t)packet_cycles * 100 / total % 100),
+                 (unsigned)length, ok ? "OK" : "FAIL");
+}
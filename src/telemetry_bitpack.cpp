@@ -0,0 +1,318 @@
+/**
+ * @file telemetry_bitpack.cpp
+ * @brief Implementación del empaquetado de bits generado desde las tablas de rangos
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Cada tabla X-macro de telemetry_types.h se expande tres veces: en la
+ * función de empaquetado, en la de desempaquetado y en la suma constante de
+ * bits del tipo. El ancho de cada campo es un parámetro de plantilla, por lo
+ * que desplazamientos y máscaras son constantes en el código generado.
+ */
+
+#include <string.h>
+#include "esp_timer.h"
+#include "../include/telemetry_bitpack.h"
+#include "../include/telemetry_housekeeping.h"
+#include "../include/telemetry_logger.h"
+
+/** @brief Bits necesarios para representar valores en [0, range] */
+static constexpr unsigned bitpack_width(uint64_t range) {
+  return range == 0 ? 0 : 1 + bitpack_width(range >> 1);
+}
+
+#define BITPACK_WIDTH(lo, hi) bitpack_width((uint64_t)((int64_t)(hi) - (int64_t)(lo)))
+
+static uint32_t clamped_values = 0;
+
+/** @brief Escritor de bits sobre un buffer de salida */
+typedef struct {
+  uint8_t* out;
+  size_t length;       /**< Bytes completos escritos */
+  uint64_t acc;        /**< Bits pendientes (los menos significativos primero) */
+  unsigned fill;       /**< Bits válidos en acc (< 32 entre llamadas) */
+} bitpack_writer_t;
+
+/** @brief Lector de bits sobre un buffer de entrada */
+typedef struct {
+  const uint8_t* in;
+  size_t length;       /**< Bytes disponibles */
+  size_t position;     /**< Siguiente byte a cargar */
+  uint64_t acc;        /**< Bits cargados y aún no consumidos */
+  unsigned avail;      /**< Bits válidos en acc */
+  bool underflow;      /**< Se pidieron más bits de los disponibles */
+} bitpack_reader_t;
+
+template<unsigned BITS>
+static inline void bitpack_put(bitpack_writer_t* w, uint32_t value) {
+  static_assert(BITS <= 32, "Un campo no puede ocupar más de 32 bits");
+  if(BITS == 0) {
+    return;
+  }
+  w->acc |= (uint64_t)value << w->fill;
+  w->fill += BITS;
+  if(w->fill >= 32) {
+    uint32_t word = (uint32_t)w->acc;
+    memcpy(w->out + w->length, &word, sizeof(word));   // ESP32 little-endian
+    w->length += sizeof(word);
+    w->acc >>= 32;
+    w->fill -= 32;
+  }
+}
+
+template<unsigned BITS>
+static inline void bitpack_put_range(bitpack_writer_t* w, int64_t value, int64_t lo, int64_t hi) {
+  if(value < lo || value > hi) {
+    clamped_values++;
+    value = value < lo ? lo : hi;
+  }
+  bitpack_put<BITS>(w, (uint32_t)(value - lo));
+}
+
+static inline void bitpack_put_float(bitpack_writer_t* w, float value) {
+  uint32_t raw;
+  memcpy(&raw, &value, sizeof(raw));
+  bitpack_put<32>(w, raw);
+}
+
+static inline size_t bitpack_finish(bitpack_writer_t* w) {
+  while(w->fill > 0) {
+    w->out[w->length++] = (uint8_t)w->acc;
+    w->acc >>= 8;
+    w->fill = w->fill > 8 ? w->fill - 8 : 0;
+  }
+  return w->length;
+}
+
+template<unsigned BITS>
+static inline uint32_t bitpack_get(bitpack_reader_t* r) {
+  static_assert(BITS <= 32, "Un campo no puede ocupar más de 32 bits");
+  if(BITS == 0) {
+    return 0;
+  }
+  if(r->avail < BITS) {
+    uint32_t word = 0;
+    size_t take = r->length - r->position < sizeof(word) ? r->length - r->position : sizeof(word);
+    memcpy(&word, r->in + r->position, take);
+    r->position += take;
+    r->acc |= (uint64_t)word << r->avail;
+    r->avail += (unsigned)take * 8;
+    if(r->avail < BITS) {
+      r->underflow = true;
+      return 0;
+    }
+  }
+  uint32_t value = (uint32_t)(r->acc & ((1ULL << BITS) - 1));
+  r->acc >>= BITS;
+  r->avail -= BITS;
+  return value;
+}
+
+static inline float bitpack_get_float(bitpack_reader_t* r) {
+  uint32_t raw = bitpack_get<32>(r);
+  float value;
+  memcpy(&value, &raw, sizeof(value));
+  return value;
+}
+
+/** @brief Bytes de entrada realmente consumidos (los bits precargados no usados se devuelven) */
+static inline size_t bitpack_consumed(const bitpack_reader_t* r) {
+  return r->position - r->avail / 8;
+}
+
+// Expansiones de las tablas de rangos
+#define BITPACK_PUT(member, lo, hi) \
+  bitpack_put_range<BITPACK_WIDTH(lo, hi)>(w, (int64_t)p->member, (int64_t)(lo), (int64_t)(hi));
+#define BITPACK_PUT_FLOAT(member) \
+  bitpack_put_float(w, p->member);
+#define BITPACK_GET(member, lo, hi) \
+  p->member = (decltype(p->member))((int64_t)(lo) + (int64_t)bitpack_get<BITPACK_WIDTH(lo, hi)>(r));
+#define BITPACK_GET_FLOAT(member) \
+  p->member = bitpack_get_float(r);
+#define BITPACK_BITS(member, lo, hi) + BITPACK_WIDTH(lo, hi)
+#define BITPACK_BITS_FLOAT(member) + 32
+
+/** @brief Genera empaquetador, desempaquetador y tamaño en bits de una estructura */
+#define BITPACK_CODEC(name, type, FIELDS) \
+  static inline void pack_##name(bitpack_writer_t* w, const type* p) { FIELDS(BITPACK_PUT, BITPACK_PUT_FLOAT) } \
+  static inline void unpack_##name(bitpack_reader_t* r, type* p) { FIELDS(BITPACK_GET, BITPACK_GET_FLOAT) } \
+  static constexpr unsigned name##_bits = 0 FIELDS(BITPACK_BITS, BITPACK_BITS_FLOAT);
+
+BITPACK_CODEC(header, telem_header_t, TELEM_HEADER_FIELDS)
+BITPACK_CODEC(system, system_status_telem_t, TELEM_SYSTEM_STATUS_FIELDS)
+BITPACK_CODEC(power, power_telem_t, TELEM_POWER_FIELDS)
+BITPACK_CODEC(temperature, temperature_telem_t, TELEM_TEMPERATURE_FIELDS)
+BITPACK_CODEC(subsystem, subsystem_status_telem_t, TELEM_SUBSYSTEM_FIELDS)
+
+/** @brief Bits del mapa de presencia de un registro de housekeeping (uno por tipo simple) */
+#define BITPACK_PRESENCE_BITS TELEM_HOUSEKEEPING
+
+static_assert((header_bits + BITPACK_PRESENCE_BITS + system_bits + power_bits +
+               temperature_bits + subsystem_bits + 7) / 8 <= sizeof(telemetry_packet_t),
+              "Un paquete empaquetado no puede ser mayor que telemetry_packet_t");
+
+/** @brief Bytes en bruto de la carga útil de un tipo propio */
+#define BITPACK_RAW_BYTES (sizeof(telemetry_packet_t) - sizeof(telem_header_t))
+
+static_assert((header_bits + 8 * BITPACK_RAW_BYTES + 7) / 8 <= sizeof(telemetry_packet_t),
+              "Un paquete propio empaquetado no puede ser mayor que telemetry_packet_t");
+
+/** @brief Tipo propio sin tabla de rangos, cuya carga viaja en bruto */
+static inline bool bitpack_is_raw(int type) {
+  return type >= TELEM_TYPE_COUNT && type <= TELEM_TYPE_MAX;
+}
+
+/**
+ * @brief Bits de la carga útil de un tipo simple o propio
+ */
+static unsigned bitpack_payload_bits(int type) {
+  switch(type) {
+    case TELEM_SYSTEM_STATUS:        return system_bits;
+    case TELEM_POWER_DATA:           return power_bits;
+    case TELEM_TEMPERATURE_DATA:     return temperature_bits;
+    case TELEM_COMMUNICATION_STATUS: return subsystem_bits;
+    default:                         return bitpack_is_raw(type) ? 8 * BITPACK_RAW_BYTES : 0;
+  }
+}
+
+/**
+ * @brief Empaqueta la carga útil de un paquete simple o propio
+ */
+static void bitpack_put_payload(bitpack_writer_t* w, const telemetry_packet_t* packet) {
+  switch(packet->header.type) {
+    case TELEM_SYSTEM_STATUS:        pack_system(w, &packet->system); break;
+    case TELEM_POWER_DATA:           pack_power(w, &packet->power); break;
+    case TELEM_TEMPERATURE_DATA:     pack_temperature(w, &packet->temperature); break;
+    case TELEM_COMMUNICATION_STATUS: pack_subsystem(w, &packet->subsystems); break;
+    default: {
+      const uint8_t* raw = (const uint8_t*)packet + sizeof(telem_header_t);
+      for(size_t i = 0; bitpack_is_raw(packet->header.type) && i < BITPACK_RAW_BYTES; i++) {
+        bitpack_put<8>(w, raw[i]);
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Desempaqueta la carga útil de un paquete simple o propio cuyo tipo ya está en el encabezado
+ */
+static void bitpack_get_payload(bitpack_reader_t* r, telemetry_packet_t* packet) {
+  switch(packet->header.type) {
+    case TELEM_SYSTEM_STATUS:        unpack_system(r, &packet->system); break;
+    case TELEM_POWER_DATA:           unpack_power(r, &packet->power); break;
+    case TELEM_TEMPERATURE_DATA:     unpack_temperature(r, &packet->temperature); break;
+    case TELEM_COMMUNICATION_STATUS: unpack_subsystem(r, &packet->subsystems); break;
+    default: {
+      uint8_t* raw = (uint8_t*)packet + sizeof(telem_header_t);
+      for(size_t i = 0; bitpack_is_raw(packet->header.type) && i < BITPACK_RAW_BYTES; i++) {
+        raw[i] = (uint8_t)bitpack_get<8>(r);
+      }
+      break;
+    }
+  }
+}
+
+size_t telemetry_bitpack_size(const telemetry_packet_t* packet) {
+  unsigned bits = header_bits;
+
+  if(packet->header.type == TELEM_HOUSEKEEPING) {
+    bits += BITPACK_PRESENCE_BITS;
+    for(int type = TELEM_SYSTEM_STATUS; type < TELEM_HOUSEKEEPING; type++) {
+      if(packet->housekeeping.presence & (1u << type)) {
+        bits += bitpack_payload_bits(type);
+      }
+    }
+  } else if((bits += bitpack_payload_bits(packet->header.type)) == header_bits) {
+    return 0;
+  }
+  return (bits + 7) / 8;
+}
+
+size_t telemetry_bitpack_encode(const telemetry_packet_t* packet, uint8_t* out, size_t capacity) {
+  size_t size = telemetry_bitpack_size(packet);
+  if(size == 0 || size > capacity) {
+    return 0;
+  }
+
+  bitpack_writer_t writer = { out, 0, 0, 0 };
+  pack_header(&writer, &packet->header);
+
+  if(packet->header.type == TELEM_HOUSEKEEPING) {
+    telemetry_packet_t part;
+    bitpack_put<BITPACK_PRESENCE_BITS>(&writer, packet->housekeeping.presence);
+    for(int type = TELEM_SYSTEM_STATUS; type < TELEM_HOUSEKEEPING; type++) {
+      if(telemetry_hk_extract(&packet->housekeeping, (telem_data_type_t)type, &part)) {
+        bitpack_put_payload(&writer, &part);
+      }
+    }
+  } else {
+    bitpack_put_payload(&writer, packet);
+  }
+
+  return bitpack_finish(&writer);
+}
+
+size_t telemetry_bitpack_decode(const uint8_t* in, size_t length, telemetry_packet_t* packet) {
+  bitpack_reader_t reader = { in, length, 0, 0, 0, false };
+
+  memset(packet, 0, sizeof(*packet));
+  unpack_header(&reader, &packet->header);
+
+  if(packet->header.type == TELEM_HOUSEKEEPING) {
+    telemetry_packet_t part;
+    uint8_t presence = (uint8_t)bitpack_get<BITPACK_PRESENCE_BITS>(&reader);
+
+    telemetry_hk_begin(&packet->housekeeping);
+    for(int type = TELEM_SYSTEM_STATUS; type < TELEM_HOUSEKEEPING; type++) {
+      if(presence & (1u << type)) {
+        memset(&part, 0, sizeof(part));
+        part.header = packet->header;
+        part.header.type = (telem_data_type_t)type;
+        bitpack_get_payload(&reader, &part);
+        telemetry_hk_add(&packet->housekeeping, &part);
+      }
+    }
+  } else {
+    bitpack_get_payload(&reader, packet);
+  }
+
+  return reader.underflow ? 0 : bitpack_consumed(&reader);
+}
+
+uint32_t telemetry_bitpack_clamped(void) {
+  return clamped_values;
+}
+
+void telemetry_bitpack_benchmark(void) {
+  const int iterations = 1000;
+  telemetry_packet_t packet;
+  telemetry_packet_t decoded;
+  uint8_t buffer[sizeof(telemetry_packet_t)];
+
+  for(int type = TELEM_SYSTEM_STATUS; type < TELEM_HOUSEKEEPING; type++) {
+    memset(&packet, 0, sizeof(packet));
+    packet.header.type = (telem_data_type_t)type;
+    packet.header.timestamp = 123456;
+    packet.header.sequence = 42;
+    packet.header.priority = 1;
+
+    size_t size = 0;
+    int64_t start = esp_timer_get_time();
+    for(int i = 0; i < iterations; i++) {
+      size = telemetry_bitpack_encode(&packet, buffer, sizeof(buffer));
+    }
+    uint32_t encode_us = (uint32_t)(esp_timer_get_time() - start);
+
+    start = esp_timer_get_time();
+    for(int i = 0; i < iterations; i++) {
+      telemetry_bitpack_decode(buffer, size, &decoded);
+    }
+    uint32_t decode_us = (uint32_t)(esp_timer_get_time() - start);
+
+    telemetry_logf("🧮 Bitpack type %d: %u -> %u bytes | encode %lu ns | decode %lu ns",
+                   type, (unsigned)(sizeof(telem_header_t) + telemetry_payload_size((telem_data_type_t)type)),
+                   (unsigned)size, encode_us * 1000 / iterations, decode_us * 1000 / iterations);
+  }
+}
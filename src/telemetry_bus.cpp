@@ -0,0 +1,354 @@
+/**
+ * @file telemetry_bus.cpp
+ * @brief Implementación del gestor asíncrono de buses
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Cada tarea de bus usa su notificación de tarea solo para la finalización
+ * de la transferencia en curso, de modo que no interfiere con las
+ * notificaciones que envía a los solicitantes. La finalización aceptada se
+ * publica como `id << 1 | ok` en una sola palabra: la tarea solo la da por
+ * buena si el identificador es el de la transferencia que espera.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "../include/telemetry_bus.h"
+#include "../include/telemetry_logger.h"
+
+/** @brief Estado de un bus */
+typedef struct {
+  QueueHandle_t queue;                    /**< Cola de telemetry_bus_txn_t* */
+  TaskHandle_t task;                      /**< Tarea propietaria */
+  telemetry_bus_driver_t driver;          /**< Controlador actual */
+  volatile uint32_t active_id;            /**< Transferencia en curso (0 = ninguna) */
+  volatile uint32_t completion;           /**< Última finalización aceptada: id << 1 | ok */
+  uint32_t next_id;                       /**< Último identificador asignado */
+  esp_timer_handle_t mock_timer;          /**< Finalización del controlador simulado */
+  volatile uint32_t mock_id;              /**< Transferencia que completará el temporizador simulado */
+  volatile int64_t mock_due_us;           /**< Vencimiento de esa transferencia */
+  telemetry_bus_stats_t stats;
+} bus_state_t;
+
+/** @brief Dispositivo del controlador simulado */
+typedef struct {
+  uint8_t bus;
+  uint8_t device;
+  uint32_t latency_us;
+  uint16_t value;
+} bus_mock_device_t;
+
+#define BUS_MOCK_ENTRY(bus, address, latency, value) { bus, address, latency, value },
+static const bus_mock_device_t mock_devices[] = { TELEM_BUS_MOCK_DEVICES(BUS_MOCK_ENTRY) };
+#undef BUS_MOCK_ENTRY
+#define BUS_MOCK_DEVICE_COUNT (sizeof(mock_devices) / sizeof(mock_devices[0]))
+
+static bus_state_t buses[TELEM_BUS_COUNT];
+static bool bus_ready = false;
+static portMUX_TYPE bus_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Fin de transferencia simulado (hace las veces de la ISR del controlador)
+ *
+ * @details Un disparo que ya estaba en marcha cuando se rearmó el temporizador
+ * llega antes del vencimiento de la transferencia nueva y se ignora.
+ */
+static void bus_mock_done(void* arg) {
+  bus_state_t* state = &buses[(uintptr_t)arg];
+  if(esp_timer_get_time() >= state->mock_due_us) {
+    telemetry_bus_complete((telem_bus_id_t)(uintptr_t)arg, state->mock_id, true);
+  }
+}
+
+/**
+ * @brief Controlador simulado: arranca un temporizador con la latencia del dispositivo
+ */
+static bool bus_mock_driver(telemetry_bus_txn_t* txn) {
+  bus_state_t* state = &buses[txn->bus];
+  for(size_t i = 0; i < BUS_MOCK_DEVICE_COUNT; i++) {
+    if(mock_devices[i].bus == txn->bus && mock_devices[i].device == txn->device) {
+      if(!txn->write) {
+        for(uint16_t b = 0; b < txn->length; b++) {
+          txn->data[b] = (uint8_t)(b % 2 == 0 ? mock_devices[i].value >> 8 : mock_devices[i].value);
+        }
+      }
+      esp_timer_stop(state->mock_timer);
+      state->mock_due_us = INT64_MAX;
+      state->mock_id = txn->id;
+      state->mock_due_us = esp_timer_get_time() + mock_devices[i].latency_us;
+      return esp_timer_start_once(state->mock_timer, mock_devices[i].latency_us) == ESP_OK;
+    }
+  }
+  return false; // Dispositivo inexistente: sin ACK
+}
+
+/**
+ * @brief Asigna el identificador de la siguiente transferencia (31 bits, nunca 0)
+ */
+static uint32_t bus_next_id(bus_state_t* state) {
+  state->next_id = (state->next_id + 1) & 0x7FFFFFFF;
+  if(state->next_id == 0) {
+    state->next_id = 1;
+  }
+  return state->next_id;
+}
+
+/**
+ * @brief Espera la finalización de la transferencia en curso
+ *
+ * @return true Si llegó la finalización con su identificador antes del timeout
+ */
+static bool bus_wait_completion(bus_state_t* state, uint32_t id, bool* ok) {
+  TickType_t start = xTaskGetTickCount();
+  TickType_t timeout = pdMS_TO_TICKS(TELEM_BUS_TIMEOUT_MS);
+
+  for(;;) {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if(elapsed >= timeout || ulTaskNotifyTake(pdTRUE, timeout - elapsed) == 0) {
+      return false;
+    }
+    uint32_t completion = state->completion;
+    if(completion >> 1 == id) {
+      *ok = (completion & 1) != 0;
+      return true;
+    }
+  }
+}
+
+/**
+ * @brief Ejecuta una transacción y avisa a quien la pidió
+ */
+static void bus_execute(bus_state_t* state, telemetry_bus_txn_t* txn) {
+  int64_t start = esp_timer_get_time();
+  bool ok = false;
+
+  txn->id = bus_next_id(state);
+  portENTER_CRITICAL(&bus_stats_mux);
+  state->active_id = txn->id;
+  portEXIT_CRITICAL(&bus_stats_mux);
+
+  ulTaskNotifyTake(pdTRUE, 0); // Descartar avisos sobrantes de transferencias anteriores
+  if(state->driver(txn) && bus_wait_completion(state, txn->id, &ok)) {
+    txn->status = ok ? TELEM_BUS_OK : TELEM_BUS_ERROR;
+  } else {
+    txn->status = TELEM_BUS_TIMEOUT;
+  }
+
+  // A partir de aquí una finalización de esta transferencia es tardía
+  portENTER_CRITICAL(&bus_stats_mux);
+  state->active_id = 0;
+  portEXIT_CRITICAL(&bus_stats_mux);
+  txn->completed_us = esp_timer_get_time();
+
+  portENTER_CRITICAL(&bus_stats_mux);
+  state->stats.transactions++;
+  state->stats.busy_us += (uint64_t)(txn->completed_us - start);
+  if(txn->status != TELEM_BUS_OK) {
+    state->stats.errors++;
+  }
+  portEXIT_CRITICAL(&bus_stats_mux);
+
+  if(txn->callback != NULL) {
+    txn->callback(txn);
+  }
+  if(txn->notify != NULL) {
+    xTaskNotifyGive(txn->notify);
+  }
+}
+
+/**
+ * @brief Tarea propietaria de un bus: vacía la cola y ejecuta las transacciones seguidas
+ */
+static void bus_task(void* pvParameters) {
+  bus_state_t* state = (bus_state_t*)pvParameters;
+  telemetry_bus_txn_t* txn;
+
+  for(;;) {
+    if(xQueueReceive(state->queue, &txn, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+
+    uint32_t batch = 0;
+    do {
+      bus_execute(state, txn);
+      batch++;
+    } while(xQueueReceive(state->queue, &txn, 0) == pdTRUE);
+
+    portENTER_CRITICAL(&bus_stats_mux);
+    state->stats.batches++;
+    if(batch > state->stats.max_batch) {
+      state->stats.max_batch = batch;
+    }
+    portEXIT_CRITICAL(&bus_stats_mux);
+  }
+}
+
+bool telemetry_bus_init(void) {
+  static const char* const names[TELEM_BUS_COUNT] = { "TelemI2C0", "TelemSPI2" };
+
+  if(bus_ready) {
+    return true;
+  }
+
+  for(int bus = 0; bus < TELEM_BUS_COUNT; bus++) {
+    bus_state_t* state = &buses[bus];
+    memset(&state->stats, 0, sizeof(state->stats));
+    state->driver = bus_mock_driver;
+
+    esp_timer_create_args_t timer_args;
+    memset(&timer_args, 0, sizeof(timer_args));
+    timer_args.callback = bus_mock_done;
+    timer_args.arg = (void*)(uintptr_t)bus;
+    timer_args.name = names[bus];
+
+    state->queue = xQueueCreate(TELEM_BUS_QUEUE_LENGTH, sizeof(telemetry_bus_txn_t*));
+    if(state->queue == NULL || esp_timer_create(&timer_args, &state->mock_timer) != ESP_OK ||
+       xTaskCreate(bus_task, names[bus], 2048, state, TELEM_BUS_TASK_PRIORITY, &state->task) != pdPASS) {
+      return false;
+    }
+  }
+
+  bus_ready = true;
+  return true;
+}
+
+void telemetry_bus_set_driver(telem_bus_id_t bus, telemetry_bus_driver_t driver) {
+  if(bus < TELEM_BUS_COUNT) {
+    buses[bus].driver = driver != NULL ? driver : bus_mock_driver;
+  }
+}
+
+bool telemetry_bus_submit(telemetry_bus_txn_t* txn) {
+  if(!bus_ready || txn->bus >= TELEM_BUS_COUNT) {
+    return false;
+  }
+
+  txn->status = TELEM_BUS_PENDING;
+  txn->queued_us = esp_timer_get_time();
+  if(xQueueSend(buses[txn->bus].queue, &txn, 0) != pdTRUE) {
+    portENTER_CRITICAL(&bus_stats_mux);
+    buses[txn->bus].stats.queue_full++;
+    portEXIT_CRITICAL(&bus_stats_mux);
+    return false;
+  }
+  return true;
+}
+
+uint32_t telemetry_bus_wait(uint32_t count, uint32_t timeout_ms) {
+  TickType_t start = xTaskGetTickCount();
+  TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+  uint32_t done = 0;
+
+  while(done < count) {
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    if(elapsed >= timeout) {
+      break;
+    }
+    uint32_t taken = ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+    if(taken == 0) {
+      break;
+    }
+    done += taken;
+  }
+  return done;
+}
+
+void telemetry_bus_complete(telem_bus_id_t bus, uint32_t id, bool ok) {
+  bus_state_t* state = &buses[bus];
+  bool in_isr = xPortInIsrContext();
+  bool current;
+
+  if(in_isr) {
+    portENTER_CRITICAL_ISR(&bus_stats_mux);
+  } else {
+    portENTER_CRITICAL(&bus_stats_mux);
+  }
+  current = id != 0 && id == state->active_id;
+  if(current) {
+    state->completion = (id << 1) | (ok ? 1 : 0);
+  } else {
+    state->stats.stale++;
+  }
+  if(in_isr) {
+    portEXIT_CRITICAL_ISR(&bus_stats_mux);
+  } else {
+    portEXIT_CRITICAL(&bus_stats_mux);
+  }
+
+  if(!current) {
+    return;
+  }
+  if(in_isr) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(state->task, &woken);
+    portYIELD_FROM_ISR(woken);
+  } else {
+    xTaskNotifyGive(state->task);
+  }
+}
+
+void telemetry_bus_get_stats(telem_bus_id_t bus, telemetry_bus_stats_t* stats) {
+  portENTER_CRITICAL(&bus_stats_mux);
+  *stats = buses[bus].stats;
+  portEXIT_CRITICAL(&bus_stats_mux);
+}
+
+bool telemetry_bus_benchmark(telemetry_bus_benchmark_t* result) {
+  const int cycles = 20;
+  static telemetry_bus_txn_t txns[BUS_MOCK_DEVICE_COUNT];
+  static uint8_t data[BUS_MOCK_DEVICE_COUNT][6];
+  uint32_t device_sum_us = 0;
+
+  if(!telemetry_bus_init()) {
+    telemetry_logf("❌ Bus benchmark: bus tasks could not be created");
+    return false;
+  }
+
+  for(size_t i = 0; i < BUS_MOCK_DEVICE_COUNT; i++) {
+    memset(&txns[i], 0, sizeof(txns[i]));
+    txns[i].bus = mock_devices[i].bus;
+    txns[i].device = mock_devices[i].device;
+    txns[i].data = data[i];
+    txns[i].length = sizeof(data[i]);
+    txns[i].notify = xTaskGetCurrentTaskHandle();
+    device_sum_us += mock_devices[i].latency_us;
+  }
+
+  // Lecturas bloqueantes: cada una espera a la anterior, como dentro de generate_*
+  bool ok = true;
+  int64_t start = esp_timer_get_time();
+  for(int cycle = 0; cycle < cycles; cycle++) {
+    for(size_t i = 0; i < BUS_MOCK_DEVICE_COUNT; i++) {
+      ok = telemetry_bus_submit(&txns[i]) && telemetry_bus_wait(1, 100) == 1 &&
+           txns[i].status == TELEM_BUS_OK && ok;
+    }
+  }
+  uint32_t blocking_us = (uint32_t)((esp_timer_get_time() - start) / cycles);
+
+  // Todas en cola a la vez: los buses trabajan en paralelo y cada uno en lote
+  start = esp_timer_get_time();
+  for(int cycle = 0; cycle < cycles; cycle++) {
+    uint32_t submitted = 0;
+    for(size_t i = 0; i < BUS_MOCK_DEVICE_COUNT; i++) {
+      submitted += telemetry_bus_submit(&txns[i]) ? 1 : 0;
+    }
+    ok = telemetry_bus_wait(submitted, 100) == BUS_MOCK_DEVICE_COUNT && ok;
+  }
+  uint32_t queued_us = (uint32_t)((esp_timer_get_time() - start) / cycles);
+
+  telemetry_logf("🚌 Bus: %u devices (%lu us of transfers) | blocking %lu us/cycle | queued %lu us/cycle | %s",
+                 (unsigned)BUS_MOCK_DEVICE_COUNT, device_sum_us, blocking_us, queued_us,
+                 ok ? "OK" : "FAIL");
+
+  if(result != NULL) {
+    result->devices = BUS_MOCK_DEVICE_COUNT;
+    result->device_sum_us = device_sum_us;
+    result->blocking_us = blocking_us;
+    result->queued_us = queued_us;
+  }
+  return ok;
+}
@@ -0,0 +1,428 @@
+/**
+ * @file telemetry_calibration.cpp
+ * @brief Implementación de la calibración en punto fijo
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Las tablas activas se copian también en memoria RTC (número mágico y CRC,
+ * ver telemetry_retention.h). Así los despertares de bajo consumo, que
+ * adquieren antes de montar LittleFS, usan las mismas tablas que el arranque
+ * que las cargó del fichero.
+ *
+ * Cada búfer de un canal cuenta sus lectores. Un lector incrementa la cuenta
+ * del búfer activo y vuelve a leer el índice: si cambió entre medias, suelta
+ * la cuenta y reintenta. Quien actualiza solo reescribe el búfer inactivo
+ * cuando su cuenta es cero; un lector que llegue tarde a ese búfer ve el
+ * índice sin cambiar y se retira sin tocar la tabla.
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <math.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "../include/telemetry_calibration.h"
+#include "../include/telemetry_retention.h"
+#include "../include/telemetry_sensors.h"
+#include "../include/telemetry_logger.h"
+
+/** @brief Coeficiente beta del NTC de 10 kΩ del diagrama de WOKWI */
+#define CAL_NTC_BETA 3950.0f
+
+/** @brief Mayor cuenta del ADC */
+#define CAL_ADC_MAX ((1u << TELEM_CAL_ADC_BITS) - 1)
+
+/** @brief Cuentas por segmento de tabla, en bits */
+#define CAL_LUT_SHIFT (TELEM_CAL_ADC_BITS - TELEM_CAL_LUT_SEGMENT_BITS)
+
+/** @brief Muestras por bloque en el benchmark */
+#define CAL_BENCH_BLOCK 256
+
+/** @brief Tablas activas, tal como se guardan en el fichero y en memoria RTC */
+typedef struct {
+  uint32_t magic;                                       /**< TELEM_RETENTION_MAGIC si es válido */
+  telemetry_calibration_t tables[TELEM_CAL_CHANNEL_COUNT];
+  uint32_t crc;                                         /**< CRC de los campos anteriores */
+} calibration_image_t;
+
+#define CAL_NAME_ENTRY(name) #name,
+static const char* const channel_names[TELEM_CAL_CHANNEL_COUNT] = { TELEM_CAL_CHANNELS(CAL_NAME_ENTRY) };
+#undef CAL_NAME_ENTRY
+
+/** @brief Doble búfer por canal: las actualizaciones escriben en el inactivo */
+static telemetry_calibration_t tables[TELEM_CAL_CHANNEL_COUNT][2];
+static uint8_t active[TELEM_CAL_CHANNEL_COUNT];
+static uint32_t readers[TELEM_CAL_CHANNEL_COUNT][2];
+static bool calibration_ready = false;
+static SemaphoreHandle_t update_mutex = NULL;
+
+static RTC_NOINIT_ATTR calibration_image_t retained;
+
+/**
+ * @brief Temperatura del NTC en °C (ecuación beta del módulo NTC de WOKWI)
+ */
+static float calibration_ntc_beta(uint32_t raw) {
+  if(raw <= 0) {
+    raw = 1;
+  } else if(raw >= CAL_ADC_MAX) {
+    raw = CAL_ADC_MAX - 1;
+  }
+  return 1.0f / (logf(1.0f / ((float)CAL_ADC_MAX / raw - 1.0f)) / CAL_NTC_BETA + 1.0f / 298.15f) - 273.15f;
+}
+
+/**
+ * @brief Tablas de por defecto: ecuación beta tabulada y divisor ideal
+ */
+static void calibration_defaults(telemetry_calibration_t* defaults) {
+  telemetry_calibration_t* ntc = &defaults[TELEM_CAL_NTC_TEMPERATURE];
+  memset(ntc, 0, sizeof(*ntc));
+  ntc->kind = TELEM_CAL_KIND_LUT;
+  ntc->count = TELEM_CAL_LUT_POINTS;
+  for(int i = 0; i < TELEM_CAL_LUT_POINTS; i++) {
+    ntc->value[i] = (int32_t)lroundf(calibration_ntc_beta((uint32_t)i << CAL_LUT_SHIFT) * TELEM_Q16_ONE);
+  }
+
+  // La entrada son mV del pin: V = u * 2^ADC_BITS / 1000 * divisor
+  telemetry_calibration_t* vbat = &defaults[TELEM_CAL_BATTERY_VOLTAGE];
+  memset(vbat, 0, sizeof(*vbat));
+  vbat->kind = TELEM_CAL_KIND_POLYNOMIAL;
+  vbat->count = 2;
+  vbat->value[1] = (int32_t)lround((CAL_ADC_MAX + 1) / 1000.0 * TELEM_SENSOR_VBAT_DIVIDER * TELEM_Q16_ONE);
+}
+
+/**
+ * @brief Comprueba que una tabla se pueda evaluar sin desbordar
+ */
+static bool calibration_valid(const telemetry_calibration_t* table) {
+  if(table->kind == TELEM_CAL_KIND_LUT) {
+    return table->count == TELEM_CAL_LUT_POINTS;
+  }
+  if(table->kind != TELEM_CAL_KIND_POLYNOMIAL || table->count == 0 || table->count > TELEM_CAL_MAX_COEFFS) {
+    return false;
+  }
+
+  // Con 0 <= u < 1 el acumulador de Horner nunca supera la suma de |c|
+  int64_t bound = 0;
+  for(int i = 0; i < table->count; i++) {
+    bound += table->value[i] < 0 ? -(int64_t)table->value[i] : table->value[i];
+  }
+  return bound <= INT32_MAX;
+}
+
+/**
+ * @brief Valida una imagen completa (fichero o memoria RTC)
+ */
+static bool calibration_image_valid(const calibration_image_t* image) {
+  if(image->magic != TELEM_RETENTION_MAGIC ||
+     image->crc != telemetry_retention_crc(image, offsetof(calibration_image_t, crc))) {
+    return false;
+  }
+  for(int channel = 0; channel < TELEM_CAL_CHANNEL_COUNT; channel++) {
+    if(!calibration_valid(&image->tables[channel])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Copia las tablas activas a una imagen sellada
+ */
+static void calibration_image_build(calibration_image_t* image) {
+  memset(image, 0, sizeof(*image));
+  image->magic = TELEM_RETENTION_MAGIC;
+  for(int channel = 0; channel < TELEM_CAL_CHANNEL_COUNT; channel++) {
+    image->tables[channel] = tables[channel][__atomic_load_n(&active[channel], __ATOMIC_ACQUIRE)];
+  }
+  image->crc = telemetry_retention_crc(image, offsetof(calibration_image_t, crc));
+}
+
+/**
+ * @brief Activa las tablas de una imagen o de una lista de tablas
+ */
+static void calibration_load(const telemetry_calibration_t* source) {
+  for(int channel = 0; channel < TELEM_CAL_CHANNEL_COUNT; channel++) {
+    tables[channel][0] = source[channel];
+    __atomic_store_n(&active[channel], 0, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&calibration_ready, true, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Deja tablas activas aunque no se haya llamado a telemetry_calibration_init()
+ *
+ * @details Los despertares de bajo consumo adquieren antes de montar LittleFS:
+ * usan la copia en memoria RTC y, si no es válida, las tablas por defecto.
+ */
+static void calibration_ensure_ready(void) {
+  if(__atomic_load_n(&calibration_ready, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  if(calibration_image_valid(&retained)) {
+    calibration_load(retained.tables);
+  } else {
+    telemetry_calibration_t defaults[TELEM_CAL_CHANNEL_COUNT];
+    calibration_defaults(defaults);
+    calibration_load(defaults);
+  }
+}
+
+/**
+ * @brief Guarda las tablas activas en el fichero
+ */
+static bool calibration_save(const calibration_image_t* image) {
+  File f = LittleFS.open(TELEM_CAL_FILE, FILE_WRITE);
+  if(!f) {
+    return false;
+  }
+  bool ok = f.write((const uint8_t*)image, sizeof(*image)) == sizeof(*image);
+  f.close();
+  return ok;
+}
+
+/**
+ * @brief Toma el búfer activo de un canal para leerlo
+ *
+ * @return uint8_t Búfer tomado, que hay que soltar con calibration_release()
+ */
+static uint8_t calibration_acquire(telem_cal_channel_t channel) {
+  for(;;) {
+    uint8_t index = __atomic_load_n(&active[channel], __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&readers[channel][index], 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(&active[channel], __ATOMIC_SEQ_CST) == index) {
+      return index;
+    }
+    // Se activó el otro búfer entre medias: este puede estar reescribiéndose
+    __atomic_sub_fetch(&readers[channel][index], 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+static void calibration_release(telem_cal_channel_t channel, uint8_t index) {
+  __atomic_sub_fetch(&readers[channel][index], 1, __ATOMIC_RELEASE);
+}
+
+bool telemetry_calibration_init(void) {
+  static calibration_image_t image;
+  bool from_flash = false;
+
+  if(update_mutex == NULL) {
+    update_mutex = xSemaphoreCreateMutex();
+  }
+
+  File f = LittleFS.open(TELEM_CAL_FILE, FILE_READ);
+  if(f) {
+    from_flash = f.read((uint8_t*)&image, sizeof(image)) == sizeof(image) && calibration_image_valid(&image);
+    f.close();
+  }
+
+  if(from_flash) {
+    calibration_load(image.tables);
+  } else {
+    telemetry_calibration_t defaults[TELEM_CAL_CHANNEL_COUNT];
+    calibration_defaults(defaults);
+    calibration_load(defaults);
+  }
+  calibration_image_build(&retained);
+
+  for(int channel = 0; channel < TELEM_CAL_CHANNEL_COUNT; channel++) {
+    const telemetry_calibration_t* table = &tables[channel][0];
+    telemetry_logf("🎯 Calibration %s: %s, %u values, version %u (%s)",
+                   channel_names[channel], table->kind == TELEM_CAL_KIND_LUT ? "LUT" : "polynomial",
+                   table->count, table->version, from_flash ? "flash" : "default");
+  }
+  return from_flash;
+}
+
+/**
+ * @brief Interpolación lineal en una tabla equiespaciada
+ */
+static void calibrate_lut(const int32_t* points, const uint16_t* raw, int32_t* out, size_t count) {
+  for(size_t i = 0; i < count; i++) {
+    uint32_t x = raw[i] > CAL_ADC_MAX ? CAL_ADC_MAX : raw[i];
+    uint32_t segment = x >> CAL_LUT_SHIFT;
+    int32_t fraction = (int32_t)(x & ((1u << CAL_LUT_SHIFT) - 1));
+    int64_t delta = (int64_t)points[segment + 1] - points[segment];
+    out[i] = points[segment] + (int32_t)((delta * fraction + (1 << (CAL_LUT_SHIFT - 1))) >> CAL_LUT_SHIFT);
+  }
+}
+
+/**
+ * @brief Polinomio por Horner con u = cuenta / 2^ADC_BITS en Q16
+ */
+static void calibrate_polynomial(const int32_t* coeffs, int degree, const uint16_t* raw, int32_t* out, size_t count) {
+  for(size_t i = 0; i < count; i++) {
+    uint32_t x = raw[i] > CAL_ADC_MAX ? CAL_ADC_MAX : raw[i];
+    int64_t u = (int64_t)x << (16 - TELEM_CAL_ADC_BITS);
+    int64_t acc = coeffs[degree];
+    for(int k = degree - 1; k >= 0; k--) {
+      acc = ((acc * u + 0x8000) >> 16) + coeffs[k];
+    }
+    out[i] = (int32_t)acc;
+  }
+}
+
+void telemetry_calibrate_block(telem_cal_channel_t channel, const uint16_t* raw, int32_t* out, size_t count) {
+  calibration_ensure_ready();
+
+  // Un búfer tomado para todo el bloque: una actualización a mitad no lo mezcla
+  uint8_t index = calibration_acquire(channel);
+  const telemetry_calibration_t* table = &tables[channel][index];
+  if(table->kind == TELEM_CAL_KIND_LUT) {
+    calibrate_lut(table->value, raw, out, count);
+  } else {
+    calibrate_polynomial(table->value, table->count - 1, raw, out, count);
+  }
+  calibration_release(channel, index);
+}
+
+int32_t telemetry_calibrate(telem_cal_channel_t channel, uint16_t raw) {
+  int32_t value;
+  telemetry_calibrate_block(channel, &raw, &value, 1);
+  return value;
+}
+
+bool telemetry_calibration_update(telem_cal_channel_t channel, const telemetry_calibration_t* table) {
+  static calibration_image_t image;
+
+  if(channel >= TELEM_CAL_CHANNEL_COUNT || !calibration_valid(table)) {
+    return false;
+  }
+  if(update_mutex == NULL || xSemaphoreTake(update_mutex, pdMS_TO_TICKS(TELEM_CAL_UPDATE_TIMEOUT_MS)) != pdTRUE) {
+    telemetry_logf("⚠️ Calibration %s update rejected: calibration not initialized or busy",
+                   channel_names[channel]);
+    return false;
+  }
+  calibration_ensure_ready();
+
+  // Esperar a quien aún convierta con la tabla anterior a la activa
+  uint8_t next = __atomic_load_n(&active[channel], __ATOMIC_SEQ_CST) ^ 1;
+  TickType_t start = xTaskGetTickCount();
+  while(__atomic_load_n(&readers[channel][next], __ATOMIC_SEQ_CST) != 0) {
+    if(xTaskGetTickCount() - start >= pdMS_TO_TICKS(TELEM_CAL_UPDATE_TIMEOUT_MS)) {
+      xSemaphoreGive(update_mutex);
+      telemetry_logf("⚠️ Calibration %s update rejected: previous table still in use",
+                     channel_names[channel]);
+      return false;
+    }
+    vTaskDelay(1);
+  }
+  tables[channel][next] = *table;
+  __atomic_store_n(&active[channel], next, __ATOMIC_SEQ_CST);
+
+  calibration_image_build(&image);
+  retained = image;
+  bool saved = calibration_save(&image);
+  xSemaphoreGive(update_mutex);
+
+  telemetry_logf("🎯 Calibration %s updated to version %u%s",
+                 channel_names[channel], table->version, saved ? "" : " (not saved to flash)");
+  return saved;
+}
+
+bool telemetry_calibration_poll_upload(void) {
+  static telemetry_calibration_upload_t upload;
+
+  if(!LittleFS.exists(TELEM_CAL_UPLOAD_FILE)) {
+    return false;
+  }
+  File f = LittleFS.open(TELEM_CAL_UPLOAD_FILE, FILE_READ);
+  bool complete = f && f.read((uint8_t*)&upload, sizeof(upload)) == sizeof(upload);
+  if(f) {
+    f.close();
+  }
+  LittleFS.remove(TELEM_CAL_UPLOAD_FILE);
+
+  if(!complete || upload.magic != TELEM_RETENTION_MAGIC ||
+     upload.crc != telemetry_retention_crc(&upload, offsetof(telemetry_calibration_upload_t, crc)) ||
+     upload.channel >= TELEM_CAL_CHANNEL_COUNT) {
+    telemetry_logf("⚠️ Calibration upload discarded: %s", complete ? "bad magic, CRC or channel" : "truncated");
+    return false;
+  }
+  return telemetry_calibration_update((telem_cal_channel_t)upload.channel, &upload.table);
+}
+
+void telemetry_calibration_get(telem_cal_channel_t channel, telemetry_calibration_t* table) {
+  calibration_ensure_ready();
+  uint8_t index = calibration_acquire(channel);
+  *table = tables[channel][index];
+  calibration_release(channel, index);
+}
+
+/**
+ * @brief Evaluación de referencia de una tabla en doble precisión
+ */
+static double calibration_reference(const telemetry_calibration_t* table, uint32_t raw) {
+  if(table->kind == TELEM_CAL_KIND_LUT) {
+    uint32_t segment = raw >> CAL_LUT_SHIFT;
+    double fraction = (double)(raw & ((1u << CAL_LUT_SHIFT) - 1)) / (1u << CAL_LUT_SHIFT);
+    return (table->value[segment] + (table->value[segment + 1] - (double)table->value[segment]) * fraction) /
+           TELEM_Q16_ONE;
+  }
+
+  double u = (double)raw / (CAL_ADC_MAX + 1);
+  double acc = 0.0;
+  for(int k = table->count - 1; k >= 0; k--) {
+    acc = acc * u + (double)table->value[k] / TELEM_Q16_ONE;
+  }
+  return acc;
+}
+
+void telemetry_calibration_benchmark(void) {
+  static uint16_t raw[CAL_BENCH_BLOCK];
+  static int32_t out[CAL_BENCH_BLOCK];
+  const uint32_t samples = CAL_ADC_MAX + 1;
+
+  calibration_ensure_ready();
+
+  for(int channel = 0; channel < TELEM_CAL_CHANNEL_COUNT; channel++) {
+    telemetry_calibration_t table;
+    telemetry_calibration_get((telem_cal_channel_t)channel, &table);
+
+    uint32_t cycles = 0;
+    double max_error = 0.0;
+    for(uint32_t base = 0; base < samples; base += CAL_BENCH_BLOCK) {
+      for(int i = 0; i < CAL_BENCH_BLOCK; i++) {
+        raw[i] = (uint16_t)(base + i);
+      }
+      uint32_t start = ESP.getCycleCount();
+      telemetry_calibrate_block((telem_cal_channel_t)channel, raw, out, CAL_BENCH_BLOCK);
+      cycles += ESP.getCycleCount() - start;
+
+      for(int i = 0; i < CAL_BENCH_BLOCK; i++) {
+        double error = fabs((double)out[i] / TELEM_Q16_ONE - calibration_reference(&table, raw[i]));
+        if(error > max_error) {
+          max_error = error;
+        }
+      }
+    }
+
+    telemetry_logf("🎯 Calibration %s: max error %.6f vs double | %.1f cycles/sample in blocks of %d",
+                   channel_names[channel], max_error, (double)cycles / samples, CAL_BENCH_BLOCK);
+  }
+
+  // Lo que cuesta y se desvía la tabla del NTC frente a la ecuación beta en float
+  volatile float sink = 0.0f;
+  double model_error = 0.0;
+  uint32_t start = ESP.getCycleCount();
+  for(uint32_t x = 0; x < samples; x++) {
+    sink = calibration_ntc_beta(x);
+  }
+  uint32_t beta_cycles = ESP.getCycleCount() - start;
+  (void)sink;
+
+  for(uint32_t x = 0; x < samples; x++) {
+    float expected = calibration_ntc_beta(x);
+    if(expected >= -40.0f && expected <= 125.0f) {
+      double error = fabs(TELEM_Q16_TO_FLOAT(telemetry_calibrate(TELEM_CAL_NTC_TEMPERATURE, (uint16_t)x)) - expected);
+      if(error > model_error) {
+        model_error = error;
+      }
+    }
+  }
+
+  telemetry_logf("🎯 NTC beta equation in float: %.1f cycles/sample | LUT deviation %.3f °C over -40..125 °C",
+                 (double)beta_cycles / samples, model_error);
+}
@@ -0,0 +1,185 @@
+/**
+ * @file telemetry_coroutine.cpp
+ * @brief Implementación de las corrutinas sin pila
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "../include/telemetry_coroutine.h"
+#include "../include/telemetry_logger.h"
+
+/** @brief Idas y vueltas del benchmark */
+#define CO_BENCH_ROUNDS 1000
+
+/** @brief Pila de la tarea auxiliar del benchmark (la de las tareas de telemetría) */
+#define CO_BENCH_STACK 4096
+
+static portMUX_TYPE co_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void telemetry_co_init(telemetry_co_t* co, const char* name, telemetry_co_body_t body) {
+  memset(co, 0, sizeof(*co));
+  co->name = name;
+  co->body = body;
+  co->wait = TELEM_CO_READY;
+}
+
+void telemetry_co_wait(telemetry_co_t* co, telem_co_wait_t wait, uint32_t timeout_ms) {
+  co->wait = (uint8_t)wait;
+  co->forever = timeout_ms == TELEM_CO_FOREVER;
+  co->deadline = xTaskGetTickCount() + (co->forever ? 0 : pdMS_TO_TICKS(timeout_ms));
+}
+
+void telemetry_co_signal(telemetry_co_t* co) {
+  portENTER_CRITICAL(&co_mux);
+  co->signals++;
+  portEXIT_CRITICAL(&co_mux);
+  if(co->task != NULL) {
+    xTaskNotifyGive(co->task);
+  }
+}
+
+void IRAM_ATTR telemetry_co_signal_from_isr(telemetry_co_t* co, BaseType_t* woken) {
+  portENTER_CRITICAL_ISR(&co_mux);
+  co->signals++;
+  portEXIT_CRITICAL_ISR(&co_mux);
+  if(co->task != NULL) {
+    vTaskNotifyGiveFromISR(co->task, woken);
+  }
+}
+
+TickType_t telemetry_co_poll(telemetry_co_t* co) {
+  if(co->wait == TELEM_CO_READY) {
+    return 0;
+  }
+
+  if(co->wait == TELEM_CO_WAIT_SIGNAL) {
+    portENTER_CRITICAL(&co_mux);
+    uint32_t pending = co->signals;
+    co->signals = 0;
+    portEXIT_CRITICAL(&co_mux);
+    if(pending > 0) {
+      co->signaled = true;
+      co->wait = TELEM_CO_READY;
+      return 0;
+    }
+  }
+
+  if(co->forever) {
+    return portMAX_DELAY;
+  }
+  TickType_t remaining = co->deadline - xTaskGetTickCount();
+  if((int32_t)remaining <= 0) {
+    co->signaled = false;
+    co->wait = TELEM_CO_READY;
+    return 0;
+  }
+  return remaining;
+}
+
+void telemetry_co_resume(telemetry_co_t* co) {
+  int64_t start = esp_timer_get_time();
+  co->body(co);
+  uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+  co->resumes++;
+  if(elapsed > co->max_run_us) {
+    co->max_run_us = elapsed;
+  }
+}
+
+static telemetry_co_t bench_ping;
+static telemetry_co_t bench_pong;
+static uint32_t bench_rounds;
+
+/**
+ * @brief Corrutina que inicia cada ida y espera la vuelta
+ */
+static void bench_ping_body(telemetry_co_t* co) {
+  TELEM_CO_BEGIN(co);
+  for(bench_rounds = 0; bench_rounds < CO_BENCH_ROUNDS; bench_rounds++) {
+    telemetry_co_signal(&bench_pong);
+    TELEM_CO_AWAIT_SIGNAL(co, TELEM_CO_FOREVER);
+  }
+  TELEM_CO_AWAIT_SIGNAL(co, TELEM_CO_FOREVER);
+  TELEM_CO_END(co);
+}
+
+/**
+ * @brief Corrutina que devuelve cada ida
+ */
+static void bench_pong_body(telemetry_co_t* co) {
+  TELEM_CO_BEGIN(co);
+  for(;;) {
+    TELEM_CO_AWAIT_SIGNAL(co, TELEM_CO_FOREVER);
+    telemetry_co_signal(&bench_ping);
+  }
+  TELEM_CO_END(co);
+}
+
+/**
+ * @brief Tarea auxiliar: devuelve cada notificación a la tarea que la lanzó
+ */
+static void bench_echo_task(void* arg) {
+  TaskHandle_t origin = (TaskHandle_t)arg;
+  for(int round = 0; round < CO_BENCH_ROUNDS; round++) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    xTaskNotifyGive(origin);
+  }
+  vTaskDelete(NULL);
+}
+
+bool telemetry_co_benchmark(telemetry_co_benchmark_t* result) {
+  TaskHandle_t echo = NULL;
+
+  // Dos tareas: ida y vuelta con notificaciones, dos cambios de contexto por ronda
+  uint32_t heap_before = esp_get_free_heap_size();
+  if(xTaskCreate(bench_echo_task, "CoBench", CO_BENCH_STACK, xTaskGetCurrentTaskHandle(),
+                 uxTaskPriorityGet(NULL), &echo) != pdPASS) {
+    telemetry_logf("⚠️ Coroutine benchmark: helper task could not be created");
+    return false;
+  }
+  uint32_t task_bytes = heap_before - esp_get_free_heap_size();
+
+  uint32_t start = ESP.getCycleCount();
+  for(int round = 0; round < CO_BENCH_ROUNDS; round++) {
+    xTaskNotifyGive(echo);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+  uint32_t task_cycles = ESP.getCycleCount() - start;
+
+  // Dos corrutinas en esta misma tarea, con el mismo bucle que las de telemetría
+  telemetry_co_init(&bench_ping, "ping", bench_ping_body);
+  telemetry_co_init(&bench_pong, "pong", bench_pong_body);
+  bench_ping.task = xTaskGetCurrentTaskHandle();
+  bench_pong.task = bench_ping.task;
+  telemetry_co_t* const bench[] = { &bench_ping, &bench_pong };
+
+  start = ESP.getCycleCount();
+  while(bench_rounds < CO_BENCH_ROUNDS) {
+    for(size_t i = 0; i < sizeof(bench) / sizeof(bench[0]); i++) {
+      if(telemetry_co_poll(bench[i]) == 0) {
+        telemetry_co_resume(bench[i]);
+      }
+    }
+  }
+  uint32_t co_cycles = ESP.getCycleCount() - start;
+  ulTaskNotifyTake(pdTRUE, 0); // Notificaciones que las señales dejaron a esta tarea
+
+  // Cada ronda son dos cambios; ns = ciclos * 1000 / MHz
+  uint64_t cycles_per_switch_to_ns = 2ULL * CO_BENCH_ROUNDS * ESP.getCpuFreqMHz();
+  telemetry_co_benchmark_t measured;
+  measured.task_switch_ns = (uint32_t)((uint64_t)task_cycles * 1000 / cycles_per_switch_to_ns);
+  measured.co_switch_ns = (uint32_t)((uint64_t)co_cycles * 1000 / cycles_per_switch_to_ns);
+  measured.task_heap_bytes = task_bytes;
+  measured.co_state_bytes = sizeof(telemetry_co_t);
+  telemetry_logf("🧵 Coroutines: switch %lu ns (tasks) vs %lu ns (coroutines) | task with %d B stack costs %lu B of heap, coroutine state %lu B",
+                 measured.task_switch_ns, measured.co_switch_ns,
+                 CO_BENCH_STACK, measured.task_heap_bytes, measured.co_state_bytes);
+  if(result != NULL) {
+    *result = measured;
+  }
+  return true;
+}
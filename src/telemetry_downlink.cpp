@@ -0,0 +1,78 @@
+/**
+ * @file telemetry_downlink.cpp
+ * @brief Construcción de tramas de bajada
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <string.h>
+#include "../include/telemetry_downlink.h"
+#include "../include/telemetry_housekeeping.h"
+#include "../include/telemetry_bitpack.h"
+#include "../include/telemetry_auth.h"
+
+size_t telemetry_packet_wire_size(const telemetry_packet_t* packet) {
+  if(packet->header.type == TELEM_HOUSEKEEPING) {
+    return offsetof(housekeeping_telem_t, payloads) + packet->housekeeping.payload_length;
+  }
+
+  size_t payload = telemetry_payload_size(packet->header.type);
+  return payload > 0 ? sizeof(telem_header_t) + payload : sizeof(telemetry_packet_t);
+}
+
+telem_frame_header_t* telemetry_frame_header(const telemetry_frame_t* frame) {
+  return (telem_frame_header_t*)frame->data;
+}
+
+void telemetry_frame_begin(telemetry_frame_t* frame, uint8_t* buffer, size_t capacity,
+                           uint16_t frame_sequence) {
+  frame->data = buffer;
+#ifdef TELEM_DOWNLINK_AUTH
+  frame->capacity = capacity - TELEM_AUTH_OVERHEAD; // Espacio para telemetry_frame_seal()
+#else
+  frame->capacity = capacity;
+#endif
+  frame->length = sizeof(telem_frame_header_t);
+
+  telem_frame_header_t* header = telemetry_frame_header(frame);
+  header->sync = TELEM_FRAME_SYNC;
+  header->frame_sequence = frame_sequence;
+  header->packet_count = 0;
+#ifdef TELEM_DOWNLINK_BITPACK
+  header->flags = TELEM_FRAME_FLAG_BITPACK;
+#else
+  header->flags = 0;
+#endif
+  header->payload_length = 0;
+}
+
+bool telemetry_frame_add_packet(telemetry_frame_t* frame, const telemetry_packet_t* packet) {
+  telem_frame_header_t* header = telemetry_frame_header(frame);
+
+  if(header->packet_count == UINT8_MAX) {
+    return false;
+  }
+
+#ifdef TELEM_DOWNLINK_BITPACK
+  size_t size = telemetry_bitpack_encode(packet, frame->data + frame->length,
+                                         frame->capacity - frame->length);
+  if(size == 0) {
+    return false;
+  }
+#else
+  size_t size = telemetry_packet_wire_size(packet);
+  if(frame->length + size > frame->capacity) {
+    return false;
+  }
+  memcpy(frame->data + frame->length, packet, size);
+#endif
+  frame->length += size;
+  header->packet_count++;
+  header->payload_length = (uint16_t)(frame->length - sizeof(telem_frame_header_t));
+  return true;
+}
+
+bool telemetry_frame_has_room(const telemetry_frame_t* frame) {
+  return frame->length + sizeof(telemetry_packet_t) <= frame->capacity &&
+         telemetry_frame_header(frame)->packet_count < UINT8_MAX;
+}
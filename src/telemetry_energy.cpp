@@ -0,0 +1,240 @@
+/**
+ * @file telemetry_energy.cpp
+ * @brief Implementación de la contabilidad de energía por etapa
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Los contadores se actualizan desde varias tareas, por lo que se protegen
+ * con un spinlock de FreeRTOS (secciones críticas muy cortas, válidas en los
+ * dos núcleos del ESP32). La energía se calcula solo al pedir el informe.
+ *
+ * uxTaskGetSystemState() suspende el planificador mientras recorre las
+ * tareas, así que se llama fuera del spinlock; un indicador atómico evita
+ * que dos informes simultáneos cuenten dos veces la misma diferencia.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "../include/telemetry_energy.h"
+#include "../include/telemetry_sleep.h"
+
+/** @brief Modelo por defecto: ESP32 a 240 MHz, LittleFS en flash interna y UART a 115200 baudios */
+static telemetry_energy_model_t energy_model = {
+  TELEM_SLEEP_ACTIVE_POWER_MW,   // cpu_nj_per_us
+  250,                           // flash_nj_per_byte (programado + borrado amortizado)
+  2900,                          // uart_nj_per_byte (~87 µs/byte a 115200 con la CPU activa)
+  TELEM_SLEEP_DEEP_POWER_UW      // sleep_uw
+};
+
+static telemetry_energy_stage_t stage_counters[TELEM_STAGE_COUNT];
+static TaskHandle_t stage_tasks[TELEM_STAGE_COUNT];
+static telem_energy_stage_t running_stage = TELEM_STAGE_SYSTEM;
+static uint64_t stage_active_us[TELEM_STAGE_COUNT];
+static uint32_t packets_generated = 0;
+static portMUX_TYPE energy_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+#define ENERGY_RUN_TIME_STATS 1
+
+/** @brief Contador de ejecución de una tarea en el informe anterior */
+typedef struct {
+  UBaseType_t number;
+  uint32_t run_time;
+} energy_task_sample_t;
+
+static TaskStatus_t task_status[TELEM_ENERGY_MAX_TASKS];
+static energy_task_sample_t task_samples[TELEM_ENERGY_MAX_TASKS];
+static UBaseType_t task_sample_count = 0;
+static bool sampling = false;
+#endif
+
+void telemetry_energy_set_model(const telemetry_energy_model_t* model) {
+  portENTER_CRITICAL(&energy_lock);
+  energy_model = *model;
+  portEXIT_CRITICAL(&energy_lock);
+}
+
+void telemetry_energy_register_task(telem_energy_stage_t stage, TaskHandle_t task) {
+  if(stage < TELEM_STAGE_COUNT) {
+    stage_tasks[stage] = task;
+  }
+}
+
+void telemetry_energy_set_running_stage(telem_energy_stage_t stage) {
+  __atomic_store_n(&running_stage, stage, __ATOMIC_RELAXED);
+}
+
+telem_energy_stage_t telemetry_energy_current_stage(void) {
+  TaskHandle_t current = xTaskGetCurrentTaskHandle();
+  int found = TELEM_STAGE_SYSTEM;
+  int matches = 0;
+  for(int stage = 0; stage < TELEM_STAGE_SYSTEM; stage++) {
+    if(stage_tasks[stage] != NULL && stage_tasks[stage] == current) {
+      found = stage;
+      matches++;
+    }
+  }
+  if(matches > 1) {
+    return __atomic_load_n(&running_stage, __ATOMIC_RELAXED);
+  }
+  return (telem_energy_stage_t)found;
+}
+
+void telemetry_energy_add_active(telem_energy_stage_t stage, uint32_t us) {
+  portENTER_CRITICAL(&energy_lock);
+  stage_active_us[stage] += us;
+#ifndef ENERGY_RUN_TIME_STATS
+  stage_counters[stage].cpu_us += us;
+#endif
+  portEXIT_CRITICAL(&energy_lock);
+}
+
+void telemetry_energy_add_flash(uint32_t bytes) {
+  telem_energy_stage_t stage = telemetry_energy_current_stage();
+  portENTER_CRITICAL(&energy_lock);
+  stage_counters[stage].flash_bytes += bytes;
+  portEXIT_CRITICAL(&energy_lock);
+}
+
+void telemetry_energy_add_uart(uint32_t bytes) {
+  telem_energy_stage_t stage = telemetry_energy_current_stage();
+  portENTER_CRITICAL(&energy_lock);
+  stage_counters[stage].uart_bytes += bytes;
+  portEXIT_CRITICAL(&energy_lock);
+}
+
+void telemetry_energy_add_packets(uint32_t count) {
+  portENTER_CRITICAL(&energy_lock);
+  packets_generated += count;
+  portEXIT_CRITICAL(&energy_lock);
+}
+
+/**
+ * @brief Aplica un modelo de costes a unos contadores (resultado en µJ)
+ */
+static uint64_t energy_apply_model(const telemetry_energy_model_t* model, uint64_t cpu_us,
+                                   uint32_t flash_bytes, uint32_t uart_bytes) {
+  uint64_t nj = cpu_us * model->cpu_nj_per_us +
+                (uint64_t)flash_bytes * model->flash_nj_per_byte +
+                (uint64_t)uart_bytes * model->uart_nj_per_byte;
+  return nj / 1000;
+}
+
+uint32_t telemetry_energy_estimate_uj(uint32_t cpu_us, uint32_t flash_bytes, uint32_t uart_bytes) {
+  telemetry_energy_model_t model;
+  portENTER_CRITICAL(&energy_lock);
+  model = energy_model;
+  portEXIT_CRITICAL(&energy_lock);
+  uint64_t uj = energy_apply_model(&model, cpu_us, flash_bytes, uart_bytes);
+  return uj > UINT32_MAX ? UINT32_MAX : (uint32_t)uj;
+}
+
+#ifdef ENERGY_RUN_TIME_STATS
+/**
+ * @brief Reparte la CPU de una tarea entre las etapas que la comparten
+ *
+ * @details Se llama con energy_lock tomado.
+ */
+static void energy_charge_task(TaskHandle_t task, uint32_t cpu_us) {
+  int stages[TELEM_STAGE_SYSTEM];
+  int count = 0;
+  uint64_t active_total = 0;
+
+  for(int stage = 0; stage < TELEM_STAGE_SYSTEM; stage++) {
+    if(stage_tasks[stage] != NULL && stage_tasks[stage] == task) {
+      stages[count++] = stage;
+      active_total += stage_active_us[stage];
+    }
+  }
+  if(count == 0) {
+    stage_counters[TELEM_STAGE_SYSTEM].cpu_us += cpu_us;
+    return;
+  }
+
+  // Sin tiempo activo declarado, a partes iguales; el resto del redondeo a la última
+  uint64_t charged = 0;
+  for(int i = 0; i < count; i++) {
+    uint64_t share;
+    if(i == count - 1) {
+      share = cpu_us - charged;
+    } else if(active_total > 0) {
+      share = (uint64_t)cpu_us * stage_active_us[stages[i]] / active_total;
+    } else {
+      share = cpu_us / count;
+    }
+    stage_counters[stages[i]].cpu_us += share;
+    charged += share;
+  }
+}
+
+/**
+ * @brief Incorpora la CPU de cada tarea desde el informe anterior
+ */
+static void energy_sample_tasks(void) {
+  if(__atomic_exchange_n(&sampling, true, __ATOMIC_ACQUIRE)) {
+    return; // Otra tarea está tomando la muestra
+  }
+
+  uint32_t total_run_time;
+  UBaseType_t count = uxTaskGetSystemState(task_status, TELEM_ENERGY_MAX_TASKS, &total_run_time);
+  if(count > 0) {
+    energy_task_sample_t samples[TELEM_ENERGY_MAX_TASKS];
+
+    portENTER_CRITICAL(&energy_lock);
+    for(UBaseType_t i = 0; i < count; i++) {
+      const TaskStatus_t* status = &task_status[i];
+      // Las tareas nuevas (o creadas tras el primer informe) parten de cero
+      uint32_t previous = 0;
+      for(UBaseType_t j = 0; j < task_sample_count; j++) {
+        if(task_samples[j].number == status->xTaskNumber) {
+          previous = task_samples[j].run_time;
+          break;
+        }
+      }
+      samples[i].number = status->xTaskNumber;
+      samples[i].run_time = status->ulRunTimeCounter;
+
+      if(strncmp(status->pcTaskName, "IDLE", 4) != 0) {
+        energy_charge_task(status->xHandle, status->ulRunTimeCounter - previous);
+      }
+    }
+    memcpy(task_samples, samples, count * sizeof(samples[0]));
+    task_sample_count = count;
+    memset(stage_active_us, 0, sizeof(stage_active_us));
+    portEXIT_CRITICAL(&energy_lock);
+  }
+
+  __atomic_store_n(&sampling, false, __ATOMIC_RELEASE);
+}
+#endif
+
+void telemetry_energy_get_report(telemetry_energy_report_t* report) {
+  telemetry_energy_model_t model;
+  telemetry_sleep_stats_t sleep_stats;
+
+#ifdef ENERGY_RUN_TIME_STATS
+  energy_sample_tasks();
+#endif
+
+  portENTER_CRITICAL(&energy_lock);
+  model = energy_model;
+  for(int stage = 0; stage < TELEM_STAGE_COUNT; stage++) {
+    report->stages[stage] = stage_counters[stage];
+  }
+  report->packets = packets_generated;
+  portEXIT_CRITICAL(&energy_lock);
+
+  telemetry_sleep_get_stats(&sleep_stats);
+  report->sleep_energy_uj = sleep_stats.sleep_us * model.sleep_uw / 1000000;
+  report->total_energy_uj = report->sleep_energy_uj;
+
+  for(int stage = 0; stage < TELEM_STAGE_COUNT; stage++) {
+    telemetry_energy_stage_t* s = &report->stages[stage];
+    s->energy_uj = energy_apply_model(&model, s->cpu_us, s->flash_bytes, s->uart_bytes);
+    report->total_energy_uj += s->energy_uj;
+  }
+
+  report->energy_per_packet_uj = report->packets > 0 ? report->total_energy_uj / report->packets : 0;
+}
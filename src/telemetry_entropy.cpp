@@ -0,0 +1,386 @@
+/**
+ * @file telemetry_entropy.cpp
+ * @brief Implementación del codificador rANS estático y de la transformación en diferencias
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * rANS de 32 bits con renormalización por bytes (L = 2^23) y probabilidades
+ * de 12 bits. El codificador recorre la entrada al revés y escribe hacia
+ * atrás; el decodificador lee hacia delante. Los símbolos se localizan en la
+ * tabla acumulada por búsqueda binaria (8 pasos), sin tablas en RAM.
+ */
+
+#include <string.h>
+#include "esp_timer.h"
+#include "../include/telemetry_entropy.h"
+#include "../include/telemetry_bitpack.h"
+#include "../include/telemetry_logger.h"
+
+#define ENTROPY_SCALE (1u << TELEM_ENTROPY_PROB_BITS)
+#define RANS_L (1u << 23)
+
+/** @brief Bytes del campo de tipo, que se copian sin transformar para poder delimitar paquetes */
+#define ENTROPY_TYPE_BYTES sizeof(telem_data_type_t)
+
+/** @brief Bytes necesarios para conocer el tamaño de cualquier paquete (incluido housekeeping) */
+#define ENTROPY_PREFIX_BYTES offsetof(housekeeping_telem_t, payloads)
+
+/**
+ * @brief Frecuencias de los residuos (suma ENTROPY_SCALE, ninguna a cero)
+ *
+ * @details Generadas por el arnés de test/test_entropy: histograma de los
+ * residuos de un día de tramas simuladas, normalizado a 4096 con un mínimo
+ * de 1 por símbolo. Para reentrenar (p. ej. con telemetría grabada) se
+ * cambia la muestra del arnés y se pegan las tablas que imprime.
+ */
+static constexpr uint16_t entropy_freq[256] = {
+  2914, 189, 69, 77, 119, 5, 13, 5, 1, 4, 1, 1, 5, 1, 1, 1,
+  1, 1, 1, 58, 58, 1, 4, 1, 1, 8, 1, 1, 4, 1, 1, 1,
+  1, 1, 1, 2, 2, 4, 1, 1, 1, 7, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 2, 1, 1, 1, 1, 1, 9, 20, 1, 1, 4, 1, 4,
+  11, 2, 6, 2, 1, 1, 1, 10, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 10, 2, 1, 1, 1, 1, 1, 1, 1, 1, 4, 2, 1, 1,
+  1, 1, 4, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1,
+  2, 1, 1, 1, 1, 2, 1, 1, 116, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  5, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 10, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 10, 1, 1, 1, 1, 1, 1,
+  2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 8, 4, 1, 2,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 7, 4, 1, 1, 1, 1, 15, 2, 36, 24
+};
+
+/** @brief Frecuencias acumuladas: entropy_cum[s] = suma de entropy_freq[0..s-1] */
+static constexpr uint16_t entropy_cum[257] = {
+  0, 2914, 3103, 3172, 3249, 3368, 3373, 3386, 3391, 3392, 3396, 3397, 3398, 3403, 3404, 3405,
+  3406, 3407, 3408, 3409, 3467, 3525, 3526, 3530, 3531, 3532, 3540, 3541, 3542, 3546, 3547, 3548,
+  3549, 3550, 3551, 3552, 3554, 3556, 3560, 3561, 3562, 3563, 3570, 3571, 3572, 3573, 3574, 3575,
+  3576, 3577, 3578, 3579, 3581, 3582, 3583, 3584, 3585, 3586, 3595, 3615, 3616, 3617, 3621, 3622,
+  3626, 3637, 3639, 3645, 3647, 3648, 3649, 3650, 3660, 3661, 3662, 3663, 3664, 3665, 3666, 3667,
+  3668, 3669, 3670, 3680, 3682, 3683, 3684, 3685, 3686, 3687, 3688, 3689, 3690, 3694, 3696, 3697,
+  3698, 3699, 3700, 3704, 3705, 3706, 3707, 3708, 3709, 3710, 3711, 3712, 3713, 3714, 3715, 3716,
+  3717, 3718, 3719, 3720, 3721, 3722, 3723, 3724, 3725, 3726, 3727, 3729, 3730, 3731, 3732, 3733,
+  3734, 3736, 3737, 3738, 3739, 3740, 3742, 3743, 3744, 3860, 3861, 3862, 3863, 3864, 3865, 3866,
+  3867, 3868, 3869, 3870, 3871, 3872, 3873, 3874, 3875, 3876, 3877, 3878, 3879, 3880, 3881, 3882,
+  3883, 3888, 3889, 3890, 3891, 3892, 3893, 3894, 3895, 3896, 3897, 3898, 3899, 3900, 3901, 3911,
+  3912, 3913, 3914, 3915, 3916, 3917, 3918, 3919, 3920, 3921, 3931, 3932, 3933, 3934, 3935, 3936,
+  3937, 3939, 3940, 3941, 3942, 3943, 3944, 3945, 3946, 3947, 3948, 3949, 3950, 3958, 3962, 3963,
+  3965, 3966, 3967, 3968, 3969, 3970, 3971, 3972, 3973, 3974, 3975, 3976, 3977, 3978, 3979, 3980,
+  3981, 3982, 3983, 3984, 3985, 3986, 3987, 3988, 3989, 3990, 3991, 3992, 3994, 3995, 3996, 3997,
+  3998, 3999, 4000, 4001, 4002, 4003, 4004, 4011, 4015, 4016, 4017, 4018, 4019, 4034, 4036, 4072,
+  4096
+};
+
+/** @brief Comprueba en compilación que la tabla acumulada corresponde a las frecuencias */
+static constexpr bool entropy_tables_consistent(int symbol) {
+  return symbol == 256 ||
+         (entropy_freq[symbol] > 0 &&
+          entropy_cum[symbol + 1] == entropy_cum[symbol] + entropy_freq[symbol] &&
+          entropy_tables_consistent(symbol + 1));
+}
+
+static_assert(entropy_cum[0] == 0 && entropy_tables_consistent(0),
+              "entropy_cum debe ser la suma acumulada de entropy_freq");
+static_assert(entropy_cum[256] == ENTROPY_SCALE, "La tabla de frecuencias debe sumar 1 << TELEM_ENTROPY_PROB_BITS");
+
+/**
+ * @brief Tamaño de un paquete a partir de los primeros bytes de su representación
+ */
+static size_t entropy_packet_size(const uint8_t* bytes, size_t remaining) {
+  telemetry_packet_t prefix;
+  memset(&prefix, 0, sizeof(prefix));
+  memcpy(&prefix, bytes, remaining < ENTROPY_PREFIX_BYTES ? remaining : ENTROPY_PREFIX_BYTES);
+  return telemetry_packet_wire_size(&prefix);
+}
+
+/**
+ * @brief Transforma una carga útil en diferencias con el paquete anterior del mismo tipo (o la invierte)
+ *
+ * @param src Carga de entrada
+ * @param dst Carga de salida (no puede solaparse con src)
+ * @param length Bytes de la carga
+ * @param inverse false para calcular diferencias, true para reconstruir
+ * @return true Si la carga se pudo delimitar en paquetes completos
+ *
+ * @details Los bytes del tipo se copian tal cual. Al invertir, cada paquete
+ * se reconstruye primero hasta ENTROPY_PREFIX_BYTES para conocer su tamaño.
+ */
+static bool entropy_delta(const uint8_t* src, uint8_t* dst, size_t length, bool inverse) {
+  size_t ref_offset[TELEM_TYPE_COUNT];
+  size_t ref_size[TELEM_TYPE_COUNT] = { 0 };
+  const uint8_t* plain = inverse ? dst : src;   // Bytes originales disponibles
+  size_t offset = 0;
+
+  while(offset < length) {
+    if(length - offset < ENTROPY_TYPE_BYTES) {
+      return false;
+    }
+    memcpy(dst + offset, src + offset, ENTROPY_TYPE_BYTES);
+
+    telem_data_type_t type;
+    memcpy(&type, plain + offset, sizeof(type));
+    bool has_ref = type < TELEM_TYPE_COUNT && ref_size[type] > 0;
+
+    size_t size = ENTROPY_PREFIX_BYTES;
+    for(size_t k = ENTROPY_TYPE_BYTES; k < size && offset + k < length; k++) {
+      uint8_t ref = has_ref && k < ref_size[type] ? plain[ref_offset[type] + k] : 0;
+      dst[offset + k] = inverse ? (uint8_t)(src[offset + k] + ref) : (uint8_t)(src[offset + k] - ref);
+      if(k + 1 == ENTROPY_PREFIX_BYTES) {
+        size = entropy_packet_size(plain + offset, length - offset);
+      }
+    }
+    if(offset + size > length) {
+      return false;
+    }
+
+    if(type < TELEM_TYPE_COUNT) {
+      ref_offset[type] = offset;
+      ref_size[type] = size;
+    }
+    offset += size;
+  }
+  return true;
+}
+
+/**
+ * @brief Símbolo cuyo intervalo acumulado contiene slot
+ */
+static uint8_t entropy_lookup(uint32_t slot) {
+  uint32_t low = 0;
+  uint32_t high = 256;
+  while(high - low > 1) {
+    uint32_t mid = (low + high) / 2;
+    if(entropy_cum[mid] <= slot) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return (uint8_t)low;
+}
+
+size_t telemetry_entropy_encode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+  if(capacity < sizeof(uint32_t)) {
+    return 0;
+  }
+
+  uint8_t* const limit = out + sizeof(uint32_t);   // Espacio reservado para el estado final
+  uint8_t* ptr = out + capacity;
+  uint32_t x = RANS_L;
+
+  for(size_t i = length; i-- > 0;) {
+    uint32_t freq = entropy_freq[in[i]];
+    uint32_t x_max = ((RANS_L >> TELEM_ENTROPY_PROB_BITS) << 8) * freq;
+    while(x >= x_max) {
+      if(ptr == limit) {
+        return 0;
+      }
+      *--ptr = (uint8_t)x;
+      x >>= 8;
+    }
+    x = ((x / freq) << TELEM_ENTROPY_PROB_BITS) + (x % freq) + entropy_cum[in[i]];
+  }
+
+  // Estado final en big-endian al principio del flujo
+  for(int byte = 0; byte < 4; byte++) {
+    *--ptr = (uint8_t)(x >> (8 * byte));
+  }
+
+  size_t size = out + capacity - ptr;
+  memmove(out, ptr, size);
+  return size;
+}
+
+bool telemetry_entropy_decode(const uint8_t* in, size_t length, uint8_t* out, size_t out_length) {
+  if(length < sizeof(uint32_t)) {
+    return false;
+  }
+
+  const uint8_t* end = in + length;
+  uint32_t x = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+  const uint8_t* ptr = in + sizeof(uint32_t);
+
+  for(size_t i = 0; i < out_length; i++) {
+    uint32_t slot = x & (ENTROPY_SCALE - 1);
+    uint8_t symbol = entropy_lookup(slot);
+    out[i] = symbol;
+    x = entropy_freq[symbol] * (x >> TELEM_ENTROPY_PROB_BITS) + slot - entropy_cum[symbol];
+    while(x < RANS_L) {
+      if(ptr == end) {
+        return false;
+      }
+      x = (x << 8) | *ptr++;
+    }
+  }
+
+  // Un flujo íntegro termina exactamente en el estado inicial del codificador
+  return x == RANS_L && ptr == end;
+}
+
+bool telemetry_frame_compress(telemetry_frame_t* frame, uint8_t* scratch, size_t scratch_capacity) {
+  telem_frame_header_t* header = telemetry_frame_header(frame);
+  uint8_t* payload = frame->data + sizeof(telem_frame_header_t);
+  size_t length = header->payload_length;
+
+  if((header->flags & (TELEM_FRAME_FLAG_BITPACK | TELEM_FRAME_FLAG_ENTROPY)) != 0 ||
+     length <= sizeof(uint16_t) + sizeof(uint32_t) || length > scratch_capacity) {
+    return false;
+  }
+
+  if(!entropy_delta(payload, scratch, length, false)) {
+    return false;
+  }
+
+  // La salida se escribe sobre la propia carga y debe quedar al menos un byte por debajo
+  size_t coded = telemetry_entropy_encode(scratch, length, payload + sizeof(uint16_t),
+                                          length - sizeof(uint16_t) - 1);
+  if(coded == 0) {
+    entropy_delta(scratch, payload, length, true);   // Restaurar la carga original
+    return false;
+  }
+
+  payload[0] = (uint8_t)length;
+  payload[1] = (uint8_t)(length >> 8);
+  header->payload_length = (uint16_t)(coded + sizeof(uint16_t));
+  header->flags |= TELEM_FRAME_FLAG_ENTROPY;
+  frame->length = sizeof(telem_frame_header_t) + header->payload_length;
+  return true;
+}
+
+size_t telemetry_frame_decompress(const uint8_t* payload, size_t length, uint8_t* out,
+                                  size_t capacity, uint8_t* scratch) {
+  if(length < sizeof(uint16_t)) {
+    return 0;
+  }
+
+  size_t original = payload[0] | ((size_t)payload[1] << 8);
+  if(original > capacity ||
+     !telemetry_entropy_decode(payload + sizeof(uint16_t), length - sizeof(uint16_t), scratch, original) ||
+     !entropy_delta(scratch, out, original, true)) {
+    return 0;
+  }
+  return original;
+}
+
+const uint16_t* telemetry_entropy_frequencies(void) {
+  return entropy_freq;
+}
+
+bool telemetry_entropy_residuals(const uint8_t* payload, uint8_t* residuals, size_t length) {
+  return entropy_delta(payload, residuals, length, false);
+}
+
+/**
+ * @brief Paquete representativo de un ciclo del recolector para la prueba de rendimiento
+ */
+static void entropy_sample_packet(uint32_t index, telemetry_packet_t* packet) {
+  uint32_t cycle = index / 4;
+  uint32_t noise = (cycle * 1103515245u + 12345u) >> 16;
+
+  memset(packet, 0, sizeof(*packet));
+  packet->header.type = (telem_data_type_t)(index % 4);
+  packet->header.timestamp = cycle * 5000 + (index % 4);
+  packet->header.sequence = (uint16_t)index;
+  packet->header.priority = packet->header.type == TELEM_POWER_DATA ? 2 : 1;
+
+  switch(packet->header.type) {
+    case TELEM_SYSTEM_STATUS:
+      packet->system.uptime_seconds = cycle;
+      packet->system.system_mode = 1;
+      packet->system.stack_high_water = 1400 + (noise & 0x3);
+      packet->system.heap_free = 250000 - (noise & 0x1FF);
+      packet->system.task_count = 9;
+      packet->system.cpu_temperature = 45.0f + (float)(noise & 0x7) * 0.5f;
+      packet->system.energy_total_mj = cycle * 3;
+      packet->system.energy_per_packet_uj = 900 + (noise & 0xF);
+      break;
+    case TELEM_POWER_DATA:
+      packet->power.battery_voltage = 3.3f + (float)(noise & 0x3) * 0.01f;
+      packet->power.battery_current = 0.1f;
+      packet->power.solar_panel_voltage = 5.0f;
+      packet->power.solar_panel_current = 0.5f;
+      packet->power.battery_level = 85 - cycle / 720;
+      packet->power.battery_temperature = 25;
+      break;
+    case TELEM_TEMPERATURE_DATA:
+      packet->temperature.obc_temperature = 35 + (noise & 0x1);
+      packet->temperature.comms_temperature = 28;
+      packet->temperature.payload_temperature = 25;
+      packet->temperature.battery_temperature = 22;
+      packet->temperature.external_temperature = -15 - (noise & 0x3);
+      break;
+    default:
+      packet->subsystems.comms_status = 1;
+      packet->subsystems.adcs_status = 1;
+      packet->subsystems.payload_status = 1;
+      packet->subsystems.power_status = 1;
+      packet->subsystems.comms_uptime = cycle;
+      packet->subsystems.payload_uptime = cycle - 100;
+      packet->subsystems.last_command_id = 0x25;
+      packet->subsystems.command_success_rate = 98;
+      break;
+  }
+}
+
+size_t telemetry_entropy_sample_payload(uint32_t first, uint8_t* out, size_t capacity, size_t* bitpacked) {
+  telemetry_packet_t packet;
+  size_t length = 0;
+  size_t packed = 0;
+
+  for(uint32_t index = first; ; index++) {
+    entropy_sample_packet(index, &packet);
+    size_t size = telemetry_packet_wire_size(&packet);
+    if(length + size > capacity) {
+      break;
+    }
+    memcpy(out + length, &packet, size);
+    length += size;
+    packed += telemetry_bitpack_size(&packet);
+  }
+
+  if(bitpacked != NULL) {
+    *bitpacked = packed;
+  }
+  return length;
+}
+
+void telemetry_entropy_benchmark(void) {
+  const int iterations = 50;
+  static uint8_t raw[TELEM_FRAME_MAX_PAYLOAD];
+  static uint8_t coded[TELEM_FRAME_MAX_PAYLOAD];
+  static uint8_t scratch[TELEM_FRAME_MAX_PAYLOAD];
+  static uint8_t restored[TELEM_FRAME_MAX_PAYLOAD];
+  size_t bitpacked = 0;
+
+  // Carga útil de una trama sin comprimir llena de ciclos completos
+  size_t raw_length = telemetry_entropy_sample_payload(0, raw, sizeof(raw), &bitpacked);
+
+  size_t coded_length = 0;
+  int64_t start = esp_timer_get_time();
+  for(int i = 0; i < iterations; i++) {
+    entropy_delta(raw, scratch, raw_length, false);
+    coded_length = telemetry_entropy_encode(scratch, raw_length, coded, sizeof(coded));
+  }
+  uint32_t encode_us = (uint32_t)(esp_timer_get_time() - start);
+
+  bool ok = true;
+  start = esp_timer_get_time();
+  for(int i = 0; i < iterations; i++) {
+    ok = telemetry_entropy_decode(coded, coded_length, scratch, raw_length) &&
+         entropy_delta(scratch, restored, raw_length, true);
+  }
+  uint32_t decode_us = (uint32_t)(esp_timer_get_time() - start);
+  ok = ok && coded_length > 0 && memcmp(restored, raw, raw_length) == 0;
+
+  // KB/s de carga original procesada
+  uint32_t encode_kbps = encode_us > 0 ? (uint32_t)((uint64_t)raw_length * iterations * 1000000ULL / ((uint64_t)encode_us * 1024)) : 0;
+  uint32_t decode_kbps = decode_us > 0 ? (uint32_t)((uint64_t)raw_length * iterations * 1000000ULL / ((uint64_t)decode_us * 1024)) : 0;
+  telemetry_logf("🗜️ Entropy: raw %u B | bitpack %u B | delta+rANS %u B (x%lu.%02lu) | enc %lu KB/s | dec %lu KB/s | %s",
+                 (unsigned)raw_length, (unsigned)bitpacked, (unsigned)coded_length,
+                 coded_length > 0 ? (unsigned long)(raw_length / coded_length) : 0UL,
+                 coded_length > 0 ? (unsigned long)(raw_length * 100 / coded_length % 100) : 0UL,
+                 encode_kbps, decode_kbps, ok ? "OK" : "MISMATCH");
+}
@@ -26,105 +26,418 @@
 #include "esp_system.h"
 #include "esp_heap_caps.h"
 #include <Arduino.h>
-#include <ESPCPUTemp.h>
+#include <string.h>
+#include "esp_attr.h"
 #include "../include/telemetry_storage.h"
+#include "../include/telemetry_generators.h"
+#include "../include/telemetry_retention.h"
+#include "../include/telemetry_sleep.h"
+#include "../include/telemetry_energy.h"
+#include "../include/telemetry_housekeeping.h"
+#include "../include/telemetry_sensors.h"
+#include "../include/telemetry_soc.h"
 
-static uint16_t sequence_number = 0; /**< Contador de secuencia para paquetes de telemetría */
-static uint32_t system_uptime = 0; /**< Tiempo de actividad del sistema en segundos */
+/**
+ * @brief Contadores de los generadores que se conservan en memoria RTC
+ *
+ * @details Se ubican en RTC slow memory sin inicializar para que la numeración
+ * de secuencia continúe tras un reinicio en caliente.
+ */
+typedef struct {
+  uint32_t magic;             /**< TELEM_RETENTION_MAGIC si el bloque es válido */
+  uint32_t system_uptime;     /**< Tiempo de actividad del sistema en segundos */
+  uint16_t sequence_number;   /**< Contador de secuencia para paquetes de telemetría */
+  uint32_t crc;               /**< CRC de los campos anteriores */
+} generator_counters_t;
 
-void generate_system_telemetry(void) {
-  system_status_telem_t system_telem;
+static RTC_NOINIT_ATTR generator_counters_t counters;
+
+/** @brief Destino actual de los paquetes generados */
+static telemetry_packet_sink_t packet_sink = telemetry_store_packet;
+
+/**
+ * @brief Calcula el CRC de los contadores retenidos
+ */
+static uint32_t counters_crc(void) {
+  const uint32_t fields[] = { counters.system_uptime, counters.sequence_number };
+  return telemetry_retention_crc(fields, sizeof(fields));
+}
+
+/**
+ * @brief Devuelve el siguiente número de secuencia y vuelve a sellar los contadores
+ */
+static uint16_t next_sequence(void) {
+  uint16_t sequence = counters.sequence_number++;
+  counters.crc = counters_crc();
+  return sequence;
+}
+
+/**
+ * @brief Marca de tiempo de los paquetes
+ *
+ * @details En modo de bajo consumo el contador de ticks se reinicia en cada
+ * despertar, por lo que se usa la base de tiempo mantenida en memoria RTC.
+ */
+static uint32_t packet_timestamp(void) {
+#ifdef TELEM_LOW_POWER_MODE
+  return telemetry_sleep_timestamp();
+#else
+  return xTaskGetTickCount();
+#endif
+}
+
+/**
+ * @brief Entrega un paquete al destino actual y lo contabiliza
+ */
+static void emit_packet(const telemetry_packet_t* packet) {
+  packet_sink(packet);
+  telemetry_energy_add_packets(1);
+}
+
+void telemetry_generators_set_sink(telemetry_packet_sink_t sink) {
+  packet_sink = sink != NULL ? sink : telemetry_store_packet;
+}
+
+/**
+ * @brief Rellena el encabezado común de un paquete y consume un número de secuencia
+ */
+static void fill_header(telem_header_t* header, telem_data_type_t type, uint8_t priority) {
+  header->type = type;
+  header->timestamp = packet_timestamp();
+  header->sequence = next_sequence();
+  header->priority = priority;
+}
 
-  system_telem.header.type = TELEM_SYSTEM_STATUS;
-  system_telem.header.timestamp = xTaskGetTickCount();
-  system_telem.header.sequence = sequence_number++;
-  system_telem.header.priority = 1;
+void telemetry_generators_stamp(telem_header_t* header, uint32_t age_ms) {
+#ifdef TELEM_LOW_POWER_MODE
+  header->timestamp = packet_timestamp() - age_ms;
+#else
+  header->timestamp = packet_timestamp() - pdMS_TO_TICKS(age_ms);
+#endif
+  header->sequence = next_sequence();
+}
 
-  system_telem.uptime_seconds = system_uptime++;
+/**
+ * @brief Rellena los campos de telemetría del estado del sistema (sin el encabezado)
+ */
+static void fill_system_telemetry(system_status_telem_t* system_telem) {
+  system_telem->uptime_seconds = counters.system_uptime++;
+  counters.crc = counters_crc();
 
   // Estados específicos del ESP32
-  system_telem.system_mode = 1; // nominal
-  system_telem.cpu_usage = 0;   // En ESP32 no tenemos esta métrica fácil
-  system_telem.stack_high_water = uxTaskGetStackHighWaterMark(NULL);
+  system_telem->system_mode = 1; // nominal
+  system_telem->cpu_usage = 0;   // En ESP32 no tenemos esta métrica fácil
+  system_telem->stack_high_water = uxTaskGetStackHighWaterMark(NULL);
 
   // Memoria ESP32
-  system_telem.heap_free = esp_get_free_heap_size();
-  system_telem.task_count = uxTaskGetNumberOfTasks();
+  system_telem->heap_free = esp_get_free_heap_size();
+  system_telem->task_count = uxTaskGetNumberOfTasks();
+
+  // temperatura CPU ESP32 (del barrido del ciclo)
+  system_telem->cpu_temperature = telemetry_sensors_frame()->value[TELEM_CH_CPU_TEMPERATURE];
 
-  // temperatura CPU ESP32
-  system_telem.cpu_temperature = temperatureRead();
-  
-  telemetry_store_packet((telemetry_packet_t*)&system_telem);
+  // Consumo estimado de la telemetría
+  telemetry_energy_report_t energy;
+  telemetry_energy_get_report(&energy);
+  uint64_t total_mj = energy.total_energy_uj / 1000;
+  system_telem->energy_total_mj = total_mj > UINT32_MAX ? UINT32_MAX : (uint32_t)total_mj;
+  system_telem->energy_per_packet_uj = energy.energy_per_packet_uj > UINT16_MAX ?
+                                       UINT16_MAX : (uint16_t)energy.energy_per_packet_uj;
 }
 
+/**
+ * @brief Rellena los campos de telemetría del sistema de potencia (sin el encabezado)
+ */
+static void fill_power_telemetry(power_telem_t* power_telem) {
+  const telemetry_sample_frame_t* samples = telemetry_sensors_frame();
 
-void generate_power_telemetry(void) {
-  power_telem_t power_telem;
+  power_telem->battery_voltage = samples->value[TELEM_CH_BATTERY_VOLTAGE];
+  power_telem->battery_temperature = (int8_t)samples->value[TELEM_CH_BATTERY_TEMPERATURE];
+  power_telem->battery_current = samples->value[TELEM_CH_BATTERY_CURRENT];
+  power_telem->solar_panel_voltage = 5.0f;
+  power_telem->solar_panel_current = 0.5f;
+  power_telem->battery_level = telemetry_soc_level();
+  power_telem->power_state = 0;
+}
 
-  power_telem.header.type = TELEM_POWER_DATA;
-  power_telem.header.timestamp = xTaskGetTickCount();
-  power_telem.header.sequence = sequence_number++;
-  power_telem.header.priority = 2;
+/**
+ * @brief Rellena los campos de telemetría de temperaturas (sin el encabezado)
+ */
+static void fill_temperature_telemetry(temperature_telem_t* temp_telem) {
+  const telemetry_sample_frame_t* samples = telemetry_sensors_frame();
 
-#ifdef WOKWI
-  power_telem.battery_voltage = read_virtual_voltage();
-  power_telem.battery_temperature = read_virtual_temperature();
-#else
-  power_telem.battery_voltage = 3.3f;
-  power_telem.battery_temperature = 25;
-#endif
+  temp_telem->obc_temperature = (int16_t)samples->value[TELEM_CH_OBC_TEMPERATURE];
+  temp_telem->comms_temperature = (int16_t)samples->value[TELEM_CH_COMMS_TEMPERATURE];
+  temp_telem->payload_temperature = (int16_t)samples->value[TELEM_CH_PAYLOAD_TEMPERATURE];
+  temp_telem->battery_temperature = (int16_t)samples->value[TELEM_CH_BATTERY_TEMPERATURE];
+  temp_telem->external_temperature = (int16_t)samples->value[TELEM_CH_EXTERNAL_TEMPERATURE];
+}
 
-  power_telem.battery_current = 0.1f;
-  power_telem.solar_panel_voltage = 5.0f;
-  power_telem.solar_panel_current = 0.5f;
-  power_telem.battery_level = 85 - (system_uptime / 3600);
-  power_telem.power_state = 0;
+/**
+ * @brief Rellena los campos de telemetría del estado de subsistemas (sin el encabezado)
+ */
+static void fill_subsystem_telemetry(subsystem_status_telem_t* subsys_telem) {
+  subsys_telem->comms_status = 1;
+  subsys_telem->adcs_status = 1;  
+  subsys_telem->payload_status = 1;
+  subsys_telem->power_status = 1;
+  subsys_telem->comms_uptime = counters.system_uptime;
+  subsys_telem->payload_uptime = counters.system_uptime - 100;
+  subsys_telem->last_command_id = 0x25;
+  subsys_telem->command_success_rate = 98;
+}
 
-  telemetry_store_packet((telemetry_packet_t*)&power_telem);
+/**
+ * @brief Barrido de sensores del ciclo y actualización del estimador de carga
+ */
+static void collector_sweep(void) {
+  telemetry_soc_update(telemetry_sensors_sweep());
 }
 
+/**
+ * @brief Ejecuta un generador: encabezado, relleno y entrega del paquete
+ */
+static void run_generator(const telemetry_generator_t* generator) {
+  telemetry_packet_t packet;
 
-void generate_temperature_telemetry(void) {
-  temperature_telem_t temp_telem;
-
-  temp_telem.header.type = TELEM_TEMPERATURE_DATA;
-  temp_telem.header.timestamp = xTaskGetTickCount();
-  temp_telem.header.sequence = sequence_number++;
-  temp_telem.header.priority = 1;
-
-#ifdef WOKWI
-  temp_telem.obc_temperature = read_virtual_temperature();
-  temp_telem.comms_temperature = read_virtual_temperature() - 5;
-  temp_telem.payload_temperature = read_virtual_temperature() + 3;
-  temp_telem.battery_temperature = read_virtual_temperature();
-  temp_telem.external_temperature = read_virtual_temperature() - 10;
+  // Partir de ceros para que el relleno de las estructuras sea determinista
+  memset(&packet, 0, sizeof(packet));
+  fill_header(&packet.header, (telem_data_type_t)generator->type, generator->priority);
+  generator->fill(&packet);
+
+  emit_packet(&packet);
+}
+
+static void fill_system_entry(telemetry_packet_t* packet) {
+  fill_system_telemetry(&packet->system);
+}
+
+static void fill_power_entry(telemetry_packet_t* packet) {
+  fill_power_telemetry(&packet->power);
+}
+
+static void fill_temperature_entry(telemetry_packet_t* packet) {
+  fill_temperature_telemetry(&packet->temperature);
+}
+
+static void fill_subsystem_entry(telemetry_packet_t* packet) {
+  fill_subsystem_telemetry(&packet->subsystems);
+}
+
+/**
+ * @brief Rellena un registro de housekeeping con las cuatro cargas útiles simples
+ */
+static void fill_housekeeping_entry(telemetry_packet_t* record) {
+  telemetry_packet_t part;
+
+  memset(&part, 0, sizeof(part));
+  telemetry_hk_begin(&record->housekeeping);
+
+  part.header.type = TELEM_SYSTEM_STATUS;
+  fill_system_telemetry(&part.system);
+  telemetry_hk_add(&record->housekeeping, &part);
+
+  part.header.type = TELEM_POWER_DATA;
+  fill_power_telemetry(&part.power);
+  telemetry_hk_add(&record->housekeeping, &part);
+
+  part.header.type = TELEM_TEMPERATURE_DATA;
+  fill_temperature_telemetry(&part.temperature);
+  telemetry_hk_add(&record->housekeeping, &part);
+
+  part.header.type = TELEM_COMMUNICATION_STATUS;
+  fill_subsystem_telemetry(&part.subsystems);
+  telemetry_hk_add(&record->housekeeping, &part);
+}
+
+static const telemetry_generator_t system_generator =
+  { TELEM_SYSTEM_STATUS, 1, TELEM_GENERATOR_PERIOD_MS, fill_system_entry };
+static const telemetry_generator_t power_generator =
+  { TELEM_POWER_DATA, 2, TELEM_GENERATOR_PERIOD_MS, fill_power_entry };
+static const telemetry_generator_t temperature_generator =
+  { TELEM_TEMPERATURE_DATA, 1, TELEM_GENERATOR_PERIOD_MS, fill_temperature_entry };
+static const telemetry_generator_t subsystem_generator =
+  { TELEM_COMMUNICATION_STATUS, 1, TELEM_GENERATOR_PERIOD_MS, fill_subsystem_entry };
+// Un único encabezado para todo el ciclo, con la prioridad más alta de su contenido
+static const telemetry_generator_t housekeeping_generator =
+  { TELEM_HOUSEKEEPING, 2, TELEM_GENERATOR_PERIOD_MS, fill_housekeeping_entry };
+
+/** @brief Generador registrado y su próximo vencimiento */
+typedef struct {
+  const telemetry_generator_t* generator;
+  uint32_t next_due_ms;
+} generator_slot_t;
+
+static generator_slot_t slots[TELEM_MAX_GENERATORS];
+static uint8_t slot_count = 0;
+/** @brief Protege ranuras y montículo frente a registros desde otras tareas */
+static portMUX_TYPE generators_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** @brief Montículo mínimo de ranuras por vencimiento: la raíz es la próxima en vencer */
+static uint8_t due_heap[TELEM_MAX_GENERATORS];
+
+/**
+ * @brief Orden del montículo: vence antes, y a igualdad, se registró antes
+ */
+static bool slot_before(uint8_t a, uint8_t b) {
+  int32_t diff = (int32_t)(slots[a].next_due_ms - slots[b].next_due_ms);
+  return diff < 0 || (diff == 0 && a < b);
+}
+
+static void heap_sift_up(uint8_t position) {
+  while(position > 0) {
+    uint8_t parent = (position - 1) / 2;
+    if(!slot_before(due_heap[position], due_heap[parent])) {
+      break;
+    }
+    uint8_t swap = due_heap[parent];
+    due_heap[parent] = due_heap[position];
+    due_heap[position] = swap;
+    position = parent;
+  }
+}
+
+static void heap_sift_down(uint8_t position) {
+  for(;;) {
+    uint8_t smallest = position;
+    uint8_t left = 2 * position + 1;
+    uint8_t right = left + 1;
+    if(left < slot_count && slot_before(due_heap[left], due_heap[smallest])) {
+      smallest = left;
+    }
+    if(right < slot_count && slot_before(due_heap[right], due_heap[smallest])) {
+      smallest = right;
+    }
+    if(smallest == position) {
+      break;
+    }
+    uint8_t swap = due_heap[smallest];
+    due_heap[smallest] = due_heap[position];
+    due_heap[position] = swap;
+    position = smallest;
+  }
+}
+
+bool telemetry_generator_register(const telemetry_generator_t* generator) {
+  // Un tipo que no cabe en el encabezado empaquetado no se podría transmitir
+  if(generator == NULL || generator->fill == NULL || generator->period_ms == 0 ||
+     generator->type > TELEM_TYPE_MAX) {
+    return false;
+  }
+
+  bool registered = false;
+  portENTER_CRITICAL(&generators_mux);
+  for(uint8_t i = 0; i < slot_count; i++) {
+    registered = registered || slots[i].generator == generator;
+  }
+  if(!registered && slot_count < TELEM_MAX_GENERATORS) {
+    // Vence en la siguiente pasada del recolector
+    slots[slot_count].generator = generator;
+    slots[slot_count].next_due_ms = pdTICKS_TO_MS(xTaskGetTickCount());
+    due_heap[slot_count] = slot_count;
+    slot_count++;
+    heap_sift_up(slot_count - 1);
+    registered = true;
+  }
+  portEXIT_CRITICAL(&generators_mux);
+  return registered;
+}
+
+bool telemetry_generators_init(void) {
+  bool restored = telemetry_retention_rtc_preserved() &&
+                  counters.magic == TELEM_RETENTION_MAGIC &&
+                  counters.crc == counters_crc();
+
+  if(!restored) {
+    counters.magic = TELEM_RETENTION_MAGIC;
+    counters.system_uptime = 0;
+    counters.sequence_number = 0;
+    counters.crc = counters_crc();
+  }
+
+  // Generadores propios; los de otros módulos se registran aparte
+#ifdef TELEM_MERGED_HOUSEKEEPING
+  telemetry_generator_register(&housekeeping_generator);
 #else
-  temp_telem.obc_temperature = 35;
-  temp_telem.comms_temperature = 28;
-  temp_telem.payload_temperature = 25;
-  temp_telem.battery_temperature = 22;
-  temp_telem.external_temperature = -15;
+  telemetry_generator_register(&system_generator);
+  telemetry_generator_register(&power_generator);
+  telemetry_generator_register(&temperature_generator);
+  telemetry_generator_register(&subsystem_generator);
 #endif
+  return restored;
+}
+
+uint32_t telemetry_generators_run_due(uint32_t now_ms) {
+  bool swept = false;
+
+  for(;;) {
+    const telemetry_generator_t* generator = NULL;
+    uint32_t wait_ms = TELEM_GENERATOR_PERIOD_MS;
+
+    // Se reprograma la raíz bajo el cerrojo; el generador se ejecuta fuera de él
+    portENTER_CRITICAL(&generators_mux);
+    if(slot_count > 0) {
+      generator_slot_t* slot = &slots[due_heap[0]];
+      if((int32_t)(slot->next_due_ms - now_ms) <= 0) {
+        generator = slot->generator;
+        // Cadencia fija; si el recolector se retrasó más de un periodo, no recuperar en ráfaga
+        slot->next_due_ms += generator->period_ms;
+        if((int32_t)(slot->next_due_ms - now_ms) <= 0) {
+          slot->next_due_ms = now_ms + generator->period_ms;
+        }
+        heap_sift_down(0);
+      } else {
+        wait_ms = slot->next_due_ms - now_ms;
+      }
+    }
+    portEXIT_CRITICAL(&generators_mux);
 
-  telemetry_store_packet((telemetry_packet_t*)&temp_telem);
+    if(generator == NULL) {
+      return wait_ms;
+    }
+    // Un único barrido de sensores para todos los paquetes de esta pasada
+    if(!swept) {
+      collector_sweep();
+      swept = true;
+    }
+    run_generator(generator);
+  }
+}
+
+void generate_system_telemetry(void) {
+  run_generator(&system_generator);
+}
+
+void generate_power_telemetry(void) {
+  run_generator(&power_generator);
+}
+
+void generate_temperature_telemetry(void) {
+  run_generator(&temperature_generator);
 }
 
 void generate_subsystem_telemetry(void) {
-  subsystem_status_telem_t subsys_telem;
-
-  subsys_telem.header.type = TELEM_COMMUNICATION_STATUS;
-  subsys_telem.header.timestamp = xTaskGetTickCount();
-  subsys_telem.header.sequence = sequence_number++;
-  subsys_telem.header.priority = 1;
-
-  subsys_telem.comms_status = 1;
-  subsys_telem.adcs_status = 1;  
-  subsys_telem.payload_status = 1;
-  subsys_telem.power_status = 1;
-  subsys_telem.comms_uptime = system_uptime;
-  subsys_telem.payload_uptime = system_uptime - 100;
-  subsys_telem.last_command_id = 0x25;
-  subsys_telem.command_success_rate = 98;
-
-  telemetry_store_packet((telemetry_packet_t*)&subsys_telem);
-}
\ No newline at end of file
+  run_generator(&subsystem_generator);
+}
+
+void generate_housekeeping_telemetry(void) {
+  run_generator(&housekeeping_generator);
+}
+
+void generate_cycle_telemetry(void) {
+  // Un único barrido de sensores para todos los paquetes del ciclo
+  collector_sweep();
+
+  const telemetry_generator_t* generators[TELEM_MAX_GENERATORS];
+  uint8_t count;
+  portENTER_CRITICAL(&generators_mux);
+  count = slot_count;
+  for(uint8_t i = 0; i < count; i++) {
+    generators[i] = slots[i].generator;
+  }
+  portEXIT_CRITICAL(&generators_mux);
+
+  for(uint8_t i = 0; i < count; i++) {
+    run_generator(generators[i]);
+  }
+}
@@ -0,0 +1,76 @@
+/**
+ * @file telemetry_housekeeping.cpp
+ * @brief Implementación de los registros combinados de housekeeping
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <string.h>
+#include "../include/telemetry_housekeeping.h"
+
+static_assert(sizeof(telemetry_packet_t) == TELEM_PACKET_RAW_SIZE,
+              "Ningún tipo de paquete debe superar TELEM_PACKET_RAW_SIZE");
+
+#ifdef TELEM_MERGED_HOUSEKEEPING
+static_assert(sizeof(system_status_telem_t) + sizeof(power_telem_t) +
+              sizeof(temperature_telem_t) + sizeof(subsystem_status_telem_t) -
+              4 * sizeof(telem_header_t) <= TELEM_HK_PAYLOAD_SIZE,
+              "Las cargas útiles de un ciclo no caben en housekeeping_telem_t");
+#endif
+
+size_t telemetry_payload_size(telem_data_type_t type) {
+  switch(type) {
+    case TELEM_SYSTEM_STATUS:        return sizeof(system_status_telem_t) - sizeof(telem_header_t);
+    case TELEM_POWER_DATA:           return sizeof(power_telem_t) - sizeof(telem_header_t);
+    case TELEM_TEMPERATURE_DATA:     return sizeof(temperature_telem_t) - sizeof(telem_header_t);
+    case TELEM_COMMUNICATION_STATUS: return sizeof(subsystem_status_telem_t) - sizeof(telem_header_t);
+    default:                         return 0;
+  }
+}
+
+void telemetry_hk_begin(housekeeping_telem_t* record) {
+  record->presence = 0;
+  record->payload_length = 0;
+}
+
+bool telemetry_hk_add(housekeeping_telem_t* record, const telemetry_packet_t* packet) {
+  telem_data_type_t type = packet->header.type;
+  size_t size = telemetry_payload_size(type);
+  uint8_t bit = (uint8_t)(1u << type);
+
+  // Solo tipos simples, sin repetir y en orden creciente
+  if(size == 0 || record->presence >= bit ||
+     record->payload_length + size > TELEM_HK_PAYLOAD_SIZE) {
+    return false;
+  }
+
+  memcpy(&record->payloads[record->payload_length],
+         (const uint8_t*)packet + sizeof(telem_header_t), size);
+  record->payload_length += (uint8_t)size;
+  record->presence |= bit;
+  return true;
+}
+
+bool telemetry_hk_extract(const housekeeping_telem_t* record, telem_data_type_t type,
+                          telemetry_packet_t* packet) {
+  size_t size = telemetry_payload_size(type);
+  if(size == 0 || (record->presence & (1u << type)) == 0) {
+    return false;
+  }
+
+  // El desplazamiento es la suma de las cargas de los tipos anteriores presentes
+  size_t offset = 0;
+  for(int previous = 0; previous < (int)type; previous++) {
+    if(record->presence & (1u << previous)) {
+      offset += telemetry_payload_size((telem_data_type_t)previous);
+    }
+  }
+  if(offset + size > record->payload_length) {
+    return false;
+  }
+
+  packet->header = record->header;
+  packet->header.type = type;
+  memcpy((uint8_t*)packet + sizeof(telem_header_t), &record->payloads[offset], size);
+  return true;
+}
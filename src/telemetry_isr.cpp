@@ -0,0 +1,250 @@
+/**
+ * @file telemetry_isr.cpp
+ * @brief Implementación del almacenamiento desde interrupciones
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "../include/telemetry_isr.h"
+#include "../include/telemetry_logger.h"
+
+static_assert((TELEM_ISR_RING_SIZE & (TELEM_ISR_RING_SIZE - 1)) == 0,
+              "TELEM_ISR_RING_SIZE debe ser potencia de dos");
+
+/** @brief Paquete en vuelo con el instante de su interrupción */
+typedef struct {
+  telemetry_packet_t packet;
+  int64_t capture_us;
+} isr_entry_t;
+
+/**
+ * @brief Anillo de una fuente
+ *
+ * @details head y los contadores del productor solo los escribe la ISR; tail
+ * y las estadísticas de fusión, solo el recolector.
+ */
+typedef struct {
+  const char* name;
+  uint32_t head;                /**< Entradas escritas (contador libre) */
+  uint32_t tail;                /**< Entradas consumidas (contador libre) */
+  uint32_t stored;
+  uint32_t overflows;
+  uint32_t merged;
+  uint32_t rejected;
+  uint32_t max_pending;
+  uint32_t max_latency_us;
+  uint64_t latency_sum_us;
+  isr_entry_t ring[TELEM_ISR_RING_SIZE];
+} isr_source_t;
+
+/** @brief Rondas del benchmark */
+#define ISR_BENCH_ROUNDS 64
+
+static isr_source_t sources[TELEM_ISR_MAX_SOURCES];
+static uint8_t source_count = 0;
+static telemetry_isr_notify_t isr_notify = NULL;
+static portMUX_TYPE isr_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+telem_isr_source_t telemetry_isr_register(const char* name) {
+  if(source_count >= TELEM_ISR_MAX_SOURCES) {
+    return TELEM_ISR_INVALID_SOURCE;
+  }
+  isr_source_t* source = &sources[source_count];
+  memset(source, 0, sizeof(*source));
+  source->name = name;
+  // Publicar la fuente antes de que la vea el recolector
+  __atomic_store_n(&source_count, (uint8_t)(source_count + 1), __ATOMIC_RELEASE);
+  return (telem_isr_source_t)(source_count - 1);
+}
+
+void telemetry_isr_set_notify(telemetry_isr_notify_t notify) {
+  __atomic_store_n(&isr_notify, notify, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Deja un paquete en el anillo (productor)
+ */
+static inline bool IRAM_ATTR isr_push(isr_source_t* src, const telemetry_packet_t* packet) {
+  int64_t capture_us = esp_timer_get_time();
+  uint32_t head = src->head;
+  if(head - __atomic_load_n(&src->tail, __ATOMIC_ACQUIRE) >= TELEM_ISR_RING_SIZE) {
+    __atomic_store_n(&src->overflows, src->overflows + 1, __ATOMIC_RELAXED);
+    return false;
+  }
+
+  isr_entry_t* entry = &src->ring[head & (TELEM_ISR_RING_SIZE - 1)];
+  memcpy(&entry->packet, packet, sizeof(entry->packet));
+  entry->capture_us = capture_us;
+  __atomic_store_n(&src->head, head + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&src->stored, src->stored + 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+/**
+ * @brief Vacía el anillo de una fuente (consumidor)
+ *
+ * @param stamp Sellar cada paquete con el siguiente número de secuencia; el
+ * benchmark no sella para no consumir la secuencia de los paquetes reales
+ * @return uint32_t Paquetes fusionados
+ */
+static uint32_t isr_drain_source(isr_source_t* src, telemetry_packet_sink_t sink, bool stamp) {
+  uint32_t tail = src->tail;
+  uint32_t head = __atomic_load_n(&src->head, __ATOMIC_ACQUIRE);
+  if(head == tail) {
+    return 0;
+  }
+
+  uint32_t pending = head - tail;
+  uint32_t merged = 0, rejected = 0, max_latency = 0;
+  uint64_t latency_sum = 0;
+  for(; tail != head; tail++) {
+    telemetry_packet_t packet = src->ring[tail & (TELEM_ISR_RING_SIZE - 1)].packet;
+    int64_t capture_us = src->ring[tail & (TELEM_ISR_RING_SIZE - 1)].capture_us;
+    // La ranura vuelve a la ISR en cuanto está copiada
+    __atomic_store_n(&src->tail, tail + 1, __ATOMIC_RELEASE);
+
+    if(stamp) {
+      uint32_t age_us = (uint32_t)(esp_timer_get_time() - capture_us);
+      telemetry_generators_stamp(&packet.header, age_us / 1000);
+    }
+    if(!sink(&packet)) {
+      rejected++;
+    }
+    // Latencia de traspaso: de la interrupción al buffer principal
+    uint32_t latency_us = (uint32_t)(esp_timer_get_time() - capture_us);
+    latency_sum += latency_us;
+    if(latency_us > max_latency) {
+      max_latency = latency_us;
+    }
+    merged++;
+  }
+
+  portENTER_CRITICAL(&isr_stats_mux);
+  src->merged += merged;
+  src->rejected += rejected;
+  src->latency_sum_us += latency_sum;
+  if(max_latency > src->max_latency_us) {
+    src->max_latency_us = max_latency;
+  }
+  if(pending > src->max_pending) {
+    src->max_pending = pending;
+  }
+  portEXIT_CRITICAL(&isr_stats_mux);
+  return merged;
+}
+
+bool IRAM_ATTR telemetry_store_packet_from_isr(telem_isr_source_t source, const telemetry_packet_t* packet,
+                                               BaseType_t* woken) {
+  if(source >= __atomic_load_n(&source_count, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  if(!isr_push(&sources[source], packet)) {
+    return false;
+  }
+
+  telemetry_isr_notify_t notify = __atomic_load_n(&isr_notify, __ATOMIC_ACQUIRE);
+  if(notify != NULL) {
+    BaseType_t local_woken = pdFALSE;
+    notify(woken != NULL ? woken : &local_woken);
+  }
+  return true;
+}
+
+uint32_t telemetry_isr_drain(telemetry_packet_sink_t sink) {
+  uint32_t total = 0;
+  uint8_t count = __atomic_load_n(&source_count, __ATOMIC_ACQUIRE);
+
+  for(uint8_t id = 0; id < count; id++) {
+    total += isr_drain_source(&sources[id], sink, true);
+  }
+  return total;
+}
+
+bool telemetry_isr_get_stats(telem_isr_source_t source, telemetry_isr_stats_t* stats) {
+  if(source >= __atomic_load_n(&source_count, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  isr_source_t* src = &sources[source];
+
+  stats->name = src->name;
+  stats->stored = __atomic_load_n(&src->stored, __ATOMIC_RELAXED);
+  stats->overflows = __atomic_load_n(&src->overflows, __ATOMIC_RELAXED);
+  portENTER_CRITICAL(&isr_stats_mux);
+  stats->merged = src->merged;
+  stats->rejected = src->rejected;
+  stats->max_pending = src->max_pending;
+  stats->max_latency_us = src->max_latency_us;
+  stats->avg_latency_us = src->merged > 0 ? (uint32_t)(src->latency_sum_us / src->merged) : 0;
+  portEXIT_CRITICAL(&isr_stats_mux);
+  return true;
+}
+
+void telemetry_isr_log_summary(void) {
+  telemetry_isr_stats_t stats;
+  uint8_t count = __atomic_load_n(&source_count, __ATOMIC_ACQUIRE);
+
+  for(uint8_t id = 0; id < count; id++) {
+    telemetry_isr_get_stats(id, &stats);
+    telemetry_logf("⚡ ISR %s: Stored=%lu | Overflows=%lu | Merged=%lu | Rejected=%lu | Max pending=%lu/%d | Handoff avg=%luus max=%luus",
+                   stats.name, stats.stored, stats.overflows, stats.merged, stats.rejected,
+                   stats.max_pending, TELEM_ISR_RING_SIZE, stats.avg_latency_us, stats.max_latency_us);
+  }
+}
+
+static uint32_t bench_sunk;
+
+/**
+ * @brief Fuente del benchmark: fuera del registro, no ocupa una fuente real
+ */
+static isr_source_t bench_source;
+
+/**
+ * @brief Destino del benchmark: solo cuenta
+ */
+static bool bench_sink(const telemetry_packet_t* packet) {
+  (void)packet;
+  bench_sunk++;
+  return true;
+}
+
+void telemetry_isr_benchmark(void) {
+  isr_source_t* source = &bench_source;
+  memset(source, 0, sizeof(*source));
+  source->name = "bench";
+
+  telemetry_packet_t packet;
+  memset(&packet, 0, sizeof(packet));
+  packet.header.type = TELEM_TEMPERATURE_DATA;
+  packet.header.priority = 1;
+
+  // Productor: lo que añade cada paquete a la ISR
+  uint32_t push_cycles = 0, drain_cycles = 0, pushes = 0;
+  bench_sunk = 0;
+  for(int round = 0; round < ISR_BENCH_ROUNDS; round++) {
+    uint32_t start = ESP.getCycleCount();
+    for(int i = 0; i < TELEM_ISR_RING_SIZE; i++) {
+      pushes += isr_push(source, &packet) ? 1 : 0;
+    }
+    push_cycles += ESP.getCycleCount() - start;
+
+    start = ESP.getCycleCount();
+    isr_drain_source(source, bench_sink, false);
+    drain_cycles += ESP.getCycleCount() - start;
+  }
+
+  // Desborde: el doble de lo que cabe sin vaciar
+  for(int i = 0; i < 2 * TELEM_ISR_RING_SIZE; i++) {
+    isr_push(source, &packet);
+  }
+  isr_drain_source(source, bench_sink, false);
+
+  telemetry_logf("⚡ ISR store: %lu cycles/packet in the ISR | merge %lu cycles/packet | %lu/%lu merged | Overflows=%lu (expected %d) | Handoff max=%luus",
+                 push_cycles / (pushes > 0 ? pushes : 1),
+                 drain_cycles / (pushes > 0 ? pushes : 1),
+                 bench_sunk, source->stored, source->overflows, TELEM_ISR_RING_SIZE,
+                 source->max_latency_us);
+}
@@ -0,0 +1,196 @@
+/**
+ * @file telemetry_lock.cpp
+ * @brief Implementación del mutex instrumentado
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include "../include/telemetry_lock.h"
+
+#if TELEM_LOCK_PROFILING
+
+#include <string.h>
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "../include/telemetry_generators.h"
+#include "../include/telemetry_logger.h"
+
+static_assert(sizeof(lock_profile_telem_t) <= sizeof(telemetry_packet_t),
+              "El resumen de un cerrojo debe caber en un paquete");
+
+static telemetry_lock_t* locks[TELEM_LOCK_MAX];
+static uint8_t lock_count = 0;
+static uint8_t next_report = 0;
+static portMUX_TYPE lock_timeout_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Intervalo del histograma: base 4 desde 4 µs, el último abierto
+ */
+static uint8_t lock_bin(uint32_t us) {
+  uint8_t bin = 0;
+  while(us >= 4 && bin < TELEM_LOCK_HIST_BINS - 1) {
+    us >>= 2;
+    bin++;
+  }
+  return bin;
+}
+
+bool telemetry_lock_create(telemetry_lock_t* lock, const char* name) {
+  memset(lock, 0, sizeof(*lock));
+  lock->name = name;
+  lock->handle = xSemaphoreCreateMutex();
+  if(lock->handle == NULL) {
+    return false;
+  }
+
+  if(lock_count < TELEM_LOCK_MAX) {
+    lock->id = lock_count;
+    locks[lock_count++] = lock;
+  } else {
+    lock->id = UINT8_MAX; // Funciona, pero no sale en los resúmenes
+  }
+  return true;
+}
+
+bool telemetry_lock_take(telemetry_lock_t* lock, TickType_t timeout) {
+  int64_t start = esp_timer_get_time();
+  bool contended = false;
+
+  if(xSemaphoreTake(lock->handle, 0) != pdTRUE) {
+    contended = true;
+    if(timeout == 0 || xSemaphoreTake(lock->handle, timeout) != pdTRUE) {
+      // Sin el cerrojo: el dueño puede estar liberándolo mientras tanto
+      TaskHandle_t owner = xSemaphoreGetMutexHolder(lock->handle);
+      const char* owner_name = owner != NULL ? pcTaskGetName(owner) : "-";
+      portENTER_CRITICAL(&lock_timeout_mux);
+      lock->timeouts++;
+      strncpy(lock->timeout_owner, owner_name, TELEM_LOCK_NAME_LEN - 1);
+      lock->timeout_owner[TELEM_LOCK_NAME_LEN - 1] = '\0';
+      portEXIT_CRITICAL(&lock_timeout_mux);
+      return false;
+    }
+  }
+
+  // Con el cerrojo: nadie más escribe estas estadísticas
+  int64_t now = esp_timer_get_time();
+  uint32_t wait_us = (uint32_t)(now - start);
+  lock->taken_us = now;
+  lock->acquires++;
+  if(contended) {
+    lock->contended++;
+  }
+  if(wait_us > lock->max_wait_us) {
+    lock->max_wait_us = wait_us;
+  }
+  lock->wait_hist[lock_bin(wait_us)]++;
+  return true;
+}
+
+void telemetry_lock_give(telemetry_lock_t* lock) {
+  uint32_t hold_us = (uint32_t)(esp_timer_get_time() - lock->taken_us);
+  if(hold_us > lock->max_hold_us) {
+    lock->max_hold_us = hold_us;
+  }
+  lock->hold_hist[lock_bin(hold_us)]++;
+  xSemaphoreGive(lock->handle);
+}
+
+/**
+ * @brief Copia coherente de un cerrojo, tomada con el propio cerrojo
+ */
+static bool lock_snapshot(telemetry_lock_t* lock, telemetry_lock_t* copy) {
+  if(xSemaphoreTake(lock->handle, pdMS_TO_TICKS(50)) != pdTRUE) {
+    return false;
+  }
+  portENTER_CRITICAL(&lock_timeout_mux);
+  *copy = *lock;
+  portEXIT_CRITICAL(&lock_timeout_mux);
+  xSemaphoreGive(lock->handle);
+  return true;
+}
+
+/**
+ * @brief Histograma en medios puntos porcentuales (0..200)
+ */
+static void lock_half_percent(const uint32_t* hist, uint8_t* half_percent) {
+  uint64_t total = 0;
+  for(int bin = 0; bin < TELEM_LOCK_HIST_BINS; bin++) {
+    total += hist[bin];
+  }
+  for(int bin = 0; bin < TELEM_LOCK_HIST_BINS; bin++) {
+    half_percent[bin] = total > 0 ? (uint8_t)((hist[bin] * 200ULL + total / 2) / total) : 0;
+  }
+}
+
+/**
+ * @brief Rellena el paquete de resumen con el siguiente cerrojo en turno
+ */
+static void fill_lock_profile(telemetry_packet_t* packet) {
+  lock_profile_telem_t* profile = (lock_profile_telem_t*)packet;
+  telemetry_lock_t copy;
+
+  if(lock_count == 0) {
+    profile->lock_id = UINT8_MAX;
+    return;
+  }
+  uint8_t id = next_report;
+  next_report = (uint8_t)((next_report + 1) % lock_count);
+  if(!lock_snapshot(locks[id], &copy)) {
+    // Cerrojo ocupado: se envían los contadores sin el estado de la adquisición en curso
+    copy = *locks[id];
+  }
+
+  profile->lock_id = id;
+  memcpy(profile->timeout_owner, copy.timeout_owner, sizeof(profile->timeout_owner));
+  profile->acquires = copy.acquires;
+  profile->contended = copy.contended;
+  profile->timeouts = copy.timeouts;
+  profile->max_wait_us = copy.max_wait_us;
+  profile->max_hold_us = copy.max_hold_us;
+  lock_half_percent(copy.wait_hist, profile->wait_hist);
+  lock_half_percent(copy.hold_hist, profile->hold_hist);
+}
+
+static const telemetry_generator_t lock_profile_generator =
+  { TELEM_LOCK_PROFILE_TYPE, 0, TELEM_LOCK_PROFILE_PERIOD_MS, fill_lock_profile };
+
+bool telemetry_lock_register_generator(void) {
+  return telemetry_generator_register(&lock_profile_generator);
+}
+
+void telemetry_lock_log_summary(void) {
+  telemetry_lock_t copy;
+
+  for(uint8_t id = 0; id < lock_count; id++) {
+    if(!lock_snapshot(locks[id], &copy)) {
+      telemetry_logf("🔒 LOCK %s: busy, no snapshot", locks[id]->name);
+      continue;
+    }
+
+    // Percentil 99 de la retención: primer intervalo que acumula el 99 %
+    uint64_t total = 0;
+    for(int bin = 0; bin < TELEM_LOCK_HIST_BINS; bin++) {
+      total += copy.hold_hist[bin];
+    }
+    uint64_t seen = 0;
+    int p99_bin = 0;
+    for(; p99_bin < TELEM_LOCK_HIST_BINS - 1; p99_bin++) {
+      seen += copy.hold_hist[p99_bin];
+      if(seen * 100 >= total * 99) {
+        break;
+      }
+    }
+
+    // En el último intervalo, abierto, solo se conoce la cota inferior
+    bool open_bin = p99_bin == TELEM_LOCK_HIST_BINS - 1;
+    unsigned long p99_bound = 4UL << (2 * (open_bin ? p99_bin - 1 : p99_bin));
+
+    telemetry_logf("🔒 LOCK %s: Acquired=%lu | Contended=%lu (%.1f%%) | Timeouts=%lu (last owner %s) | Max wait=%luus | Max hold=%luus | Hold p99 %s%luus",
+                   copy.name, copy.acquires, copy.contended,
+                   copy.acquires > 0 ? copy.contended * 100.0 / copy.acquires : 0.0,
+                   copy.timeouts, copy.timeouts > 0 ? copy.timeout_owner : "-",
+                   copy.max_wait_us, copy.max_hold_us, open_bin ? ">=" : "<", p99_bound);
+  }
+}
+
+#endif // TELEM_LOCK_PROFILING
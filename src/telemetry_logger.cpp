@@ -7,18 +7,70 @@
  * @details  Este módulo implementa un logger simple de telemetría
  * que escribe mensajes formateados en un archivo de LittleFS.
  * El logger también imprime los mensajes en el puerto serie. 
+ * Las líneas de la tarea diferida van a un buffer circular en RAM y se
+ * escriben en telemetry_log_flush().
  */
 
 #include <Arduino.h>
 #include <FS.h>
 #include <LittleFS.h>
 #include <stdarg.h>
+#include <string.h>
 #include "../include/telemetry_logger.h"
+#include "../include/telemetry_energy.h"
 
 
-// Implementación mínima sin mutex (solo usada desde loop/setup)
+/** @brief Longitud máxima de una línea (sin el fin de línea) */
+#define LOG_LINE_MAX 159
+
+// Implementación mínima sin mutex: Serial y LittleFS serializan sus escrituras
 static bool s_logger_ready = false;
 
+// Líneas diferidas: índices libres (se reducen módulo el tamaño al acceder)
+static char s_deferred[TELEM_LOG_DEFER_BYTES];
+static uint32_t s_deferred_head = 0;
+static uint32_t s_deferred_tail = 0;
+static uint32_t s_deferred_dropped = 0;
+static TaskHandle_t s_deferred_task = NULL;
+static portMUX_TYPE s_deferred_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Copia una línea con su fin de línea al buffer diferido, entera o nada
+ */
+static void logger_defer_line(const char *line) {
+    size_t length = strlen(line);
+    portENTER_CRITICAL(&s_deferred_mux);
+    if (s_deferred_head - s_deferred_tail + length + 2 > TELEM_LOG_DEFER_BYTES) {
+        s_deferred_dropped++;
+    } else {
+        for (size_t i = 0; i < length; i++) {
+            s_deferred[s_deferred_head++ % TELEM_LOG_DEFER_BYTES] = line[i];
+        }
+        s_deferred[s_deferred_head++ % TELEM_LOG_DEFER_BYTES] = '\r';
+        s_deferred[s_deferred_head++ % TELEM_LOG_DEFER_BYTES] = '\n';
+    }
+    portEXIT_CRITICAL(&s_deferred_mux);
+}
+
+/**
+ * @brief Saca la siguiente línea diferida (con su fin de línea)
+ *
+ * @return size_t Bytes copiados, 0 si no quedan líneas
+ */
+static size_t logger_next_deferred(char *line, size_t capacity) {
+    size_t length = 0;
+    portENTER_CRITICAL(&s_deferred_mux);
+    while (s_deferred_tail != s_deferred_head && length < capacity) {
+        char c = s_deferred[s_deferred_tail++ % TELEM_LOG_DEFER_BYTES];
+        line[length++] = c;
+        if (c == '\n') {
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_deferred_mux);
+    return length;
+}
+
 bool telemetry_logger_init(void) {
     if (!LittleFS.begin(true)) {
         Serial.println("[Logger] ERROR montando LittleFS");
@@ -31,23 +83,65 @@ bool telemetry_logger_init(void) {
 
 void telemetry_logf(const char *fmt, ...) {
     if (!s_logger_ready) return;
-    char buffer[160];
+    char buffer[LOG_LINE_MAX + 1];
     va_list args;
     va_start(args, fmt);
     vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
 
+    // La tarea diferida no espera a la UART ni a la flash
+    TaskHandle_t deferred = __atomic_load_n(&s_deferred_task, __ATOMIC_ACQUIRE);
+    if (deferred != NULL && xTaskGetCurrentTaskHandle() == deferred) {
+        logger_defer_line(buffer);
+        return;
+    }
+
     // Serial
-    Serial.println(buffer);
+    size_t sent = Serial.println(buffer);
+    telemetry_energy_add_uart(sent);
 
     // Archivo
     File f = LittleFS.open(TELEMETRY_LOG_FILE, FILE_APPEND);
     if (f) {
-        f.println(buffer);
+        size_t written = f.println(buffer);
+        f.close();
+        telemetry_energy_add_flash(written);
+    }
+}
+
+void telemetry_logger_defer_task(TaskHandle_t task) {
+    __atomic_store_n(&s_deferred_task, task, __ATOMIC_RELEASE);
+}
+
+void telemetry_log_flush(void) {
+    if (!s_logger_ready) return;
+    char line[LOG_LINE_MAX + 2];
+    File f;
+    bool opened = false;
+    size_t length;
+
+    while ((length = logger_next_deferred(line, sizeof(line))) > 0) {
+        size_t sent = Serial.write((const uint8_t *)line, length);
+        telemetry_energy_add_uart(sent);
+
+        if (!opened) {
+            f = LittleFS.open(TELEMETRY_LOG_FILE, FILE_APPEND);
+            opened = true;
+        }
+        if (f) {
+            size_t written = f.write((const uint8_t *)line, length);
+            telemetry_energy_add_flash(written);
+        }
+    }
+    if (f) {
         f.close();
     }
 }
 
+uint32_t telemetry_log_dropped(void) {
+    return __atomic_load_n(&s_deferred_dropped, __ATOMIC_RELAXED);
+}
+
 void telemetry_dump_log(void) {
     if (!s_logger_ready) {
         Serial.println("[Logger] No listo para dump");
@@ -65,6 +159,7 @@ void telemetry_dump_log(void) {
         Serial.write(f.read());
     }
     f.close();
+    telemetry_energy_add_uart(sz);
     Serial.println("[Logger] --- END ---");
     Serial.println("[Logger] <<< END FILE DUMP\n");
 }
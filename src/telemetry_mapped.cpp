@@ -0,0 +1,268 @@
+/**
+ * @file telemetry_mapped.cpp
+ * @brief Implementación de la partición de archivo mapeada en memoria
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * La partición se mapea una sola vez al iniciar. La escritura usa
+ * esp_partition_erase_range()/esp_partition_write(), que invalidan la caché
+ * de la región modificada, por lo que las lecturas posteriores a través del
+ * mapeo ven los datos nuevos sin volver a mapear.
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include "esp_partition.h"
+#include "../include/telemetry_mapped.h"
+#include "../include/telemetry_retention.h"
+#include "../include/telemetry_energy.h"
+
+#define MAPPED_RECORDS_PER_BLOCK (TELEM_ARCHIVE_BLOCK_SIZE / sizeof(telem_archive_record_t))
+#define MAPPED_FOOTER_OFFSET (TELEM_MAPPED_SLOT_SIZE - TELEM_ARCHIVE_BLOCK_SIZE)
+
+static const esp_partition_t* mapped_partition = NULL;
+static const uint8_t* mapped_base = NULL;
+static spi_flash_mmap_handle_t mapped_handle;
+
+static uint32_t slot_count = 0;                          /**< Ranuras de la partición */
+static uint8_t slot_order[TELEM_MAPPED_MAX_SLOTS];       /**< Ranuras publicadas, de la más antigua a la más reciente */
+static uint32_t published = 0;                           /**< Entradas válidas en slot_order */
+static uint32_t next_generation = 1;
+
+static int32_t writing_slot = -1;                        /**< Ranura en escritura (-1 si ninguna) */
+static uint32_t writing_segment = 0;
+
+/**
+ * @brief Pie de una ranura física en la flash mapeada
+ */
+static const telem_mapped_footer_t* mapped_slot_footer(uint32_t slot) {
+  return (const telem_mapped_footer_t*)(mapped_base + slot * TELEM_MAPPED_SLOT_SIZE + MAPPED_FOOTER_OFFSET);
+}
+
+/**
+ * @brief Comprueba si una ranura física está sellada y su pie es íntegro
+ */
+static bool mapped_slot_valid(uint32_t slot) {
+  const telem_mapped_footer_t* footer = mapped_slot_footer(slot);
+  return footer->magic == TELEM_MAPPED_MAGIC &&
+         footer->crc == telemetry_retention_crc(footer, offsetof(telem_mapped_footer_t, crc));
+}
+
+/**
+ * @brief Elimina una ranura física del orden de publicación
+ */
+static void mapped_forget_slot(uint32_t slot) {
+  uint32_t out = 0;
+  for(uint32_t i = 0; i < published; i++) {
+    if(slot_order[i] != slot) {
+      slot_order[out++] = slot_order[i];
+    }
+  }
+  published = out;
+}
+
+bool telemetry_mapped_init(void) {
+  // El mapeo se hace una vez; los pies se vuelven a leer en cada llamada
+  if(mapped_base == NULL) {
+    mapped_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                TELEM_MAPPED_PARTITION);
+    if(mapped_partition == NULL) {
+      return false;
+    }
+
+    const void* base;
+    if(esp_partition_mmap(mapped_partition, 0, mapped_partition->size, SPI_FLASH_MMAP_DATA,
+                          &base, &mapped_handle) != ESP_OK) {
+      mapped_partition = NULL;
+      return false;
+    }
+    mapped_base = (const uint8_t*)base;
+  }
+  writing_slot = -1;
+
+  slot_count = mapped_partition->size / TELEM_MAPPED_SLOT_SIZE;
+  if(slot_count > TELEM_MAPPED_MAX_SLOTS) {
+    slot_count = TELEM_MAPPED_MAX_SLOTS;
+  }
+
+  // Ordenación por inserción de las ranuras válidas según su generación
+  published = 0;
+  for(uint32_t slot = 0; slot < slot_count; slot++) {
+    if(!mapped_slot_valid(slot)) {
+      continue;
+    }
+    uint32_t generation = mapped_slot_footer(slot)->generation;
+    uint32_t i = published++;
+    while(i > 0 && mapped_slot_footer(slot_order[i - 1])->generation > generation) {
+      slot_order[i] = slot_order[i - 1];
+      i--;
+    }
+    slot_order[i] = (uint8_t)slot;
+    if(generation >= next_generation) {
+      next_generation = generation + 1;
+    }
+  }
+  return true;
+}
+
+bool telemetry_mapped_available(void) {
+  return mapped_base != NULL;
+}
+
+bool telemetry_mapped_begin(uint32_t source_segment) {
+  uint32_t slot;
+
+  if(mapped_base == NULL || slot_count == 0) {
+    return false;
+  }
+
+  // Primero una ranura libre; si no hay, la publicada más antigua
+  for(slot = 0; slot < slot_count; slot++) {
+    if(!mapped_slot_valid(slot)) {
+      break;
+    }
+  }
+  if(slot == slot_count) {
+    slot = slot_order[0];
+  }
+
+  mapped_forget_slot(slot);
+  if(esp_partition_erase_range(mapped_partition, slot * TELEM_MAPPED_SLOT_SIZE, TELEM_MAPPED_SLOT_SIZE) != ESP_OK) {
+    writing_slot = -1;
+    return false;
+  }
+
+  writing_slot = (int32_t)slot;
+  writing_segment = source_segment;
+  return true;
+}
+
+bool telemetry_mapped_write_block(uint32_t block, const void* data) {
+  if(writing_slot < 0 || (block + 1) * TELEM_ARCHIVE_BLOCK_SIZE > MAPPED_FOOTER_OFFSET) {
+    return false;
+  }
+
+  size_t offset = writing_slot * TELEM_MAPPED_SLOT_SIZE + block * TELEM_ARCHIVE_BLOCK_SIZE;
+  if(esp_partition_write(mapped_partition, offset, data, TELEM_ARCHIVE_BLOCK_SIZE) != ESP_OK) {
+    return false;
+  }
+  telemetry_energy_add_flash(TELEM_ARCHIVE_BLOCK_SIZE);
+  return true;
+}
+
+bool telemetry_mapped_seal(const telem_zone_map_t* zone) {
+  telem_mapped_footer_t footer;
+
+  if(writing_slot < 0) {
+    return false;
+  }
+
+  memset(&footer, 0, sizeof(footer));
+  footer.zone = *zone;
+  footer.magic = TELEM_MAPPED_MAGIC;
+  footer.generation = next_generation++;
+  footer.source_segment = writing_segment;
+  footer.crc = telemetry_retention_crc(&footer, offsetof(telem_mapped_footer_t, crc));
+
+  size_t offset = writing_slot * TELEM_MAPPED_SLOT_SIZE + MAPPED_FOOTER_OFFSET;
+  bool ok = esp_partition_write(mapped_partition, offset, &footer, sizeof(footer)) == ESP_OK;
+  if(ok) {
+    slot_order[published++] = (uint8_t)writing_slot;
+    telemetry_energy_add_flash(sizeof(footer));
+  }
+  writing_slot = -1;
+  return ok;
+}
+
+uint32_t telemetry_mapped_slots(void) {
+  return published;
+}
+
+const telem_mapped_footer_t* telemetry_mapped_footer(uint32_t position) {
+  if(position >= published) {
+    return NULL;
+  }
+  return mapped_slot_footer(slot_order[position]);
+}
+
+/**
+ * @brief Posición en el orden de publicación de la primera ranura con generación >= generation
+ */
+static uint32_t mapped_position_from(uint32_t generation) {
+  uint32_t position = 0;
+  while(position < published && mapped_slot_footer(slot_order[position])->generation < generation) {
+    position++;
+  }
+  return position;
+}
+
+void telemetry_mapped_cursor_begin(telemetry_mapped_cursor_t* cursor) {
+  cursor->generation = 0;
+  cursor->record = 0;
+}
+
+const telem_mapped_footer_t* telemetry_mapped_cursor_footer(telemetry_mapped_cursor_t* cursor) {
+  uint32_t position = mapped_position_from(cursor->generation);
+  if(position >= published) {
+    return NULL;
+  }
+
+  const telem_mapped_footer_t* footer = mapped_slot_footer(slot_order[position]);
+  if(footer->generation != cursor->generation) {
+    // Ranura nueva (o la anterior se reutilizó): se empieza por su primer registro
+    cursor->generation = footer->generation;
+    cursor->record = 0;
+  }
+  return footer;
+}
+
+void telemetry_mapped_cursor_skip(telemetry_mapped_cursor_t* cursor) {
+  const telem_mapped_footer_t* footer = telemetry_mapped_cursor_footer(cursor);
+  if(footer != NULL) {
+    cursor->generation = footer->generation + 1;
+    cursor->record = 0;
+  }
+}
+
+uint32_t telemetry_mapped_generation_of(const telem_zone_map_t* zone) {
+  for(uint32_t position = 0; position < published; position++) {
+    const telem_mapped_footer_t* footer = mapped_slot_footer(slot_order[position]);
+    if(memcmp(&footer->zone, zone, sizeof(*zone)) == 0) {
+      return footer->generation;
+    }
+  }
+  return 0;
+}
+
+const telemetry_packet_t* telemetry_mapped_next_in_slot(telemetry_mapped_cursor_t* cursor) {
+  const telem_mapped_footer_t* footer = telemetry_mapped_cursor_footer(cursor);
+  if(footer == NULL) {
+    return NULL;
+  }
+
+  const uint8_t* slot = (const uint8_t*)footer - MAPPED_FOOTER_OFFSET;
+  while(cursor->record < footer->zone.records) {
+    uint32_t block = cursor->record / MAPPED_RECORDS_PER_BLOCK;
+    uint32_t index = cursor->record % MAPPED_RECORDS_PER_BLOCK;
+    const telem_archive_record_t* record =
+      (const telem_archive_record_t*)(slot + block * TELEM_ARCHIVE_BLOCK_SIZE) + index;
+    cursor->record++;
+
+    if(record->crc == telemetry_retention_crc(&record->packet, sizeof(record->packet))) {
+      return &record->packet;
+    }
+  }
+
+  cursor->generation = footer->generation + 1;
+  cursor->record = 0;
+  return NULL;
+}
+
+const telemetry_packet_t* telemetry_mapped_next(telemetry_mapped_cursor_t* cursor) {
+  const telemetry_packet_t* packet = NULL;
+  while(packet == NULL && telemetry_mapped_cursor_footer(cursor) != NULL) {
+    packet = telemetry_mapped_next_in_slot(cursor);
+  }
+  return packet;
+}
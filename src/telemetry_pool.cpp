@@ -0,0 +1,100 @@
+/**
+ * @file telemetry_pool.cpp
+ * @brief Implementación del pool de paquetes con contador de referencias
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * La lista de bloques libres es una pila de Treiber: la cabeza combina en 32
+ * bits el índice del primer bloque libre (16 bits bajos) y una etiqueta que
+ * se incrementa en cada cambio (16 bits altos) para evitar el problema ABA.
+ * Todas las operaciones usan las primitivas atómicas de GCC, soportadas por
+ * el Xtensa del ESP32 con la instrucción S32C1I.
+ */
+
+#include "../include/telemetry_pool.h"
+
+static telemetry_packet_t pool_blocks[TELEM_POOL_SIZE];   /**< Memoria de los bloques */
+static uint16_t pool_next[TELEM_POOL_SIZE];               /**< Enlace de la lista libre */
+static uint16_t pool_refcount[TELEM_POOL_SIZE];           /**< Referencias por bloque */
+static uint32_t pool_free_head = TELEM_POOL_INVALID;      /**< Etiqueta | índice del primer libre */
+
+static uint32_t pool_in_use = 0;
+static uint32_t pool_high_water = 0;
+static uint32_t pool_exhausted = 0;
+
+/**
+ * @brief Construye una nueva cabeza con la etiqueta incrementada
+ */
+static inline uint32_t pool_make_head(uint32_t old_head, uint16_t index) {
+  return ((old_head + 0x10000u) & 0xFFFF0000u) | index;
+}
+
+/**
+ * @brief Devuelve un bloque a la lista libre
+ */
+static void pool_push(uint16_t index) {
+  uint32_t head = __atomic_load_n(&pool_free_head, __ATOMIC_ACQUIRE);
+  uint32_t new_head;
+  do {
+    pool_next[index] = (uint16_t)(head & 0xFFFFu);
+    new_head = pool_make_head(head, index);
+  } while(!__atomic_compare_exchange_n(&pool_free_head, &head, new_head, true,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  __atomic_fetch_sub(&pool_in_use, 1, __ATOMIC_RELAXED);
+}
+
+void telemetry_pool_init(void) {
+  for(uint16_t i = 0; i < TELEM_POOL_SIZE; i++) {
+    pool_next[i] = (i + 1 < TELEM_POOL_SIZE) ? (uint16_t)(i + 1) : (uint16_t)TELEM_POOL_INVALID;
+    pool_refcount[i] = 0;
+  }
+  pool_in_use = 0;
+  pool_high_water = 0;
+  pool_exhausted = 0;
+  __atomic_store_n(&pool_free_head, 0u, __ATOMIC_RELEASE);
+}
+
+telem_pool_handle_t telemetry_pool_alloc(void) {
+  uint32_t head = __atomic_load_n(&pool_free_head, __ATOMIC_ACQUIRE);
+  uint16_t index;
+  do {
+    index = (uint16_t)(head & 0xFFFFu);
+    if(index == TELEM_POOL_INVALID) {
+      __atomic_fetch_add(&pool_exhausted, 1, __ATOMIC_RELAXED);
+      return TELEM_POOL_INVALID;
+    }
+  } while(!__atomic_compare_exchange_n(&pool_free_head, &head, pool_make_head(head, pool_next[index]),
+                                       true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+  __atomic_store_n(&pool_refcount[index], (uint16_t)1, __ATOMIC_RELEASE);
+
+  // Máximo histórico: solo se actualiza si este valor lo supera
+  uint32_t in_use = __atomic_add_fetch(&pool_in_use, 1, __ATOMIC_RELAXED);
+  uint32_t high_water = __atomic_load_n(&pool_high_water, __ATOMIC_RELAXED);
+  while(in_use > high_water &&
+        !__atomic_compare_exchange_n(&pool_high_water, &high_water, in_use, true,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+  return index;
+}
+
+void telemetry_pool_retain(telem_pool_handle_t handle) {
+  __atomic_fetch_add(&pool_refcount[handle], 1, __ATOMIC_RELAXED);
+}
+
+void telemetry_pool_release(telem_pool_handle_t handle) {
+  if(__atomic_sub_fetch(&pool_refcount[handle], 1, __ATOMIC_ACQ_REL) == 0) {
+    pool_push(handle);
+  }
+}
+
+telemetry_packet_t* telemetry_pool_get(telem_pool_handle_t handle) {
+  return &pool_blocks[handle];
+}
+
+void telemetry_pool_get_stats(uint32_t* in_use, uint32_t* high_water, uint32_t* exhausted) {
+  *in_use = __atomic_load_n(&pool_in_use, __ATOMIC_RELAXED);
+  *high_water = __atomic_load_n(&pool_high_water, __ATOMIC_RELAXED);
+  *exhausted = __atomic_load_n(&pool_exhausted, __ATOMIC_RELAXED);
+}
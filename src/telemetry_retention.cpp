@@ -0,0 +1,38 @@
+/**
+ * @file telemetry_retention.cpp
+ * @brief Utilidades de conservación de estado tras reinicios en caliente
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Implementa la detección de reinicios en caliente a partir de la causa de
+ * reset del ESP32 y el cálculo de CRC32 usado para validar los bloques de
+ * memoria retenidos.
+ */
+
+#include "esp_system.h"
+#include "esp_rom_crc.h"
+#include "../include/telemetry_retention.h"
+
+bool telemetry_retention_warm_boot(void) {
+  switch(esp_reset_reason()) {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_BROWNOUT:
+      return true;
+    default:
+      // Encendido, reset externo o salida de deep sleep: la DRAM no es fiable
+      return false;
+  }
+}
+
+bool telemetry_retention_rtc_preserved(void) {
+  return telemetry_retention_warm_boot() || esp_reset_reason() == ESP_RST_DEEPSLEEP;
+}
+
+uint32_t telemetry_retention_crc(const void* data, size_t len) {
+  return esp_rom_crc32_le(0, (const uint8_t*)data, (uint32_t)len);
+}
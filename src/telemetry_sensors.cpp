@@ -0,0 +1,250 @@
+/**
+ * @file telemetry_sensors.cpp
+ * @brief Implementación del barrido multicanal de sensores
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * El barrido lo lanza el recolector al empezar cada ciclo y los generadores
+ * solo leen el marco, siempre desde la misma tarea, así que no hace falta
+ * exclusión mutua. Las entradas ADC se convierten en punto fijo con su tabla
+ * de calibración (telemetry_calibration.h): el NTC desde cuentas brutas y la
+ * batería desde los mV del pin, ya corregidos con la calibración del eFuse.
+ *
+ * Las entradas que cuelgan de un bus se piden al gestor de buses
+ * (telemetry_bus.h) al principio del barrido y se recogen al final, de modo
+ * que la transferencia I2C se solapa con las conversiones del ADC. Si el bus
+ * no está operativo o la lectura falla, sus canales toman el valor nominal.
+ *
+ * La ISR de la línea ALERT no lee el marco de muestras: copia un paquete de
+ * alerta que cada barrido deja preparado. Hay dos copias y el barrido
+ * escribe la que la ISR no está usando antes de publicarla, así que la ISR
+ * nunca ve las medidas de dos barridos mezcladas.
+ */
+
+#include <Arduino.h>
+#include <ESPCPUTemp.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "../include/telemetry_sensors.h"
+#include "../include/telemetry_calibration.h"
+#include "../include/telemetry_bus.h"
+#include "../include/telemetry_isr.h"
+
+#ifdef WOKWI
+#define SENSOR_EXTERNAL_WIRED true
+#else
+#define SENSOR_EXTERNAL_WIRED false
+#endif
+
+/** @brief Entradas ADC con hardware detrás; el resto usa el valor nominal de sus canales */
+static const bool input_wired[TELEM_SENSOR_INPUT_COUNT] = {
+  SENSOR_EXTERNAL_WIRED,  // NTC_TEMPERATURE
+  SENSOR_EXTERNAL_WIRED,  // BATTERY_DIVIDER
+  false,                  // BATTERY_SHUNT (por bus, ver bus_inputs)
+  true                    // CPU_TEMPERATURE (sensor interno del ESP32)
+};
+
+/** @brief Entrada leída por bus: registro de 16 bits big-endian de un dispositivo */
+typedef struct {
+  telem_sensor_input_t input;
+  uint8_t bus;
+  uint8_t device;
+  uint8_t reg;
+  float scale;               /**< Unidades de la entrada por cuenta del registro */
+} sensor_bus_input_t;
+
+static const sensor_bus_input_t bus_inputs[] = {
+  // Tensión de shunt del monitor de batería: 10 µV por cuenta
+  { TELEM_INPUT_BATTERY_SHUNT, TELEM_BUS_I2C0, 0x40, 0x01, 10e-6f / TELEM_SENSOR_SHUNT_OHMS },
+};
+#define SENSOR_BUS_INPUT_COUNT (sizeof(bus_inputs) / sizeof(bus_inputs[0]))
+
+/**
+ * @brief Descriptores de las lecturas por bus
+ *
+ * @details Estáticos: si una lectura no termina dentro del barrido, la tarea
+ * del bus la sigue teniendo y no se vuelve a pedir hasta que termine.
+ */
+static telemetry_bus_txn_t bus_txns[SENSOR_BUS_INPUT_COUNT];
+static uint8_t bus_data[SENSOR_BUS_INPUT_COUNT][2];
+static bool bus_in_flight[SENSOR_BUS_INPUT_COUNT];
+
+static telemetry_sample_frame_t sample_frame;
+static telemetry_sensor_stats_t sensor_stats;
+
+/** @brief Paquetes de alerta preparados por el barrido (dos copias) */
+static telemetry_packet_t alert_packets[2];
+/** @brief Copia que usa la ISR */
+static uint8_t alert_current = 0;
+static telem_isr_source_t alert_source = TELEM_ISR_INVALID_SOURCE;
+
+/** @brief Mayor entrada de una tabla de calibración */
+#define SENSOR_CAL_INPUT_MAX ((1u << TELEM_CAL_ADC_BITS) - 1)
+
+/**
+ * @brief Convierte una lectura con la tabla de su canal
+ */
+static float sensor_calibrated(telem_cal_channel_t channel, uint32_t input) {
+  uint16_t value = (uint16_t)(input > SENSOR_CAL_INPUT_MAX ? SENSOR_CAL_INPUT_MAX : input);
+  return TELEM_Q16_TO_FLOAT(telemetry_calibrate(channel, value));
+}
+
+/**
+ * @brief Convierte una entrada física
+ */
+static float sensor_convert(telem_sensor_input_t input) {
+  switch(input) {
+    case TELEM_INPUT_NTC_TEMPERATURE:
+      return sensor_calibrated(TELEM_CAL_NTC_TEMPERATURE, (uint32_t)analogRead(TELEM_SENSOR_NTC_PIN));
+    case TELEM_INPUT_BATTERY_DIVIDER:
+      return sensor_calibrated(TELEM_CAL_BATTERY_VOLTAGE, analogReadMilliVolts(TELEM_SENSOR_VBAT_PIN));
+    case TELEM_INPUT_CPU_TEMPERATURE:
+      return temperatureRead();
+    default:
+      return 0.0f;
+  }
+}
+
+/**
+ * @brief Pide al gestor de buses las lecturas del barrido
+ *
+ * @param submitted Lecturas que quedaron en cola
+ * @return uint32_t Número de lecturas en cola
+ */
+static uint32_t sensor_bus_submit(bool* submitted) {
+  uint32_t count = 0;
+  for(size_t i = 0; i < SENSOR_BUS_INPUT_COUNT; i++) {
+    telemetry_bus_txn_t* txn = &bus_txns[i];
+    submitted[i] = false;
+    if(bus_in_flight[i] && txn->status == TELEM_BUS_PENDING) {
+      continue; // La lectura anterior sigue en el bus
+    }
+    memset(txn, 0, sizeof(*txn));
+    txn->bus = bus_inputs[i].bus;
+    txn->device = bus_inputs[i].device;
+    txn->reg = bus_inputs[i].reg;
+    txn->data = bus_data[i];
+    txn->length = sizeof(bus_data[i]);
+    txn->notify = xTaskGetCurrentTaskHandle();
+    submitted[i] = telemetry_bus_submit(txn);
+    bus_in_flight[i] = submitted[i];
+    count += submitted[i] ? 1 : 0;
+  }
+  return count;
+}
+
+/**
+ * @brief Recoge las lecturas por bus y marca como válidas las que terminaron bien
+ *
+ * @details Se comprueba el estado de cada descriptor y no solo el número de
+ * notificaciones: en modo cooperativo la tarea recibe también las señales de
+ * las corrutinas.
+ */
+static void sensor_bus_collect(const bool* submitted, uint32_t count, float* inputs, bool* valid) {
+  int64_t deadline = esp_timer_get_time() + 2 * TELEM_BUS_TIMEOUT_MS * 1000;
+  for(size_t i = 0; i < SENSOR_BUS_INPUT_COUNT; i++) {
+    telemetry_bus_txn_t* txn = &bus_txns[i];
+    while(count > 0 && submitted[i] && txn->status == TELEM_BUS_PENDING) {
+      int64_t left_us = deadline - esp_timer_get_time();
+      if(left_us <= 0 || telemetry_bus_wait(1, (uint32_t)(left_us / 1000) + 1) == 0) {
+        break;
+      }
+    }
+    if(submitted[i] && txn->status == TELEM_BUS_OK) {
+      int16_t raw = (int16_t)(((uint16_t)bus_data[i][0] << 8) | bus_data[i][1]);
+      inputs[bus_inputs[i].input] = raw * bus_inputs[i].scale;
+      valid[bus_inputs[i].input] = true;
+    } else {
+      sensor_stats.bus_failures++;
+    }
+  }
+}
+
+/**
+ * @brief Prepara el paquete de alerta con las medidas del marco y lo publica
+ */
+static void sensor_alert_prepare(void) {
+  uint8_t next = (uint8_t)(__atomic_load_n(&alert_current, __ATOMIC_RELAXED) ^ 1);
+  power_telem_t* power = &alert_packets[next].power;
+  memset(power, 0, sizeof(*power));
+  power->header.type = TELEM_POWER_DATA;
+  power->header.priority = 2;
+  power->battery_voltage = sample_frame.value[TELEM_CH_BATTERY_VOLTAGE];
+  power->battery_current = sample_frame.value[TELEM_CH_BATTERY_CURRENT];
+  power->battery_temperature = (int8_t)sample_frame.value[TELEM_CH_BATTERY_TEMPERATURE];
+  power->power_state = TELEM_POWER_STATE_ALERT;
+  __atomic_store_n(&alert_current, next, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief ISR de la línea ALERT: deja el paquete de alerta para el recolector
+ */
+static void IRAM_ATTR sensor_alert_isr(void) {
+  BaseType_t woken = pdFALSE;
+  const telemetry_packet_t* packet = &alert_packets[__atomic_load_n(&alert_current, __ATOMIC_ACQUIRE)];
+  telemetry_store_packet_from_isr(alert_source, packet, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+const telemetry_sample_frame_t* telemetry_sensors_sweep(void) {
+  float inputs[TELEM_SENSOR_INPUT_COUNT] = { 0 };
+  bool valid[TELEM_SENSOR_INPUT_COUNT];
+  bool submitted[SENSOR_BUS_INPUT_COUNT];
+  int64_t start = esp_timer_get_time();
+
+  // Las lecturas por bus avanzan mientras se convierten las entradas ADC
+  uint32_t bus_count = sensor_bus_submit(submitted);
+
+  // Una conversión por entrada cableada
+  for(int input = 0; input < TELEM_SENSOR_INPUT_COUNT; input++) {
+    valid[input] = input_wired[input];
+    if(input_wired[input]) {
+      inputs[input] = sensor_convert((telem_sensor_input_t)input);
+      sensor_stats.conversions++;
+    }
+  }
+  sensor_bus_collect(submitted, bus_count, inputs, valid);
+
+  // Canales derivados de la misma muestra
+#define SENSOR_FILL_CHANNEL(name, input, offset, nominal) \
+  sample_frame.value[TELEM_CH_##name] = valid[TELEM_INPUT_##input] ? \
+    inputs[TELEM_INPUT_##input] + (offset) : (nominal);
+  TELEM_SENSOR_CHANNELS(SENSOR_FILL_CHANNEL)
+#undef SENSOR_FILL_CHANNEL
+
+  uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+  sample_frame.sample_time_us = start;
+  sample_frame.sweep_us = elapsed;
+  sample_frame.sweep = ++sensor_stats.sweeps;
+  sensor_alert_prepare();
+
+  sensor_stats.last_sweep_us = elapsed;
+  if(elapsed > sensor_stats.worst_sweep_us) {
+    sensor_stats.worst_sweep_us = elapsed;
+  }
+  return &sample_frame;
+}
+
+const telemetry_sample_frame_t* telemetry_sensors_frame(void) {
+  if(sample_frame.sweep == 0) {
+    return telemetry_sensors_sweep();
+  }
+  return &sample_frame;
+}
+
+bool telemetry_sensors_alert_init(void) {
+  alert_source = telemetry_isr_register("power-alert");
+  if(alert_source == TELEM_ISR_INVALID_SOURCE) {
+    return false;
+  }
+  // El paquete de alerta necesita un marco: el primer barrido se hace ya
+  telemetry_sensors_frame();
+  pinMode(TELEM_SENSOR_ALERT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(TELEM_SENSOR_ALERT_PIN), sensor_alert_isr, FALLING);
+  return true;
+}
+
+void telemetry_sensors_get_stats(telemetry_sensor_stats_t* stats) {
+  *stats = sensor_stats;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file telemetry_sleep.cpp
+ * @brief Implementación del modo de bajo consumo con deep sleep
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * El lote de muestras, los paquetes sin transmitir, los contadores del ciclo
+ * y las estadísticas de consumo se guardan en memoria RTC slow
+ * (`RTC_DATA_ATTR`), que se pone a cero en el arranque en frío y se conserva
+ * durante el deep sleep.
+ */
+
+#include <Arduino.h>
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "../include/telemetry_sleep.h"
+#include "../include/telemetry_generators.h"
+#include "../include/telemetry_topics.h"
+#include "../include/telemetry_storage.h"
+#include "../include/telemetry_archive.h"
+#include "../include/telemetry_logger.h"
+
+/** @brief Lote de paquetes muestreados mientras las tareas no se ejecutan */
+static RTC_DATA_ATTR telemetry_packet_t sleep_batch[TELEM_SLEEP_BATCH_SIZE];
+static RTC_DATA_ATTR uint32_t batch_count = 0;     /**< Paquetes en el lote */
+static RTC_DATA_ATTR uint32_t batch_cycles = 0;    /**< Ciclos de muestreo en el lote */
+/** @brief Paquetes del buffer principal que el transmisor no llegó a enviar */
+static RTC_DATA_ATTR telemetry_packet_t sleep_carry[TELEM_SLEEP_CARRY_SIZE];
+static RTC_DATA_ATTR uint32_t carry_count = 0;     /**< Paquetes en sleep_carry */
+static RTC_DATA_ATTR uint32_t time_base_ms = 0;    /**< Tiempo acumulado en despertares anteriores */
+static RTC_DATA_ATTR telemetry_sleep_stats_t sleep_stats;
+
+#ifdef TELEM_LOW_POWER_MODE
+/**
+ * @brief Destino de los generadores durante un despertar de muestreo
+ */
+static bool sleep_batch_store(const telemetry_packet_t* packet) {
+  if(batch_count >= TELEM_SLEEP_BATCH_SIZE) {
+    return false;
+  }
+  sleep_batch[batch_count++] = *packet;
+  return true;
+}
+
+/**
+ * @brief Recalcula la energía estimada por muestra con el modelo de consumo
+ */
+static void sleep_update_energy(void) {
+  if(sleep_stats.samples == 0) {
+    return;
+  }
+  // mW * ms = µJ ; µW * s = µJ
+  uint64_t active_uj = sleep_stats.awake_us * TELEM_SLEEP_ACTIVE_POWER_MW / 1000;
+  uint64_t sleep_uj = sleep_stats.sleep_us * TELEM_SLEEP_DEEP_POWER_UW / 1000000;
+  sleep_stats.energy_per_sample_uj = (uint32_t)((active_uj + sleep_uj) / sleep_stats.samples);
+}
+
+/**
+ * @brief Pasa a memoria RTC lo que queda en el buffer principal
+ *
+ * @details Si no cabe todo se conservan los más recientes; los más antiguos
+ * ya están en el archivo masivo.
+ */
+static void sleep_carry_store(void) {
+  telemetry_packet_t packet;
+  uint32_t available = telemetry_available_packets();
+
+  for(; available > TELEM_SLEEP_CARRY_SIZE && telemetry_retrieve_packet(&packet); available--) {
+    sleep_stats.carry_dropped++;
+  }
+  carry_count = 0;
+  while(carry_count < TELEM_SLEEP_CARRY_SIZE && telemetry_retrieve_packet(&sleep_carry[carry_count])) {
+    carry_count++;
+  }
+  sleep_stats.carried += carry_count;
+}
+
+/**
+ * @brief Contabiliza el despertar actual y entra en deep sleep hasta la próxima muestra
+ */
+static void sleep_enter(void) {
+  uint64_t awake_us = (uint64_t)esp_timer_get_time();
+  uint64_t period_us = (uint64_t)TELEM_SLEEP_PERIOD_MS * 1000;
+  uint64_t sleep_us = awake_us < period_us ? period_us - awake_us : 1000;
+
+  sleep_stats.awake_us += awake_us;
+  sleep_stats.sleep_us += sleep_us;
+  time_base_ms += (uint32_t)((awake_us + sleep_us) / 1000);
+  sleep_update_energy();
+
+  esp_sleep_enable_timer_wakeup(sleep_us);
+  esp_deep_sleep_start();
+}
+#endif
+
+void telemetry_sleep_handle_wake(void) {
+#ifdef TELEM_LOW_POWER_MODE
+  if(esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+    return;
+  }
+
+  // Despertar mínimo: solo generadores, sin logger ni tareas
+  telemetry_generators_init();
+  telemetry_generators_set_sink(sleep_batch_store);
+  generate_cycle_telemetry();
+  telemetry_generators_set_sink(NULL);
+
+  batch_cycles++;
+  sleep_stats.samples++;
+
+  if(batch_cycles < TELEM_SLEEP_BATCH_CYCLES) {
+    sleep_enter();
+  }
+  // Lote completo: continuar con el arranque normal para procesarlo
+#endif
+}
+
+uint32_t telemetry_sleep_flush_batch(telemetry_packet_sink_t sink) {
+  uint32_t flushed = 0;
+
+  // Lo conservado al dormir es más antiguo que el lote y ya pasó por el bus
+  for(uint32_t i = 0; i < carry_count; i++) {
+    telemetry_store_packet(&sleep_carry[i]);
+  }
+  carry_count = 0;
+
+  for(uint32_t i = 0; i < batch_count; i++) {
+    if(sink(&sleep_batch[i])) {
+      flushed++;
+    }
+  }
+
+  if(batch_cycles > 0) {
+    sleep_stats.full_wakes++;
+  }
+  batch_count = 0;
+  batch_cycles = 0;
+  return flushed;
+}
+
+void telemetry_sleep_service(void) {
+#ifdef TELEM_LOW_POWER_MODE
+  if(millis() < TELEM_SLEEP_MIN_AWAKE_MS || telemetry_topic_pending() > 0) {
+    return;
+  }
+
+  // El buffer principal (.noinit) y el bloque parcial del archivo no sobreviven al deep sleep
+  sleep_carry_store();
+  telemetry_archive_sync();
+  sleep_update_energy();
+  telemetry_logf("💤 Entering deep sleep: %lu samples, ~%lu uJ/sample | Carried=%lu",
+                 sleep_stats.samples, sleep_stats.energy_per_sample_uj, carry_count);
+  Serial.flush();
+  sleep_enter();
+#endif
+}
+
+uint32_t telemetry_sleep_timestamp(void) {
+  return time_base_ms + (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+uint64_t telemetry_sleep_timestamp_us(void) {
+  return (uint64_t)time_base_ms * 1000 + (uint64_t)esp_timer_get_time();
+}
+
+void telemetry_sleep_get_stats(telemetry_sleep_stats_t* stats) {
+  *stats = sleep_stats;
+}
@@ -0,0 +1,241 @@
+/**
+ * @file telemetry_soc.cpp
+ * @brief Implementación del estimador de estado de carga
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * Formatos: SoC en Q30 (un conteo de 5 s a 100 mA mueve unas 50.000
+ * unidades, así que el redondeo no pierde culombios), varianza en Q32,
+ * tensiones y H (V por unidad de SoC) en Q16. La varianza se limita a la
+ * inicial, lo que acota todos los productos intermedios a 64 bits.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "../include/telemetry_soc.h"
+#include "../include/telemetry_calibration.h"
+#include "../include/telemetry_retention.h"
+#include "../include/telemetry_sleep.h"
+#include "../include/telemetry_logger.h"
+
+/** @brief Uno en Q30 */
+#define SOC_ONE (1 << 30)
+
+/** @brief Segmentos de la curva OCV, en bits */
+#define SOC_OCV_SEGMENT_BITS 4
+
+/** @brief Bits de SoC por segmento */
+#define SOC_OCV_SHIFT (30 - SOC_OCV_SEGMENT_BITS)
+
+/** @brief mV a V en Q16 */
+#define SOC_MV(mv) ((int32_t)((mv) * (int64_t)TELEM_Q16_ONE / 1000))
+
+/** @brief Capacidad en A·µs, dividida por la escala Q30/Q16 para que I·dt no desborde */
+#define SOC_CAPACITY_DIVISOR ((int64_t)TELEM_SOC_CAPACITY_MAH * 3600000LL / (SOC_ONE / TELEM_Q16_ONE))
+
+/** @brief Varianza de la tensión en V² Q32 */
+#define SOC_VOLTAGE_VARIANCE ((int64_t)TELEM_SOC_VOLTAGE_NOISE_MV * TELEM_SOC_VOLTAGE_NOISE_MV * 4294967296LL / 1000000)
+
+/** @brief Ruido de proceso en fracción² Q32 por cada 1000 s */
+#define SOC_DRIFT_PER_KS ((int64_t)TELEM_SOC_DRIFT_PCT2_PER_HOUR * 4294967296LL / 36000)
+
+/** @brief Varianza inicial y máxima: (10 %)² en Q32 */
+#define SOC_VARIANCE_MAX 42949673u
+
+/** @brief Pasos de la descarga simulada del benchmark (5 s cada uno) */
+#define SOC_BENCH_STEPS 2000
+
+/**
+ * @brief Curva OCV de una celda de ion-litio (NMC) en SoC = i/16
+ */
+static const int32_t ocv_table[(1 << SOC_OCV_SEGMENT_BITS) + 1] = {
+  SOC_MV(3000), SOC_MV(3300), SOC_MV(3450), SOC_MV(3530), SOC_MV(3580), SOC_MV(3620),
+  SOC_MV(3650), SOC_MV(3680), SOC_MV(3710), SOC_MV(3750), SOC_MV(3800), SOC_MV(3850),
+  SOC_MV(3900), SOC_MV(3960), SOC_MV(4030), SOC_MV(4110), SOC_MV(4200)
+};
+
+/** @brief Estimador de a bordo, conservado en memoria RTC */
+typedef struct {
+  uint32_t magic;                   /**< TELEM_RETENTION_MAGIC si el bloque es válido */
+  telemetry_soc_state_t state;
+  uint32_t crc;                     /**< CRC de los campos anteriores */
+} soc_retained_t;
+
+static RTC_NOINIT_ATTR soc_retained_t retained;
+
+/**
+ * @brief Tensión en circuito abierto estimada: V + I·R (Q16)
+ */
+static int32_t soc_open_circuit(int32_t voltage_q16, int32_t current_q16) {
+  return voltage_q16 + (int32_t)((int64_t)current_q16 * TELEM_SOC_RESISTANCE_MOHM / 1000);
+}
+
+void telemetry_soc_reset(telemetry_soc_state_t* state, int32_t voltage_q16, int32_t current_q16, uint64_t now_us) {
+  const int segments = 1 << SOC_OCV_SEGMENT_BITS;
+  int32_t ocv = soc_open_circuit(voltage_q16, current_q16);
+  int32_t soc;
+
+  if(ocv <= ocv_table[0]) {
+    soc = 0;
+  } else if(ocv >= ocv_table[segments]) {
+    soc = SOC_ONE;
+  } else {
+    int i = 0;
+    while(ocv >= ocv_table[i + 1]) {
+      i++;
+    }
+    soc = (i << SOC_OCV_SHIFT) +
+          (int32_t)(((int64_t)(ocv - ocv_table[i]) << SOC_OCV_SHIFT) / (ocv_table[i + 1] - ocv_table[i]));
+  }
+
+  state->soc = soc;
+  state->variance = SOC_VARIANCE_MAX;
+  state->last_us = now_us;
+  state->updates = 0;
+}
+
+void telemetry_soc_step(telemetry_soc_state_t* state, int32_t voltage_q16, int32_t current_q16, uint64_t now_us) {
+  int64_t dt_us = now_us > state->last_us ? (int64_t)(now_us - state->last_us) : 0;
+  state->last_us = now_us;
+  state->updates++;
+
+  // Predicción: conteo de culombios y crecimiento de la varianza
+  int64_t soc = state->soc - (int64_t)current_q16 * dt_us / SOC_CAPACITY_DIVISOR;
+  int64_t variance = state->variance + dt_us * SOC_DRIFT_PER_KS / 1000000000LL;
+  if(variance > SOC_VARIANCE_MAX) {
+    variance = SOC_VARIANCE_MAX;
+  }
+  if(soc < 0) {
+    soc = 0;
+  } else if(soc > SOC_ONE) {
+    soc = SOC_ONE;
+  }
+
+  // Curva OCV y su pendiente en el SoC predicho
+  int32_t segment = (int32_t)(soc >> SOC_OCV_SHIFT);
+  int64_t fraction = soc & ((1 << SOC_OCV_SHIFT) - 1);
+  if(segment >= (1 << SOC_OCV_SEGMENT_BITS)) {
+    segment = (1 << SOC_OCV_SEGMENT_BITS) - 1;
+    fraction = 1 << SOC_OCV_SHIFT;
+  }
+  int64_t rise = ocv_table[segment + 1] - ocv_table[segment];
+  int64_t predicted = ocv_table[segment] + ((rise * fraction) >> SOC_OCV_SHIFT);
+  int64_t slope = rise << SOC_OCV_SEGMENT_BITS;
+
+  // Corrección: K = P·H / (H²·P + R), P' = P·R / S
+  int64_t innovation = soc_open_circuit(voltage_q16, current_q16) - predicted;
+  if(innovation > TELEM_Q16_ONE) {
+    innovation = TELEM_Q16_ONE;
+  } else if(innovation < -TELEM_Q16_ONE) {
+    innovation = -TELEM_Q16_ONE;
+  }
+  int64_t hp = (slope * variance) >> 16;
+  int64_t s = ((slope * hp) >> 16) + SOC_VOLTAGE_VARIANCE;
+
+  soc += hp * innovation * (1 << 14) / s;
+  variance = variance * SOC_VOLTAGE_VARIANCE / s;
+
+  if(soc < 0) {
+    soc = 0;
+  } else if(soc > SOC_ONE) {
+    soc = SOC_ONE;
+  }
+  state->soc = (int32_t)soc;
+  state->variance = (uint32_t)variance;
+}
+
+/**
+ * @brief CRC del estimador retenido
+ */
+static uint32_t soc_retained_crc(void) {
+  return telemetry_retention_crc(&retained, offsetof(soc_retained_t, crc));
+}
+
+void telemetry_soc_update(const telemetry_sample_frame_t* samples) {
+  int32_t voltage = (int32_t)lroundf(samples->value[TELEM_CH_BATTERY_VOLTAGE] * TELEM_Q16_ONE);
+  int32_t current = (int32_t)lroundf(samples->value[TELEM_CH_BATTERY_CURRENT] * TELEM_Q16_ONE);
+  uint64_t now_us = telemetry_sleep_timestamp_us();
+
+  if(retained.magic == TELEM_RETENTION_MAGIC && retained.crc == soc_retained_crc()) {
+    telemetry_soc_step(&retained.state, voltage, current, now_us);
+  } else {
+    // Arranque en frío: sin conteo previo, se parte de la tensión
+    retained.magic = TELEM_RETENTION_MAGIC;
+    telemetry_soc_reset(&retained.state, voltage, current, now_us);
+  }
+  retained.crc = soc_retained_crc();
+}
+
+uint8_t telemetry_soc_level(void) {
+  if(retained.magic != TELEM_RETENTION_MAGIC || retained.crc != soc_retained_crc()) {
+    return 0;
+  }
+  return (uint8_t)(((int64_t)retained.state.soc * 100 + SOC_ONE / 2) >> 30);
+}
+
+void telemetry_soc_get_state(telemetry_soc_state_t* state) {
+  *state = retained.state;
+}
+
+/**
+ * @brief OCV de la batería simulada en V (misma curva, en coma flotante)
+ */
+static double soc_simulated_ocv(double soc) {
+  double position = soc * (1 << SOC_OCV_SEGMENT_BITS);
+  int segment = position >= (1 << SOC_OCV_SEGMENT_BITS) ? (1 << SOC_OCV_SEGMENT_BITS) - 1 : (int)position;
+  double low = (double)ocv_table[segment] / TELEM_Q16_ONE;
+  double high = (double)ocv_table[segment + 1] / TELEM_Q16_ONE;
+  return low + (high - low) * (position - segment);
+}
+
+void telemetry_soc_benchmark(void) {
+  const double dt_s = 5.0;
+  const double resistance = TELEM_SOC_RESISTANCE_MOHM / 1000.0;
+  telemetry_soc_state_t state;
+  uint32_t noise = 12345;
+  double truth = 0.9;
+  double worst_late = 0.0;
+  uint32_t cycles = 0;
+  uint32_t worst_cycles = 0;
+
+  for(int step = 0; step < SOC_BENCH_STEPS; step++) {
+    // Carga base de 300 mA y pulso de transmisión de 1,5 A uno de cada diez pasos
+    double current = step % 10 == 0 ? 1.5 : 0.3;
+    truth -= current * dt_s / (TELEM_SOC_CAPACITY_MAH * 3.6);
+
+    // ±10 mV de ruido de tensión y +2 % de error de ganancia en la corriente
+    noise = noise * 1664525u + 1013904223u;
+    double voltage = soc_simulated_ocv(truth) - current * resistance + ((int32_t)(noise >> 8) % 10001) * 1e-6 - 0.005;
+    int32_t voltage_q16 = (int32_t)lround(voltage * TELEM_Q16_ONE);
+    int32_t current_q16 = (int32_t)lround(current * 1.02 * TELEM_Q16_ONE);
+    uint64_t now_us = (uint64_t)(step * dt_s * 1000000.0);
+
+    if(step == 0) {
+      telemetry_soc_reset(&state, voltage_q16, current_q16, now_us);
+      state.soc -= (int32_t)(0.3 * SOC_ONE); // Error inicial de 30 puntos
+      continue;
+    }
+
+    uint32_t start = ESP.getCycleCount();
+    telemetry_soc_step(&state, voltage_q16, current_q16, now_us);
+    uint32_t elapsed = ESP.getCycleCount() - start;
+    cycles += elapsed;
+    if(elapsed > worst_cycles) {
+      worst_cycles = elapsed;
+    }
+
+    if(step >= SOC_BENCH_STEPS / 2) {
+      double error = fabs((double)state.soc / SOC_ONE - truth);
+      if(error > worst_late) {
+        worst_late = error;
+      }
+    }
+  }
+
+  telemetry_logf("🔋 SoC: %.1f cycles/update (worst %lu) | true %.1f%% est %.1f%% | worst error %.2f%% over last %d steps",
+                 (double)cycles / (SOC_BENCH_STEPS - 1), worst_cycles, truth * 100.0,
+                 (double)state.soc * 100.0 / SOC_ONE, worst_late * 100.0, SOC_BENCH_STEPS / 2);
+}
@@ -8,28 +8,236 @@
  * Este archivo contiene la implementación del sistema de almacenamiento de
  * telemetría basado en un buffer circular con sincronización mediante mutex
  * de FreeRTOS. Diseñado específicamente para ejecutarse en el ESP32 bajo FreeRTOS.
+ *
+ * El buffer reside en una sección no inicializada (`.noinit`), por lo que su
+ * contenido sobrevive a reinicios software, watchdogs y brownouts. Los índices
+ * y contadores se sellan con un CRC en cada operación y cada paquete guarda su
+ * propio CRC, de modo que tras el reinicio basta con validar unos pocos bytes.
+ *
+ * Cuando la carga útil de un paquete coincide con la del último paquete
+ * completo de su tipo, solo se guardan sus campos de encabezado en una ranura
+ * de repeticiones. Como el buffer es FIFO, al leer esa entrada el último
+ * paquete completo leído de ese tipo es exactamente el que se comparó al
+ * escribir, así que la expansión es transparente para los consumidores.
  */
 
   #include "freertos/FreeRTOS.h"
   #include "freertos/semphr.h"
   #include "freertos/task.h"
+  #include <string.h>
+  #include "esp_attr.h"
   #include "../include/telemetry_storage.h"
+  #include "../include/telemetry_retention.h"
+  #include "../include/telemetry_downlink.h"
 
-  /** @brief Instancia global del buffer circular (static para encapsulamiento) */
-static telemetry_buffer_t telem_buffer;
+  /** @brief Instancia global del buffer circular (static para encapsulamiento, sin inicializar para sobrevivir a reinicios) */
+static __NOINIT_ATTR telemetry_buffer_t telem_buffer;
+
+/** @brief true si el último init conservó el contenido previo al reinicio */
+static bool storage_restored = false;
+
+/**
+ * @brief Calcula el CRC de los índices y contadores del buffer
+ */
+static uint32_t storage_control_crc(void) {
+  const uint32_t control[] = {
+    telem_buffer.write_index,
+    telem_buffer.read_index,
+    telem_buffer.read_entry,
+    telem_buffer.pending_packets,
+    telem_buffer.packets_written,
+    telem_buffer.packets_read,
+    telem_buffer.packets_lost,
+    telem_buffer.packets_deduplicated,
+    telem_buffer.reader_valid_mask,
+    telem_buffer.head_generation,
+    telem_buffer.tail_generation
+  };
+  return telemetry_retention_crc(control, sizeof(control));
+}
+
+/**
+ * @brief Vuelve a sellar el bloque de control tras modificarlo (llamar con el mutex tomado)
+ */
+static void storage_seal_control(void) {
+  telem_buffer.control_crc = storage_control_crc();
+}
+
+/**
+ * @brief Comprueba si el estado retenido en RAM es coherente
+ */
+static bool storage_control_valid(void) {
+  return telem_buffer.magic == TELEM_RETENTION_MAGIC &&
+         telem_buffer.write_index < TELEM_BUFFER_SIZE &&
+         telem_buffer.read_index < TELEM_BUFFER_SIZE &&
+         telem_buffer.control_crc == storage_control_crc();
+}
+
+/**
+ * @brief Sella una ranura con su CRC tras escribirla
+ */
+static void storage_seal_slot(uint32_t slot) {
+  telem_buffer.slot_crc[slot] = telemetry_retention_crc(&telem_buffer.buffer[slot], sizeof(telemetry_slot_t));
+}
+
+/**
+ * @brief Marca una ranura como en escritura para los iteradores de instantánea
+ *
+ * @param slot Ranura que se va a modificar
+ * @param position Posición absoluta que ocupa (o pasará a ocupar) la ranura
+ */
+static void storage_slot_begin_write(uint32_t slot, uint32_t position) {
+  __atomic_store_n(&telem_buffer.slot_generation[slot], 2 * position + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publica una ranura ya escrita y sellada
+ */
+static void storage_slot_end_write(uint32_t slot, uint32_t position) {
+  __atomic_store_n(&telem_buffer.slot_generation[slot], 2 * position + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Añade la ranura de write_index al final de la cola
+ */
+static void storage_commit_slot(void) {
+  telem_buffer.write_index = (telem_buffer.write_index + 1) % TELEM_BUFFER_SIZE;
+  __atomic_store_n(&telem_buffer.head_generation, telem_buffer.head_generation + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Retira la ranura de read_index de la cola
+ */
+static void storage_release_slot(void) {
+  telem_buffer.read_index = (telem_buffer.read_index + 1) % TELEM_BUFFER_SIZE;
+  telem_buffer.read_entry = 0;
+  __atomic_store_n(&telem_buffer.tail_generation, telem_buffer.tail_generation + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Paquetes que representa una ranura a partir de la entrada indicada
+ */
+static uint32_t storage_slot_packets(uint32_t slot, uint32_t first_entry) {
+  const telemetry_slot_t* s = &telem_buffer.buffer[slot];
+  if(s->packet.header.type != TELEM_STORAGE_REPEAT_TYPE) {
+    return 1;
+  }
+  return s->repeat.count > first_entry ? s->repeat.count - first_entry : 0;
+}
+
+/**
+ * @brief Recalcula los paquetes pendientes recorriendo las ranuras ocupadas
+ *
+ * @details Solo se usa tras descartar una ranura dañada, cuando su contenido
+ * (y por tanto cuántos paquetes representaba) ya no es fiable.
+ */
+static void storage_recount_pending(void) {
+  uint32_t pending = 0;
+  uint32_t first_entry = telem_buffer.read_entry;
+  for(uint32_t slot = telem_buffer.read_index; slot != telem_buffer.write_index;
+      slot = (slot + 1) % TELEM_BUFFER_SIZE) {
+    pending += storage_slot_packets(slot, first_entry);
+    first_entry = 0;
+  }
+  telem_buffer.packets_lost += telem_buffer.pending_packets > pending ?
+                               telem_buffer.pending_packets - pending : 0;
+  telem_buffer.pending_packets = pending;
+}
+
+/**
+ * @brief Indica si la carga útil de un paquete es idéntica a la del último escrito de su tipo
+ */
+static bool storage_is_repeat(const telemetry_packet_t* packet) {
+  telem_data_type_t type = packet->header.type;
+  if(!TELEM_DEDUP_ENABLED || (uint32_t)type >= TELEM_TYPE_COUNT ||
+     (telem_buffer.writer_valid_mask & (1u << type)) == 0) {
+    return false;
+  }
+
+  const telemetry_packet_t* last = &telem_buffer.writer_last[type];
+  size_t size = telemetry_packet_wire_size(packet);
+  return size == telemetry_packet_wire_size(last) &&
+         memcmp(&packet->raw_data[sizeof(telem_header_t)], &last->raw_data[sizeof(telem_header_t)],
+                size - sizeof(telem_header_t)) == 0;
+}
+
+/**
+ * @brief Guarda un paquete repetido como entrada de una ranura de repeticiones
+ *
+ * @return true Si se guardó (en la última ranura abierta o en una nueva)
+ * @return false Si el buffer está lleno
+ */
+static bool storage_append_repeat(const telemetry_packet_t* packet) {
+  telem_repeat_entry_t entry;
+  entry.timestamp = packet->header.timestamp;
+  entry.sequence = packet->header.sequence;
+  entry.type = (uint8_t)packet->header.type;
+  entry.priority = packet->header.priority;
+
+  // La última ranura escrita sigue abierta si no se ha consumido y tiene hueco
+  if(telem_buffer.read_index != telem_buffer.write_index) {
+    uint32_t tail = (telem_buffer.write_index + TELEM_BUFFER_SIZE - 1) % TELEM_BUFFER_SIZE;
+    telem_repeat_run_t* run = &telem_buffer.buffer[tail].repeat;
+    if(run->header.type == TELEM_STORAGE_REPEAT_TYPE && run->count < TELEM_REPEAT_ENTRIES) {
+      uint32_t position = telem_buffer.head_generation - 1;
+      storage_slot_begin_write(tail, position);
+      run->entries[run->count++] = entry;
+      storage_seal_slot(tail);
+      storage_slot_end_write(tail, position);
+      return true;
+    }
+  }
+
+  uint32_t next_write = (telem_buffer.write_index + 1) % TELEM_BUFFER_SIZE;
+  if(next_write == telem_buffer.read_index) {
+    return false;
+  }
+
+  telemetry_slot_t* slot = &telem_buffer.buffer[telem_buffer.write_index];
+  storage_slot_begin_write(telem_buffer.write_index, telem_buffer.head_generation);
+  memset(slot, 0, sizeof(*slot));
+  slot->repeat.header = packet->header;
+  slot->repeat.header.type = TELEM_STORAGE_REPEAT_TYPE;
+  slot->repeat.count = 1;
+  slot->repeat.entries[0] = entry;
+  storage_seal_slot(telem_buffer.write_index);
+  storage_slot_end_write(telem_buffer.write_index, telem_buffer.head_generation);
+  storage_commit_slot();
+  return true;
+}
 
 void telemetry_storage_init(void) {
-  /* Inicialización de índices y contadores */
-  telem_buffer.write_index = 0;
-  telem_buffer.read_index = 0;
-  telem_buffer.packets_written = 0;
-  telem_buffer.packets_read = 0;
-  telem_buffer.packets_lost = 0;
+  storage_restored = telemetry_retention_warm_boot() && storage_control_valid();
 
-  /* Crear e inicializar el mutex */
-  telem_buffer.mutex = xSemaphoreCreateMutex();
+  if(!storage_restored) {
+    /* Inicialización de índices y contadores */
+    telem_buffer.write_index = 0;
+    telem_buffer.read_index = 0;
+    telem_buffer.read_entry = 0;
+    telem_buffer.pending_packets = 0;
+    telem_buffer.packets_written = 0;
+    telem_buffer.packets_read = 0;
+    telem_buffer.packets_lost = 0;
+    telem_buffer.packets_deduplicated = 0;
+    telem_buffer.reader_valid_mask = 0;
+    telem_buffer.head_generation = 0;
+    telem_buffer.tail_generation = 0;
+    for(uint32_t slot = 0; slot < TELEM_BUFFER_SIZE; slot++) {
+      telem_buffer.slot_generation[slot] = 0;
+    }
+    telem_buffer.magic = TELEM_RETENTION_MAGIC;
+  }
+
+  /* El próximo paquete de cada tipo se guarda completo aunque se repita */
+  telem_buffer.writer_valid_mask = 0;
+  storage_seal_control();
 
-  if (telem_buffer.mutex == NULL) {
+  /* El pool de paquetes compartidos no se conserva: ningún handle sobrevive al reinicio */
+  telemetry_pool_init();
+
+  /* Crear e inicializar el mutex */
+  if (!telemetry_lock_create(&telem_buffer.mutex, "buffer")) {
     /* Error crítico: no se pudo crear el mutex */
     while(1) {
       /* En un sistema real, aquí deberíamos notificar el error */
@@ -39,56 +247,285 @@ void telemetry_storage_init(void) {
 }
 
 bool telemetry_store_packet(const telemetry_packet_t* packet) {
-  if(xSemaphoreTake(telem_buffer.mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+  if(telemetry_lock_take(&telem_buffer.mutex, pdMS_TO_TICKS(100))) {
+    // Carga útil repetida: guardar solo su encabezado
+    if(storage_is_repeat(packet)) {
+      bool stored = storage_append_repeat(packet);
+      if(stored) {
+        telem_buffer.packets_written++;
+        telem_buffer.packets_deduplicated++;
+        telem_buffer.pending_packets++;
+      } else {
+        telem_buffer.packets_lost++;
+      }
+      storage_seal_control();
+      telemetry_lock_give(&telem_buffer.mutex);
+      return stored;
+    }
+
     // Verificar si hay espacio
     uint32_t next_write = (telem_buffer.write_index + 1) % TELEM_BUFFER_SIZE;
 
     if(next_write == telem_buffer.read_index) {
       // Buffer lleno
       telem_buffer.packets_lost++;
-      xSemaphoreGive(telem_buffer.mutex);
+      storage_seal_control();
+      telemetry_lock_give(&telem_buffer.mutex);
       return false;
     }
 
     // Almacenar paquete
-    telem_buffer.buffer[telem_buffer.write_index] = *packet;
-    telem_buffer.write_index = next_write;
+    storage_slot_begin_write(telem_buffer.write_index, telem_buffer.head_generation);
+    telem_buffer.buffer[telem_buffer.write_index].packet = *packet;
+    storage_seal_slot(telem_buffer.write_index);
+    storage_slot_end_write(telem_buffer.write_index, telem_buffer.head_generation);
+    storage_commit_slot();
     telem_buffer.packets_written++;
+    telem_buffer.pending_packets++;
+
+    // Referencia para detectar repeticiones de este tipo
+    if((uint32_t)packet->header.type < TELEM_TYPE_COUNT) {
+      telem_buffer.writer_last[packet->header.type] = *packet;
+      telem_buffer.writer_valid_mask |= 1u << packet->header.type;
+    }
+    storage_seal_control();
 
-    xSemaphoreGive(telem_buffer.mutex);
+    telemetry_lock_give(&telem_buffer.mutex);
     return true;
   }
   return false;
 }
 
 bool telemetry_retrieve_packet(telemetry_packet_t* packet) {
-  if(xSemaphoreTake(telem_buffer.mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-    if(telem_buffer.read_index == telem_buffer.write_index) {
-      // Buffer vacío
-      xSemaphoreGive(telem_buffer.mutex);
+  if(telemetry_lock_take(&telem_buffer.mutex, pdMS_TO_TICKS(100))) {
+    while(telem_buffer.read_index != telem_buffer.write_index) {
+      uint32_t slot = telem_buffer.read_index;
+      const telemetry_slot_t* stored = &telem_buffer.buffer[slot];
+
+      if(telemetry_retention_crc(stored, sizeof(telemetry_slot_t)) != telem_buffer.slot_crc[slot]) {
+        // Ranura dañada (p. ej. RAM alterada por un brownout): se descarta;
+        // las referencias se invalidan antes de que la cola avance
+        telem_buffer.reader_valid_mask = 0;
+        telem_buffer.writer_valid_mask = 0;
+        storage_release_slot();
+        storage_recount_pending();
+        continue;
+      }
+
+      telem_buffer.pending_packets--;
+
+      if(stored->packet.header.type == TELEM_STORAGE_REPEAT_TYPE) {
+        // Expandir la siguiente repetición con la última carga útil leída de su tipo
+        const telem_repeat_entry_t* entry = &stored->repeat.entries[telem_buffer.read_entry];
+        uint32_t type = entry->type;
+        bool expanded = type < TELEM_TYPE_COUNT &&
+                        (telem_buffer.reader_valid_mask & (1u << type)) != 0 &&
+                        telemetry_retention_crc(&telem_buffer.reader_last[type], TELEM_PACKET_SIZE) ==
+                        telem_buffer.reader_last_crc[type];
+        if(expanded) {
+          *packet = telem_buffer.reader_last[type];
+          packet->header.type = (telem_data_type_t)type;
+          packet->header.timestamp = entry->timestamp;
+          packet->header.sequence = entry->sequence;
+          packet->header.priority = entry->priority;
+        }
+
+        if(++telem_buffer.read_entry >= stored->repeat.count) {
+          storage_release_slot();
+        }
+
+        if(!expanded) {
+          // Sin carga útil de referencia: forzar que el próximo paquete de este tipo se guarde completo
+          telem_buffer.packets_lost++;
+          if(type < TELEM_TYPE_COUNT) {
+            telem_buffer.writer_valid_mask &= ~(1u << type);
+          }
+          continue;
+        }
+      } else {
+        // Recuperar paquete; la referencia de su tipo se actualiza antes de
+        // soltar la ranura, para que una instantánea que vea la cola nueva
+        // no la empareje con la referencia anterior
+        *packet = stored->packet;
+        if((uint32_t)packet->header.type < TELEM_TYPE_COUNT) {
+          telem_buffer.reader_last[packet->header.type] = *packet;
+          telem_buffer.reader_last_crc[packet->header.type] = telemetry_retention_crc(packet, TELEM_PACKET_SIZE);
+          telem_buffer.reader_valid_mask |= 1u << packet->header.type;
+        }
+        storage_release_slot();
+      }
+
+      telem_buffer.packets_read++;
+      storage_seal_control();
+      telemetry_lock_give(&telem_buffer.mutex);
+      return true;
+    }
+
+    // Buffer vacío
+    storage_seal_control();
+    telemetry_lock_give(&telem_buffer.mutex);
+    return false;
+  }
+  return false;
+}
+
+bool telemetry_retrieve_handle(telem_pool_handle_t* handle) {
+  telem_pool_handle_t block = telemetry_pool_alloc();
+  if(block == TELEM_POOL_INVALID) {
+    return false;
+  }
+
+  if(!telemetry_retrieve_packet(telemetry_pool_get(block))) {
+    telemetry_pool_release(block);
+    return false;
+  }
+
+  *handle = block;
+  return true;
+}
+
+bool telemetry_storage_was_restored(void) {
+  return storage_restored;
+}
+
+void telemetry_snapshot_begin(telemetry_snapshot_t* snapshot) {
+  uint32_t tail;
+
+  // Las repeticiones iniciales se expanden con las referencias del consumidor,
+  // copiadas mientras la cola no avanza (se reintenta si el consumidor lee a la vez).
+  // El consumidor actualiza su referencia antes de soltar la ranura: una copia
+  // más nueva que la cola leída corresponde al paquete completo de esa misma
+  // posición, que la instantánea vuelve a leer y la sustituye igualmente.
+  do {
+    tail = __atomic_load_n(&telem_buffer.tail_generation, __ATOMIC_ACQUIRE);
+    uint32_t reader_mask = telem_buffer.reader_valid_mask;
+    snapshot->valid_mask = 0;
+    for(uint32_t type = 0; type < TELEM_TYPE_COUNT; type++) {
+      if((reader_mask & (1u << type)) == 0) {
+        continue;
+      }
+      memcpy(&snapshot->last[type], (const void*)&telem_buffer.reader_last[type], TELEM_PACKET_SIZE);
+      if(telemetry_retention_crc(&snapshot->last[type], TELEM_PACKET_SIZE) == telem_buffer.reader_last_crc[type]) {
+        snapshot->valid_mask |= 1u << type;
+      }
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while(__atomic_load_n(&telem_buffer.tail_generation, __ATOMIC_RELAXED) != tail);
+
+  snapshot->position = tail;
+  snapshot->end = __atomic_load_n(&telem_buffer.head_generation, __ATOMIC_ACQUIRE);
+  snapshot->entry = 0;
+  snapshot->has_slot = false;
+  snapshot->skipped = 0;
+  snapshot->unresolved = 0;
+}
+
+/**
+ * @brief Copia de forma consistente la ranura de una posición absoluta
+ *
+ * @return true Si la ranura sigue conteniendo esa posición y no cambió durante la copia
+ */
+static bool storage_snapshot_copy(uint32_t position, telemetry_slot_t* copy) {
+  uint32_t slot = position % TELEM_BUFFER_SIZE;
+  uint32_t expected = 2 * position + 2;
+
+  if(__atomic_load_n(&telem_buffer.slot_generation[slot], __ATOMIC_ACQUIRE) != expected) {
+    return false;
+  }
+  memcpy(copy, (const void*)&telem_buffer.buffer[slot], sizeof(*copy));
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&telem_buffer.slot_generation[slot], __ATOMIC_RELAXED) == expected;
+}
+
+bool telemetry_snapshot_next(telemetry_snapshot_t* snapshot, telemetry_packet_t* packet) {
+  for(;;) {
+    // Entradas pendientes de la ranura de repeticiones en curso
+    if(snapshot->has_slot) {
+      const telem_repeat_run_t* run = &snapshot->slot.repeat;
+      if(snapshot->entry < run->count && snapshot->entry < TELEM_REPEAT_ENTRIES) {
+        const telem_repeat_entry_t* entry = &run->entries[snapshot->entry++];
+        if(entry->type >= TELEM_TYPE_COUNT || (snapshot->valid_mask & (1u << entry->type)) == 0) {
+          snapshot->unresolved++;
+          continue;
+        }
+        *packet = snapshot->last[entry->type];
+        packet->header.type = (telem_data_type_t)entry->type;
+        packet->header.timestamp = entry->timestamp;
+        packet->header.sequence = entry->sequence;
+        packet->header.priority = entry->priority;
+        return true;
+      }
+      snapshot->has_slot = false;
+    }
+
+    if(snapshot->position == snapshot->end) {
       return false;
     }
 
-    // Recuperar paquete
-    *packet = telem_buffer.buffer[telem_buffer.read_index];
-    telem_buffer.read_index = (telem_buffer.read_index + 1) % TELEM_BUFFER_SIZE;
-    telem_buffer.packets_read++;
+    uint32_t position = snapshot->position++;
+    if(!storage_snapshot_copy(position, &snapshot->slot)) {
+      snapshot->skipped++;
+      continue;
+    }
 
-    xSemaphoreGive(telem_buffer.mutex);
+    if(snapshot->slot.packet.header.type == TELEM_STORAGE_REPEAT_TYPE) {
+      snapshot->has_slot = true;
+      snapshot->entry = 0;
+      continue;
+    }
+
+    *packet = snapshot->slot.packet;
+    if((uint32_t)packet->header.type < TELEM_TYPE_COUNT) {
+      snapshot->last[packet->header.type] = *packet;
+      snapshot->valid_mask |= 1u << packet->header.type;
+    }
     return true;
   }
-  return false;
 }
 
 uint32_t telemetry_available_packets(void) {
   uint32_t available = 0;
-  if(xSemaphoreTake(telem_buffer.mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+  if(telemetry_lock_take(&telem_buffer.mutex, pdMS_TO_TICKS(50))) {
+    available = telem_buffer.pending_packets;
+    telemetry_lock_give(&telem_buffer.mutex);
+  }
+  return available;
+}
+
+uint32_t telemetry_free_space(void) {
+  uint32_t used = 0;
+  if(telemetry_lock_take(&telem_buffer.mutex, pdMS_TO_TICKS(50))) {
     if(telem_buffer.write_index >= telem_buffer.read_index) {
-      available = telem_buffer.write_index - telem_buffer.read_index;
+      used = telem_buffer.write_index - telem_buffer.read_index;
     } else {
-      available = TELEM_BUFFER_SIZE - telem_buffer.read_index + telem_buffer.write_index;
+      used = TELEM_BUFFER_SIZE - telem_buffer.read_index + telem_buffer.write_index;
     }
-    xSemaphoreGive(telem_buffer.mutex);
+    telemetry_lock_give(&telem_buffer.mutex);
   }
-  return available;
-}
\ No newline at end of file
+  return (TELEM_BUFFER_SIZE - 1) - used;
+}
+
+uint32_t telemetry_deduplicated_packets(void) {
+  uint32_t deduplicated = 0;
+  if(telemetry_lock_take(&telem_buffer.mutex, pdMS_TO_TICKS(50))) {
+    deduplicated = telem_buffer.packets_deduplicated;
+    telemetry_lock_give(&telem_buffer.mutex);
+  }
+  return deduplicated;
+}
+
+void telemetry_get_stats(uint32_t* written, uint32_t* read, uint32_t* lost) {
+  *written = 0;
+  *read = 0;
+  *lost = 0;
+  if(telemetry_lock_take(&telem_buffer.mutex, pdMS_TO_TICKS(50))) {
+    *written = telem_buffer.packets_written;
+    *read = telem_buffer.packets_read;
+    *lost = telem_buffer.packets_lost;
+    telemetry_lock_give(&telem_buffer.mutex);
+  }
+}
+
+void telemetry_get_pool_stats(uint32_t* in_use, uint32_t* high_water, uint32_t* exhausted) {
+  telemetry_pool_get_stats(in_use, high_water, exhausted);
+}
@@ -21,120 +21,527 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "../include/telemetry_storage.h"
 #include "../include/telemetry_generators.h"
 #include "../include/telemetry_tasks.h"
 #include "../include/telemetry_logger.h"
+#include "../include/telemetry_sleep.h"
+#include "../include/telemetry_energy.h"
+#include "../include/telemetry_arena.h"
+#include "../include/telemetry_downlink.h"
+#include "../include/telemetry_housekeeping.h"
+#include "../include/telemetry_archive.h"
+#include "../include/telemetry_entropy.h"
+#include "../include/telemetry_auth.h"
+#include "../include/telemetry_timecorr.h"
+#include "../include/telemetry_timers.h"
+#include "../include/telemetry_lock.h"
+#include "../include/telemetry_coroutine.h"
+#include "../include/telemetry_isr.h"
+#include "../include/telemetry_topics.h"
+#include "../include/telemetry_bus.h"
 
+static_assert(2 * TELEM_BUS_TIMEOUT_MS * 1000 < TELEM_COOP_STALL_BUDGET_US,
+              "Una lectura por bus fallida no puede agotar el margen del modo cooperativo");
 
-void vTelemetryCollectorTask(void *pvParameters) {
-  TickType_t xLastWakeTime = xTaskGetTickCount();
+static void collector_body(telemetry_co_t* co);
+static void processor_body(telemetry_co_t* co);
+static void transmitter_body(telemetry_co_t* co);
+
+static telemetry_co_t collector_co = TELEM_CO_INITIALIZER("collector", collector_body);
+static telemetry_co_t processor_co = TELEM_CO_INITIALIZER("processor", processor_body);
+static telemetry_co_t transmitter_co = TELEM_CO_INITIALIZER("transmitter", transmitter_body);
+
+/** @brief Corrutina de cada etapa, en orden de reanudación */
+typedef struct {
+  telemetry_co_t* co;
+  telem_energy_stage_t stage;
+} task_coroutine_t;
+
+static const task_coroutine_t task_coroutines[] = {
+  { &collector_co, TELEM_STAGE_COLLECTOR },
+  { &processor_co, TELEM_STAGE_PROCESSOR },
+  { &transmitter_co, TELEM_STAGE_TRANSMITTER }
+};
+
+/**
+ * @brief Callback de temporizador que despierta a una corrutina
+ *
+ * @details Se ejecuta en la tarea de servicio (TELEM_TIMER_WORKER_SERVICE):
+ * solo señaliza, el trabajo lo hace la corrutina en su tarea.
+ */
+static void wake_coroutine(void* arg) {
+  telemetry_co_signal((telemetry_co_t*)arg);
+}
 
+/** @brief Suscripción del procesador al bus de temas */
+static telem_topic_sub_t processor_topic = TELEM_TOPIC_INVALID;
+
+/**
+ * @brief Suscripción del archivo en el modo cooperativo
+ *
+ * @details Con ella el archivo se escribe en telemetry_coop_io_service() y
+ * no en el procesador; sin ella (o si no se pudo crear) lo escribe el
+ * procesador.
+ */
+static telem_topic_sub_t archive_topic = TELEM_TOPIC_INVALID;
+
+/**
+ * @brief Destino de los paquetes del recolector
+ *
+ * @details El buffer principal es la cola de la bajada y solo lo vacía el
+ * transmisor; los consumidores a bordo reciben el paquete por el bus. Si el
+ * pool del bus está agotado el paquete sigue en el buffer (se devuelve si
+ * se guardó allí), pero los suscriptores no lo ven: se avisa en el log y
+ * cada suscriptor lo cuenta en sus estadísticas.
+ */
+static bool collector_publish(const telemetry_packet_t* packet) {
+  bool stored = telemetry_store_packet(packet);
+  if(!telemetry_topic_publish_packet(packet)) {
+    telemetry_logf("⚠️ Topic pool exhausted: type %d not delivered on board (Seq=%d)",
+                   packet->header.type, packet->header.sequence);
+  }
+  return stored;
+}
+
+/**
+ * @brief Aviso de las fuentes de interrupción: despierta al recolector
+ */
+static void IRAM_ATTR wake_collector_from_isr(BaseType_t* woken) {
+  telemetry_co_signal_from_isr(&collector_co, woken);
+}
+
+/**
+ * @brief Arranque del recolector: contadores, buffer y lote de bajo consumo
+ */
+static void collector_start(void) {
+  bool counters_restored = telemetry_generators_init();
   telemetry_storage_init();
+  telemetry_lock_register_generator();
+  telemetry_generators_set_sink(collector_publish);
+  // Con el buffer listo, las interrupciones ya pueden despertar al recolector
+  telemetry_isr_set_notify(wake_collector_from_isr);
   telemetry_logf("🚀 Telemetry Collector Task Started");
 
-  for(;;) {
-    generate_system_telemetry();
-    generate_power_telemetry();
-    generate_temperature_telemetry(); 
-    generate_subsystem_telemetry();
-    
-    // En WOKWI podemos usar intervalos más cortos para ver datos rápido
-    vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(5000)); // 5 segundos
+  if(telemetry_storage_was_restored() || counters_restored) {
+    telemetry_logf("♻️ Warm restart: %lu packets recovered, sequence resumed=%s",
+                   telemetry_available_packets(),
+                   counters_restored ? "yes" : "no");
   }
+
+#ifdef TELEM_LOW_POWER_MODE
+  uint32_t batched = telemetry_sleep_flush_batch(collector_publish);
+  telemetry_sleep_stats_t sleep_stats;
+  telemetry_sleep_get_stats(&sleep_stats);
+  telemetry_logf("💤 Low-power batch: %lu packets | Samples=%lu | Wakes=%lu | ~%lu uJ/sample",
+                 batched, sleep_stats.samples, sleep_stats.full_wakes,
+                 sleep_stats.energy_per_sample_uj);
+#endif
 }
 
+/**
+ * @brief Fusiona los paquetes de las interrupciones y ejecuta los generadores
+ * vencidos (el bus de temas avisa a los suscriptores)
+ *
+ * @return uint32_t Milisegundos hasta el próximo vencimiento
+ */
+static uint32_t collector_cycle(void) {
+  int64_t work_start = esp_timer_get_time();
+  telemetry_energy_add_packets(telemetry_isr_drain(collector_publish));
+  uint32_t wait_ms = telemetry_generators_run_due(pdTICKS_TO_MS(xTaskGetTickCount()));
+  telemetry_energy_add_active(TELEM_STAGE_COLLECTOR, (uint32_t)(esp_timer_get_time() - work_start));
+  return wait_ms;
+}
 
-void vTelemetryProcessorTask(void *pvParameters) {
-  telemetry_packet_t packet;
-  uint32_t processed_count = 0;
+static void collector_body(telemetry_co_t* co) {
+  static telemetry_timer_t tick_timer;
 
-  telemetry_logf("🔧 Telemetry Processor Task Started");
+  TELEM_CO_BEGIN(co);
+  telemetry_timer_setup(&tick_timer, "collector", wake_coroutine, co, TELEM_TIMER_WORKER_SERVICE);
+  collector_start();
 
   for(;;) {
-    if(telemetry_retrieve_packet(&packet)) {
-      processed_count++;
-
-      // Visualización
-      switch(packet.header.type) {
-        case TELEM_SYSTEM_STATUS:
-          telemetry_logf("📊 SYSTEM: Uptime=%lus | Heap=%lu | Tasks=%d | CPU Temp=%.1fC | Seq=%d",
-          packet.system.uptime_seconds,
-          packet.system.heap_free,
-          packet.system.task_count,
-          packet.system.cpu_temperature,
-          packet.header.sequence);
-        break;
-
-        case TELEM_POWER_DATA:
-          telemetry_logf("🔋 POWER: Bat=%.2fV | Level=%d%% | Temp=%dC | Seq=%d", 
-          packet.power.battery_voltage,
-          packet.power.battery_level,
-          packet.power.battery_temperature,
-          packet.header.sequence);
-        break;
-
-        case TELEM_TEMPERATURE_DATA:
-          telemetry_logf("🌡️ TEMP: OBC=%dC | COMMS=%dC | PAYLOAD=%dC | Seq=%d",
-          packet.temperature.obc_temperature,
-          packet.temperature.comms_temperature,
-          packet.temperature.payload_temperature, 
-          packet.header.sequence);
-        break;
-
-        case TELEM_COMMUNICATION_STATUS:
-          telemetry_logf("📡 COMMS: Status=%d | Uptime=%lu | Success=%d%% | Seq=%d",
-					packet.subsystems.comms_status,
-          packet.subsystems.comms_uptime,
-          packet.subsystems.command_success_rate,
-          packet.header.sequence);
-        break;
+    // Dormir hasta el próximo vencimiento (TELEM_GENERATOR_PERIOD_MS para los generadores propios)
+    // o hasta que una interrupción deje un paquete
+    telemetry_timer_start(&tick_timer, collector_cycle(), 0);
+    TELEM_CO_AWAIT_SIGNAL(co, TELEM_CO_FOREVER);
+  }
+  TELEM_CO_END(co);
+}
+
+
+/**
+ * @brief Muestra un paquete de telemetría en el log
+ *
+ * @details Los registros combinados de housekeeping se expanden y cada
+ * carga útil presente se muestra como su paquete simple equivalente.
+ */
+static void log_packet(const telemetry_packet_t* packet) {
+  // Visualización
+  switch(packet->header.type) {
+    case TELEM_SYSTEM_STATUS:
+      telemetry_logf("📊 SYSTEM: Uptime=%lus | Heap=%lu | Tasks=%d | CPU Temp=%.1fC | Seq=%d",
+      packet->system.uptime_seconds,
+      packet->system.heap_free,
+      packet->system.task_count,
+      packet->system.cpu_temperature,
+      packet->header.sequence);
+    break;
+
+    case TELEM_POWER_DATA:
+      telemetry_logf("🔋 POWER: Bat=%.2fV | Level=%d%% | Temp=%dC | Seq=%d", 
+      packet->power.battery_voltage,
+      packet->power.battery_level,
+      packet->power.battery_temperature,
+      packet->header.sequence);
+    break;
+
+    case TELEM_TEMPERATURE_DATA:
+      telemetry_logf("🌡️ TEMP: OBC=%dC | COMMS=%dC | PAYLOAD=%dC | Seq=%d",
+      packet->temperature.obc_temperature,
+      packet->temperature.comms_temperature,
+      packet->temperature.payload_temperature, 
+      packet->header.sequence);
+    break;
+
+    case TELEM_COMMUNICATION_STATUS:
+      telemetry_logf("📡 COMMS: Status=%d | Uptime=%lu | Success=%d%% | Seq=%d",
+					packet->subsystems.comms_status,
+      packet->subsystems.comms_uptime,
+      packet->subsystems.command_success_rate,
+      packet->header.sequence);
+    break;
+
+    case TELEM_HOUSEKEEPING: {
+      telemetry_packet_t part;
+      telemetry_logf("🧾 HOUSEKEEPING: Presence=0x%02X | %d bytes | Seq=%d",
+      packet->housekeeping.presence,
+      packet->housekeeping.payload_length,
+      packet->header.sequence);
+      for(int type = TELEM_SYSTEM_STATUS; type < TELEM_HOUSEKEEPING; type++) {
+        if(telemetry_hk_extract(&packet->housekeeping, (telem_data_type_t)type, &part)) {
+          log_packet(&part);
+        }
       }
+    }
+    break;
+  }
+}
+
+/**
+ * @brief Procesa el siguiente paquete recibido por el bus de temas
+ *
+ * @return true Si había un paquete
+ */
+static bool processor_next_packet(void) {
+  static uint32_t processed_count = 0;
+  telem_pool_handle_t handle;
+
+  int64_t work_start = esp_timer_get_time();
+  if(!telemetry_topic_receive(processor_topic, &handle, 0)) {
+    return false;
+  }
+
+  // El paquete se consulta directamente en el pool, sin copias adicionales
+  const telemetry_packet_t* packet = telemetry_pool_get(handle);
+  processed_count++;
+
+  log_packet(packet);
+  if(__atomic_load_n(&archive_topic, __ATOMIC_ACQUIRE) == TELEM_TOPIC_INVALID) {
+    telemetry_archive_append(packet);
+  }
 
   telemetry_logf("   Available packets: %lu", telemetry_available_packets());
+  telemetry_pool_release(handle);
+  telemetry_energy_add_active(TELEM_STAGE_PROCESSOR, (uint32_t)(esp_timer_get_time() - work_start));
+  return true;
+}
 
-		} else {
-      vTaskDelay(pdMS_TO_TICKS(1000));
+static void processor_body(telemetry_co_t* co) {
+  TELEM_CO_BEGIN(co);
+  telemetry_logf("🔧 Telemetry Processor Task Started");
+  processor_topic = telemetry_topic_subscribe("processor", TELEM_TOPIC_ALL, wake_coroutine, co);
+  if(__atomic_load_n(&archive_topic, __ATOMIC_ACQUIRE) == TELEM_TOPIC_INVALID) {
+    telemetry_archive_init();
+  }
+
+  for(;;) {
+    if(processor_next_packet()) {
+      // Un paquete por turno para no retrasar a las demás corrutinas de la tarea
+      TELEM_CO_YIELD(co);
+    } else {
+      // Sin trabajo pendiente: el bloque parcial del archivo se lleva al soporte
+      if(__atomic_load_n(&archive_topic, __ATOMIC_ACQUIRE) == TELEM_TOPIC_INVALID) {
+        telemetry_archive_flush();
+      }
+      TELEM_CO_AWAIT_SIGNAL(co, 1000);
     }
   }
+  TELEM_CO_END(co);
 }
 
-void vTelemetryTransmitterTask(void *pvParameters) {
-  telemetry_packet_t packet;
-  bool ground_station_available = false;
-  uint32_t transmission_count = 0;
-
+/**
+ * @brief Arranque del transmisor: época de reloj, autenticación y ventanas de contacto
+ */
+static void transmitter_start(telemetry_timer_t* contact_timer, telemetry_co_t* co) {
   telemetry_logf("📡 Telemetry Transmitter Task Started");
+  telemetry_timecorr_init();
+#ifdef TELEM_DOWNLINK_AUTH
+  if(!telemetry_auth_init()) {
+    telemetry_logf("⚠️ Downlink authentication unavailable: packets held until frames can be sealed");
+  }
+#endif
+
+  // Simular una ventana de contacto con la estación terrestre cada 30 segundos
+  telemetry_timer_setup(contact_timer, "contact", wake_coroutine, co, TELEM_TIMER_WORKER_SERVICE);
+  telemetry_timer_start(contact_timer, TELEM_CONTACT_PERIOD_MS, TELEM_CONTACT_PERIOD_MS);
+}
+
+/**
+ * @brief Sella una trama antes de entregarla (siempre true sin `TELEM_DOWNLINK_AUTH`)
+ *
+ * @details Con la autenticación activa una trama que no se puede sellar no
+ * sale en claro: el llamador la descarta.
+ */
+static bool transmitter_seal(telemetry_frame_t* frame) {
+#ifdef TELEM_DOWNLINK_AUTH
+  return telemetry_frame_seal(frame);
+#else
+  (void)frame;
+  return true;
+#endif
+}
+
+static void transmitter_body(telemetry_co_t* co) {
+  static telemetry_timer_t contact_timer;
+  static telemetry_packet_t packet;
+  static uint32_t transmission_count = 0;
+  static uint16_t frame_sequence = 0;
+  // Estado de la pasada en curso: sobrevive a las esperas entre paquetes
+  static uint32_t available;
+  static telemetry_frame_t* sent_frames;
+  static uint32_t frames_in_pass;
+  static bool pending;
+  static uint8_t* frame_buffer;
+  static telemetry_frame_t* frame;
+#ifdef TELEM_DOWNLINK_ENTROPY
+  static uint8_t* entropy_scratch;
+#endif
+
+  TELEM_CO_BEGIN(co);
+  transmitter_start(&contact_timer, co);
 
   for(;;) {
-    // Simular disponibilidad aleatoria de estación terrestre
-    if((xTaskGetTickCount() / 1000) % 30 == 0) { // Cada ~30 segundos
-      ground_station_available = true;
-      telemetry_logf("\n🎯 GROUND STATION CONTACT WINDOW OPEN!");
+    TELEM_CO_AWAIT_SIGNAL(co, TELEM_CO_FOREVER);
+    telemetry_logf("\n🎯 GROUND STATION CONTACT WINDOW OPEN!");
+
+    available = telemetry_available_packets();
+#ifdef TELEM_DOWNLINK_AUTH
+    // Sin clave o sin nonces no sale nada: los paquetes esperan en el almacenamiento
+    if(available > 0 && (!telemetry_auth_init() || !telemetry_auth_ready())) {
+      telemetry_logf("🔒 Downlink authentication unavailable: %lu packets held", available);
+      available = 0;
     }
+#endif
+    if(available > 0) {
+      telemetry_logf("📤 TRANSMITTING %lu packets to ground...", available);
 
-    if(ground_station_available) {
-      uint32_t available = telemetry_available_packets();
+      // Estado de retransmisión de la pasada: las tramas enviadas se conservan en la arena hasta LOS
+      sent_frames = (telemetry_frame_t*)telemetry_arena_alloc(
+        TELEM_FRAMES_PER_PASS * sizeof(telemetry_frame_t));
+      frames_in_pass = 0;
+      pending = true;
+#ifdef TELEM_DOWNLINK_ENTROPY
+      entropy_scratch = (uint8_t*)telemetry_arena_alloc(TELEM_FRAME_MAX_PAYLOAD);
+#endif
 
-      if(available > 0) {
-        telemetry_logf("📤 TRANSMITTING %lu packets to ground...", available);
+      while(pending && sent_frames != NULL && frames_in_pass < TELEM_FRAMES_PER_PASS) {
+#ifdef TELEM_DOWNLINK_AUTH
+        static const size_t frame_capacity = sizeof(telem_frame_header_t) + TELEM_FRAME_MAX_PAYLOAD + TELEM_AUTH_OVERHEAD;
+#else
+        static const size_t frame_capacity = sizeof(telem_frame_header_t) + TELEM_FRAME_MAX_PAYLOAD;
+#endif
+        frame_buffer = (uint8_t*)telemetry_arena_alloc(frame_capacity);
+        if(frame_buffer == NULL) {
+          break; // Arena agotada: el resto espera a la siguiente pasada
+        }
 
-        while(telemetry_retrieve_packet(&packet)) {
-          transmission_count++;
-          telemetry_logf("   📦 [%lu] Type=%d, Seq=%d, Time=%lu",
-          transmission_count, packet.header.type,
-          packet.header.sequence, packet.header.timestamp);
+        frame = &sent_frames[frames_in_pass];
+        telemetry_frame_begin(frame, frame_buffer, frame_capacity, frame_sequence);
 
-          // Pequeña pausa para simular transmisión
-          vTaskDelay(pdMS_TO_TICKS(50));
+        while(telemetry_frame_has_room(frame) && (pending = telemetry_retrieve_packet(&packet))) {
+          { // Bloque propio: sus variables no pueden cruzar la espera
+            int64_t work_start = esp_timer_get_time();
+            // Con sitio garantizado, solo falla un tipo que no se puede codificar
+            if(telemetry_frame_add_packet(frame, &packet)) {
+              transmission_count++;
+              telemetry_logf("   📦 [%lu] Type=%d, Seq=%d, Time=%lu",
+              transmission_count, packet.header.type,
+              packet.header.sequence, packet.header.timestamp);
+            } else {
+              telemetry_logf("   ❌ Packet dropped: type %d cannot be encoded (Seq=%d)",
+                             packet.header.type, packet.header.sequence);
+            }
+            telemetry_energy_add_active(TELEM_STAGE_TRANSMITTER, (uint32_t)(esp_timer_get_time() - work_start));
+          }
+
+          // Pequeña pausa para simular transmisión (las demás corrutinas siguen)
+          TELEM_CO_SLEEP(co, 50);
+        }
+
+        telem_frame_header_t* header = telemetry_frame_header(frame);
+        if(header->packet_count == 0) {
+          break;
         }
 
-        telemetry_logf("✅ Transmission complete. Total sent: %lu packets", transmission_count);
+#ifdef TELEM_DOWNLINK_ENTROPY
+        size_t raw_length = frame->length;
+        if(entropy_scratch != NULL &&
+           telemetry_frame_compress(frame, entropy_scratch, TELEM_FRAME_MAX_PAYLOAD)) {
+          telemetry_logf("   🗜️ Frame #%u compressed: %u -> %u bytes",
+                         header->frame_sequence, (unsigned)raw_length, (unsigned)frame->length);
+        }
+#endif
+        if(!transmitter_seal(frame)) {
+          // Nunca en claro: se pierde esta trama y el resto espera a la siguiente pasada
+          telemetry_logf("   ❌ Frame #%u dropped: sealing failed (%u packets)",
+                         header->frame_sequence, header->packet_count);
+          break;
+        }
+        // Entrega de la trama: instante de emisión de su marcador
+        telemetry_timecorr_mark(header->frame_sequence);
+        telemetry_logf("   🧱 Frame #%u: %u packets, %u bytes",
+                       header->frame_sequence, header->packet_count, (unsigned)frame->length);
+        frame_sequence++;
+
+        // Correlación de tiempo con el marcador recién emitido
+        if(telemetry_timecorr_due(frames_in_pass)) {
+#ifdef TELEM_DOWNLINK_AUTH
+          const size_t corr_capacity = sizeof(telem_frame_header_t) + sizeof(telem_time_correlation_t) + TELEM_AUTH_OVERHEAD;
+#else
+          const size_t corr_capacity = sizeof(telem_frame_header_t) + sizeof(telem_time_correlation_t);
+#endif
+          uint8_t* corr_buffer = (uint8_t*)telemetry_arena_alloc(corr_capacity);
+          telemetry_frame_t corr_frame;
+          if(corr_buffer != NULL &&
+             telemetry_timecorr_frame(&corr_frame, corr_buffer, corr_capacity, frame_sequence)) {
+            if(!transmitter_seal(&corr_frame)) {
+              telemetry_logf("   ❌ Frame #%u dropped: time correlation could not be sealed", frame_sequence);
+            } else {
+              telemetry_logf("   🕰️ Frame #%u: time correlation for marker #%u",
+                             frame_sequence, header->frame_sequence);
+              frame_sequence++;
+            }
+          }
+        }
+        frames_in_pass++;
       }
 
-      ground_station_available = false;
+      uint32_t arena_used, arena_high_water, arena_failures;
+      telemetry_arena_get_stats(&arena_used, &arena_high_water, &arena_failures);
+      telemetry_logf("✅ Transmission complete. Total sent: %lu packets in %lu frames (arena %lu/%u bytes)",
+                     transmission_count, frames_in_pass, arena_used, (unsigned)TELEM_ARENA_SIZE);
+
+
+      // LOS: liberar de golpe todos los buffers temporales de la pasada
+      telemetry_arena_reset();
     }
+  }
+  TELEM_CO_END(co);
+}
 
-    vTaskDelay(pdMS_TO_TICKS(2000)); // Revisar cada 2 segundos
+/**
+ * @brief Ejecuta corrutinas de telemetría en la tarea actual
+ *
+ * @param entries Corrutinas a multiplexar
+ * @param count Número de corrutinas
+ *
+ * @details Reanuda las que estén listas y bloquea la tarea hasta el plazo más
+ * próximo o hasta que una señal la notifique. Con varias corrutinas en la
+ * misma tarea, la CPU de la tarea se reparte entre sus etapas según el
+ * tiempo activo de cada una, y la flash y la UART de cada reanudación van a
+ * su etapa.
+ */
+static void run_coroutines(const task_coroutine_t* entries, size_t count) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  for(size_t i = 0; i < count; i++) {
+    entries[i].co->task = self;
+    // La CPU de esta tarea se imputa a sus etapas
+    telemetry_energy_register_task(entries[i].stage, self);
   }
-}
\ No newline at end of file
+
+  for(;;) {
+    TickType_t wait = portMAX_DELAY;
+    for(size_t i = 0; i < count; i++) {
+      telemetry_co_t* co = entries[i].co;
+      if(telemetry_co_poll(co) == 0) {
+        telemetry_energy_set_running_stage(entries[i].stage);
+        telemetry_co_resume(co);
+        telemetry_energy_set_running_stage(TELEM_STAGE_SYSTEM);
+      }
+      TickType_t remaining = telemetry_co_poll(co);
+      if(remaining < wait) {
+        wait = remaining;
+      }
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
+  }
+}
+
+void vTelemetryCollectorTask(void *pvParameters) {
+  run_coroutines(&task_coroutines[0], 1);
+}
+
+void vTelemetryProcessorTask(void *pvParameters) {
+  run_coroutines(&task_coroutines[1], 1);
+}
+
+void vTelemetryTransmitterTask(void *pvParameters) {
+  run_coroutines(&task_coroutines[2], 1);
+}
+
+void vTelemetryCoopTask(void *pvParameters) {
+  // La E/S que bloquea sale de la tarea: el log se difiere y el archivo lo
+  // escribe telemetry_coop_io_service() (suscrito antes de que publique el recolector)
+  telemetry_logger_defer_task(xTaskGetCurrentTaskHandle());
+  __atomic_store_n(&archive_topic, telemetry_topic_subscribe("archive", TELEM_TOPIC_ALL, NULL, NULL),
+                   __ATOMIC_RELEASE);
+  run_coroutines(task_coroutines, sizeof(task_coroutines) / sizeof(task_coroutines[0]));
+}
+
+void telemetry_coop_io_service(void *arg) {
+  static bool archive_ready = false;
+  telem_topic_sub_t topic = __atomic_load_n(&archive_topic, __ATOMIC_ACQUIRE);
+  telem_pool_handle_t handle;
+
+  telemetry_log_flush();
+  if(topic == TELEM_TOPIC_INVALID) {
+    return;
+  }
+  if(!archive_ready) {
+    telemetry_archive_init();
+    archive_ready = true;
+  }
+
+  while(telemetry_topic_receive(topic, &handle, 0)) {
+    telemetry_archive_append(telemetry_pool_get(handle));
+    telemetry_pool_release(handle);
+  }
+  // Como el procesador en reposo: el bloque parcial se lleva al soporte si toca
+  telemetry_archive_flush();
+}
+
+void telemetry_tasks_log_summary(void) {
+  for(size_t i = 0; i < sizeof(task_coroutines) / sizeof(task_coroutines[0]); i++) {
+    const telemetry_co_t* co = task_coroutines[i].co;
+    telemetry_logf("%s COOP %s: Resumes=%lu | Longest=%luus (budget %luus)",
+                   co->max_run_us > TELEM_COOP_STALL_BUDGET_US ? "⚠️" : "🧵",
+                   co->name, co->resumes, co->max_run_us, (unsigned long)TELEM_COOP_STALL_BUDGET_US);
+  }
+  uint32_t dropped = telemetry_log_dropped();
+  if(dropped > 0) {
+    telemetry_logf("⚠️ COOP log: %lu deferred lines dropped", dropped);
+  }
+}
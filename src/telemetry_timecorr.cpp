@@ -0,0 +1,60 @@
+/**
+ * @file telemetry_timecorr.cpp
+ * @brief Implementación de las tramas de correlación de tiempo
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * La época se guarda en memoria RTC (`RTC_DATA_ATTR`): igual que la base de
+ * tiempo de telemetry_sleep.cpp, sobrevive al deep sleep y se pone a cero en
+ * el arranque en frío, así que cambia exactamente cuando cambia el dominio
+ * del reloj local.
+ */
+
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "../include/telemetry_timecorr.h"
+#include "../include/telemetry_sleep.h"
+
+static RTC_DATA_ATTR uint32_t timecorr_epoch = 0;
+
+static telem_time_correlation_t last_marker;
+static bool marker_valid = false;
+
+void telemetry_timecorr_init(void) {
+  if(timecorr_epoch == 0) {
+    timecorr_epoch = esp_random() | 1; // Nunca 0: 0 significa "sin elegir"
+  }
+}
+
+void telemetry_timecorr_mark(uint16_t frame_sequence) {
+  last_marker.marker_local_us = telemetry_sleep_timestamp_us();
+  last_marker.epoch = timecorr_epoch;
+  last_marker.marker_sequence = frame_sequence;
+  marker_valid = true;
+}
+
+bool telemetry_timecorr_due(uint32_t frame_in_pass) {
+  return frame_in_pass % TELEM_TIMECORR_PERIOD == 0;
+}
+
+bool telemetry_timecorr_frame(telemetry_frame_t* frame, uint8_t* buffer, size_t capacity,
+                              uint16_t frame_sequence) {
+  if(!marker_valid) {
+    return false;
+  }
+
+  telemetry_frame_begin(frame, buffer, capacity, frame_sequence);
+  if(frame->length + sizeof(last_marker) > frame->capacity) {
+    return false;
+  }
+
+  memcpy(frame->data + frame->length, &last_marker, sizeof(last_marker));
+  frame->length += sizeof(last_marker);
+
+  telem_frame_header_t* header = telemetry_frame_header(frame);
+  header->flags = TELEM_FRAME_FLAG_TIMECORR;
+  header->payload_length = sizeof(last_marker);
+  return true;
+}
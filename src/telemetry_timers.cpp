@@ -0,0 +1,367 @@
+/**
+ * @file telemetry_timers.cpp
+ * @brief Implementación de la rueda jerárquica de temporizadores
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details
+ * wheel_next es el próximo tick por procesar: todo lo que vence antes ya se
+ * ha disparado. Un temporizador a distancia d de wheel_next va al nivel más
+ * bajo que cubre d y a la ranura (vencimiento >> 6·nivel) & 63. Cuando el
+ * índice del nivel 0 vuelve a cero se vacía la ranura actual del nivel 1 (y,
+ * si también vuelve a cero, la del 2, etc.) reinsertando sus temporizadores.
+ *
+ * La rueda se protege con un mutex; los callbacks siempre se ejecutan fuera
+ * de él, así que pueden rearmar temporizadores.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "../include/telemetry_timers.h"
+
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS)
+#define TIMER_SLOT_MASK (TIMER_SLOTS - 1)
+
+/** @brief Mayor distancia representable; más lejos se vuelve a colocar al bajar de nivel */
+#define TIMER_MAX_DELTA ((1u << (TELEM_TIMER_LEVELS * TIMER_SLOT_BITS)) - 1)
+
+/** @brief Disparos recogidos por pasada antes de soltar el mutex */
+#define TIMER_BATCH 8
+
+#define TIMER_FLAG_ACTIVE 0x01    /**< En la rueda */
+#define TIMER_FLAG_QUEUED 0x02    /**< Disparado y pendiente de ejecutar */
+
+static telemetry_timer_t* wheel[TELEM_TIMER_LEVELS][TIMER_SLOTS];
+static uint64_t occupied[TELEM_TIMER_LEVELS];
+static uint32_t wheel_next;
+
+/** @brief Vencimiento por el que espera la tarea de servicio */
+static uint32_t service_deadline;
+static bool service_idle = true;
+
+static SemaphoreHandle_t timer_mutex = NULL;
+static TaskHandle_t service_task = NULL;
+static QueueHandle_t worker_queues[TELEM_TIMER_WORKER_COUNT];
+static telemetry_timer_stats_t timer_stats;
+
+/**
+ * @brief Rota un mapa de ranuras para que el bit 0 sea la ranura start
+ */
+static uint64_t timer_rotate(uint64_t bits, uint32_t start) {
+  return start == 0 ? bits : (bits >> start) | (bits << (TIMER_SLOTS - start));
+}
+
+/**
+ * @brief Inserta un temporizador en su nivel y ranura (O(1))
+ */
+static void timer_link(telemetry_timer_t* timer) {
+  uint32_t expires = timer->expires;
+  int32_t delta = (int32_t)(expires - wheel_next);
+
+  if(delta < 0) {
+    expires = wheel_next;
+    delta = 0;
+  } else if((uint32_t)delta > TIMER_MAX_DELTA) {
+    expires = wheel_next + TIMER_MAX_DELTA;
+    delta = TIMER_MAX_DELTA;
+  }
+
+  int level = 0;
+  while(level < TELEM_TIMER_LEVELS - 1 && (uint32_t)delta >= (1u << (TIMER_SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  uint32_t slot = (expires >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK;
+
+  telemetry_timer_t** head = &wheel[level][slot];
+  timer->prev = NULL;
+  timer->next = *head;
+  if(*head != NULL) {
+    (*head)->prev = timer;
+  }
+  *head = timer;
+  occupied[level] |= 1ULL << slot;
+
+  timer->level = (uint8_t)level;
+  timer->slot = (uint8_t)slot;
+  timer->flags |= TIMER_FLAG_ACTIVE;
+  timer_stats.active++;
+}
+
+/**
+ * @brief Saca un temporizador de la rueda (O(1))
+ */
+static void timer_unlink(telemetry_timer_t* timer) {
+  if(timer->prev != NULL) {
+    timer->prev->next = timer->next;
+  } else {
+    wheel[timer->level][timer->slot] = timer->next;
+    if(timer->next == NULL) {
+      occupied[timer->level] &= ~(1ULL << timer->slot);
+    }
+  }
+  if(timer->next != NULL) {
+    timer->next->prev = timer->prev;
+  }
+  timer->next = timer->prev = NULL;
+  timer->flags &= ~TIMER_FLAG_ACTIVE;
+  timer_stats.active--;
+}
+
+/**
+ * @brief Baja de nivel la ranura actual de un nivel (y de los superiores si también dan la vuelta)
+ */
+static void timer_cascade(int level) {
+  uint32_t slot = (wheel_next >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK;
+
+  if(slot == 0 && level + 1 < TELEM_TIMER_LEVELS) {
+    timer_cascade(level + 1);
+  }
+
+  telemetry_timer_t* timer = wheel[level][slot];
+  wheel[level][slot] = NULL;
+  occupied[level] &= ~(1ULL << slot);
+  while(timer != NULL) {
+    telemetry_timer_t* next = timer->next;
+    timer_stats.active--;
+    timer_link(timer);
+    timer_stats.cascades++;
+    timer = next;
+  }
+}
+
+/**
+ * @brief Procesa los ticks hasta now y recoge los temporizadores vencidos
+ *
+ * @return uint32_t Disparos recogidos; si se llena el lote, la siguiente
+ * llamada continúa en la misma ranura
+ */
+static uint32_t timer_advance(uint32_t now, telemetry_timer_t** fired) {
+  uint32_t count = 0;
+
+  while((int32_t)(now - wheel_next) >= 0) {
+    uint32_t index = wheel_next & TIMER_SLOT_MASK;
+    if(index == 0) {
+      timer_cascade(1);
+    }
+
+    telemetry_timer_t* timer;
+    while((timer = wheel[0][index]) != NULL) {
+      if(count == TIMER_BATCH) {
+        return count;
+      }
+      timer_unlink(timer);
+      timer_stats.expirations++;
+
+      if(timer->flags & TIMER_FLAG_QUEUED) {
+        timer->overruns++;
+        timer_stats.overruns++;
+      } else {
+        timer->flags |= TIMER_FLAG_QUEUED;
+        timer->due = timer->expires;
+        fired[count++] = timer;
+      }
+
+      if(timer->period != 0) {
+        timer->expires += timer->period;
+        if((int32_t)(timer->expires - now) <= 0) {
+          timer->expires = now + timer->period;
+        }
+        timer_link(timer);
+      }
+    }
+
+    // Saltar los ticks vacíos hasta la siguiente ranura ocupada o el límite de bloque
+    uint64_t ahead = index == TIMER_SLOT_MASK ? 0 : occupied[0] >> (index + 1);
+    uint32_t step = ahead != 0 ? (uint32_t)__builtin_ctzll(ahead) + 1 : TIMER_SLOTS - index;
+    uint32_t remaining = now - wheel_next + 1;
+    wheel_next += step < remaining ? step : remaining;
+  }
+  return count;
+}
+
+/**
+ * @brief Próximo vencimiento exacto
+ *
+ * @return true Si hay algún temporizador en la rueda
+ */
+static bool timer_next_deadline(uint32_t* deadline) {
+  bool found = false;
+
+  // Nivel 0: la ranura es el tick exacto
+  uint32_t index = wheel_next & TIMER_SLOT_MASK;
+  uint64_t rotated = timer_rotate(occupied[0], index);
+  if(rotated != 0) {
+    *deadline = wheel_next + (uint32_t)__builtin_ctzll(rotated);
+    found = true;
+  }
+
+  // Niveles superiores: la ranura actual (pendiente de bajar si el índice
+  // inferior está en cero, o a una vuelta completa) y la primera ocupada tras ella
+  for(int level = 1; level < TELEM_TIMER_LEVELS; level++) {
+    if(occupied[level] == 0) {
+      continue;
+    }
+    uint32_t current = (wheel_next >> (TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK;
+    uint32_t start = (current + 1) & TIMER_SLOT_MASK;
+    uint32_t slots[2] = {
+      current,
+      (start + (uint32_t)__builtin_ctzll(timer_rotate(occupied[level], start))) & TIMER_SLOT_MASK
+    };
+    for(int i = 0; i < 2; i++) {
+      for(telemetry_timer_t* timer = wheel[level][slots[i]]; timer != NULL; timer = timer->next) {
+        if(!found || (int32_t)(timer->expires - *deadline) < 0) {
+          *deadline = timer->expires;
+          found = true;
+        }
+      }
+    }
+  }
+  return found;
+}
+
+/**
+ * @brief Ejecuta un disparo salvo que se haya cancelado mientras esperaba
+ */
+static void timer_run(telemetry_timer_t* timer) {
+  xSemaphoreTake(timer_mutex, portMAX_DELAY);
+  bool pending = (timer->flags & TIMER_FLAG_QUEUED) != 0;
+  timer->flags &= ~TIMER_FLAG_QUEUED;
+  uint32_t latency_ms = pdTICKS_TO_MS(xTaskGetTickCount() - timer->due);
+  if(pending && latency_ms > timer_stats.max_latency_ms) {
+    timer_stats.max_latency_ms = latency_ms;
+  }
+  xSemaphoreGive(timer_mutex);
+
+  if(pending) {
+    timer->runs++;
+    timer->callback(timer->arg);
+  }
+}
+
+/**
+ * @brief Tarea de servicio: procesa los vencimientos y duerme hasta el siguiente
+ */
+static void timer_service_task(void* pvParameters) {
+  telemetry_timer_t* fired[TIMER_BATCH];
+
+  for(;;) {
+    xSemaphoreTake(timer_mutex, portMAX_DELAY);
+    uint32_t now = xTaskGetTickCount();
+    uint32_t count = timer_advance(now, fired);
+
+    TickType_t wait = 0;
+    if(count < TIMER_BATCH) {
+      uint32_t deadline;
+      service_idle = !timer_next_deadline(&deadline);
+      if(service_idle) {
+        wait = portMAX_DELAY;
+      } else {
+        service_deadline = deadline;
+        wait = (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+      }
+    }
+    xSemaphoreGive(timer_mutex);
+
+    for(uint32_t i = 0; i < count; i++) {
+      telemetry_timer_t* timer = fired[i];
+      if(timer->worker == TELEM_TIMER_WORKER_SERVICE) {
+        timer_run(timer);
+      } else if(xQueueSend(worker_queues[timer->worker], &timer, 0) != pdTRUE) {
+        xSemaphoreTake(timer_mutex, portMAX_DELAY);
+        timer->flags &= ~TIMER_FLAG_QUEUED;
+        timer->overruns++;
+        timer_stats.overruns++;
+        xSemaphoreGive(timer_mutex);
+      }
+    }
+
+    if(wait != 0) {
+      timer_stats.wakeups++;
+      ulTaskNotifyTake(pdTRUE, wait);
+    }
+  }
+}
+
+bool telemetry_timers_init(void) {
+  if(service_task != NULL) {
+    return true;
+  }
+
+  timer_mutex = xSemaphoreCreateMutex();
+  if(timer_mutex == NULL) {
+    return false;
+  }
+  for(int worker = TELEM_TIMER_WORKER_SERVICE + 1; worker < TELEM_TIMER_WORKER_COUNT; worker++) {
+    worker_queues[worker] = xQueueCreate(TELEM_TIMER_QUEUE_LENGTH, sizeof(telemetry_timer_t*));
+    if(worker_queues[worker] == NULL) {
+      return false;
+    }
+  }
+
+  wheel_next = xTaskGetTickCount();
+  return xTaskCreate(timer_service_task, "TelemTimers", 2048, NULL,
+                     TELEM_TIMER_TASK_PRIORITY, &service_task) == pdPASS;
+}
+
+void telemetry_timer_setup(telemetry_timer_t* timer, const char* name, telemetry_timer_callback_t callback,
+                           void* arg, telem_timer_worker_t worker) {
+  memset(timer, 0, sizeof(*timer));
+  timer->name = name;
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->worker = (uint8_t)worker;
+}
+
+void telemetry_timer_start(telemetry_timer_t* timer, uint32_t delay_ms, uint32_t period_ms) {
+  xSemaphoreTake(timer_mutex, portMAX_DELAY);
+  if(timer->flags & TIMER_FLAG_ACTIVE) {
+    timer_unlink(timer);
+  }
+  timer->expires = xTaskGetTickCount() + pdMS_TO_TICKS(delay_ms);
+  timer->period = period_ms != 0 && pdMS_TO_TICKS(period_ms) == 0 ? 1 : pdMS_TO_TICKS(period_ms);
+  timer_link(timer);
+
+  // Despertar al servicio solo si este vencimiento es anterior al que esperaba
+  bool earlier = service_idle || (int32_t)(timer->expires - service_deadline) < 0;
+  if(earlier) {
+    service_deadline = timer->expires;
+    service_idle = false;
+  }
+  xSemaphoreGive(timer_mutex);
+
+  if(earlier) {
+    xTaskNotifyGive(service_task);
+  }
+}
+
+void telemetry_timer_stop(telemetry_timer_t* timer) {
+  xSemaphoreTake(timer_mutex, portMAX_DELAY);
+  if(timer->flags & TIMER_FLAG_ACTIVE) {
+    timer_unlink(timer);
+  }
+  timer->flags &= ~TIMER_FLAG_QUEUED;
+  xSemaphoreGive(timer_mutex);
+}
+
+bool telemetry_timers_dispatch(telem_timer_worker_t worker, uint32_t timeout_ms) {
+  telemetry_timer_t* timer;
+  TickType_t timeout = timeout_ms == TELEM_TIMER_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+  if(worker == TELEM_TIMER_WORKER_SERVICE || worker >= TELEM_TIMER_WORKER_COUNT ||
+     worker_queues[worker] == NULL ||
+     xQueueReceive(worker_queues[worker], &timer, timeout) != pdTRUE) {
+    return false;
+  }
+  timer_run(timer);
+  return true;
+}
+
+void telemetry_timers_get_stats(telemetry_timer_stats_t* stats) {
+  xSemaphoreTake(timer_mutex, portMAX_DELAY);
+  *stats = timer_stats;
+  xSemaphoreGive(timer_mutex);
+}
@@ -0,0 +1,201 @@
+/**
+ * @file telemetry_topics.cpp
+ * @brief Implementación del bus de publicación/suscripción
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ */
+
+#include <string.h>
+#include "../include/telemetry_topics.h"
+#include "../include/telemetry_logger.h"
+
+/** @brief Suscriptor registrado */
+typedef struct {
+  const char* name;
+  uint32_t mask;
+  telemetry_topic_notify_t notify;
+  void* arg;
+  QueueHandle_t queue;            /**< Cola de telem_pool_handle_t */
+  uint32_t delivered;
+  uint32_t dropped;
+  uint32_t pool_dropped;
+  uint32_t received;
+  uint32_t high_water;
+} topic_subscriber_t;
+
+static topic_subscriber_t subscribers[TELEM_TOPIC_MAX_SUBSCRIBERS];
+static uint8_t subscriber_count = 0;
+static portMUX_TYPE topic_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Indica si un tipo entra en una máscara de suscripción
+ */
+static bool topic_matches(uint32_t mask, uint8_t type) {
+  if(type >= 32) {
+    return mask == TELEM_TOPIC_ALL;
+  }
+  return (mask & TELEM_TOPIC_MASK(type)) != 0;
+}
+
+telem_topic_sub_t telemetry_topic_subscribe(const char* name, uint32_t mask,
+                                            telemetry_topic_notify_t notify, void* arg) {
+  // La cola se crea fuera de la sección crítica, donde no se puede reservar memoria
+  QueueHandle_t queue = xQueueCreate(TELEM_TOPIC_QUEUE_LENGTH, sizeof(telem_pool_handle_t));
+  if(queue == NULL) {
+    telemetry_logf("❌ Topic queue could not be created: %s not subscribed", name);
+    return TELEM_TOPIC_INVALID;
+  }
+
+  telem_topic_sub_t id = TELEM_TOPIC_INVALID;
+  portENTER_CRITICAL(&topic_mux);
+  if(subscriber_count < TELEM_TOPIC_MAX_SUBSCRIBERS) {
+    id = subscriber_count;
+    topic_subscriber_t* sub = &subscribers[id];
+    memset(sub, 0, sizeof(*sub));
+    sub->queue = queue;
+    sub->name = name;
+    sub->mask = mask;
+    sub->notify = notify;
+    sub->arg = arg;
+    // Publicar el suscriptor completo antes de que lo vea quien publica
+    __atomic_store_n(&subscriber_count, (uint8_t)(id + 1), __ATOMIC_RELEASE);
+  }
+  portEXIT_CRITICAL(&topic_mux);
+
+  if(id == TELEM_TOPIC_INVALID) {
+    vQueueDelete(queue);
+    telemetry_logf("⚠️ Topic bus full: %s not subscribed", name);
+  }
+  return id;
+}
+
+/**
+ * @brief Anota un paquete perdido por falta de bloques en los suscriptores de su tipo
+ */
+static void topic_count_pool_drop(uint8_t type) {
+  uint8_t count = __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE);
+
+  portENTER_CRITICAL(&topic_mux);
+  for(uint8_t id = 0; id < count; id++) {
+    if(topic_matches(subscribers[id].mask, type)) {
+      subscribers[id].pool_dropped++;
+    }
+  }
+  portEXIT_CRITICAL(&topic_mux);
+}
+
+uint32_t telemetry_topic_publish(telem_pool_handle_t handle) {
+  uint8_t type = telemetry_pool_get(handle)->header.type;
+  uint8_t count = __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE);
+  uint32_t delivered = 0;
+
+  for(uint8_t id = 0; id < count; id++) {
+    topic_subscriber_t* sub = &subscribers[id];
+    if(!topic_matches(sub->mask, type)) {
+      continue;
+    }
+
+    // Referencia del suscriptor: la suelta él al recibirlo, o aquí si no cabe
+    telemetry_pool_retain(handle);
+    bool queued = xQueueSend(sub->queue, &handle, 0) == pdTRUE;
+    if(!queued) {
+      telemetry_pool_release(handle);
+    }
+
+    uint32_t depth = queued ? (uint32_t)uxQueueMessagesWaiting(sub->queue) : 0;
+    portENTER_CRITICAL(&topic_mux);
+    if(queued) {
+      sub->delivered++;
+      if(depth > sub->high_water) {
+        sub->high_water = depth;
+      }
+    } else {
+      sub->dropped++;
+    }
+    portEXIT_CRITICAL(&topic_mux);
+
+    if(queued) {
+      delivered++;
+      if(sub->notify != NULL) {
+        sub->notify(sub->arg);
+      }
+    }
+  }
+  return delivered;
+}
+
+bool telemetry_topic_publish_packet(const telemetry_packet_t* packet) {
+  if(__atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE) == 0) {
+    return true; // Nadie escucha: ni siquiera hace falta el bloque
+  }
+
+  telem_pool_handle_t handle = telemetry_pool_alloc();
+  if(handle == TELEM_POOL_INVALID) {
+    topic_count_pool_drop(packet->header.type);
+    return false;
+  }
+  memcpy(telemetry_pool_get(handle), packet, sizeof(*packet));
+  telemetry_topic_publish(handle);
+  telemetry_pool_release(handle);
+  return true;
+}
+
+bool telemetry_topic_receive(telem_topic_sub_t subscriber, telem_pool_handle_t* handle,
+                             TickType_t timeout) {
+  if(subscriber >= __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  topic_subscriber_t* sub = &subscribers[subscriber];
+  if(xQueueReceive(sub->queue, handle, timeout) != pdTRUE) {
+    return false;
+  }
+
+  portENTER_CRITICAL(&topic_mux);
+  sub->received++;
+  portEXIT_CRITICAL(&topic_mux);
+  return true;
+}
+
+uint32_t telemetry_topic_pending(void) {
+  uint8_t count = __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE);
+  uint32_t pending = 0;
+
+  for(uint8_t id = 0; id < count; id++) {
+    pending += (uint32_t)uxQueueMessagesWaiting(subscribers[id].queue);
+  }
+  return pending;
+}
+
+bool telemetry_topic_get_stats(telem_topic_sub_t subscriber, telemetry_topic_stats_t* stats) {
+  if(subscriber >= __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  topic_subscriber_t* sub = &subscribers[subscriber];
+
+  stats->name = sub->name;
+  stats->mask = sub->mask;
+  stats->queued = (uint32_t)uxQueueMessagesWaiting(sub->queue);
+  portENTER_CRITICAL(&topic_mux);
+  stats->delivered = sub->delivered;
+  stats->dropped = sub->dropped;
+  stats->pool_dropped = sub->pool_dropped;
+  stats->received = sub->received;
+  stats->high_water = sub->high_water;
+  portEXIT_CRITICAL(&topic_mux);
+  return true;
+}
+
+void telemetry_topic_log_summary(void) {
+  telemetry_topic_stats_t stats;
+  uint8_t count = __atomic_load_n(&subscriber_count, __ATOMIC_ACQUIRE);
+
+  for(uint8_t id = 0; id < count; id++) {
+    telemetry_topic_get_stats(id, &stats);
+    uint32_t lost = stats.dropped + stats.pool_dropped;
+    uint32_t offered = stats.delivered + lost;
+    telemetry_logf("📬 TOPIC %s: Filter=0x%08lX | Delivered=%lu | Dropped=%lu queue full + %lu no pool block (%.1f%%) | Received=%lu | Queue=%lu/%d (max %lu)",
+                   stats.name, stats.mask, stats.delivered, stats.dropped, stats.pool_dropped,
+                   offered > 0 ? lost * 100.0 / offered : 0.0,
+                   stats.received, stats.queued, TELEM_TOPIC_QUEUE_LENGTH, stats.high_water);
+  }
+}
@@ -0,0 +1,302 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del archivo masivo (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que el vaciado periódico solo escribe el bloque parcial
+ * al llegar al umbral de registros, que en LittleFS los segmentos crecen por
+ * el final sin reescribir lo ya escrito, que lo sincronizado se recupera tras
+ * un reinicio en los dos soportes, que las consultas ven los tipos de los registros de housekeeping,
+ * sueltan el mutex entre tramos y leen de la partición mapeada el histórico
+ * que ya rotó fuera de LittleFS, y mide el camino de escritura con
+ * telemetry_archive_benchmark().
+ * En el PC las cifras son las del disco del anfitrión: sirven para comparar
+ * cambios del camino de escritura, no como rendimiento de la tarjeta SD.
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_archive.h"
+#include "../../include/telemetry_housekeeping.h"
+#include "../../include/telemetry_logger.h"
+#include "../../include/telemetry_mapped.h"
+
+/** @brief Registros por segmento del respaldo LittleFS */
+#define RECORDS_PER_BLOCK (TELEM_ARCHIVE_BLOCK_SIZE / sizeof(telem_archive_record_t))
+#define RECORDS_PER_SEGMENT ((TELEM_ARCHIVE_FALLBACK_SEGMENT_SIZE / TELEM_ARCHIVE_BLOCK_SIZE - 1) * RECORDS_PER_BLOCK)
+
+static telemetry_packet_t power_packet(uint32_t timestamp, float voltage) {
+  telemetry_packet_t packet;
+  memset(&packet, 0, sizeof(packet));
+  packet.header.type = TELEM_POWER_DATA;
+  packet.header.timestamp = timestamp;
+  packet.power.battery_voltage = voltage;
+  return packet;
+}
+
+static telemetry_packet_t temperature_packet(uint32_t timestamp, int16_t celsius) {
+  telemetry_packet_t packet;
+  memset(&packet, 0, sizeof(packet));
+  packet.header.type = TELEM_TEMPERATURE_DATA;
+  packet.header.timestamp = timestamp;
+  packet.temperature.obc_temperature = celsius;
+  return packet;
+}
+
+static void append_temperatures(uint32_t count) {
+  for(uint32_t i = 0; i < count; i++) {
+    telemetry_packet_t packet = temperature_packet(1000 + i, 20);
+    TEST_ASSERT_TRUE(telemetry_archive_append(&packet));
+  }
+}
+
+static uint32_t flushes(void) {
+  telemetry_archive_stats_t stats;
+  telemetry_archive_get_stats(&stats);
+  return stats.flushes;
+}
+
+void setUp(void) {
+  host_shims_reset_storage();
+  host_shims_set_sd_present(false);
+}
+
+void tearDown(void) {
+}
+
+static uint32_t bytes_written(void) {
+  telemetry_archive_stats_t stats;
+  telemetry_archive_get_stats(&stats);
+  return stats.bytes_written;
+}
+
+void test_idle_flush_waits_for_the_threshold(void) {
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  telemetry_packet_t packet = power_packet(10, 3.7f);
+  TEST_ASSERT_TRUE(telemetry_archive_append(&packet));
+
+  // Un registro suelto no justifica escribir el bloque en cada reposo
+  uint32_t before = flushes();
+  for(int i = 0; i < 10; i++) {
+    telemetry_archive_flush();
+  }
+  TEST_ASSERT_EQUAL_UINT32(before, flushes());
+
+  // Antes de dormir sí se escribe, y una sola vez
+  telemetry_archive_sync();
+  telemetry_archive_sync();
+  TEST_ASSERT_EQUAL_UINT32(before + 1, flushes());
+
+  for(uint32_t i = 0; i < TELEM_ARCHIVE_SYNC_RECORDS - 1; i++) {
+    TEST_ASSERT_TRUE(telemetry_archive_append(&packet));
+    telemetry_archive_flush();
+  }
+  TEST_ASSERT_EQUAL_UINT32(before + 1, flushes());
+  TEST_ASSERT_TRUE(telemetry_archive_append(&packet));
+  telemetry_archive_flush();
+  TEST_ASSERT_EQUAL_UINT32(before + 2, flushes());
+}
+
+void test_littlefs_segment_grows_by_appends(void) {
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  uint32_t before = bytes_written();
+
+  append_temperatures(3);
+  telemetry_archive_sync();
+  File f = LittleFS.open(TELEM_ARCHIVE_DIR "/seg_00000.bin", FILE_READ);
+  TEST_ASSERT_TRUE((bool)f);
+  TEST_ASSERT_EQUAL_UINT32(3 * sizeof(telem_archive_record_t), f.size());
+  f.close();
+
+  // Completar el bloque con vaciados intermedios escribe cada byte una vez
+  for(uint32_t i = 3; i < RECORDS_PER_BLOCK; i++) {
+    telemetry_packet_t packet = temperature_packet(1000 + i, 20);
+    TEST_ASSERT_TRUE(telemetry_archive_append(&packet));
+    telemetry_archive_flush();
+  }
+  TEST_ASSERT_EQUAL_UINT32(TELEM_ARCHIVE_BLOCK_SIZE, bytes_written() - before);
+  f = LittleFS.open(TELEM_ARCHIVE_DIR "/seg_00000.bin", FILE_READ);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_ARCHIVE_BLOCK_SIZE, f.size());
+  f.close();
+}
+
+static void check_synced_block_survives_restart(bool sd) {
+  host_shims_reset_storage();
+  host_shims_set_sd_present(sd);
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  for(uint32_t i = 0; i < 3; i++) {
+    telemetry_packet_t packet = power_packet(100 + i, 3.5f);
+    TEST_ASSERT_TRUE(telemetry_archive_append(&packet));
+  }
+  telemetry_archive_sync();
+
+  // El bloque recuperado ya está en el soporte: no queda nada por escribir
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  telemetry_archive_sync();
+  TEST_ASSERT_EQUAL_UINT32(0, flushes());
+
+  telemetry_archive_query_t query = { 0, UINT32_MAX, 0, TELEM_FIELD_NONE, 0.0f, 0.0f };
+  TEST_ASSERT_EQUAL_UINT32(3, telemetry_archive_query(&query, NULL, NULL, NULL));
+
+  // Los registros siguientes continúan el bloque recuperado
+  telemetry_packet_t packet = power_packet(103, 3.5f);
+  TEST_ASSERT_TRUE(telemetry_archive_append(&packet));
+  telemetry_archive_sync();
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  TEST_ASSERT_EQUAL_UINT32(4, telemetry_archive_query(&query, NULL, NULL, NULL));
+}
+
+void test_synced_block_survives_restart(void) {
+  check_synced_block_survives_restart(false);
+  check_synced_block_survives_restart(true);
+}
+
+void test_type_mask_matches_housekeeping_presence(void) {
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+
+  telemetry_packet_t power = power_packet(50, 3.9f);
+  telemetry_packet_t hk;
+  memset(&hk, 0, sizeof(hk));
+  hk.header = power.header;
+  hk.header.type = TELEM_HOUSEKEEPING;
+  telemetry_hk_begin(&hk.housekeeping);
+  TEST_ASSERT_TRUE(telemetry_hk_add(&hk.housekeeping, &power));
+  TEST_ASSERT_TRUE(telemetry_archive_append(&hk));
+  // El resto del segmento solo lleva temperaturas: se sella con el registro combinado dentro
+  append_temperatures(RECORDS_PER_SEGMENT - 1);
+
+  telemetry_archive_query_t query = { 0, UINT32_MAX, 1UL << TELEM_POWER_DATA, TELEM_FIELD_NONE, 0.0f, 0.0f };
+  telemetry_archive_query_stats_t stats;
+  TEST_ASSERT_EQUAL_UINT32(1, telemetry_archive_query(&query, NULL, NULL, &stats));
+  TEST_ASSERT_EQUAL_UINT32(2, stats.segments);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.segments_skipped);
+
+  query.type_mask = 1UL << TELEM_COMMUNICATION_STATUS;
+  TEST_ASSERT_EQUAL_UINT32(0, telemetry_archive_query(&query, NULL, NULL, &stats));
+  TEST_ASSERT_EQUAL_UINT32(2, stats.segments_skipped);
+}
+
+static TaskHandle_t appender_task;
+static volatile bool appended;
+static volatile uint32_t visits;
+static uint32_t visits_at_append;
+
+static void appender(void* arg) {
+  telemetry_packet_t packet = temperature_packet(5000, 21);
+  telemetry_archive_append(&packet);
+  appended = true;
+  vTaskDelete(NULL);
+}
+
+static bool slow_visitor(const telemetry_packet_t* packet, void* context) {
+  if(visits++ == 0) {
+    // La tarea procesadora llega a mitad del primer tramo y queda esperando el mutex
+    xTaskCreate(appender, "Appender", 4096, NULL, 1, &appender_task);
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+  if(appended && visits_at_append == 0) {
+    visits_at_append = visits;
+  }
+  return true;
+}
+
+void test_query_releases_the_lock_between_chunks(void) {
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  append_temperatures(RECORDS_PER_SEGMENT * 2);
+  appended = false;
+  visits = 0;
+  visits_at_append = 0;
+
+  telemetry_archive_query_t query = { 0, UINT32_MAX, 0, TELEM_FIELD_NONE, 0.0f, 0.0f };
+  telemetry_archive_query(&query, slow_visitor, NULL, NULL);
+
+  // Con el mutex tomado por segmento la escritura esperaría al segmento entero
+  TEST_ASSERT_TRUE(appended);
+  TEST_ASSERT_NOT_EQUAL(0, visits_at_append);
+  TEST_ASSERT_LESS_THAN(RECORDS_PER_SEGMENT, visits_at_append);
+}
+
+void test_query_reads_rotated_history_from_mapped_partition(void) {
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  // Cinco segmentos llenos: LittleFS solo conserva tres sellados, la partición los cinco
+  append_temperatures(RECORDS_PER_SEGMENT * 5);
+  TEST_ASSERT_EQUAL_UINT32(5, telemetry_mapped_slots());
+
+  telemetry_archive_query_t query = { 0, UINT32_MAX, 0, TELEM_FIELD_NONE, 0.0f, 0.0f };
+  telemetry_archive_query_stats_t stats;
+  TEST_ASSERT_EQUAL_UINT32(RECORDS_PER_SEGMENT * 5, telemetry_archive_query(&query, NULL, NULL, &stats));
+  TEST_ASSERT_EQUAL_UINT32(5, stats.segments_mapped);
+  // Los ficheros sellados ya publicados no se vuelven a leer: solo falta el actual (vacío)
+  TEST_ASSERT_EQUAL_UINT32(6, stats.segments);
+
+  // El primer segmento solo existe ya en la partición
+  query.to_timestamp = 1000 + RECORDS_PER_SEGMENT - 1;
+  TEST_ASSERT_EQUAL_UINT32(RECORDS_PER_SEGMENT, telemetry_archive_query(&query, NULL, NULL, &stats));
+  // Las otras cuatro ranuras y el segmento actual, vacío, se descartan por su mapa de zona
+  TEST_ASSERT_EQUAL_UINT32(5, stats.segments_skipped);
+
+  telemetry_logger_init();
+  telemetry_archive_replay_benchmark();
+}
+
+void test_mapped_cursor_survives_slot_reuse(void) {
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+  append_temperatures(RECORDS_PER_SEGMENT * 2);
+
+  telemetry_mapped_cursor_t cursor;
+  telemetry_mapped_cursor_begin(&cursor);
+  const telemetry_packet_t* packet = telemetry_mapped_next(&cursor);
+  TEST_ASSERT_NOT_NULL(packet);
+  TEST_ASSERT_EQUAL_UINT32(1000, packet->header.timestamp);
+
+  // Se publican ranuras hasta reutilizar la del cursor
+  uint32_t slots = TELEM_MAPPED_MAX_SLOTS < 0xC0000 / TELEM_MAPPED_SLOT_SIZE ? TELEM_MAPPED_MAX_SLOTS
+                                                                               : 0xC0000 / TELEM_MAPPED_SLOT_SIZE;
+  append_temperatures(RECORDS_PER_SEGMENT * (slots - 1));
+  packet = telemetry_mapped_next(&cursor);
+  TEST_ASSERT_NOT_NULL(packet);
+  // Sigue por la generación siguiente, desde su primer registro
+  TEST_ASSERT_EQUAL_UINT32(1000 + RECORDS_PER_SEGMENT, packet->header.timestamp);
+}
+
+static void run_benchmark(bool sd) {
+  host_shims_set_sd_present(sd);
+  TEST_ASSERT_TRUE(telemetry_archive_init());
+
+  telemetry_archive_benchmark_t result;
+  TEST_ASSERT_TRUE(telemetry_archive_benchmark(512UL * 1024UL, &result));
+  TEST_ASSERT_EQUAL_UINT32(512UL * 1024UL, result.bytes);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, result.kbps);
+
+  char message[96];
+  snprintf(message, sizeof(message), "%s: %lu.%02lu MB/s sustained, worst block %lu us",
+           sd ? "SD" : "LittleFS", (unsigned long)(result.kbps / 1024),
+           (unsigned long)((result.kbps % 1024) * 100 / 1024), (unsigned long)result.worst_block_us);
+  TEST_MESSAGE(message);
+}
+
+void test_benchmark_reports_littlefs(void) {
+  run_benchmark(false);
+}
+
+void test_benchmark_reports_sd(void) {
+  run_benchmark(true);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_idle_flush_waits_for_the_threshold);
+  RUN_TEST(test_littlefs_segment_grows_by_appends);
+  RUN_TEST(test_synced_block_survives_restart);
+  RUN_TEST(test_type_mask_matches_housekeeping_presence);
+  RUN_TEST(test_query_releases_the_lock_between_chunks);
+  RUN_TEST(test_query_reads_rotated_history_from_mapped_partition);
+  RUN_TEST(test_mapped_cursor_survives_slot_reuse);
+  RUN_TEST(test_benchmark_reports_littlefs);
+  RUN_TEST(test_benchmark_reports_sd);
+  return UNITY_END();
+}
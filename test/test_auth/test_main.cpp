@@ -0,0 +1,193 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del sellado AES-GCM de tramas (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que ningún nonce se repite, ni dentro de un arranque
+ * aunque el número de secuencia de trama dé la vuelta, ni entre arranques en
+ * frío, y que el sellado falla cerrado: sin clave, sin reserva en NVS o con
+ * el cifrado fallando la trama se rechaza y se contabiliza.
+ * Cada arranque en frío es un proceso hijo (fork) que comparte con el padre
+ * solo los ficheros de NVS, como un reinicio comparte la flash.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+#include "esp_system.h"
+#include "host_shims.h"
+#include "../../include/telemetry_auth.h"
+
+#define TEST_PAYLOAD 64
+#define TEST_CAPACITY (sizeof(telem_frame_header_t) + TEST_PAYLOAD + TELEM_AUTH_OVERHEAD)
+
+static uint8_t buffer[TEST_CAPACITY];
+static uint8_t original[TEST_PAYLOAD];
+
+/**
+ * @brief Prepara una trama con una carga conocida y un número de secuencia dado
+ */
+static void build_frame(telemetry_frame_t* frame, uint16_t sequence) {
+  telemetry_frame_begin(frame, buffer, sizeof(buffer), sequence);
+  for(size_t i = 0; i < TEST_PAYLOAD; i++) {
+    original[i] = (uint8_t)(i * 13 + sequence);
+  }
+  memcpy(frame->data + sizeof(telem_frame_header_t), original, TEST_PAYLOAD);
+  frame->length = sizeof(telem_frame_header_t) + TEST_PAYLOAD;
+  telemetry_frame_header(frame)->payload_length = TEST_PAYLOAD;
+}
+
+static telem_auth_prefix_t prefix_of(const telemetry_frame_t* frame) {
+  telem_auth_prefix_t prefix;
+  memcpy(&prefix, frame->data + sizeof(telem_frame_header_t), sizeof(prefix));
+  return prefix;
+}
+
+/**
+ * @brief Arranque en frío en un proceso hijo: sella una trama y devuelve su prefijo
+ *
+ * @return false Si el hijo no pudo sellar
+ */
+static bool cold_boot_seal(telem_auth_prefix_t* prefix) {
+  int fds[2];
+  TEST_ASSERT_EQUAL(0, pipe(fds));
+  pid_t child = fork();
+  if(child == 0) {
+    close(fds[0]);
+    host_shims_set_reset_reason(ESP_RST_POWERON);
+    telemetry_frame_t frame;
+    build_frame(&frame, 0);
+    if(telemetry_auth_init() && telemetry_frame_seal(&frame)) {
+      telem_auth_prefix_t sealed = prefix_of(&frame);
+      if(write(fds[1], &sealed, sizeof(sealed)) != (ssize_t)sizeof(sealed)) {
+        _exit(2);
+      }
+    }
+    _exit(0);
+  }
+  close(fds[1]);
+  bool sealed = read(fds[0], prefix, sizeof(*prefix)) == (ssize_t)sizeof(*prefix);
+  close(fds[0]);
+  int status;
+  waitpid(child, &status, 0);
+  return sealed;
+}
+
+void setUp(void) {
+  host_shims_fail_gcm(0);
+  host_shims_fail_nvs(0);
+}
+
+void tearDown(void) {
+}
+
+void test_cold_boots_never_reuse_a_boot_number(void) {
+  // Primera prueba: los hijos heredan un módulo que aún no tiene clave
+  host_shims_reset_storage();
+  telem_auth_prefix_t first;
+  TEST_ASSERT_TRUE(cold_boot_seal(&first));
+  TEST_ASSERT_EQUAL_UINT32(0, first.counter);
+
+  uint32_t previous = first.boot;
+  for(int i = 0; i < 3; i++) {
+    telem_auth_prefix_t prefix;
+    TEST_ASSERT_TRUE(cold_boot_seal(&prefix));
+    TEST_ASSERT_EQUAL_UINT32(0, prefix.counter);
+    // Cada arranque en frío salta por encima de toda la reserva anterior
+    TEST_ASSERT_GREATER_OR_EQUAL(previous + TELEM_AUTH_BOOT_RESERVE, prefix.boot);
+    previous = prefix.boot;
+  }
+
+  // Sin poder reservar en NVS el arranque no sella nada
+  host_shims_fail_nvs(1);
+  telem_auth_prefix_t prefix;
+  TEST_ASSERT_FALSE(cold_boot_seal(&prefix));
+}
+
+void test_nvs_failure_keeps_the_downlink_closed(void) {
+  // El módulo aún no tiene clave en este proceso
+  host_shims_fail_nvs(1);
+  TEST_ASSERT_FALSE(telemetry_auth_init());
+  TEST_ASSERT_FALSE(telemetry_auth_ready());
+
+  telemetry_frame_t frame;
+  build_frame(&frame, 1);
+  TEST_ASSERT_FALSE(telemetry_frame_seal(&frame));
+  TEST_ASSERT_EQUAL_HEX8(0, telemetry_frame_header(&frame)->flags & TELEM_FRAME_FLAG_AUTH);
+
+  telemetry_auth_stats_t stats;
+  telemetry_auth_get_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.failures);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.sealed);
+
+  // Con NVS disponible se reserva el arranque y se puede sellar
+  TEST_ASSERT_TRUE(telemetry_auth_init());
+  TEST_ASSERT_TRUE(telemetry_frame_seal(&frame));
+}
+
+void test_round_trip_and_tamper(void) {
+  TEST_ASSERT_TRUE(telemetry_auth_init());
+  telemetry_frame_t frame;
+  build_frame(&frame, 7);
+  TEST_ASSERT_TRUE(telemetry_frame_seal(&frame));
+  TEST_ASSERT_EQUAL(sizeof(telem_frame_header_t) + TEST_PAYLOAD + TELEM_AUTH_OVERHEAD, frame.length);
+
+  uint8_t copy[TEST_CAPACITY];
+  memcpy(copy, frame.data, frame.length);
+  copy[sizeof(telem_frame_header_t) + sizeof(telem_auth_prefix_t)] ^= 1;
+  TEST_ASSERT_EQUAL(0, telemetry_frame_open(copy, frame.length));
+
+  TEST_ASSERT_EQUAL(TEST_PAYLOAD, telemetry_frame_open(frame.data, frame.length));
+  TEST_ASSERT_EQUAL_MEMORY(original, frame.data + sizeof(telem_frame_header_t), TEST_PAYLOAD);
+}
+
+void test_nonce_does_not_follow_the_frame_sequence(void) {
+  TEST_ASSERT_TRUE(telemetry_auth_init());
+  telemetry_frame_t frame;
+  telem_auth_prefix_t previous;
+  // La misma secuencia de 16 bits tres veces, como tras una vuelta completa
+  for(int i = 0; i < 3; i++) {
+    build_frame(&frame, 0xFFFF);
+    TEST_ASSERT_TRUE(telemetry_frame_seal(&frame));
+    telem_auth_prefix_t prefix = prefix_of(&frame);
+    if(i > 0) {
+      TEST_ASSERT_EQUAL_UINT32(previous.boot, prefix.boot);
+      TEST_ASSERT_EQUAL_UINT32(previous.counter + 1, prefix.counter);
+    }
+    previous = prefix;
+  }
+}
+
+void test_gcm_failure_drops_the_frame_and_burns_its_nonce(void) {
+  TEST_ASSERT_TRUE(telemetry_auth_init());
+  telemetry_auth_stats_t before, after;
+  telemetry_auth_get_stats(&before);
+
+  telemetry_frame_t frame;
+  build_frame(&frame, 3);
+  host_shims_fail_gcm(1);
+  TEST_ASSERT_FALSE(telemetry_frame_seal(&frame));
+  telemetry_auth_get_stats(&after);
+  TEST_ASSERT_EQUAL_UINT32(before.failures + 1, after.failures);
+
+  // La trama fallida no se puede volver a sellar: habría que rehacerla
+  TEST_ASSERT_FALSE(telemetry_frame_seal(&frame));
+
+  build_frame(&frame, 3);
+  TEST_ASSERT_TRUE(telemetry_frame_seal(&frame));
+  // El nonce del intento fallido no se reutiliza
+  TEST_ASSERT_EQUAL_UINT32(before.sealed + 1, prefix_of(&frame).counter);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_cold_boots_never_reuse_a_boot_number);
+  RUN_TEST(test_nvs_failure_keeps_the_downlink_closed);
+  RUN_TEST(test_round_trip_and_tamper);
+  RUN_TEST(test_nonce_does_not_follow_the_frame_sequence);
+  RUN_TEST(test_gcm_failure_drops_the_frame_and_burns_its_nonce);
+  return UNITY_END();
+}
@@ -0,0 +1,163 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del empaquetado de bits en los extremos de cada rango (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Las mismas tablas X-macro de telemetry_types.h que generan el
+ * empaquetador generan aquí los paquetes de prueba: cada tipo se empaqueta
+ * con todos sus campos en el mínimo y después en el máximo declarados, y el
+ * desempaquetado debe devolver exactamente los mismos valores, consumir los
+ * bytes que anuncia telemetry_bitpack_size() y no saturar nada. Los floats
+ * van a ±FLT_MAX. También se comprueba el tipo propio más alto, que viaja en
+ * bruto, y que los valores fuera de rango se saturan y se cuentan.
+ */
+
+#include <Arduino.h>
+#include <float.h>
+#include <string.h>
+#include <unity.h>
+#include "../../include/telemetry_bitpack.h"
+
+/** @brief Valor de relleno de la carga útil en bruto del tipo propio */
+#define RAW_FILL 0xA5
+
+// Extremos de cada campo a partir de las tablas de rangos
+#define LIMIT_SET(member, lo, hi) \
+  p->member = high ? (hi) : (lo);
+#define LIMIT_SET_FLOAT(member) \
+  p->member = high ? FLT_MAX : -FLT_MAX;
+#define LIMIT_CHECK(member, lo, hi) \
+  TEST_ASSERT_EQUAL_UINT64((uint64_t)(int64_t)expected->member, (uint64_t)(int64_t)actual->member);
+#define LIMIT_CHECK_FLOAT(member) \
+  TEST_ASSERT_EQUAL_FLOAT(expected->member, actual->member);
+
+#define LIMIT_CASE(name, type, FIELDS) \
+  static void name##_at_limit(type* p, bool high) { FIELDS(LIMIT_SET, LIMIT_SET_FLOAT) } \
+  static void name##_check(const type* expected, const type* actual) { FIELDS(LIMIT_CHECK, LIMIT_CHECK_FLOAT) }
+
+LIMIT_CASE(system, system_status_telem_t, TELEM_SYSTEM_STATUS_FIELDS)
+LIMIT_CASE(power, power_telem_t, TELEM_POWER_FIELDS)
+LIMIT_CASE(temperature, temperature_telem_t, TELEM_TEMPERATURE_FIELDS)
+LIMIT_CASE(subsystem, subsystem_status_telem_t, TELEM_SUBSYSTEM_FIELDS)
+
+/**
+ * @brief Paquete del tipo dado con el encabezado y la carga útil en un extremo
+ */
+static void make_limit_packet(telemetry_packet_t* packet, telem_data_type_t type, bool high) {
+  memset(packet, 0, sizeof(*packet));
+  packet->header.timestamp = high ? UINT32_MAX : 0;
+  packet->header.sequence = high ? UINT16_MAX : 0;
+  packet->header.priority = high ? 2 : 0;
+  packet->header.type = type;
+
+  switch(type) {
+    case TELEM_SYSTEM_STATUS:        system_at_limit(&packet->system, high); break;
+    case TELEM_POWER_DATA:           power_at_limit(&packet->power, high); break;
+    case TELEM_TEMPERATURE_DATA:     temperature_at_limit(&packet->temperature, high); break;
+    case TELEM_COMMUNICATION_STATUS: subsystem_at_limit(&packet->subsystems, high); break;
+    default: break;
+  }
+}
+
+/**
+ * @brief Empaqueta y desempaqueta comprobando el tamaño anunciado
+ */
+static void round_trip(const telemetry_packet_t* packet, telemetry_packet_t* decoded) {
+  uint8_t buffer[sizeof(telemetry_packet_t)];
+  size_t size = telemetry_bitpack_size(packet);
+
+  TEST_ASSERT_GREATER_THAN(0, size);
+  // Sin sitio para el último byte no se escribe nada
+  TEST_ASSERT_EQUAL(0, telemetry_bitpack_encode(packet, buffer, size - 1));
+  TEST_ASSERT_EQUAL(size, telemetry_bitpack_encode(packet, buffer, sizeof(buffer)));
+  // Ni se lee un paquete truncado
+  TEST_ASSERT_EQUAL(0, telemetry_bitpack_decode(buffer, size - 1, decoded));
+  TEST_ASSERT_EQUAL(size, telemetry_bitpack_decode(buffer, size, decoded));
+  TEST_ASSERT_EQUAL(packet->header.type, decoded->header.type);
+}
+
+/**
+ * @brief Compara los campos del encabezado salvo el tipo
+ */
+static void header_check(const telem_header_t* expected, const telem_header_t* actual) {
+  TEST_ASSERT_EQUAL_UINT32(expected->timestamp, actual->timestamp);
+  TEST_ASSERT_EQUAL_UINT16(expected->sequence, actual->sequence);
+  TEST_ASSERT_EQUAL_UINT8(expected->priority, actual->priority);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_every_type_round_trips_at_its_limits(void) {
+  telemetry_packet_t packet, decoded;
+  uint32_t clamped = telemetry_bitpack_clamped();
+
+  for(int high = 0; high <= 1; high++) {
+    for(int type = TELEM_SYSTEM_STATUS; type < TELEM_HOUSEKEEPING; type++) {
+      make_limit_packet(&packet, (telem_data_type_t)type, high);
+      round_trip(&packet, &decoded);
+      header_check(&packet.header, &decoded.header);
+
+      switch(type) {
+        case TELEM_SYSTEM_STATUS:        system_check(&packet.system, &decoded.system); break;
+        case TELEM_POWER_DATA:           power_check(&packet.power, &decoded.power); break;
+        case TELEM_TEMPERATURE_DATA:     temperature_check(&packet.temperature, &decoded.temperature); break;
+        case TELEM_COMMUNICATION_STATUS: subsystem_check(&packet.subsystems, &decoded.subsystems); break;
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(clamped, telemetry_bitpack_clamped());
+}
+
+void test_highest_custom_type_travels_raw(void) {
+  telemetry_packet_t packet, decoded;
+  const size_t payload = sizeof(telemetry_packet_t) - sizeof(telem_header_t);
+
+  make_limit_packet(&packet, (telem_data_type_t)TELEM_TYPE_MAX, true);
+  memset((uint8_t*)&packet + sizeof(telem_header_t), RAW_FILL, payload);
+  round_trip(&packet, &decoded);
+  header_check(&packet.header, &decoded.header);
+  TEST_ASSERT_EQUAL_MEMORY((uint8_t*)&packet + sizeof(telem_header_t),
+                           (uint8_t*)&decoded + sizeof(telem_header_t), payload);
+
+  // Por encima del campo de tipo no hay formato
+  packet.header.type = (telem_data_type_t)(TELEM_TYPE_MAX + 1);
+  TEST_ASSERT_EQUAL(0, telemetry_bitpack_size(&packet));
+}
+
+void test_out_of_range_values_saturate(void) {
+  telemetry_packet_t packet, decoded;
+  uint32_t clamped = telemetry_bitpack_clamped();
+
+  make_limit_packet(&packet, TELEM_POWER_DATA, false);
+  packet.power.battery_level = 200;
+  packet.power.battery_temperature = -100;
+  packet.power.power_state = 16;
+  round_trip(&packet, &decoded);
+  TEST_ASSERT_EQUAL_UINT8(100, decoded.power.battery_level);
+  TEST_ASSERT_EQUAL_INT(-40, decoded.power.battery_temperature);
+  TEST_ASSERT_EQUAL_UINT8(15, decoded.power.power_state);
+
+  make_limit_packet(&packet, TELEM_SYSTEM_STATUS, true);
+  packet.system.heap_free = UINT32_MAX;
+  packet.system.task_count = UINT8_MAX;
+  packet.header.priority = 3;
+  round_trip(&packet, &decoded);
+  TEST_ASSERT_EQUAL_UINT32(524287, decoded.system.heap_free);
+  TEST_ASSERT_EQUAL_UINT8(63, decoded.system.task_count);
+  TEST_ASSERT_EQUAL_UINT8(2, decoded.header.priority);
+
+  TEST_ASSERT_EQUAL_UINT32(clamped + 6, telemetry_bitpack_clamped());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_type_round_trips_at_its_limits);
+  RUN_TEST(test_highest_custom_type_travels_raw);
+  RUN_TEST(test_out_of_range_values_saturate);
+  return UNITY_END();
+}
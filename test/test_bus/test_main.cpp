@@ -0,0 +1,159 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del gestor asíncrono de buses (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que una finalización tardía no completa la transacción
+ * siguiente, que el barrido de sensores lee la corriente de batería por el
+ * bus I2C y cae al valor nominal si la lectura falla, y mide con el
+ * controlador simulado (latencias de TELEM_BUS_MOCK_DEVICES sobre el
+ * esp_timer de host_shims) un ciclo de lecturas bloqueantes frente a uno en
+ * cola. En el PC las cifras incluyen el planificador del anfitrión: sirven
+ * para ver el solape entre buses, no como tiempos del ESP32.
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_bus.h"
+#include "../../include/telemetry_sensors.h"
+
+/** @brief Suma de las latencias de los cuatro dispositivos I2C de TELEM_BUS_MOCK_DEVICES */
+#define MOCK_I2C_SERIAL_US (600 + 600 + 400 + 400)
+
+static telemetry_bus_txn_t* volatile started_txn;
+static volatile uint16_t shunt_register;
+
+/**
+ * @brief Controlador que arranca la transferencia y deja que la prueba la termine
+ */
+static bool manual_driver(telemetry_bus_txn_t* txn) {
+  started_txn = txn;
+  return true;
+}
+
+/**
+ * @brief Controlador que responde al instante con un registro de shunt fijo
+ */
+static bool shunt_driver(telemetry_bus_txn_t* txn) {
+  txn->data[0] = (uint8_t)(shunt_register >> 8);
+  txn->data[1] = (uint8_t)shunt_register;
+  telemetry_bus_complete((telem_bus_id_t)txn->bus, txn->id, true);
+  return true;
+}
+
+/**
+ * @brief Controlador que no obtiene ACK del dispositivo
+ */
+static bool nack_driver(telemetry_bus_txn_t* txn) {
+  return false;
+}
+
+static void wait_started(telemetry_bus_txn_t* txn) {
+  for(int i = 0; i < 1000 && started_txn != txn; i++) {
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  TEST_ASSERT_EQUAL_PTR(txn, started_txn);
+}
+
+static void prepare(telemetry_bus_txn_t* txn, uint8_t* data, uint16_t length) {
+  memset(txn, 0, sizeof(*txn));
+  txn->bus = TELEM_BUS_SPI2;
+  txn->data = data;
+  txn->length = length;
+  txn->notify = xTaskGetCurrentTaskHandle();
+}
+
+void setUp(void) {
+  TEST_ASSERT_TRUE(telemetry_bus_init());
+  ulTaskNotifyTake(pdTRUE, 0);
+}
+
+void tearDown(void) {
+  telemetry_bus_set_driver(TELEM_BUS_I2C0, NULL);
+  telemetry_bus_set_driver(TELEM_BUS_SPI2, NULL);
+}
+
+void test_late_completion_does_not_complete_the_next_transaction(void) {
+  telemetry_bus_txn_t first, second;
+  uint8_t data[2];
+  telemetry_bus_stats_t before, after;
+  telemetry_bus_get_stats(TELEM_BUS_SPI2, &before);
+  telemetry_bus_set_driver(TELEM_BUS_SPI2, manual_driver);
+
+  // La primera transferencia nunca termina a tiempo
+  prepare(&first, data, sizeof(data));
+  TEST_ASSERT_TRUE(telemetry_bus_submit(&first));
+  TEST_ASSERT_EQUAL_UINT32(1, telemetry_bus_wait(1, 10 * TELEM_BUS_TIMEOUT_MS));
+  TEST_ASSERT_EQUAL(TELEM_BUS_TIMEOUT, first.status);
+
+  prepare(&second, data, sizeof(data));
+  TEST_ASSERT_TRUE(telemetry_bus_submit(&second));
+  wait_started(&second);
+  TEST_ASSERT_NOT_EQUAL_UINT32(first.id, second.id);
+
+  // Su finalización llega con la segunda en curso: se descarta
+  telemetry_bus_complete(TELEM_BUS_SPI2, first.id, true);
+  vTaskDelay(pdMS_TO_TICKS(2));
+  TEST_ASSERT_EQUAL(TELEM_BUS_PENDING, second.status);
+
+  telemetry_bus_complete(TELEM_BUS_SPI2, second.id, false);
+  TEST_ASSERT_EQUAL_UINT32(1, telemetry_bus_wait(1, 10 * TELEM_BUS_TIMEOUT_MS));
+  TEST_ASSERT_EQUAL(TELEM_BUS_ERROR, second.status);
+
+  telemetry_bus_get_stats(TELEM_BUS_SPI2, &after);
+  TEST_ASSERT_EQUAL_UINT32(before.stale + 1, after.stale);
+  TEST_ASSERT_EQUAL_UINT32(before.errors + 2, after.errors);
+}
+
+void test_sweep_reads_battery_current_through_the_bus(void) {
+  telemetry_bus_stats_t before, after;
+  telemetry_sensor_stats_t sensors_before, sensors_after;
+  telemetry_bus_get_stats(TELEM_BUS_I2C0, &before);
+
+  // Controlador simulado por defecto: 1000 cuentas de 10 µV sobre 0.1 ohm
+  const telemetry_sample_frame_t* frame = telemetry_sensors_sweep();
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.1, frame->value[TELEM_CH_BATTERY_CURRENT]);
+  telemetry_bus_get_stats(TELEM_BUS_I2C0, &after);
+  TEST_ASSERT_EQUAL_UINT32(before.transactions + 1, after.transactions);
+
+  shunt_register = 2500;
+  telemetry_bus_set_driver(TELEM_BUS_I2C0, shunt_driver);
+  frame = telemetry_sensors_sweep();
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.25, frame->value[TELEM_CH_BATTERY_CURRENT]);
+
+  // Sin ACK el canal vuelve a su valor nominal y se contabiliza
+  telemetry_sensors_get_stats(&sensors_before);
+  telemetry_bus_set_driver(TELEM_BUS_I2C0, nack_driver);
+  frame = telemetry_sensors_sweep();
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.1, frame->value[TELEM_CH_BATTERY_CURRENT]);
+  telemetry_sensors_get_stats(&sensors_after);
+  TEST_ASSERT_EQUAL_UINT32(sensors_before.bus_failures + 1, sensors_after.bus_failures);
+}
+
+void test_queued_cycle_overlaps_the_buses(void) {
+  telemetry_bus_benchmark_t result;
+  TEST_ASSERT_TRUE(telemetry_bus_benchmark(&result));
+
+  char message[160];
+  snprintf(message, sizeof(message), "Bus: %lu devices (%lu us of transfers) | blocking %lu us/cycle | queued %lu us/cycle",
+           (unsigned long)result.devices, (unsigned long)result.device_sum_us,
+           (unsigned long)result.blocking_us, (unsigned long)result.queued_us);
+  TEST_MESSAGE(message);
+
+  // Bloqueante: todas las latencias en serie; en cola: solo las del bus I2C
+  TEST_ASSERT_GREATER_OR_EQUAL(result.device_sum_us, result.blocking_us);
+  TEST_ASSERT_GREATER_OR_EQUAL(MOCK_I2C_SERIAL_US, result.queued_us);
+  TEST_ASSERT_LESS_THAN(result.blocking_us, result.queued_us);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_late_completion_does_not_complete_the_next_transaction);
+  RUN_TEST(test_sweep_reads_battery_current_through_the_bus);
+  RUN_TEST(test_queued_cycle_overlaps_the_buses);
+  return UNITY_END();
+}
@@ -0,0 +1,257 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de la calibración en punto fijo (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Compara cada conversión en Q16.16 con la misma tabla evaluada en
+ * doble precisión en las 4096 entradas, y comprueba las subidas desde
+ * tierra y el cambio de tablas con conversiones en curso.
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <math.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_calibration.h"
+#include "../../include/telemetry_retention.h"
+#include "../../include/telemetry_sensors.h"
+#include "../../include/telemetry_logger.h"
+
+#define ADC_SPAN (1u << TELEM_CAL_ADC_BITS)
+#define LUT_SHIFT (TELEM_CAL_ADC_BITS - TELEM_CAL_LUT_SEGMENT_BITS)
+
+/** @brief Error admitido frente a la referencia: dos LSB de Q16.16 */
+#define Q16_TOLERANCE (2.0 / TELEM_Q16_ONE)
+
+static double reference(const telemetry_calibration_t* table, uint32_t raw) {
+  if(table->kind == TELEM_CAL_KIND_LUT) {
+    uint32_t segment = raw >> LUT_SHIFT;
+    double fraction = (double)(raw & ((1u << LUT_SHIFT) - 1)) / (1u << LUT_SHIFT);
+    return (table->value[segment] + (table->value[segment + 1] - (double)table->value[segment]) * fraction) /
+           TELEM_Q16_ONE;
+  }
+  double u = (double)raw / ADC_SPAN;
+  double acc = 0.0;
+  for(int k = table->count - 1; k >= 0; k--) {
+    acc = acc * u + (double)table->value[k] / TELEM_Q16_ONE;
+  }
+  return acc;
+}
+
+static double max_error(telem_cal_channel_t channel) {
+  static uint16_t raw[ADC_SPAN];
+  static int32_t out[ADC_SPAN];
+  telemetry_calibration_t table;
+
+  telemetry_calibration_get(channel, &table);
+  for(uint32_t i = 0; i < ADC_SPAN; i++) {
+    raw[i] = (uint16_t)i;
+  }
+  telemetry_calibrate_block(channel, raw, out, ADC_SPAN);
+
+  double worst = 0.0;
+  for(uint32_t i = 0; i < ADC_SPAN; i++) {
+    double error = fabs((double)out[i] / TELEM_Q16_ONE - reference(&table, i));
+    worst = error > worst ? error : worst;
+  }
+  return worst;
+}
+
+static telemetry_calibration_t constant_table(int32_t value, uint16_t version) {
+  telemetry_calibration_t table;
+  memset(&table, 0, sizeof(table));
+  table.kind = TELEM_CAL_KIND_POLYNOMIAL;
+  table.count = 1;
+  table.version = version;
+  table.value[0] = value;
+  return table;
+}
+
+void setUp(void) {
+  host_shims_reset_storage();
+  LittleFS.begin(true);
+  telemetry_calibration_init();
+}
+
+void tearDown(void) {
+}
+
+void test_ntc_lut_matches_double(void) {
+  TEST_ASSERT_TRUE(max_error(TELEM_CAL_NTC_TEMPERATURE) <= Q16_TOLERANCE);
+}
+
+void test_ntc_lut_reads_room_temperature_at_midscale(void) {
+  // Con la ecuación beta del WOKWI, media escala son 25 °C
+  float celsius = TELEM_Q16_TO_FLOAT(telemetry_calibrate(TELEM_CAL_NTC_TEMPERATURE, ADC_SPAN / 2));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 25.0f, celsius);
+}
+
+void test_battery_default_converts_pin_millivolts(void) {
+  TEST_ASSERT_TRUE(max_error(TELEM_CAL_BATTERY_VOLTAGE) <= Q16_TOLERANCE);
+
+  // 1850 mV en el pin con el divisor por 2 son 3.7 V de batería
+  float volts = TELEM_Q16_TO_FLOAT(telemetry_calibrate(TELEM_CAL_BATTERY_VOLTAGE, 1850));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.850f * TELEM_SENSOR_VBAT_DIVIDER, volts);
+}
+
+void test_cubic_polynomial_matches_double(void) {
+  telemetry_calibration_t cubic;
+  memset(&cubic, 0, sizeof(cubic));
+  cubic.kind = TELEM_CAL_KIND_POLYNOMIAL;
+  cubic.count = 4;
+  cubic.version = 3;
+  cubic.value[0] = (int32_t)lround(-2.5 * TELEM_Q16_ONE);
+  cubic.value[1] = (int32_t)lround(9.75 * TELEM_Q16_ONE);
+  cubic.value[2] = (int32_t)lround(-4.125 * TELEM_Q16_ONE);
+  cubic.value[3] = (int32_t)lround(1.0625 * TELEM_Q16_ONE);
+
+  TEST_ASSERT_TRUE(telemetry_calibration_update(TELEM_CAL_BATTERY_VOLTAGE, &cubic));
+  // Un redondeo por paso de Horner
+  TEST_ASSERT_TRUE(max_error(TELEM_CAL_BATTERY_VOLTAGE) <= 4.0 / TELEM_Q16_ONE);
+}
+
+void test_invalid_tables_are_rejected(void) {
+  telemetry_calibration_t table = constant_table(TELEM_Q16_ONE, 9);
+
+  table.count = 0;
+  TEST_ASSERT_FALSE(telemetry_calibration_update(TELEM_CAL_BATTERY_VOLTAGE, &table));
+  table.count = TELEM_CAL_MAX_COEFFS + 1;
+  TEST_ASSERT_FALSE(telemetry_calibration_update(TELEM_CAL_BATTERY_VOLTAGE, &table));
+
+  // Suma de |c| fuera de 32 bits: la evaluación podría desbordar
+  table.count = 2;
+  table.value[0] = INT32_MAX;
+  table.value[1] = 1;
+  TEST_ASSERT_FALSE(telemetry_calibration_update(TELEM_CAL_BATTERY_VOLTAGE, &table));
+
+  table.kind = TELEM_CAL_KIND_LUT;
+  table.count = TELEM_CAL_LUT_POINTS - 1;
+  TEST_ASSERT_FALSE(telemetry_calibration_update(TELEM_CAL_NTC_TEMPERATURE, &table));
+
+  telemetry_calibration_t active;
+  telemetry_calibration_get(TELEM_CAL_BATTERY_VOLTAGE, &active);
+  TEST_ASSERT_EQUAL_UINT16(0, active.version);
+}
+
+void test_update_is_saved_and_reloaded(void) {
+  telemetry_calibration_t table = constant_table(5 * TELEM_Q16_ONE, 7);
+  TEST_ASSERT_TRUE(telemetry_calibration_update(TELEM_CAL_BATTERY_VOLTAGE, &table));
+
+  TEST_ASSERT_TRUE(telemetry_calibration_init());
+  telemetry_calibration_t reloaded;
+  telemetry_calibration_get(TELEM_CAL_BATTERY_VOLTAGE, &reloaded);
+  TEST_ASSERT_EQUAL_UINT16(7, reloaded.version);
+  TEST_ASSERT_EQUAL_INT32(5 * TELEM_Q16_ONE, telemetry_calibrate(TELEM_CAL_BATTERY_VOLTAGE, 1234));
+}
+
+static void write_upload(const telemetry_calibration_upload_t* upload, size_t length) {
+  File f = LittleFS.open(TELEM_CAL_UPLOAD_FILE, FILE_WRITE);
+  f.write((const uint8_t*)upload, length);
+  f.close();
+}
+
+void test_upload_file_is_applied_once(void) {
+  telemetry_calibration_upload_t upload;
+  memset(&upload, 0, sizeof(upload));
+  upload.magic = TELEM_RETENTION_MAGIC;
+  upload.channel = TELEM_CAL_BATTERY_VOLTAGE;
+  upload.table = constant_table(3 * TELEM_Q16_ONE, 11);
+  upload.crc = telemetry_retention_crc(&upload, offsetof(telemetry_calibration_upload_t, crc));
+
+  TEST_ASSERT_FALSE(telemetry_calibration_poll_upload());
+  write_upload(&upload, sizeof(upload));
+  TEST_ASSERT_TRUE(telemetry_calibration_poll_upload());
+  TEST_ASSERT_FALSE(LittleFS.exists(TELEM_CAL_UPLOAD_FILE));
+  TEST_ASSERT_EQUAL_INT32(3 * TELEM_Q16_ONE, telemetry_calibrate(TELEM_CAL_BATTERY_VOLTAGE, 100));
+}
+
+void test_corrupt_or_truncated_upload_is_discarded(void) {
+  telemetry_calibration_upload_t upload;
+  memset(&upload, 0, sizeof(upload));
+  upload.magic = TELEM_RETENTION_MAGIC;
+  upload.channel = TELEM_CAL_BATTERY_VOLTAGE;
+  upload.table = constant_table(3 * TELEM_Q16_ONE, 12);
+  upload.crc = telemetry_retention_crc(&upload, offsetof(telemetry_calibration_upload_t, crc)) ^ 1;
+
+  write_upload(&upload, sizeof(upload));
+  TEST_ASSERT_FALSE(telemetry_calibration_poll_upload());
+  TEST_ASSERT_FALSE(LittleFS.exists(TELEM_CAL_UPLOAD_FILE));
+
+  upload.crc ^= 1;
+  write_upload(&upload, sizeof(upload) / 2);
+  TEST_ASSERT_FALSE(telemetry_calibration_poll_upload());
+
+  telemetry_calibration_t active;
+  telemetry_calibration_get(TELEM_CAL_BATTERY_VOLTAGE, &active);
+  TEST_ASSERT_EQUAL_UINT16(0, active.version);
+}
+
+/** @brief Bloques con mezcla de tablas vistos por el lector concurrente */
+static volatile uint32_t torn_blocks;
+static volatile uint32_t reader_blocks;
+static volatile bool reader_stop;
+static TaskHandle_t reader_done_task;
+
+/** @brief Muestras por bloque del lector: un bloque largo abarca varias actualizaciones */
+#define SWAP_BLOCK (256u * ADC_SPAN)
+
+static void swap_reader(void* arg) {
+  static uint16_t raw[SWAP_BLOCK];
+  static int32_t out[SWAP_BLOCK];
+  for(uint32_t i = 0; i < SWAP_BLOCK; i++) {
+    raw[i] = (uint16_t)(i % ADC_SPAN);
+  }
+  xTaskNotifyGive(reader_done_task);
+  while(!reader_stop) {
+    telemetry_calibrate_block(TELEM_CAL_BATTERY_VOLTAGE, raw, out, SWAP_BLOCK);
+    for(uint32_t i = 1; i < SWAP_BLOCK; i++) {
+      if(out[i] != out[0]) {
+        torn_blocks++;
+        break;
+      }
+    }
+    reader_blocks++;
+  }
+  xTaskNotifyGive(reader_done_task);
+  vTaskDelete(NULL);
+}
+
+void test_back_to_back_updates_never_tear_a_block(void) {
+  torn_blocks = 0;
+  reader_blocks = 0;
+  reader_stop = false;
+  reader_done_task = xTaskGetCurrentTaskHandle();
+  // La tabla por defecto no es constante: el lector no debe ver nunca otra
+  telemetry_calibration_t initial = constant_table(TELEM_Q16_ONE, 0);
+  TEST_ASSERT_TRUE(telemetry_calibration_update(TELEM_CAL_BATTERY_VOLTAGE, &initial));
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(swap_reader, "CalReader", 4096, NULL, 1, NULL));
+  TEST_ASSERT_NOT_EQUAL(0, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000)));
+
+  // Dos actualizaciones seguidas reescriben el búfer que un lector lento aún usa
+  for(uint16_t version = 1; version <= 50; version++) {
+    telemetry_calibration_t table = constant_table((version % 3 + 1) * TELEM_Q16_ONE, version);
+    TEST_ASSERT_TRUE(telemetry_calibration_update(TELEM_CAL_BATTERY_VOLTAGE, &table));
+  }
+
+  reader_stop = true;
+  TEST_ASSERT_NOT_EQUAL(0, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000)));
+  TEST_ASSERT_TRUE(reader_blocks > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, torn_blocks);
+}
+
+int main(int argc, char** argv) {
+  LittleFS.begin(true);
+  UNITY_BEGIN();
+  RUN_TEST(test_ntc_lut_matches_double);
+  RUN_TEST(test_ntc_lut_reads_room_temperature_at_midscale);
+  RUN_TEST(test_battery_default_converts_pin_millivolts);
+  RUN_TEST(test_cubic_polynomial_matches_double);
+  RUN_TEST(test_invalid_tables_are_rejected);
+  RUN_TEST(test_update_is_saved_and_reloaded);
+  RUN_TEST(test_upload_file_is_applied_once);
+  RUN_TEST(test_corrupt_or_truncated_upload_is_discarded);
+  RUN_TEST(test_back_to_back_updates_never_tear_a_block);
+  return UNITY_END();
+}
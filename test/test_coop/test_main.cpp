@@ -0,0 +1,132 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del modo cooperativo: log diferido y cifras de memoria y cambio de contexto (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que las líneas de la tarea diferida no tocan la UART ni
+ * LittleFS hasta telemetry_log_flush(), que llegan enteras y en orden, y que
+ * si el buffer se llena se pierden líneas completas y se cuentan. La última
+ * prueba ejecuta telemetry_co_benchmark(): en el PC el cambio entre tareas
+ * es el de dos hilos POSIX y el heap solo descuenta la pila, así que sirve
+ * para comparar órdenes de magnitud, no como cifras del ESP32.
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_logger.h"
+#include "../../include/telemetry_coroutine.h"
+
+/** @brief Pila de las tareas de telemetría que el modo cooperativo ahorra */
+#define TELEMETRY_TASK_STACK 4096
+
+static std::string read_log(void) {
+  std::string text;
+  File f = LittleFS.open(TELEMETRY_LOG_FILE, FILE_READ);
+  while(f && f.available()) {
+    text += (char)f.read();
+  }
+  if(f) {
+    f.close();
+  }
+  return text;
+}
+
+void setUp(void) {
+  TEST_ASSERT_TRUE(telemetry_logger_init());
+  telemetry_log_clear();
+  telemetry_logger_defer_task(xTaskGetCurrentTaskHandle());
+}
+
+void tearDown(void) {
+  telemetry_logger_defer_task(NULL);
+  telemetry_log_flush();
+}
+
+static void direct_log_task(void* arg) {
+  telemetry_logf("direct line");
+  *(volatile bool*)arg = true;
+  vTaskDelete(NULL);
+}
+
+void test_deferred_lines_wait_for_the_flush(void) {
+  for(int i = 0; i < 3; i++) {
+    telemetry_logf("deferred %d", i);
+  }
+  TEST_ASSERT_EQUAL(0, read_log().size());
+
+  // Las demás tareas siguen escribiendo al momento
+  volatile bool done = false;
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(direct_log_task, "direct", 2048, (void*)&done, 1, NULL));
+  for(int i = 0; i < 1000 && !done; i++) {
+    vTaskDelay(1);
+  }
+  TEST_ASSERT_TRUE(done);
+  TEST_ASSERT_TRUE(read_log() == "direct line\r\n");
+
+  telemetry_log_flush();
+  std::string text = read_log();
+  TEST_ASSERT_TRUE(text == "direct line\r\ndeferred 0\r\ndeferred 1\r\ndeferred 2\r\n");
+}
+
+void test_full_buffer_drops_whole_lines(void) {
+  char line[64];
+  uint32_t before = telemetry_log_dropped();
+  int logged = 0;
+  while(telemetry_log_dropped() == before) {
+    snprintf(line, sizeof(line), "line %04d with some padding to fill the buffer", logged);
+    telemetry_logf("%s", line);
+    logged++;
+  }
+  uint32_t dropped = telemetry_log_dropped() - before;
+  TEST_ASSERT_EQUAL_UINT32(1, dropped);
+
+  telemetry_log_flush();
+  std::string text = read_log();
+  TEST_ASSERT_LESS_OR_EQUAL(TELEM_LOG_DEFER_BYTES, text.size());
+
+  // Todas las líneas escritas están completas y son las primeras, en orden
+  size_t offset = 0;
+  int kept = 0;
+  while(offset < text.size()) {
+    size_t end = text.find("\r\n", offset);
+    TEST_ASSERT_TRUE(end != std::string::npos);
+    snprintf(line, sizeof(line), "line %04d with some padding to fill the buffer", kept);
+    TEST_ASSERT_TRUE(text.compare(offset, end - offset, line) == 0);
+    offset = end + 2;
+    kept++;
+  }
+  TEST_ASSERT_EQUAL(logged - 1, kept);
+}
+
+void test_coroutines_save_stacks_and_switch_faster(void) {
+  telemetry_logger_defer_task(NULL);
+  telemetry_co_benchmark_t result;
+  TEST_ASSERT_TRUE(telemetry_co_benchmark(&result));
+
+  // El modo cooperativo sustituye tres tareas por una
+  uint32_t saved = 2 * result.task_heap_bytes - 3 * result.co_state_bytes;
+  char message[200];
+  snprintf(message, sizeof(message),
+           "Coop: switch %lu ns (tasks) vs %lu ns (coroutines) | task %lu B of heap, coroutine %lu B | saves %lu B",
+           (unsigned long)result.task_switch_ns, (unsigned long)result.co_switch_ns,
+           (unsigned long)result.task_heap_bytes, (unsigned long)result.co_state_bytes, (unsigned long)saved);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_GREATER_OR_EQUAL(TELEMETRY_TASK_STACK, result.task_heap_bytes);
+  TEST_ASSERT_LESS_THAN(result.task_switch_ns, result.co_switch_ns);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_deferred_lines_wait_for_the_flush);
+  RUN_TEST(test_full_buffer_drops_whole_lines);
+  RUN_TEST(test_coroutines_save_stacks_and_switch_faster);
+  return UNITY_END();
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del correlador de reloj de tierra (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Simula un reloj local que adelanta 50 ppm y pares (reloj local,
+ * UTC) con ±100 µs de ruido repartidos en un día de pases, y comprueba la
+ * deriva ajustada y la conversión en lote de marcas de tiempo que cruzan la
+ * vuelta de los 32 bits de milisegundos.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+#include "telemetry_correlator.h"
+
+/** @brief Deriva simulada del reloj local (ppm, adelanta) */
+#define DRIFT_PPM 50.0
+
+/** @brief UTC del instante local cero de la época (s) */
+#define EPOCH_UTC_S 1790000000.0
+
+/** @brief Pares de correlación simulados */
+#define PAIRS 20
+
+/** @brief Marcas de tiempo convertidas en la prueba de lote */
+#define BATCH 100000
+
+static uint32_t noise_state = 12345;
+
+/**
+ * @brief Ruido uniforme en [-1, 1] reproducible
+ */
+static double noise(void) {
+  noise_state = noise_state * 1103515245u + 12345u;
+  return (double)(noise_state >> 8) / (double)(1u << 23) - 1.0;
+}
+
+/**
+ * @brief UTC verdadero de un instante del reloj local
+ */
+static double true_utc(uint64_t local_us) {
+  return EPOCH_UTC_S + (double)local_us * 1e-6 / (1.0 + DRIFT_PPM * 1e-6);
+}
+
+/**
+ * @brief Ajusta PAIRS pares repartidos en un día a partir de first_local_us
+ */
+static void fit_day(uint64_t first_local_us, telemetry_time_fit_t* fit) {
+  uint64_t local_us[PAIRS];
+  double utc_s[PAIRS];
+
+  for(int i = 0; i < PAIRS; i++) {
+    local_us[i] = first_local_us + (uint64_t)i * 4320ULL * 1000000ULL;
+    utc_s[i] = true_utc(local_us[i]) + noise() * 100e-6;
+  }
+  TEST_ASSERT_TRUE(telemetry_correlator_fit(local_us, utc_s, PAIRS, fit));
+}
+
+void setUp(void) {
+  noise_state = 12345;
+}
+
+void tearDown(void) {
+}
+
+void test_fit_recovers_drift_and_offset(void) {
+  telemetry_time_fit_t fit;
+  fit_day(3600ULL * 1000000ULL, &fit);
+
+  char message[96];
+  snprintf(message, sizeof(message), "drift %.4f ppm, residual %.1f us", fit.drift_ppm, fit.residual_rms_us);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_DOUBLE_WITHIN(0.01, DRIFT_PPM, fit.drift_ppm);
+  TEST_ASSERT_EQUAL_UINT32(PAIRS, fit.points);
+  TEST_ASSERT_LESS_THAN(100.0, fit.residual_rms_us);
+
+  uint64_t probe = 12ULL * 3600ULL * 1000000ULL;
+  TEST_ASSERT_DOUBLE_WITHIN(100e-6, true_utc(probe), telemetry_correlator_utc(&fit, probe));
+}
+
+void test_single_pair_assumes_nominal_rate(void) {
+  uint64_t local_us = 5000000;
+  double utc_s = EPOCH_UTC_S + 5.0;
+  telemetry_time_fit_t fit;
+
+  TEST_ASSERT_FALSE(telemetry_correlator_fit(&local_us, &utc_s, 0, &fit));
+  TEST_ASSERT_TRUE(telemetry_correlator_fit(&local_us, &utc_s, 1, &fit));
+  TEST_ASSERT_DOUBLE_WITHIN(1e-12, 1e-6, fit.rate);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, EPOCH_UTC_S + 6.0, telemetry_correlator_utc(&fit, 6000000));
+}
+
+void test_batch_conversion_across_ms_wrap(void) {
+  static uint32_t timestamps_ms[BATCH];
+  static double utc_s[BATCH];
+  static uint64_t truth_ms[BATCH];
+
+  // El día de pares termina justo después de la vuelta de 2^32 ms (~49.7 días)
+  uint64_t wrap_ms = 1ULL << 32;
+  telemetry_time_fit_t fit;
+  fit_day(wrap_ms * 1000ULL - 20ULL * 3600ULL * 1000000ULL, &fit);
+
+  // Marcas de ±10 h alrededor de la vuelta
+  for(int i = 0; i < BATCH; i++) {
+    truth_ms[i] = wrap_ms - 10ULL * 3600000ULL + (uint64_t)i * 720ULL;
+    timestamps_ms[i] = (uint32_t)truth_ms[i];
+  }
+  telemetry_correlator_convert(&fit, timestamps_ms, BATCH, utc_s);
+
+  double worst = 0.0;
+  for(int i = 0; i < BATCH; i++) {
+    double error = fabs(utc_s[i] - true_utc(truth_ms[i] * 1000ULL));
+    worst = error > worst ? error : worst;
+  }
+  char message[64];
+  snprintf(message, sizeof(message), "worst batch error %.1f us", worst * 1e6);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(100e-6, worst);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fit_recovers_drift_and_offset);
+  RUN_TEST(test_single_pair_assumes_nominal_rate);
+  RUN_TEST(test_batch_conversion_across_ms_wrap);
+  return UNITY_END();
+}
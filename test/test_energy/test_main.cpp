@@ -0,0 +1,211 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de la contabilidad de CPU por etapa (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details En el PC el contador de ejecución de cada tarea es el tiempo de
+ * CPU de su hilo, así que una tarea bloqueada o expulsada no acumula CPU
+ * aunque pase el tiempo de reloj. La última prueba lleva la energía más
+ * allá de los 32 bits de µJ y comprueba que el informe no da la vuelta y que
+ * el paquete de sistema satura sus mJ.
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_energy.h"
+#include "../../include/telemetry_generators.h"
+
+/** @brief Margen para el reparto del planificador del PC */
+#define CPU_TOLERANCE_US 15000
+
+static TaskHandle_t test_task;
+
+/**
+ * @brief Consume un tiempo de CPU del hilo, por mucho que lo expulsen
+ */
+static void busy_for_us(uint32_t us) {
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  int64_t end = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000 + us;
+  do {
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  } while((int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000 < end);
+}
+
+static uint64_t stage_cpu(telem_energy_stage_t stage) {
+  telemetry_energy_report_t report;
+  telemetry_energy_get_report(&report);
+  return report.stages[stage].cpu_us;
+}
+
+static void busy_stage_task(void* arg) {
+  telemetry_energy_register_task(TELEM_STAGE_COLLECTOR, xTaskGetCurrentTaskHandle());
+  busy_for_us(100000);
+  xTaskNotifyGive(test_task);
+  // Una tarea borrada se lleva su contador: sigue viva hasta la muestra
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  vTaskDelete(NULL);
+}
+
+static void idle_stage_task(void* arg) {
+  telemetry_energy_register_task(TELEM_STAGE_PROCESSOR, xTaskGetCurrentTaskHandle());
+  // Mucho tiempo de reloj "trabajando", casi nada de CPU
+  int64_t start = esp_timer_get_time();
+  vTaskDelay(pdMS_TO_TICKS(100));
+  telemetry_energy_add_active(TELEM_STAGE_PROCESSOR, (uint32_t)(esp_timer_get_time() - start));
+  xTaskNotifyGive(test_task);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  vTaskDelete(NULL);
+}
+
+static void shared_stage_task(void* arg) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  telemetry_energy_register_task(TELEM_STAGE_PROCESSOR, self);
+  telemetry_energy_register_task(TELEM_STAGE_TRANSMITTER, self);
+
+  // Tres cuartos para el procesador y uno para el transmisor
+  telemetry_energy_set_running_stage(TELEM_STAGE_PROCESSOR);
+  busy_for_us(150000);
+  telemetry_energy_add_active(TELEM_STAGE_PROCESSOR, 150000);
+  telemetry_energy_set_running_stage(TELEM_STAGE_TRANSMITTER);
+  TEST_ASSERT_EQUAL(TELEM_STAGE_TRANSMITTER, telemetry_energy_current_stage());
+  busy_for_us(50000);
+  telemetry_energy_add_active(TELEM_STAGE_TRANSMITTER, 50000);
+  telemetry_energy_set_running_stage(TELEM_STAGE_SYSTEM);
+
+  // La muestra se toma con la tarea viva, como hace el estado periódico
+  xTaskNotifyGive(test_task);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  vTaskDelete(NULL);
+}
+
+void setUp(void) {
+  test_task = xTaskGetCurrentTaskHandle();
+  for(int stage = 0; stage < TELEM_STAGE_SYSTEM; stage++) {
+    telemetry_energy_register_task((telem_energy_stage_t)stage, NULL);
+  }
+  stage_cpu(TELEM_STAGE_SYSTEM);
+}
+
+void tearDown(void) {
+}
+
+void test_dedicated_task_cpu_comes_from_run_time_stats(void) {
+  uint64_t collector = stage_cpu(TELEM_STAGE_COLLECTOR);
+  uint64_t processor = stage_cpu(TELEM_STAGE_PROCESSOR);
+
+  TaskHandle_t busy, idle;
+  xTaskCreate(idle_stage_task, "EnergyIdle", 4096, NULL, 1, &idle);
+  xTaskCreate(busy_stage_task, "EnergyBusy", 4096, NULL, 1, &busy);
+  for(int done = 0; done < 2;) {
+    done += (int)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000));
+  }
+  telemetry_energy_report_t report;
+  telemetry_energy_get_report(&report);
+  xTaskNotifyGive(busy);
+  xTaskNotifyGive(idle);
+
+  uint64_t busy_cpu = report.stages[TELEM_STAGE_COLLECTOR].cpu_us - collector;
+  uint64_t idle_cpu = report.stages[TELEM_STAGE_PROCESSOR].cpu_us - processor;
+  TEST_ASSERT_UINT32_WITHIN(CPU_TOLERANCE_US, 100000, (uint32_t)busy_cpu);
+  // 100 ms de tiempo activo bloqueado no son CPU
+  TEST_ASSERT_LESS_THAN(CPU_TOLERANCE_US, (uint32_t)idle_cpu);
+}
+
+void test_shared_task_cpu_is_split_by_active_time(void) {
+  uint64_t processor = stage_cpu(TELEM_STAGE_PROCESSOR);
+  uint64_t transmitter = stage_cpu(TELEM_STAGE_TRANSMITTER);
+
+  TaskHandle_t shared;
+  xTaskCreate(shared_stage_task, "EnergyCoop", 4096, NULL, 1, &shared);
+  TEST_ASSERT_NOT_EQUAL(0, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000)));
+  telemetry_energy_report_t report;
+  telemetry_energy_get_report(&report);
+  xTaskNotifyGive(shared);
+
+  uint64_t processor_cpu = report.stages[TELEM_STAGE_PROCESSOR].cpu_us - processor;
+  uint64_t transmitter_cpu = report.stages[TELEM_STAGE_TRANSMITTER].cpu_us - transmitter;
+  TEST_ASSERT_UINT32_WITHIN(CPU_TOLERANCE_US, 200000, (uint32_t)(processor_cpu + transmitter_cpu));
+  TEST_ASSERT_UINT32_WITHIN(CPU_TOLERANCE_US, 150000, (uint32_t)processor_cpu);
+}
+
+void test_unregistered_tasks_are_system(void) {
+  uint64_t system = stage_cpu(TELEM_STAGE_SYSTEM);
+  busy_for_us(50000);
+  // Cada informe es una muestra nueva: se toma una sola vez
+  uint64_t system_cpu = stage_cpu(TELEM_STAGE_SYSTEM) - system;
+  TEST_ASSERT_UINT32_WITHIN(CPU_TOLERANCE_US, 50000, (uint32_t)system_cpu);
+}
+
+void test_estimate_applies_the_model(void) {
+  telemetry_energy_model_t model = { 100, 250, 2900, 10 };
+  telemetry_energy_set_model(&model);
+  // 1000 µs * 100 nJ + 8 B * 250 nJ + 4 B * 2900 nJ = 113.6 µJ
+  TEST_ASSERT_EQUAL_UINT32(113, telemetry_energy_estimate_uj(1000, 8, 4));
+}
+
+static telemetry_packet_t system_packet;
+static uint32_t system_packets;
+
+static bool capture_system(const telemetry_packet_t* packet) {
+  if(packet->header.type == TELEM_SYSTEM_STATUS) {
+    system_packet = *packet;
+    system_packets++;
+  }
+  return true;
+}
+
+/**
+ * @brief Genera un ciclo y devuelve los mJ del paquete de sistema
+ */
+static uint32_t wire_energy_mj(void) {
+  system_packets = 0;
+  telemetry_generators_set_sink(capture_system);
+  generate_cycle_telemetry();
+  telemetry_generators_set_sink(NULL);
+  TEST_ASSERT_EQUAL_UINT32(1, system_packets);
+  return system_packet.system.energy_total_mj;
+}
+
+static uint64_t flash_bytes(const telemetry_energy_report_t* report) {
+  uint64_t bytes = 0;
+  for(int stage = 0; stage < TELEM_STAGE_COUNT; stage++) {
+    bytes += report->stages[stage].flash_bytes;
+  }
+  return bytes;
+}
+
+void test_totals_do_not_wrap(void) {
+  telemetry_energy_report_t report;
+  telemetry_generators_init();
+
+  // Solo cuenta la flash, a 1 J por byte: 5000 B superan los ~4295 J de 32 bits
+  telemetry_energy_model_t model = { 0, 1000000000UL, 0, 0 };
+  telemetry_energy_set_model(&model);
+  telemetry_energy_add_flash(5000);
+  telemetry_energy_get_report(&report);
+  TEST_ASSERT_TRUE(report.total_energy_uj > UINT32_MAX);
+  TEST_ASSERT_TRUE(flash_bytes(&report) * 1000000ULL == report.total_energy_uj);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)(report.total_energy_uj / 1000), wire_energy_mj());
+
+  // Más allá de UINT32_MAX mJ el paquete satura en vez de dar la vuelta
+  model.flash_nj_per_byte = UINT32_MAX;
+  telemetry_energy_set_model(&model);
+  telemetry_energy_add_flash(2000000);
+  telemetry_energy_get_report(&report);
+  TEST_ASSERT_TRUE(report.total_energy_uj / 1000 > UINT32_MAX);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wire_energy_mj());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_dedicated_task_cpu_comes_from_run_time_stats);
+  RUN_TEST(test_shared_task_cpu_is_split_by_active_time);
+  RUN_TEST(test_unregistered_tasks_are_system);
+  RUN_TEST(test_estimate_applies_the_model);
+  RUN_TEST(test_totals_do_not_wrap);
+  return UNITY_END();
+}
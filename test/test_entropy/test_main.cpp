@@ -0,0 +1,183 @@
+/**
+ * @file test_main.cpp
+ * @brief Arnés de entrenamiento y pruebas del codificador rANS (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details La tabla de frecuencias de telemetry_entropy.cpp sale de
+ * train_frequencies(): histograma de los residuos de un día de tramas
+ * simuladas (telemetry_entropy_sample_payload(), un ciclo cada 5 s),
+ * normalizado a 1 << TELEM_ENTROPY_PROB_BITS con un mínimo de 1 por símbolo
+ * y el sobrante asignado al símbolo más frecuente. Si la prueba de la tabla
+ * falla, imprime la tabla nueva lista para pegar.
+ *
+ * La prueba de rendimiento deja la carga de muestra en
+ * <host_shims_root()>/entropy_sample.bin para compararla con zlib y xz con
+ * tools/entropy_compare.py.
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_entropy.h"
+
+#define ENTROPY_SCALE (1u << TELEM_ENTROPY_PROB_BITS)
+
+/** @brief Paquetes por ciclo del recolector en la muestra */
+#define SAMPLE_PACKETS_PER_CYCLE 4
+
+/** @brief Ciclos de entrenamiento: un día a un ciclo cada 5 s */
+#define TRAINING_CYCLES (24 * 3600 / 5)
+
+static uint8_t raw[TELEM_FRAME_MAX_PAYLOAD];
+static uint8_t residuals[TELEM_FRAME_MAX_PAYLOAD];
+static uint8_t coded[TELEM_FRAME_MAX_PAYLOAD];
+static uint8_t restored[TELEM_FRAME_MAX_PAYLOAD];
+static uint8_t scratch[TELEM_FRAME_MAX_PAYLOAD];
+
+/**
+ * @brief Entrena la tabla de frecuencias con las tramas simuladas
+ */
+static void train_frequencies(uint16_t freq[256]) {
+  static uint64_t counts[256];
+  uint64_t total = 0;
+
+  memset(counts, 0, sizeof(counts));
+  for(uint32_t first = 0; first < TRAINING_CYCLES * SAMPLE_PACKETS_PER_CYCLE;) {
+    size_t length = telemetry_entropy_sample_payload(first, raw, sizeof(raw), NULL);
+    TEST_ASSERT_TRUE(telemetry_entropy_residuals(raw, residuals, length));
+    for(size_t i = 0; i < length; i++) {
+      counts[residuals[i]]++;
+    }
+    total += length;
+    // La siguiente trama empieza donde acabó esta: ~16 paquetes por trama
+    size_t packets = 0;
+    for(size_t offset = 0; offset < length; packets++) {
+      telemetry_packet_t packet;
+      memcpy(&packet, raw + offset, sizeof(packet.header));
+      offset += telemetry_packet_wire_size(&packet);
+    }
+    first += packets;
+  }
+
+  uint32_t sum = 0;
+  int top = 0;
+  for(int symbol = 0; symbol < 256; symbol++) {
+    uint64_t scaled = counts[symbol] * ENTROPY_SCALE / total;
+    freq[symbol] = scaled > 0 ? (uint16_t)scaled : 1;
+    sum += freq[symbol];
+    if(counts[symbol] > counts[top]) {
+      top = symbol;
+    }
+  }
+  freq[top] = (uint16_t)(freq[top] + ENTROPY_SCALE - sum);
+}
+
+static void print_table(const char* name, const uint16_t* values, int count) {
+  printf("static constexpr uint16_t %s[%d] = {\n", name, count);
+  for(int i = 0; i < count; i++) {
+    printf("%s%u%s", i % 16 == 0 ? "  " : "", values[i], i + 1 == count ? "\n" : (i % 16 == 15 ? ",\n" : ", "));
+  }
+  printf("};\n");
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_compiled_table_matches_training(void) {
+  uint16_t freq[256];
+  train_frequencies(freq);
+
+  if(memcmp(freq, telemetry_entropy_frequencies(), sizeof(freq)) != 0) {
+    uint16_t cum[257];
+    cum[0] = 0;
+    for(int symbol = 0; symbol < 256; symbol++) {
+      cum[symbol + 1] = (uint16_t)(cum[symbol] + freq[symbol]);
+    }
+    print_table("entropy_freq", freq, 256);
+    print_table("entropy_cum", cum, 257);
+    TEST_FAIL_MESSAGE("entropy_freq no corresponde al entrenamiento: pegar las tablas impresas");
+  }
+}
+
+void test_sample_frames_round_trip(void) {
+  // Tramas que no se usaron para entrenar (segundo día)
+  for(uint32_t first = TRAINING_CYCLES * SAMPLE_PACKETS_PER_CYCLE; first < (TRAINING_CYCLES + 400) * SAMPLE_PACKETS_PER_CYCLE;
+      first += 16) {
+    size_t length = telemetry_entropy_sample_payload(first, raw, sizeof(raw), NULL);
+    TEST_ASSERT_TRUE(telemetry_entropy_residuals(raw, residuals, length));
+
+    // Mismo formato que telemetry_frame_compress(): longitud original y flujo rANS
+    coded[0] = (uint8_t)length;
+    coded[1] = (uint8_t)(length >> 8);
+    size_t size = telemetry_entropy_encode(residuals, length, coded + 2, sizeof(coded) - 2);
+    TEST_ASSERT_GREATER_THAN(0, size);
+    TEST_ASSERT_LESS_THAN(length / 2, size);
+
+    TEST_ASSERT_EQUAL_UINT32(length, telemetry_frame_decompress(coded, size + 2, restored, sizeof(restored), scratch));
+    TEST_ASSERT_EQUAL_MEMORY(raw, restored, length);
+  }
+}
+
+void test_corrupted_stream_is_rejected(void) {
+  size_t length = telemetry_entropy_sample_payload(0, raw, sizeof(raw), NULL);
+  TEST_ASSERT_TRUE(telemetry_entropy_residuals(raw, residuals, length));
+  size_t size = telemetry_entropy_encode(residuals, length, coded, sizeof(coded));
+  TEST_ASSERT_TRUE(telemetry_entropy_decode(coded, size, scratch, length));
+
+  // Un flujo íntegro acaba en el estado inicial; uno truncado no
+  TEST_ASSERT_FALSE(telemetry_entropy_decode(coded, size - 1, scratch, length));
+}
+
+void test_benchmark_reports_ratio_and_speed(void) {
+  const int iterations = 2000;
+  size_t bitpacked = 0;
+  size_t length = telemetry_entropy_sample_payload(0, raw, sizeof(raw), &bitpacked);
+
+  size_t size = 0;
+  timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < iterations; i++) {
+    telemetry_entropy_residuals(raw, residuals, length);
+    size = telemetry_entropy_encode(residuals, length, coded, sizeof(coded));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double encode_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < iterations; i++) {
+    TEST_ASSERT_TRUE(telemetry_entropy_decode(coded, size, scratch, length));
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double decode_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  std::string path = std::string(host_shims_root()) + "/entropy_sample.bin";
+  FILE* sample = fopen(path.c_str(), "wb");
+  TEST_ASSERT_NOT_NULL(sample);
+  fwrite(raw, 1, length, sample);
+  fclose(sample);
+
+  char message[200];
+  snprintf(message, sizeof(message),
+           "raw %u B | bitpack %u B | delta+rANS %u B (+2 B length) | enc %.1f MB/s | dec %.1f MB/s | sample %s",
+           (unsigned)length, (unsigned)bitpacked, (unsigned)size,
+           length * iterations / encode_s / 1e6, length * iterations / decode_s / 1e6, path.c_str());
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(bitpacked, size);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_compiled_table_matches_training);
+  RUN_TEST(test_sample_frames_round_trip);
+  RUN_TEST(test_corrupted_stream_is_rejected);
+  RUN_TEST(test_benchmark_reports_ratio_and_speed);
+  return UNITY_END();
+}
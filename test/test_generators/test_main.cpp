@@ -0,0 +1,125 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del registro de generadores y de los tipos propios (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que el paquete de resumen de cerrojos, el primer tipo
+ * propio, sobrevive al empaquetado de bits con su carga en bruto, que el
+ * registro rechaza los tipos que no caben en el encabezado empaquetado y que
+ * registrar desde otra tarea mientras el recolector ejecuta generadores no
+ * corrompe el montículo de vencimientos.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_bitpack.h"
+#include "../../include/telemetry_generators.h"
+#include "../../include/telemetry_lock.h"
+
+/** @brief Generadores que registra la tarea concurrente */
+#define RACE_GENERATORS 4
+
+static telemetry_packet_t captured;
+static volatile uint32_t captured_count;
+
+static bool capture_sink(const telemetry_packet_t* packet) {
+  captured = *packet;
+  captured_count++;
+  return true;
+}
+
+static void fill_nothing(telemetry_packet_t* packet) {
+}
+
+static uint32_t now_ms(void) {
+  return pdTICKS_TO_MS(xTaskGetTickCount());
+}
+
+void setUp(void) {
+  telemetry_generators_set_sink(capture_sink);
+  captured_count = 0;
+}
+
+void tearDown(void) {
+  telemetry_generators_set_sink(NULL);
+}
+
+void test_lock_profile_survives_bitpack(void) {
+  static telemetry_lock_t lock;
+  TEST_ASSERT_TRUE(telemetry_lock_create(&lock, "test"));
+  TEST_ASSERT_TRUE(telemetry_lock_take(&lock, portMAX_DELAY));
+  telemetry_lock_give(&lock);
+  TEST_ASSERT_TRUE(telemetry_lock_register_generator());
+
+  telemetry_generators_run_due(now_ms());
+  TEST_ASSERT_EQUAL_UINT32(1, captured_count);
+  TEST_ASSERT_EQUAL(TELEM_LOCK_PROFILE_TYPE, captured.header.type);
+  const lock_profile_telem_t* profile = (const lock_profile_telem_t*)&captured;
+  TEST_ASSERT_EQUAL_UINT32(1, profile->acquires);
+
+  uint8_t packed[sizeof(telemetry_packet_t)];
+  size_t size = telemetry_bitpack_encode(&captured, packed, sizeof(packed));
+  TEST_ASSERT_GREATER_THAN(0, size);
+  TEST_ASSERT_EQUAL(size, telemetry_bitpack_size(&captured));
+
+  telemetry_packet_t decoded;
+  TEST_ASSERT_EQUAL(size, telemetry_bitpack_decode(packed, size, &decoded));
+  TEST_ASSERT_EQUAL_MEMORY(&captured, &decoded, sizeof(decoded));
+}
+
+void test_register_rejects_types_outside_the_header(void) {
+  static const telemetry_generator_t largest = { TELEM_TYPE_MAX, 0, 1000, fill_nothing };
+  static const telemetry_generator_t too_large = { TELEM_TYPE_MAX + 1, 0, 1000, fill_nothing };
+  TEST_ASSERT_TRUE(telemetry_generator_register(&largest));
+  TEST_ASSERT_FALSE(telemetry_generator_register(&too_large));
+
+  // Un tipo que el registro no aceptaría tampoco se empaqueta
+  telemetry_packet_t packet;
+  uint8_t packed[sizeof(telemetry_packet_t)];
+  memset(&packet, 0, sizeof(packet));
+  packet.header.type = (telem_data_type_t)(TELEM_TYPE_MAX + 1);
+  TEST_ASSERT_EQUAL(0, telemetry_bitpack_encode(&packet, packed, sizeof(packed)));
+}
+
+static volatile bool race_done;
+
+static void register_task(void* param) {
+  static const telemetry_generator_t generators[RACE_GENERATORS] = {
+    { TELEM_TYPE_COUNT, 0, 1, fill_nothing },
+    { TELEM_TYPE_COUNT, 0, 2, fill_nothing },
+    { TELEM_TYPE_COUNT, 0, 3, fill_nothing },
+    { TELEM_TYPE_COUNT, 0, 5, fill_nothing },
+  };
+  for(int i = 0; i < RACE_GENERATORS; i++) {
+    telemetry_generator_register(&generators[i]);
+    vTaskDelay(1);
+  }
+  race_done = true;
+  vTaskDelete(NULL);
+}
+
+void test_register_while_the_collector_runs(void) {
+  race_done = false;
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(register_task, "register", 4096, NULL, 1, NULL));
+
+  uint32_t start = now_ms();
+  while(!race_done || now_ms() - start < 50) {
+    uint32_t wait_ms = telemetry_generators_run_due(now_ms());
+    TEST_ASSERT_LESS_OR_EQUAL(TELEM_LOCK_PROFILE_PERIOD_MS, wait_ms);
+    vTaskDelay(1);
+  }
+
+  // Todos vencen como mucho cada 5 ms: en 50 ms cada uno se ejecutó varias veces
+  TEST_ASSERT_GREATER_THAN(4 * RACE_GENERATORS, captured_count);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lock_profile_survives_bitpack);
+  RUN_TEST(test_register_rejects_types_outside_the_header);
+  RUN_TEST(test_register_while_the_collector_runs);
+  return UNITY_END();
+}
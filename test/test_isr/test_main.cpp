@@ -0,0 +1,138 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del almacenamiento desde interrupciones (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que el benchmark no deja rastro (ni fuente ocupada ni
+ * números de secuencia consumidos), que la línea ALERT del monitor de
+ * potencia llega al consumidor en orden y sellada, y que una ráfaga mayor
+ * que el anillo se cuenta como desborde. La interrupción la lanza
+ * host_shims_trigger_interrupt() desde otra tarea y el consumidor es la
+ * tarea de la prueba, despertada por el aviso como el recolector. En el PC
+ * la latencia de traspaso incluye el planificador del anfitrión: sirve para
+ * comprobar el camino completo, no como tiempo del ESP32.
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_isr.h"
+#include "../../include/telemetry_sensors.h"
+
+/** @brief Interrupciones que lanza la tarea de alertas */
+#define ALERT_EVENTS 32
+
+/** @brief Fuente de la línea ALERT (la primera que se registra) */
+#define ALERT_SOURCE 0
+
+static telemetry_packet_t captured[ALERT_EVENTS + TELEM_ISR_RING_SIZE];
+static uint32_t captured_count;
+static TaskHandle_t consumer;
+static volatile bool alerts_done;
+
+static bool capture_sink(const telemetry_packet_t* packet) {
+  if(captured_count < sizeof(captured) / sizeof(captured[0])) {
+    captured[captured_count] = *packet;
+  }
+  captured_count++;
+  return true;
+}
+
+static void wake_consumer(BaseType_t* woken) {
+  vTaskNotifyGiveFromISR(consumer, woken);
+}
+
+static void alert_task(void* arg) {
+  for(int i = 0; i < ALERT_EVENTS; i++) {
+    host_shims_trigger_interrupt(TELEM_SENSOR_ALERT_PIN);
+    vTaskDelay(1);
+  }
+  alerts_done = true;
+  vTaskDelete(NULL);
+}
+
+void setUp(void) {
+  captured_count = 0;
+  consumer = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyTake(pdTRUE, 0);
+}
+
+void tearDown(void) {
+  telemetry_isr_set_notify(NULL);
+}
+
+void test_benchmark_leaves_no_trace(void) {
+  telem_header_t before, after;
+  memset(&before, 0, sizeof(before));
+  memset(&after, 0, sizeof(after));
+  telemetry_generators_stamp(&before, 0);
+  telemetry_isr_benchmark();
+  telemetry_generators_stamp(&after, 0);
+  TEST_ASSERT_EQUAL_UINT16((uint16_t)(before.sequence + 1), after.sequence);
+
+  // Las dos fuentes siguen libres para las interrupciones reales
+  telemetry_isr_stats_t stats;
+  TEST_ASSERT_FALSE(telemetry_isr_get_stats(ALERT_SOURCE, &stats));
+  TEST_ASSERT_TRUE(telemetry_sensors_alert_init());
+  TEST_ASSERT_NOT_EQUAL(TELEM_ISR_INVALID_SOURCE, telemetry_isr_register("spare"));
+  TEST_ASSERT_TRUE(telemetry_isr_get_stats(ALERT_SOURCE, &stats));
+  TEST_ASSERT_EQUAL_STRING("power-alert", stats.name);
+}
+
+void test_alert_line_reaches_the_consumer_in_order(void) {
+  telemetry_isr_set_notify(wake_consumer);
+  alerts_done = false;
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(alert_task, "alert", 2048, NULL, 2, NULL));
+
+  uint32_t start = millis();
+  while((!alerts_done || captured_count < ALERT_EVENTS) && millis() - start < 2000) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+    telemetry_isr_drain(capture_sink);
+  }
+  TEST_ASSERT_EQUAL_UINT32(ALERT_EVENTS, captured_count);
+
+  // Sin WOKWI la batería toma sus valores nominales
+  for(uint32_t i = 0; i < captured_count; i++) {
+    TEST_ASSERT_EQUAL(TELEM_POWER_DATA, captured[i].header.type);
+    TEST_ASSERT_EQUAL(TELEM_POWER_STATE_ALERT, captured[i].power.power_state);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 3.95, captured[i].power.battery_voltage);
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)(captured[0].header.sequence + i), captured[i].header.sequence);
+  }
+
+  telemetry_isr_stats_t stats;
+  TEST_ASSERT_TRUE(telemetry_isr_get_stats(ALERT_SOURCE, &stats));
+  char message[160];
+  snprintf(message, sizeof(message), "ISR: %lu alerts | Overflows=%lu | Max pending=%lu | Handoff avg=%lu us max=%lu us",
+           (unsigned long)stats.merged, (unsigned long)stats.overflows, (unsigned long)stats.max_pending,
+           (unsigned long)stats.avg_latency_us, (unsigned long)stats.max_latency_us);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT32(ALERT_EVENTS, stats.stored);
+  TEST_ASSERT_EQUAL_UINT32(ALERT_EVENTS, stats.merged);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.overflows);
+}
+
+void test_burst_overflows_the_ring(void) {
+  telemetry_isr_stats_t before, after;
+  TEST_ASSERT_TRUE(telemetry_isr_get_stats(ALERT_SOURCE, &before));
+
+  // Rebotes del pulsador: el doble de flancos de lo que cabe sin vaciar
+  for(int i = 0; i < 2 * TELEM_ISR_RING_SIZE; i++) {
+    TEST_ASSERT_TRUE(host_shims_trigger_interrupt(TELEM_SENSOR_ALERT_PIN));
+  }
+  TEST_ASSERT_EQUAL_UINT32(TELEM_ISR_RING_SIZE, telemetry_isr_drain(capture_sink));
+
+  TEST_ASSERT_TRUE(telemetry_isr_get_stats(ALERT_SOURCE, &after));
+  TEST_ASSERT_EQUAL_UINT32(before.overflows + TELEM_ISR_RING_SIZE, after.overflows);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_ISR_RING_SIZE, after.max_pending);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_benchmark_leaves_no_trace);
+  RUN_TEST(test_alert_line_reaches_the_consumer_in_order);
+  RUN_TEST(test_burst_overflows_the_ring);
+  return UNITY_END();
+}
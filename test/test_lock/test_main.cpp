@@ -0,0 +1,132 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del mutex instrumentado (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Una tarea auxiliar retiene el cerrojo mientras la prueba lo pide.
+ * Comprueba que una adquisición libre no cuenta como contención, que una que
+ * espera a que la auxiliar lo suelte sí, con su espera y la retención de la
+ * auxiliar en los máximos y en los histogramas, y que un tiempo agotado (con
+ * espera o sin ella) se cuenta aparte, con el nombre de la tarea que tenía el
+ * cerrojo y sin sumar adquisiciones.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_lock.h"
+
+/** @brief Tiempo que la tarea auxiliar retiene el cerrojo (ms) */
+#define HOLD_MS 20
+
+/** @brief Nombre de la tarea auxiliar, esperado como dueño en los tiempos agotados */
+#define HOLDER_NAME "holder"
+
+static telemetry_lock_t lock;
+static volatile bool holder_has_lock;
+static volatile bool holder_release;
+static volatile bool holder_done;
+
+static void holder_task(void* arg) {
+  uint32_t hold_ms = (uint32_t)(intptr_t)arg;
+
+  telemetry_lock_take(&lock, portMAX_DELAY);
+  holder_has_lock = true;
+  uint32_t start = millis();
+  while(!holder_release && millis() - start < hold_ms) {
+    vTaskDelay(1);
+  }
+  telemetry_lock_give(&lock);
+  holder_done = true;
+  vTaskDelete(NULL);
+}
+
+/**
+ * @brief Arranca la tarea auxiliar y espera a que tenga el cerrojo
+ */
+static void start_holder(uint32_t hold_ms) {
+  holder_has_lock = false;
+  holder_release = false;
+  holder_done = false;
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(holder_task, HOLDER_NAME, 2048, (void*)(intptr_t)hold_ms, 1, NULL));
+  for(int i = 0; i < 1000 && !holder_has_lock; i++) {
+    vTaskDelay(1);
+  }
+  TEST_ASSERT_TRUE(holder_has_lock);
+}
+
+static void wait_for_holder(void) {
+  for(int i = 0; i < 1000 && !holder_done; i++) {
+    vTaskDelay(1);
+  }
+  TEST_ASSERT_TRUE(holder_done);
+}
+
+static uint32_t hist_total(const uint32_t* hist) {
+  uint32_t total = 0;
+  for(int bin = 0; bin < TELEM_LOCK_HIST_BINS; bin++) {
+    total += hist[bin];
+  }
+  return total;
+}
+
+void setUp(void) {
+  TEST_ASSERT_TRUE(telemetry_lock_create(&lock, "test"));
+}
+
+void tearDown(void) {
+}
+
+void test_free_lock_is_not_contended(void) {
+  TEST_ASSERT_TRUE(telemetry_lock_take(&lock, 0));
+  telemetry_lock_give(&lock);
+  TEST_ASSERT_TRUE(telemetry_lock_take(&lock, portMAX_DELAY));
+  telemetry_lock_give(&lock);
+
+  TEST_ASSERT_EQUAL_UINT32(2, lock.acquires);
+  TEST_ASSERT_EQUAL_UINT32(0, lock.contended);
+  TEST_ASSERT_EQUAL_UINT32(0, lock.timeouts);
+  TEST_ASSERT_EQUAL_UINT32(2, hist_total(lock.wait_hist));
+  TEST_ASSERT_EQUAL_UINT32(2, hist_total(lock.hold_hist));
+}
+
+void test_waiting_for_the_holder_is_contended(void) {
+  start_holder(HOLD_MS);
+  TEST_ASSERT_TRUE(telemetry_lock_take(&lock, portMAX_DELAY));
+  telemetry_lock_give(&lock);
+  wait_for_holder();
+
+  TEST_ASSERT_EQUAL_UINT32(2, lock.acquires);
+  TEST_ASSERT_EQUAL_UINT32(1, lock.contended);
+  TEST_ASSERT_EQUAL_UINT32(0, lock.timeouts);
+  // La espera y la retención de la auxiliar son de milisegundos: intervalo de 1 ms o más
+  TEST_ASSERT_GREATER_THAN(HOLD_MS * 1000 / 2, lock.max_wait_us);
+  TEST_ASSERT_TRUE(lock.max_hold_us >= HOLD_MS * 1000);
+  TEST_ASSERT_EQUAL_UINT32(1, lock.wait_hist[TELEM_LOCK_HIST_BINS - 3] + lock.wait_hist[TELEM_LOCK_HIST_BINS - 2] +
+                              lock.wait_hist[TELEM_LOCK_HIST_BINS - 1]);
+  TEST_ASSERT_EQUAL_UINT32(2, hist_total(lock.hold_hist));
+}
+
+void test_timeouts_record_the_owner(void) {
+  start_holder(portMAX_DELAY);
+  TEST_ASSERT_FALSE(telemetry_lock_take(&lock, pdMS_TO_TICKS(5)));
+  TEST_ASSERT_FALSE(telemetry_lock_take(&lock, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, lock.timeouts);
+  TEST_ASSERT_EQUAL_STRING(HOLDER_NAME, lock.timeout_owner);
+
+  holder_release = true;
+  wait_for_holder();
+  TEST_ASSERT_EQUAL_UINT32(1, lock.acquires);
+  TEST_ASSERT_EQUAL_UINT32(0, lock.contended);
+  TEST_ASSERT_EQUAL_UINT32(1, hist_total(lock.wait_hist));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_free_lock_is_not_contended);
+  RUN_TEST(test_waiting_for_the_holder_is_contended);
+  RUN_TEST(test_timeouts_record_the_owner);
+  return UNITY_END();
+}
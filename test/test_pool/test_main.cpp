@@ -0,0 +1,156 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del pool de paquetes con contador de referencias (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que un bloque compartido solo vuelve al pool con la
+ * última referencia, que el agotamiento se cuenta sin repartir dos veces el
+ * mismo bloque y que varias tareas reservando y liberando a la vez nunca
+ * reciben un bloque que otra sigue usando.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_pool.h"
+
+/** @brief Tareas que compiten por el pool */
+#define RACE_TASKS 4
+
+/** @brief Reservas de cada tarea en la prueba de concurrencia */
+#define RACE_ROUNDS 20000
+
+static volatile uint32_t race_finished;
+static volatile uint32_t race_collisions;
+static volatile uint32_t race_failures;
+
+void setUp(void) {
+  telemetry_pool_init();
+}
+
+void tearDown(void) {
+}
+
+void test_block_returns_with_the_last_reference(void) {
+  uint32_t in_use, high_water, exhausted;
+
+  telem_pool_handle_t handle = telemetry_pool_alloc();
+  TEST_ASSERT_NOT_EQUAL(TELEM_POOL_INVALID, handle);
+  telemetry_pool_get(handle)->header.sequence = 1234;
+
+  // Dos consumidores más comparten el bloque
+  telemetry_pool_retain(handle);
+  telemetry_pool_retain(handle);
+  telemetry_pool_release(handle);
+  telemetry_pool_release(handle);
+  telemetry_pool_get_stats(&in_use, &high_water, &exhausted);
+  TEST_ASSERT_EQUAL_UINT32(1, in_use);
+  TEST_ASSERT_EQUAL_UINT16(1234, telemetry_pool_get(handle)->header.sequence);
+
+  telemetry_pool_release(handle);
+  telemetry_pool_get_stats(&in_use, &high_water, &exhausted);
+  TEST_ASSERT_EQUAL_UINT32(0, in_use);
+  TEST_ASSERT_EQUAL_UINT32(1, high_water);
+
+  // La lista libre es una pila: el bloque liberado es el siguiente en salir
+  TEST_ASSERT_EQUAL_UINT16(handle, telemetry_pool_alloc());
+}
+
+void test_exhaustion_is_counted(void) {
+  uint32_t in_use, high_water, exhausted;
+  bool seen[TELEM_POOL_SIZE];
+  telem_pool_handle_t held[TELEM_POOL_SIZE];
+
+  memset(seen, 0, sizeof(seen));
+  for(int i = 0; i < TELEM_POOL_SIZE; i++) {
+    held[i] = telemetry_pool_alloc();
+    TEST_ASSERT_LESS_THAN(TELEM_POOL_SIZE, held[i]);
+    TEST_ASSERT_FALSE(seen[held[i]]);
+    seen[held[i]] = true;
+  }
+
+  TEST_ASSERT_EQUAL(TELEM_POOL_INVALID, telemetry_pool_alloc());
+  TEST_ASSERT_EQUAL(TELEM_POOL_INVALID, telemetry_pool_alloc());
+  telemetry_pool_get_stats(&in_use, &high_water, &exhausted);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_POOL_SIZE, in_use);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_POOL_SIZE, high_water);
+  TEST_ASSERT_EQUAL_UINT32(2, exhausted);
+
+  // Un bloque liberado vuelve a estar disponible
+  telemetry_pool_release(held[7]);
+  TEST_ASSERT_EQUAL_UINT16(held[7], telemetry_pool_alloc());
+  TEST_ASSERT_EQUAL(TELEM_POOL_INVALID, telemetry_pool_alloc());
+
+  for(int i = 0; i < TELEM_POOL_SIZE; i++) {
+    telemetry_pool_release(held[i]);
+  }
+  telemetry_pool_get_stats(&in_use, &high_water, &exhausted);
+  TEST_ASSERT_EQUAL_UINT32(0, in_use);
+  TEST_ASSERT_EQUAL_UINT32(3, exhausted);
+}
+
+static void race_task(void* arg) {
+  uint16_t owner = (uint16_t)(intptr_t)arg;
+  telem_pool_handle_t held[2];
+
+  for(uint32_t round = 0; round < RACE_ROUNDS; round++) {
+    // Dos bloques a la vez para que la pila cambie entre reserva y liberación
+    for(int i = 0; i < 2; i++) {
+      held[i] = telemetry_pool_alloc();
+      if(held[i] == TELEM_POOL_INVALID) {
+        __atomic_add_fetch(&race_failures, 1, __ATOMIC_RELAXED);
+        continue;
+      }
+      telemetry_pool_get(held[i])->header.sequence = owner;
+      telemetry_pool_get(held[i])->header.timestamp = round;
+    }
+    if((round & 0xFF) == 0) {
+      taskYIELD();
+    }
+    for(int i = 0; i < 2; i++) {
+      if(held[i] == TELEM_POOL_INVALID) {
+        continue;
+      }
+      const telemetry_packet_t* packet = telemetry_pool_get(held[i]);
+      if(packet->header.sequence != owner || packet->header.timestamp != round) {
+        __atomic_add_fetch(&race_collisions, 1, __ATOMIC_RELAXED);
+      }
+      telemetry_pool_release(held[i]);
+    }
+  }
+  __atomic_add_fetch(&race_finished, 1, __ATOMIC_RELEASE);
+  vTaskDelete(NULL);
+}
+
+void test_concurrent_alloc_never_shares_a_block(void) {
+  uint32_t in_use, high_water, exhausted;
+
+  race_finished = 0;
+  race_collisions = 0;
+  race_failures = 0;
+  for(int i = 0; i < RACE_TASKS; i++) {
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(race_task, "pool-race", 2048, (void*)(intptr_t)(i + 1), 1, NULL));
+  }
+  for(int i = 0; i < 10000 && __atomic_load_n(&race_finished, __ATOMIC_ACQUIRE) < RACE_TASKS; i++) {
+    vTaskDelay(1);
+  }
+  TEST_ASSERT_EQUAL_UINT32(RACE_TASKS, race_finished);
+
+  TEST_ASSERT_EQUAL_UINT32(0, race_collisions);
+  // Nunca hay más de 2 * RACE_TASKS bloques en uso: el pool no se agota
+  TEST_ASSERT_EQUAL_UINT32(0, race_failures);
+  telemetry_pool_get_stats(&in_use, &high_water, &exhausted);
+  TEST_ASSERT_EQUAL_UINT32(0, in_use);
+  TEST_ASSERT_LESS_OR_EQUAL(2 * RACE_TASKS, high_water);
+  TEST_ASSERT_EQUAL_UINT32(0, exhausted);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_block_returns_with_the_last_reference);
+  RUN_TEST(test_exhaustion_is_counted);
+  RUN_TEST(test_concurrent_alloc_never_shares_a_block);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del modo de bajo consumo (entorno native_lowpower)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Se compila con `TELEM_LOW_POWER_MODE`. Cada despertar de muestreo
+ * se ejecuta en su propia tarea, porque en el PC esp_deep_sleep_start() deja
+ * la tarea parada para siempre; host_shims_deep_sleeps() indica cuándo ha
+ * "dormido". Comprueba que el lote se llena ciclo a ciclo y se vuelca
+ * completo, que las marcas de tiempo avanzan al menos un periodo por ciclo,
+ * la energía estimada por muestra y que el buffer principal pasa a memoria
+ * RTC al volver a dormir y vuelve al buffer en el siguiente despertar.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_sleep.h"
+#include "../../include/telemetry_storage.h"
+
+/** @brief Paquetes que quedan en el buffer al volver a dormir */
+#define LEFTOVER_PACKETS (TELEM_SLEEP_CARRY_SIZE + 4)
+
+static telemetry_packet_t flushed[TELEM_SLEEP_BATCH_SIZE];
+static uint32_t flushed_count;
+static volatile bool wake_returned;
+
+static bool capture_sink(const telemetry_packet_t* packet) {
+  if(flushed_count < TELEM_SLEEP_BATCH_SIZE) {
+    flushed[flushed_count] = *packet;
+  }
+  flushed_count++;
+  return true;
+}
+
+static void wake_task(void* arg) {
+  telemetry_sleep_handle_wake();
+  // Solo retorna con el lote completo
+  wake_returned = true;
+  vTaskDelete(NULL);
+}
+
+static void service_task(void* arg) {
+  telemetry_sleep_service();
+  vTaskDelete(NULL);
+}
+
+/**
+ * @brief Espera a que una tarea entre en deep sleep
+ */
+static bool wait_for_sleeps(uint32_t sleeps) {
+  for(int i = 0; i < 2000 && host_shims_deep_sleeps() < sleeps; i++) {
+    vTaskDelay(1);
+  }
+  return host_shims_deep_sleeps() == sleeps;
+}
+
+void setUp(void) {
+  flushed_count = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_batch_fills_one_cycle_per_wake(void) {
+  host_shims_set_reset_reason(ESP_RST_DEEPSLEEP);
+  wake_returned = false;
+
+  for(uint32_t cycle = 1; cycle < TELEM_SLEEP_BATCH_CYCLES; cycle++) {
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(wake_task, "wake", 4096, NULL, 1, NULL));
+    TEST_ASSERT_TRUE(wait_for_sleeps(cycle));
+    TEST_ASSERT_FALSE(wake_returned);
+  }
+  // El último ciclo completa el lote y sigue con el arranque normal
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(wake_task, "wake", 4096, NULL, 1, NULL));
+  for(int i = 0; i < 2000 && !wake_returned; i++) {
+    vTaskDelay(1);
+  }
+  TEST_ASSERT_TRUE(wake_returned);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_SLEEP_BATCH_CYCLES - 1, host_shims_deep_sleeps());
+
+  telemetry_storage_init();
+  TEST_ASSERT_EQUAL_UINT32(TELEM_SLEEP_BATCH_SIZE, telemetry_sleep_flush_batch(capture_sink));
+  TEST_ASSERT_EQUAL_UINT32(TELEM_SLEEP_BATCH_SIZE, flushed_count);
+  // El lote queda vacío
+  TEST_ASSERT_EQUAL_UINT32(0, telemetry_sleep_flush_batch(capture_sink));
+
+  // Entre ciclos pasa al menos un periodo de sueño de la base de tiempo RTC
+  for(uint32_t i = TELEM_SLEEP_PACKETS_PER_CYCLE; i < TELEM_SLEEP_BATCH_SIZE; i += TELEM_SLEEP_PACKETS_PER_CYCLE) {
+    TEST_ASSERT_TRUE(flushed[i].header.timestamp >=
+                     flushed[i - TELEM_SLEEP_PACKETS_PER_CYCLE].header.timestamp + TELEM_SLEEP_PERIOD_MS);
+  }
+
+  telemetry_sleep_stats_t stats;
+  telemetry_sleep_get_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_SLEEP_BATCH_CYCLES, stats.samples);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.full_wakes);
+  TEST_ASSERT_TRUE(stats.awake_us + stats.sleep_us >=
+                   (uint64_t)(TELEM_SLEEP_BATCH_CYCLES - 1) * TELEM_SLEEP_PERIOD_MS * 1000);
+
+  // La última estimación se hizo al dormir tras la muestra anterior
+  uint64_t active_uj = stats.awake_us * TELEM_SLEEP_ACTIVE_POWER_MW / 1000;
+  uint64_t sleep_uj = stats.sleep_us * TELEM_SLEEP_DEEP_POWER_UW / 1000000;
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)((active_uj + sleep_uj) / (TELEM_SLEEP_BATCH_CYCLES - 1)),
+                           stats.energy_per_sample_uj);
+}
+
+void test_buffer_is_carried_across_sleep(void) {
+  telemetry_storage_init();
+  telemetry_packet_t packet;
+  while(telemetry_retrieve_packet(&packet)) {
+  }
+  for(uint16_t sequence = 0; sequence < LEFTOVER_PACKETS; sequence++) {
+    memset(&packet, 0, sizeof(packet));
+    packet.header.type = TELEM_TEMPERATURE_DATA;
+    packet.header.sequence = sequence;
+    packet.temperature.obc_temperature = (int16_t)sequence;
+    TEST_ASSERT_TRUE(telemetry_store_packet(&packet));
+  }
+
+  // Duerme sin esperar a que el transmisor vacíe el buffer
+  while(millis() < TELEM_SLEEP_MIN_AWAKE_MS) {
+    vTaskDelay(10);
+  }
+  uint32_t sleeps = host_shims_deep_sleeps();
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(service_task, "service", 4096, NULL, 1, NULL));
+  TEST_ASSERT_TRUE(wait_for_sleeps(sleeps + 1));
+  TEST_ASSERT_EQUAL_UINT32(0, telemetry_available_packets());
+
+  telemetry_sleep_stats_t stats;
+  telemetry_sleep_get_stats(&stats);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_SLEEP_CARRY_SIZE, stats.carried);
+  TEST_ASSERT_EQUAL_UINT32(LEFTOVER_PACKETS - TELEM_SLEEP_CARRY_SIZE, stats.carry_dropped);
+
+  // Siguiente despertar completo: vuelven al buffer los más recientes, en orden
+  TEST_ASSERT_EQUAL_UINT32(0, telemetry_sleep_flush_batch(capture_sink));
+  TEST_ASSERT_EQUAL_UINT32(0, flushed_count);
+  TEST_ASSERT_EQUAL_UINT32(TELEM_SLEEP_CARRY_SIZE, telemetry_available_packets());
+  for(uint16_t sequence = LEFTOVER_PACKETS - TELEM_SLEEP_CARRY_SIZE; sequence < LEFTOVER_PACKETS; sequence++) {
+    TEST_ASSERT_TRUE(telemetry_retrieve_packet(&packet));
+    TEST_ASSERT_EQUAL_UINT16(sequence, packet.header.sequence);
+    TEST_ASSERT_EQUAL((int16_t)sequence, packet.temperature.obc_temperature);
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_batch_fills_one_cycle_per_wake);
+  RUN_TEST(test_buffer_is_carried_across_sleep);
+  return UNITY_END();
+}
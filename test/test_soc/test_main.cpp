@@ -0,0 +1,110 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del estimador de estado de carga (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Usa tensiones que caen justo en puntos de la curva OCV (3,71 V
+ * es el 50 % y 3,80 V el 62,5 %), así que el SoC correcto se conoce sin
+ * simular la batería. Comprueba que el arranque lee la curva descontando la
+ * caída en la resistencia interna, que un estimador desviado 30 puntos con la
+ * batería en reposo converge a la OCV sin alejarse nunca y con la varianza a
+ * la baja, y que el estimador de a bordo arranca en frío desde la tensión y
+ * después solo actualiza.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "../../include/telemetry_soc.h"
+#include "../../include/telemetry_calibration.h"
+
+/** @brief Uno en Q30, el formato del SoC */
+#define SOC_ONE (1 << 30)
+
+/** @brief mV a V en Q16 */
+#define MV_Q16(mv) ((int32_t)((mv) * (int64_t)TELEM_Q16_ONE / 1000))
+
+/** @brief Tolerancia del SoC: 0,1 puntos en Q30 */
+#define SOC_TOLERANCE (SOC_ONE / 1000)
+
+/** @brief Periodo entre muestras del recolector (µs) */
+#define STEP_US 5000000ULL
+
+/** @brief Muestras en reposo para la prueba de convergencia */
+#define CONVERGENCE_STEPS 200
+
+/** @brief Error inicial de la prueba de convergencia: 30 puntos */
+#define INITIAL_ERROR (SOC_ONE / 10 * 3)
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_reset_reads_the_ocv_curve(void) {
+  telemetry_soc_state_t state;
+
+  telemetry_soc_reset(&state, MV_Q16(3710), 0, 0);
+  TEST_ASSERT_UINT32_WITHIN(SOC_TOLERANCE, SOC_ONE / 2, state.soc);
+  TEST_ASSERT_EQUAL_UINT32(0, state.updates);
+
+  // Con 1 A de descarga la tensión en bornes cae I·R
+  telemetry_soc_reset(&state, MV_Q16(3710 - TELEM_SOC_RESISTANCE_MOHM), TELEM_Q16_ONE, 0);
+  TEST_ASSERT_UINT32_WITHIN(SOC_TOLERANCE, SOC_ONE / 2, state.soc);
+
+  // Fuera de la curva se satura
+  telemetry_soc_reset(&state, MV_Q16(2800), 0, 0);
+  TEST_ASSERT_EQUAL_INT32(0, state.soc);
+  telemetry_soc_reset(&state, MV_Q16(4300), 0, 0);
+  TEST_ASSERT_EQUAL_INT32(SOC_ONE, state.soc);
+}
+
+void test_converges_from_a_known_ocv(void) {
+  telemetry_soc_state_t state;
+  const int32_t truth = SOC_ONE / 16 * 10;
+
+  telemetry_soc_reset(&state, MV_Q16(3800), 0, 0);
+  TEST_ASSERT_UINT32_WITHIN(SOC_TOLERANCE, truth, state.soc);
+  state.soc -= INITIAL_ERROR;
+
+  uint32_t initial_variance = state.variance;
+  int32_t error = INITIAL_ERROR;
+  for(uint32_t step = 1; step <= CONVERGENCE_STEPS; step++) {
+    telemetry_soc_step(&state, MV_Q16(3800), 0, step * STEP_US);
+    int32_t now = truth > state.soc ? truth - state.soc : state.soc - truth;
+    TEST_ASSERT_LESS_OR_EQUAL(error, now);
+    error = now;
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(CONVERGENCE_STEPS, state.updates);
+  TEST_ASSERT_LESS_THAN(SOC_ONE / 100, error);
+  TEST_ASSERT_LESS_THAN(initial_variance, state.variance);
+}
+
+void test_onboard_estimator_starts_from_voltage(void) {
+  telemetry_sample_frame_t frame;
+  telemetry_soc_state_t state;
+
+  memset(&frame, 0, sizeof(frame));
+  frame.value[TELEM_CH_BATTERY_VOLTAGE] = 3.71f;
+  telemetry_soc_update(&frame);
+  TEST_ASSERT_EQUAL_UINT8(50, telemetry_soc_level());
+  telemetry_soc_get_state(&state);
+  TEST_ASSERT_EQUAL_UINT32(0, state.updates);
+
+  // El estado retenido es válido: la siguiente muestra ya es una actualización
+  telemetry_soc_update(&frame);
+  TEST_ASSERT_EQUAL_UINT8(50, telemetry_soc_level());
+  telemetry_soc_get_state(&state);
+  TEST_ASSERT_EQUAL_UINT32(1, state.updates);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reset_reads_the_ocv_curve);
+  RUN_TEST(test_converges_from_a_known_ocv);
+  RUN_TEST(test_onboard_estimator_starts_from_voltage);
+  return UNITY_END();
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del buffer circular con repeticiones deduplicadas (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Los paquetes de prueba llevan en la carga útil un valor que solo
+ * cambia cada RUN_LENGTH números de secuencia, así que cada paquete completo
+ * va seguido de repeticiones y cualquier expansión con la carga útil de otro
+ * paquete se detecta comparando la carga con la secuencia. La prueba de
+ * concurrencia recorre instantáneas desde otra tarea mientras la prueba
+ * guarda y consume; la de vuelta del anillo intercala dos tipos con series
+ * largas y consume por tandas durante varias vueltas del array, de modo que
+ * los grupos de repeticiones y los paquetes completos a los que se refieren
+ * quedan a los dos lados del final del array.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_storage.h"
+
+/** @brief Paquetes seguidos con la misma carga útil */
+#define RUN_LENGTH 4
+
+/** @brief Paquetes que la prueba de concurrencia mantiene en el buffer */
+#define LIVE_PACKETS 8
+
+/** @brief Duración de la prueba de concurrencia (ms) */
+#define RACE_MS 1000
+
+/** @brief Paquetes seguidos con la misma carga útil en la prueba de vuelta del anillo */
+#define WRAP_RUN_LENGTH 48
+
+/** @brief Paquetes guardados en la prueba de vuelta: al menos cuatro vueltas aunque todas las ranuras sean repeticiones */
+#define WRAP_PACKETS (4 * TELEM_BUFFER_SIZE * TELEM_REPEAT_ENTRIES)
+
+/** @brief Paquetes que la prueba de vuelta deja en el buffer al consumir */
+#define WRAP_KEEP (TELEM_BUFFER_SIZE / 2)
+
+static telemetry_snapshot_t snapshot;
+static volatile bool race_running;
+static volatile uint32_t snapshot_packets;
+static volatile uint32_t snapshot_mismatches;
+static volatile bool snapshot_done;
+
+static float run_value(uint16_t sequence) {
+  return (float)(sequence / RUN_LENGTH);
+}
+
+static void make_packet(telemetry_packet_t* packet, uint16_t sequence) {
+  memset(packet, 0, sizeof(*packet));
+  packet->header.type = TELEM_POWER_DATA;
+  packet->header.sequence = sequence;
+  packet->header.timestamp = sequence;
+  packet->power.battery_voltage = run_value(sequence);
+}
+
+static bool matches_run(const telemetry_packet_t* packet) {
+  return packet->header.type == TELEM_POWER_DATA &&
+         packet->power.battery_voltage == run_value(packet->header.sequence);
+}
+
+/**
+ * @brief Paquete de la prueba de vuelta: tipos alternos, cada uno con sus series
+ */
+static void make_wrap_packet(telemetry_packet_t* packet, uint32_t index) {
+  uint16_t run = (uint16_t)(index / WRAP_RUN_LENGTH);
+  memset(packet, 0, sizeof(*packet));
+  packet->header.sequence = (uint16_t)index;
+  packet->header.timestamp = index;
+  if(index & 1) {
+    packet->header.type = TELEM_TEMPERATURE_DATA;
+    packet->temperature.obc_temperature = (int16_t)(run % 100);
+  } else {
+    packet->header.type = TELEM_POWER_DATA;
+    packet->power.battery_voltage = (float)run;
+  }
+}
+
+static bool matches_wrap(const telemetry_packet_t* packet, uint32_t index) {
+  telemetry_packet_t expected;
+  make_wrap_packet(&expected, index);
+  return memcmp(packet, &expected, sizeof(expected)) == 0;
+}
+
+static void drain(void) {
+  telemetry_packet_t packet;
+  while(telemetry_retrieve_packet(&packet)) {
+  }
+}
+
+void setUp(void) {
+  telemetry_storage_init();
+  drain();
+}
+
+void tearDown(void) {
+}
+
+static void snapshot_task(void* arg) {
+  telemetry_packet_t packet;
+  while(race_running) {
+    telemetry_snapshot_begin(&snapshot);
+    while(telemetry_snapshot_next(&snapshot, &packet)) {
+      snapshot_packets++;
+      if(!matches_run(&packet)) {
+        snapshot_mismatches++;
+      }
+    }
+  }
+  snapshot_done = true;
+  vTaskDelete(NULL);
+}
+
+void test_snapshot_and_retrieve_agree_on_repeats(void) {
+  race_running = true;
+  snapshot_done = false;
+  snapshot_packets = 0;
+  snapshot_mismatches = 0;
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(snapshot_task, "snapshot", 4096, NULL, 1, NULL));
+
+  telemetry_packet_t packet;
+  uint16_t sequence = 0;
+  uint32_t retrieved = 0, retrieved_mismatches = 0;
+  uint32_t start = millis();
+  while(millis() - start < RACE_MS) {
+    make_packet(&packet, sequence++);
+    TEST_ASSERT_TRUE(telemetry_store_packet(&packet));
+    if(telemetry_available_packets() > LIVE_PACKETS) {
+      TEST_ASSERT_TRUE(telemetry_retrieve_packet(&packet));
+      retrieved++;
+      if(!matches_run(&packet)) {
+        retrieved_mismatches++;
+      }
+    }
+  }
+  race_running = false;
+  for(int i = 0; i < 1000 && !snapshot_done; i++) {
+    vTaskDelay(1);
+  }
+  TEST_ASSERT_TRUE(snapshot_done);
+
+  TEST_ASSERT_GREATER_THAN(0, telemetry_deduplicated_packets());
+  TEST_ASSERT_GREATER_THAN(0, retrieved);
+  TEST_ASSERT_GREATER_THAN(0, snapshot_packets);
+  TEST_ASSERT_EQUAL_UINT32(0, retrieved_mismatches);
+  TEST_ASSERT_EQUAL_UINT32(0, snapshot_mismatches);
+}
+
+void test_repeats_expand_across_the_ring_wrap(void) {
+  telemetry_packet_t packet;
+  uint32_t written_before, read_before, lost_before;
+  uint32_t dedup_before = telemetry_deduplicated_packets();
+  telemetry_get_stats(&written_before, &read_before, &lost_before);
+
+  uint32_t next_read = 0, mismatches = 0;
+  for(uint32_t index = 0; index < WRAP_PACKETS; index++) {
+    make_wrap_packet(&packet, index);
+    TEST_ASSERT_TRUE(telemetry_store_packet(&packet));
+    // Se consume por tandas hasta dejar WRAP_KEEP paquetes
+    if(telemetry_available_packets() >= TELEM_BUFFER_SIZE - 1) {
+      while(telemetry_available_packets() > WRAP_KEEP) {
+        TEST_ASSERT_TRUE(telemetry_retrieve_packet(&packet));
+        if(!matches_wrap(&packet, next_read)) {
+          mismatches++;
+        }
+        next_read++;
+      }
+    }
+  }
+  while(telemetry_retrieve_packet(&packet)) {
+    if(!matches_wrap(&packet, next_read)) {
+      mismatches++;
+    }
+    next_read++;
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+  TEST_ASSERT_EQUAL_UINT32(WRAP_PACKETS, next_read);
+  // Casi todo son repeticiones, y ninguna se perdió por falta de sitio
+  uint32_t written, read, lost;
+  telemetry_get_stats(&written, &read, &lost);
+  TEST_ASSERT_EQUAL_UINT32(lost_before, lost);
+  TEST_ASSERT_GREATER_THAN(WRAP_PACKETS / 2, telemetry_deduplicated_packets() - dedup_before);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_snapshot_and_retrieve_agree_on_repeats);
+  RUN_TEST(test_repeats_expand_across_the_ring_wrap);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de la rueda jerárquica de temporizadores (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Arma a la vez temporizadores a ambos lados de los límites de 64
+ * ticks (nivel 0 / nivel 1) y de 4096 ticks (nivel 1 / nivel 2), de modo que
+ * los de niveles altos tienen que bajar de nivel antes de vencer. Cada uno
+ * debe dispararse en su tick exacto o después, nunca antes, y sin más
+ * retraso que el del planificador del anfitrión. La segunda prueba comprueba
+ * que la tarea de servicio duerme hasta el próximo vencimiento exacto en vez
+ * de despertar en cada límite de bloque, y que armar un temporizador
+ * anterior al que esperaba la despierta antes.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_timers.h"
+
+/** @brief Retraso máximo admitido respecto al vencimiento (ticks) */
+#define LATE_TICKS 20
+
+/** @brief Ticks que cubre el nivel 0 de la rueda */
+#define LEVEL0_TICKS 64
+
+/** @brief Temporizador lejano que mantiene ocupado un nivel alto en la segunda prueba */
+#define FAR_DELAY_MS 3000
+
+/** @brief Temporizador cercano que se arma después del lejano */
+#define NEAR_DELAY_MS 300
+
+/** @brief Retardos de la prueba de bajada de nivel: a ambos lados de 64 y de 4096 ticks */
+static const uint32_t cascade_delays[] = { 1, 63, 64, 65, 127, 128, 129, 200, 4095, 4096, 4097 };
+
+#define CASCADE_TIMERS (sizeof(cascade_delays) / sizeof(cascade_delays[0]))
+
+static telemetry_timer_t timers[CASCADE_TIMERS];
+static volatile uint32_t fired_tick[CASCADE_TIMERS];
+
+static void record_fire(void* arg) {
+  fired_tick[(intptr_t)arg] = xTaskGetTickCount();
+}
+
+/**
+ * @brief Espera a que se disparen los temporizadores indicados
+ */
+static bool wait_for_runs(const telemetry_timer_t* list, uint32_t count, uint32_t timeout_ms) {
+  uint32_t start = millis();
+  for(;;) {
+    uint32_t done = 0;
+    for(uint32_t i = 0; i < count; i++) {
+      done += list[i].runs != 0;
+    }
+    if(done == count) {
+      return true;
+    }
+    if(millis() - start > timeout_ms) {
+      return false;
+    }
+    vTaskDelay(10);
+  }
+}
+
+void setUp(void) {
+  TEST_ASSERT_TRUE(telemetry_timers_init());
+  memset((void*)fired_tick, 0, sizeof(fired_tick));
+}
+
+void tearDown(void) {
+}
+
+void test_timers_cascade_across_level_boundaries(void) {
+  telemetry_timer_stats_t before, after;
+  telemetry_timers_get_stats(&before);
+
+  for(uint32_t i = 0; i < CASCADE_TIMERS; i++) {
+    telemetry_timer_setup(&timers[i], "cascade", record_fire, (void*)(intptr_t)i, TELEM_TIMER_WORKER_SERVICE);
+    telemetry_timer_start(&timers[i], cascade_delays[i], 0);
+  }
+  TEST_ASSERT_TRUE(wait_for_runs(timers, CASCADE_TIMERS, cascade_delays[CASCADE_TIMERS - 1] + 1000));
+
+  for(uint32_t i = 0; i < CASCADE_TIMERS; i++) {
+    TEST_ASSERT_EQUAL_UINT32(1, timers[i].runs);
+    TEST_ASSERT_EQUAL_UINT32(timers[i].expires, timers[i].due);
+    TEST_ASSERT_TRUE((int32_t)(fired_tick[i] - timers[i].due) >= 0);
+    TEST_ASSERT_LESS_OR_EQUAL(LATE_TICKS, fired_tick[i] - timers[i].due);
+  }
+
+  telemetry_timers_get_stats(&after);
+  TEST_ASSERT_EQUAL_UINT32(before.expirations + CASCADE_TIMERS, after.expirations);
+  // Todo lo que estaba más allá del nivel 0 tuvo que bajar al menos una vez
+  uint32_t beyond_level0 = 0;
+  for(uint32_t i = 0; i < CASCADE_TIMERS; i++) {
+    beyond_level0 += cascade_delays[i] > LEVEL0_TICKS;
+  }
+  TEST_ASSERT_TRUE(after.cascades - before.cascades >= beyond_level0);
+  TEST_ASSERT_EQUAL_UINT32(0, after.overruns - before.overruns);
+  TEST_ASSERT_EQUAL_UINT32(before.active, after.active);
+}
+
+void test_service_sleeps_until_the_next_deadline(void) {
+  telemetry_timer_stats_t before, after;
+
+  telemetry_timer_setup(&timers[0], "far", record_fire, (void*)(intptr_t)0, TELEM_TIMER_WORKER_SERVICE);
+  telemetry_timer_setup(&timers[1], "near", record_fire, (void*)(intptr_t)1, TELEM_TIMER_WORKER_SERVICE);
+  telemetry_timer_start(&timers[0], FAR_DELAY_MS, 0);
+  vTaskDelay(10);
+  telemetry_timers_get_stats(&before);
+
+  // El cercano vence antes que el que esperaba el servicio: tiene que despertarlo
+  telemetry_timer_start(&timers[1], NEAR_DELAY_MS, 0);
+  TEST_ASSERT_TRUE(wait_for_runs(&timers[1], 1, NEAR_DELAY_MS + 1000));
+  TEST_ASSERT_LESS_OR_EQUAL(LATE_TICKS, fired_tick[1] - timers[1].due);
+  TEST_ASSERT_EQUAL_UINT32(0, timers[0].runs);
+
+  TEST_ASSERT_TRUE(wait_for_runs(&timers[0], 1, FAR_DELAY_MS + 1000));
+  TEST_ASSERT_TRUE((int32_t)(fired_tick[0] - timers[0].due) >= 0);
+  TEST_ASSERT_LESS_OR_EQUAL(LATE_TICKS, fired_tick[0] - timers[0].due);
+
+  // Una espera por el aviso del cercano, otra hasta cada vencimiento: ninguna
+  // por los límites de bloque que cruza el lejano mientras baja de nivel
+  telemetry_timers_get_stats(&after);
+  TEST_ASSERT_GREATER_THAN(0, after.cascades - before.cascades);
+  TEST_ASSERT_LESS_OR_EQUAL(4, after.wakeups - before.wakeups);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_timers_cascade_across_level_boundaries);
+  RUN_TEST(test_service_sleeps_until_the_next_deadline);
+  return UNITY_END();
+}
@@ -0,0 +1,138 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del bus de publicación/suscripción (entorno native)
+ * @author Aarón Ramírez Valencia - TeideSat
+ * @date 18-10-2026
+ *
+ * @details Comprueba que un paquete que no se puede publicar por tener el
+ * pool agotado se anota en los suscriptores de su tipo y solo en ellos, y
+ * que varias tareas que se suscriben a la vez reciben posiciones distintas
+ * sin pasar de TELEM_TOPIC_MAX_SUBSCRIBERS.
+ */
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+#include "host_shims.h"
+#include "../../include/telemetry_topics.h"
+
+/** @brief Suscriptores que registra la primera prueba */
+#define FIRST_SUBSCRIBERS 2
+
+/** @brief Tareas que compiten por los suscriptores libres */
+#define RACE_TASKS 4
+
+static telem_topic_sub_t power_sub;
+static telem_topic_sub_t temperature_sub;
+
+static volatile bool race_start;
+static volatile uint32_t race_finished;
+static telem_topic_sub_t race_ids[RACE_TASKS];
+static const char* const race_names[RACE_TASKS] = { "race-0", "race-1", "race-2", "race-3" };
+
+static void power_packet(telemetry_packet_t* packet) {
+  memset(packet, 0, sizeof(*packet));
+  packet->header.type = TELEM_POWER_DATA;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_pool_exhaustion_is_counted_per_subscriber(void) {
+  telemetry_pool_init();
+  power_sub = telemetry_topic_subscribe("power", TELEM_TOPIC_MASK(TELEM_POWER_DATA), NULL, NULL);
+  temperature_sub = telemetry_topic_subscribe("temperature", TELEM_TOPIC_MASK(TELEM_TEMPERATURE_DATA), NULL, NULL);
+  TEST_ASSERT_NOT_EQUAL(TELEM_TOPIC_INVALID, power_sub);
+  TEST_ASSERT_NOT_EQUAL(TELEM_TOPIC_INVALID, temperature_sub);
+
+  // Otro consumidor retiene todos los bloques
+  telem_pool_handle_t held[TELEM_POOL_SIZE];
+  for(int i = 0; i < TELEM_POOL_SIZE; i++) {
+    held[i] = telemetry_pool_alloc();
+    TEST_ASSERT_NOT_EQUAL(TELEM_POOL_INVALID, held[i]);
+  }
+
+  telemetry_packet_t packet;
+  power_packet(&packet);
+  TEST_ASSERT_FALSE(telemetry_topic_publish_packet(&packet));
+
+  telemetry_topic_stats_t power, temperature;
+  TEST_ASSERT_TRUE(telemetry_topic_get_stats(power_sub, &power));
+  TEST_ASSERT_TRUE(telemetry_topic_get_stats(temperature_sub, &temperature));
+  TEST_ASSERT_EQUAL_UINT32(1, power.pool_dropped);
+  TEST_ASSERT_EQUAL_UINT32(0, power.dropped);
+  TEST_ASSERT_EQUAL_UINT32(0, power.delivered);
+  TEST_ASSERT_EQUAL_UINT32(0, temperature.pool_dropped);
+
+  // Con bloques libres vuelve a llegar
+  for(int i = 0; i < TELEM_POOL_SIZE; i++) {
+    telemetry_pool_release(held[i]);
+  }
+  TEST_ASSERT_TRUE(telemetry_topic_publish_packet(&packet));
+  telem_pool_handle_t handle;
+  TEST_ASSERT_TRUE(telemetry_topic_receive(power_sub, &handle, 0));
+  TEST_ASSERT_EQUAL(TELEM_POWER_DATA, telemetry_pool_get(handle)->header.type);
+  telemetry_pool_release(handle);
+
+  TEST_ASSERT_TRUE(telemetry_topic_get_stats(power_sub, &power));
+  TEST_ASSERT_EQUAL_UINT32(1, power.pool_dropped);
+  TEST_ASSERT_EQUAL_UINT32(1, power.delivered);
+  TEST_ASSERT_EQUAL_UINT32(1, power.received);
+}
+
+static void subscribe_task(void* arg) {
+  int index = (int)(intptr_t)arg;
+  while(!race_start) {
+    vTaskDelay(1);
+  }
+  race_ids[index] = telemetry_topic_subscribe(race_names[index], TELEM_TOPIC_ALL, NULL, NULL);
+  __atomic_add_fetch(&race_finished, 1, __ATOMIC_RELEASE);
+  vTaskDelete(NULL);
+}
+
+void test_concurrent_subscribers_get_distinct_slots(void) {
+  race_start = false;
+  race_finished = 0;
+  for(int i = 0; i < RACE_TASKS; i++) {
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(subscribe_task, race_names[i], 2048, (void*)(intptr_t)i, 1, NULL));
+  }
+  race_start = true;
+  for(int i = 0; i < 1000 && __atomic_load_n(&race_finished, __ATOMIC_ACQUIRE) < RACE_TASKS; i++) {
+    vTaskDelay(1);
+  }
+  TEST_ASSERT_EQUAL_UINT32(RACE_TASKS, race_finished);
+
+  // Solo quedaban TELEM_TOPIC_MAX_SUBSCRIBERS - FIRST_SUBSCRIBERS posiciones
+  uint32_t seen = 0, subscribed = 0;
+  for(int i = 0; i < RACE_TASKS; i++) {
+    if(race_ids[i] == TELEM_TOPIC_INVALID) {
+      continue;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(FIRST_SUBSCRIBERS, race_ids[i]);
+    TEST_ASSERT_LESS_THAN(TELEM_TOPIC_MAX_SUBSCRIBERS, race_ids[i]);
+    TEST_ASSERT_EQUAL_UINT32(0, seen & (1UL << race_ids[i]));
+    seen |= 1UL << race_ids[i];
+    subscribed++;
+
+    telemetry_topic_stats_t stats;
+    TEST_ASSERT_TRUE(telemetry_topic_get_stats(race_ids[i], &stats));
+    TEST_ASSERT_EQUAL_STRING(race_names[i], stats.name);
+  }
+  TEST_ASSERT_EQUAL_UINT32(TELEM_TOPIC_MAX_SUBSCRIBERS - FIRST_SUBSCRIBERS, subscribed);
+
+  // Todos los suscriptores tienen cola: publicar llega a los de su tipo
+  telemetry_packet_t packet;
+  power_packet(&packet);
+  TEST_ASSERT_TRUE(telemetry_topic_publish_packet(&packet));
+  TEST_ASSERT_EQUAL_UINT32(1 + subscribed, telemetry_topic_pending());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_pool_exhaustion_is_counted_per_subscriber);
+  RUN_TEST(test_concurrent_subscribers_get_distinct_slots);
+  return UNITY_END();
+}
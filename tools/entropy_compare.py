@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+"""
+Compara el tamaño de una carga de trama con zlib y xz.
+
+Referencia para el codificador rANS de telemetry_entropy: la prueba
+test_benchmark_reports_ratio_and_speed de test/test_entropy deja la carga de
+muestra en <raíz de los sustitutos>/entropy_sample.bin y registra su tamaño
+con delta+rANS; este script da el de los compresores de propósito general
+sobre los mismos bytes.
+
+Uso:
+    TELEM_HOST_ROOT=/tmp/telem pio test -e native -f test_entropy
+    python3 tools/entropy_compare.py /tmp/telem/entropy_sample.bin
+
+Autor: Aarón Ramírez Valencia - TeideSat
+Fecha: 18-10-2026
+"""
+
+import lzma
+import sys
+import zlib
+
+
+def main() -> int:
+    if len(sys.argv) != 2:
+        print(__doc__.strip())
+        return 1
+
+    with open(sys.argv[1], "rb") as sample:
+        data = sample.read()
+
+    lzma2 = [{"id": lzma.FILTER_LZMA2, "preset": 9 | lzma.PRESET_EXTREME}]
+    sizes = [
+        ("raw", len(data)),
+        ("zlib -9", len(zlib.compress(data, 9))),
+        ("xz -9e", len(lzma.compress(data, preset=9 | lzma.PRESET_EXTREME))),
+        ("lzma2 -9e (sin contenedor)", len(lzma.compress(data, format=lzma.FORMAT_RAW, filters=lzma2))),
+    ]
+    for name, size in sizes:
+        print(f"{name:28} {size:6} B")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())